@@ -0,0 +1,182 @@
+/* Define version here for Unix, but using /D for Windows. */
+#define VERSION "1.8.1"
+
+/* Define to the base type of arg 3 for `accept`. */
+#define ACCEPT_TYPE_ARG3 socklen_t
+
+/* Define if your compiler has bool support. */
+#define HAVE_CXX_BOOL 1
+
+/* Define if your compiler has C++ cast support. */
+#define HAVE_CXX_CASTS 1
+
+/* Define if your compiler has exceptions support. */
+#define HAVE_CXX_EXCEPTIONS 1
+
+/* Define if your compiler has mutable support. */
+#define HAVE_CXX_MUTABLE 1
+
+/* Define if your compiler has standard C++ library support. */
+#define HAVE_CXX_STDLIB 1
+
+/* Define if the <X11/extensions/dpms.h> header file declares function prototypes. */
+#define HAVE_DPMS_PROTOTYPES 1
+
+/* Define if you have a working `getpwuid_r` function. */
+#define HAVE_GETPWUID_R 1
+
+/* Define to 1 if you have the `gmtime_r` function. */
+#define HAVE_GMTIME_R 1
+
+/* Define if you have the `inet_aton` function. */
+#define HAVE_INET_ATON 1
+
+/* Define to 1 if you have the <inttypes.h> header file. */
+#define HAVE_INTTYPES_H 1
+
+/* Define to 1 if you have the <istream> header file. */
+#define HAVE_ISTREAM 1
+
+/* Define to 1 if you have the <locale.h> header file. */
+#define HAVE_LOCALE_H 1
+
+/* Define to 1 if you have the <memory.h> header file. */
+#define HAVE_MEMORY_H 1
+
+/* Define if you have the `nanosleep` function. */
+#define HAVE_NANOSLEEP 1
+
+/* Define if you have the `clock_gettime` function. */
+#define HAVE_CLOCK_GETTIME 1
+
+/* Define to 1 if you have the <ostream> header file. */
+#define HAVE_OSTREAM 1
+
+/* Define if you have the `poll` function. */
+#define HAVE_POLL 1
+
+/* Define if you have a POSIX `sigwait` function. */
+#define HAVE_POSIX_SIGWAIT 1
+
+/* Define if you have POSIX threads libraries and header files. */
+#define HAVE_PTHREAD 1
+
+/* Define if you have `pthread_sigmask` and `pthread_kill` functions. */
+#define HAVE_PTHREAD_SIGNAL 1
+
+/* Define if your compiler defines socklen_t. */
+#define HAVE_SOCKLEN_T 1
+
+/* Define to 1 if you have the <sstream> header file. */
+#define HAVE_SSTREAM 1
+
+/* Define to 1 if you have the <stdint.h> header file. */
+#define HAVE_STDINT_H 1
+
+/* Define to 1 if you have the <stdlib.h> header file. */
+#define HAVE_STDLIB_H 1
+
+/* Define to 1 if you have the `strftime` function. */
+#define HAVE_STRFTIME 1
+
+/* Define to 1 if you have the <strings.h> header file. */
+#define HAVE_STRINGS_H 1
+
+/* Define to 1 if you have the <string.h> header file. */
+#define HAVE_STRING_H 1
+
+/* Define to 1 if you have the <sys/select.h> header file. */
+#define HAVE_SYS_SELECT_H 1
+
+/* Define to 1 if you have the <sys/sendfile.h> header file. */
+#define HAVE_SYS_SENDFILE_H 1
+
+/* Define to 1 if you have the <sys/socket.h> header file. */
+#define HAVE_SYS_SOCKET_H 1
+
+/* Define to 1 if you have the <sys/stat.h> header file. */
+#define HAVE_SYS_STAT_H 1
+
+/* Define to 1 if you have the <sys/time.h> header file. */
+#define HAVE_SYS_TIME_H 1
+
+/* Define to 1 if you have the <sys/types.h> header file. */
+#define HAVE_SYS_TYPES_H 1
+
+/* Define to 1 if you have the <sys/utsname.h> header file. */
+#define HAVE_SYS_UTSNAME_H 1
+
+/* Define to 1 if you have the <unistd.h> header file. */
+#define HAVE_UNISTD_H 1
+
+/* Define to 1 if you have the `vsnprintf` function. */
+#define HAVE_VSNPRINTF 1
+
+/* Define to 1 if you have the <wchar.h> header file. */
+#define HAVE_WCHAR_H 1
+
+/* Define to 1 if you have the <X11/extensions/Xrandr.h> header file. */
+/* #undef HAVE_X11_EXTENSIONS_XRANDR_H */
+
+/* Define to 1 if you have the <X11/extensions/Xfixes.h> header file. */
+#define HAVE_X11_EXTENSIONS_XFIXES_H 1
+
+/* Define to 1 if you have the <X11/extensions/dpms.h> header file. */
+#define HAVE_X11_EXTENSIONS_DPMS_H 1
+
+/* Define to 1 if you have the <X11/extensions/Xinerama.h> header file. */
+/* #undef HAVE_X11_EXTENSIONS_XINERAMA_H */
+
+/* Define to 1 if you have the <X11/extensions/XKBstr.h> header file. */
+#define HAVE_X11_EXTENSIONS_XKBSTR_H 1
+
+/* Define to 1 if you have the <X11/extensions/XTest.h> header file. */
+#define HAVE_X11_EXTENSIONS_XTEST_H 1
+
+/* Define to 1 if you have the <X11/XKBlib.h> header file. */
+#define HAVE_X11_XKBLIB_H 1
+
+/* Define to 1 if you have the <X11/extensions/XInput2.h> header file. */
+/* #undef HAVE_XI2 */
+
+/* Define this if the XKB extension is available. */
+#define HAVE_XKB_EXTENSION 1
+
+/* Define to necessary symbol if this constant uses a non-standard name on your system. */
+/* #undef PTHREAD_CREATE_JOINABLE */
+
+/* Define to the type of arg 1 for `select`. */
+#define SELECT_TYPE_ARG1 int
+
+/* Define to the type of args 2, 3 and 4 for `select`. */
+#define SELECT_TYPE_ARG234 (fd_set *)
+
+/* Define to the type of arg 5 for `select`. */
+#define SELECT_TYPE_ARG5 (struct timeval *)
+
+/* The size of `char`, as computed by sizeof. */
+#define SIZEOF_CHAR 1
+
+/* The size of `int`, as computed by sizeof. */
+#define SIZEOF_INT 4
+
+/* The size of `long`, as computed by sizeof. */
+#define SIZEOF_LONG 8
+
+/* The size of `short`, as computed by sizeof. */
+#define SIZEOF_SHORT 2
+
+/* Define to 1 if you have the ANSI C header files. */
+#define STDC_HEADERS 1
+
+/* Define to 1 if you can safely include both <sys/time.h> and <time.h>. */
+#define TIME_WITH_SYS_TIME 1
+
+/* Define to 1 if your <sys/time.h> declares `struct tm`. */
+/* #undef TM_IN_SYS_TIME */
+
+/* Define to 1 if the X Window System is missing or not being used. */
+/* #undef X_DISPLAY_MISSING */
+
+/* Define to `unsigned int` if <sys/types.h> does not define. */
+/* #undef size_t */
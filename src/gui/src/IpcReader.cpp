@@ -34,77 +34,73 @@ IpcReader::~IpcReader()
 
 void IpcReader::start()
 {
+	m_Buffer.clear();
 	connect(m_Socket, SIGNAL(readyRead()), this, SLOT(read()));
 }
 
 void IpcReader::stop()
 {
 	disconnect(m_Socket, SIGNAL(readyRead()), this, SLOT(read()));
+	m_Buffer.clear();
 }
 
 void IpcReader::read()
 {
 	QMutexLocker locker(&m_Mutex);
-	std::cout << "ready read" << std::endl;
 
-	while (m_Socket->bytesAvailable()) {
-		std::cout << "bytes available" << std::endl;
-
-		char codeBuf[5];
-		readStream(codeBuf, 4);
-		codeBuf[4] = 0;
-		std::cout << "ipc read: " << codeBuf << std::endl;
-
-		if (memcmp(codeBuf, kIpcMsgLogLine, 4) == 0) {
-			std::cout << "reading log line" << std::endl;
-
-			char lenBuf[4];
-			readStream(lenBuf, 4);
-			int len = bytesToInt(lenBuf, 4);
-
-			char* data = new char[len];
-			readStream(data, len);
-			QString line = QString::fromUtf8(data, len);
-			delete data;
-
-			readLogLine(line);
-		}
-		else {
-			std::cerr << "aborting, message invalid" << std::endl;
-			return;
-		}
+	// take whatever has arrived.  never wait for the rest of a message,
+	// we'll get another readyRead when it comes.
+	m_Buffer.append(m_Socket->readAll());
+
+	// pull out every complete message and pass their log lines on in
+	// one go, so a burst of log traffic doesn't update the view once
+	// per line.
+	QString logLines;
+	int offset = 0;
+	while (readMessage(offset, logLines)) {
+		// keep going
 	}
+	m_Buffer.remove(0, offset);
 
-	std::cout << "read done" << std::endl;
+	if (!logLines.isEmpty()) {
+		readLogLine(logLines);
+	}
 }
 
-bool IpcReader::readStream(char* buffer, int length)
+bool IpcReader::readMessage(int& offset, QString& logLines)
 {
-	std::cout << "reading stream" << std::endl;
+	const int headerSize = 8;
+	if (m_Buffer.size() - offset < 4) {
+		return false;
+	}
 
-	int read = 0;
-	while (read < length) {
-		int ask = length - read;
-		if (m_Socket->bytesAvailable() < ask) {
-			std::cout << "buffer too short, waiting" << std::endl;
-			m_Socket->waitForReadyRead(-1);
-		}
+	const char* message = m_Buffer.constData() + offset;
+	if (memcmp(message, kIpcMsgLogLine, 4) != 0) {
+		// we can't find the next message after one we don't know
+		std::cerr << "aborting, message invalid" << std::endl;
+		offset = m_Buffer.size();
+		return false;
+	}
 
-		int got = m_Socket->read(buffer, ask);
-		read += got;
+	if (m_Buffer.size() - offset < headerSize) {
+		return false;
+	}
 
-		std::cout << "> ask=" << ask << " got=" << got
-			<< " read=" << read << std::endl;
+	int len = bytesToInt(message + 4, 4);
+	if (len < 0) {
+		std::cerr << "aborting, message invalid" << std::endl;
+		offset = m_Buffer.size();
+		return false;
+	}
+	if (m_Buffer.size() - offset - headerSize < len) {
+		return false;
+	}
 
-		if (got == -1) {
-			std::cout << "socket ended, aborting" << std::endl;
-			return false;
-		}
-		else if (length - read > 0) {
-			std::cout << "more remains, seek to " << got << std::endl;
-			buffer += got;
-		}
+	if (!logLines.isEmpty()) {
+		logLines += '\n';
 	}
+	logLines += QString::fromUtf8(message + headerSize, len);
+	offset += headerSize + len;
 	return true;
 }
 
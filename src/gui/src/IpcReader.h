@@ -20,6 +20,7 @@
 
 #include <QObject>
 #include <QMutex>
+#include <QByteArray>
 
 class QTcpSocket;
 
@@ -34,10 +35,11 @@ public:
 	void stop();
 
 signals:
+	// may hold several lines, one per message read at the same time
 	void readLogLine(const QString& text);
 
 private:
-	bool readStream(char* buffer, int length);
+	bool readMessage(int& offset, QString& logLines);
 	int bytesToInt(const char* buffer, int size);
 
 private slots:
@@ -46,4 +48,7 @@ private slots:
 private:
 	QTcpSocket* m_Socket;
 	QMutex m_Mutex;
+
+	// bytes read but not yet parsed, which may end in a partial message
+	QByteArray m_Buffer;
 };
@@ -215,6 +215,18 @@ public:
 	virtual size_t		writeSocket(ArchSocket s,
 							const void* buf, size_t len) = 0;
 
+	//! Write data from a file to socket
+	/*!
+	Write up to \c len bytes to socket \c s from the file open on \c fd,
+	starting at \c offset, without copying them through user space.
+	Returns the number of bytes written, which may be 0 if the internal
+	buffers are full.  If the file ends at \c offset, returns 0 and sets
+	\c fileEnded.  Throws XArchNetworkSupport if this isn't supported.
+	*/
+	virtual size_t		sendFileOnSocket(ArchSocket s,
+							int fd, size_t offset, size_t len,
+							bool& fileEnded) = 0;
+
 	//! Check error on socket
 	/*!
 	If the socket \c s is in an error state then throws an appropriate
@@ -236,6 +248,30 @@ public:
 	*/
 	virtual bool		setReuseAddrOnSocket(ArchSocket, bool reuse) = 0;
 
+	//! Limit unsent data queued on socket
+	/*!
+	Ask the kernel to report the socket writable only while it has
+	fewer than \p bytes of data waiting to be sent (TCP_NOTSENT_LOWAT).
+	The rest of the data then waits in our own buffers, where newer
+	data can still replace it.  Returns false if this isn't supported.
+	*/
+	virtual bool		setNotSentLowWaterOnSocket(ArchSocket, int bytes) = 0;
+
+	//! Get unsent data queued on socket
+	/*!
+	Returns the number of bytes written to the socket that the kernel
+	hasn't sent yet, or -1 if that can't be found out.
+	*/
+	virtual int			getUnsentOnSocket(ArchSocket) = 0;
+
+	//! Get pollable descriptor of socket
+	/*!
+	Returns a file descriptor for \c s that an event loop can pass to
+	poll() along with its own descriptors, or -1 if \c s is NULL or
+	the platform's sockets can't be polled that way.
+	*/
+	virtual int			getPollFdOnSocket(ArchSocket s) = 0;
+
 	//! Return local host's name
 	virtual std::string		getHostName() = 0;
 
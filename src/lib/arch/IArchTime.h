@@ -19,6 +19,7 @@
 #pragma once
 
 #include "common/IInterface.h"
+#include "common/basic_types.h"
 
 //! Interface for architecture dependent time operations
 /*!
@@ -33,9 +34,27 @@ public:
 	//! Get the current time
 	/*!
 	Returns the number of seconds since some arbitrary starting time.
-	This should return as high a precision as reasonable.
+	This should return as high a precision as reasonable.  Like
+	\c ticks() it's monotonic.
 	*/
 	virtual double		time() = 0;
 
+	//! Get the monotonic clock
+	/*!
+	Returns the number of nanoseconds since some arbitrary starting
+	time.  This never goes backwards and doesn't jump when the wall
+	clock is changed, so it's what intervals and timeouts should be
+	measured with.
+	*/
+	virtual UInt64		ticks() = 0;
+
+	//! Get the coarse monotonic clock
+	/*!
+	Like \c ticks() but may be cheaper to read, at the cost of a
+	resolution of a few milliseconds.  For hot paths that only need
+	rough times.
+	*/
+	virtual UInt64		coarseTicks() = 0;
+
 	//@}
 };
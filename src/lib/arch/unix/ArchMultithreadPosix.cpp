@@ -36,6 +36,12 @@
 
 #define SIGWAKEUP SIGUSR1
 
+// time condition variable waits with the monotonic clock where we can,
+// so they aren't thrown off by changes to the wall clock
+#if HAVE_CLOCK_GETTIME && !defined(__APPLE__)
+#	define USE_MONOTONIC_CONDVAR 1
+#endif
+
 #if !HAVE_PTHREAD_SIGNAL
 	// boy, is this platform broken.  forget about pthread signal
 	// handling and let signals through to every process.  synergy
@@ -185,7 +191,15 @@ ArchCond
 ArchMultithreadPosix::newCondVar()
 {
 	ArchCondImpl* cond = new ArchCondImpl;
+#if USE_MONOTONIC_CONDVAR
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	int status = pthread_cond_init(&cond->m_cond, &attr);
+	pthread_condattr_destroy(&attr);
+#else
 	int status = pthread_cond_init(&cond->m_cond, NULL);
+#endif
 	(void)status;
 	assert(status == 0);
 	return cond;
@@ -237,11 +251,15 @@ ArchMultithreadPosix::waitCondVar(ArchCond cond,
 	testCancelThread();
 
 	// get final time
+	struct timespec finalTime;
+#if USE_MONOTONIC_CONDVAR
+	clock_gettime(CLOCK_MONOTONIC, &finalTime);
+#else
 	struct timeval now;
 	gettimeofday(&now, NULL);
-	struct timespec finalTime;
 	finalTime.tv_sec   = now.tv_sec;
 	finalTime.tv_nsec  = now.tv_usec * 1000;
+#endif
 	long timeout_sec   = (long)timeout;
 	long timeout_nsec  = (long)(1.0e+9 * (timeout - timeout_sec));
 	finalTime.tv_sec  += timeout_sec;
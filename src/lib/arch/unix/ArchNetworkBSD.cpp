@@ -31,6 +31,13 @@
 #	include <netinet/tcp.h>
 #endif
 #include <arpa/inet.h>
+#include <sys/ioctl.h>
+#if HAVE_SYS_SENDFILE_H
+#	include <sys/sendfile.h>
+#endif
+#if defined(__linux__)
+#	include <linux/sockios.h>
+#endif
 #include <fcntl.h>
 #include <errno.h>
 #include <string.h>
@@ -538,6 +545,35 @@ ArchNetworkBSD::writeSocket(ArchSocket s, const void* buf, size_t len)
 	return n;
 }
 
+size_t
+ArchNetworkBSD::sendFileOnSocket(ArchSocket s,
+				int fd, size_t offset, size_t len, bool& fileEnded)
+{
+	assert(s != NULL);
+
+	fileEnded = false;
+#if HAVE_SYS_SENDFILE_H
+	off_t position = static_cast<off_t>(offset);
+	ssize_t n = sendfile(s->m_fd, fd, &position, len);
+	if (n == -1) {
+		if (errno == EINTR || errno == EAGAIN) {
+			return 0;
+		}
+		throwError(errno);
+	}
+	if (n == 0 && len > 0) {
+		// the file was truncated under us
+		fileEnded = true;
+	}
+	return n;
+#else
+	(void)fd;
+	(void)offset;
+	(void)len;
+	throw XArchNetworkSupport("");
+#endif
+}
+
 void
 ArchNetworkBSD::throwErrorOnSocket(ArchSocket s)
 {
@@ -623,6 +659,55 @@ ArchNetworkBSD::setReuseAddrOnSocket(ArchSocket s, bool reuse)
 	return (oflag != 0);
 }
 
+bool
+ArchNetworkBSD::setNotSentLowWaterOnSocket(ArchSocket s, int bytes)
+{
+	assert(s != NULL);
+
+#if defined(TCP_NOTSENT_LOWAT)
+	if (setsockopt(s->m_fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT,
+							(optval_t*)&bytes, (socklen_t)sizeof(bytes)) == -1) {
+		// older kernels don't have the option
+		return false;
+	}
+	return true;
+#else
+	(void)bytes;
+	return false;
+#endif
+}
+
+int
+ArchNetworkBSD::getUnsentOnSocket(ArchSocket s)
+{
+	assert(s != NULL);
+
+	int bytes = -1;
+#if defined(SIOCOUTQNSD)
+	// just the data not sent yet, not what's waiting to be acked
+	if (ioctl(s->m_fd, SIOCOUTQNSD, &bytes) == -1) {
+		bytes = -1;
+	}
+#elif defined(SIOCOUTQ)
+	if (ioctl(s->m_fd, SIOCOUTQ, &bytes) == -1) {
+		bytes = -1;
+	}
+#elif defined(SO_NWRITE)
+	socklen_t size = (socklen_t)sizeof(bytes);
+	if (getsockopt(s->m_fd, SOL_SOCKET, SO_NWRITE,
+							(optval_t*)&bytes, &size) == -1) {
+		bytes = -1;
+	}
+#endif
+	return bytes;
+}
+
+int
+ArchNetworkBSD::getPollFdOnSocket(ArchSocket s)
+{
+	return (s == NULL) ? -1 : s->m_fd;
+}
+
 std::string
 ArchNetworkBSD::getHostName()
 {
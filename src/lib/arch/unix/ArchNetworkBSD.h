@@ -76,9 +76,15 @@ public:
 	virtual size_t		readSocket(ArchSocket s, void* buf, size_t len);
 	virtual size_t		writeSocket(ArchSocket s,
 							const void* buf, size_t len);
+	virtual size_t		sendFileOnSocket(ArchSocket s,
+							int fd, size_t offset, size_t len,
+							bool& fileEnded);
 	virtual void		throwErrorOnSocket(ArchSocket);
 	virtual bool		setNoDelayOnSocket(ArchSocket, bool noDelay);
 	virtual bool		setReuseAddrOnSocket(ArchSocket, bool reuse);
+	virtual bool		setNotSentLowWaterOnSocket(ArchSocket, int bytes);
+	virtual int			getUnsentOnSocket(ArchSocket);
+	virtual int			getPollFdOnSocket(ArchSocket);
 	virtual std::string		getHostName();
 	virtual ArchNetAddress	newAnyAddr(EAddressFamily);
 	virtual ArchNetAddress	copyAddr(ArchNetAddress);
@@ -27,6 +27,27 @@
 #	else
 #		include <time.h>
 #	endif
+#endif
+#if !HAVE_CLOCK_GETTIME && defined(__APPLE__)
+#	include <mach/mach_time.h>
+#endif
+
+#if HAVE_CLOCK_GETTIME
+
+static
+UInt64
+getClock(clockid_t id)
+{
+	struct timespec t;
+	clock_gettime(id, &t);
+	return static_cast<UInt64>(t.tv_sec) * 1000000000 +
+			static_cast<UInt64>(t.tv_nsec);
+}
+
+#elif defined(__APPLE__)
+
+static mach_timebase_info_data_t	s_timebase;
+
 #endif
 
 //
@@ -35,7 +56,9 @@
 
 ArchTimeUnix::ArchTimeUnix()
 {
-	// do nothing
+#if !HAVE_CLOCK_GETTIME && defined(__APPLE__)
+	mach_timebase_info(&s_timebase);
+#endif
 }
 
 ArchTimeUnix::~ArchTimeUnix()
@@ -46,7 +69,31 @@ ArchTimeUnix::~ArchTimeUnix()
 double
 ArchTimeUnix::time()
 {
+	return 1.0e-9 * static_cast<double>(ticks());
+}
+
+UInt64
+ArchTimeUnix::ticks()
+{
+#if HAVE_CLOCK_GETTIME
+	return getClock(CLOCK_MONOTONIC);
+#elif defined(__APPLE__)
+	return mach_absolute_time() * s_timebase.numer / s_timebase.denom;
+#else
+	// no monotonic clock;  this jumps when the wall clock is changed
 	struct timeval t;
 	gettimeofday(&t, NULL);
-	return (double)t.tv_sec + 1.0e-6 * (double)t.tv_usec;
+	return static_cast<UInt64>(t.tv_sec) * 1000000000 +
+			static_cast<UInt64>(t.tv_usec) * 1000;
+#endif
+}
+
+UInt64
+ArchTimeUnix::coarseTicks()
+{
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC_COARSE)
+	return getClock(CLOCK_MONOTONIC_COARSE);
+#else
+	return ticks();
+#endif
 }
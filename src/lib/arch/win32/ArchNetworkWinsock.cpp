@@ -576,6 +576,13 @@ ArchNetworkWinsock::writeSocket(ArchSocket s, const void* buf, size_t len)
 	return static_cast<size_t>(n);
 }
 
+size_t
+ArchNetworkWinsock::sendFileOnSocket(ArchSocket, int, size_t, size_t, bool&)
+{
+	// TransmitFile() needs a file handle, not a descriptor
+	throw XArchNetworkSupport("");
+}
+
 void
 ArchNetworkWinsock::throwErrorOnSocket(ArchSocket s)
 {
@@ -654,6 +661,27 @@ ArchNetworkWinsock::setReuseAddrOnSocket(ArchSocket s, bool reuse)
 	return (oflag != 0);
 }
 
+bool
+ArchNetworkWinsock::setNotSentLowWaterOnSocket(ArchSocket, int)
+{
+	// winsock has no equivalent
+	return false;
+}
+
+int
+ArchNetworkWinsock::getUnsentOnSocket(ArchSocket)
+{
+	// winsock can't tell us
+	return -1;
+}
+
+int
+ArchNetworkWinsock::getPollFdOnSocket(ArchSocket)
+{
+	// a SOCKET isn't a descriptor poll() understands
+	return -1;
+}
+
 std::string
 ArchNetworkWinsock::getHostName()
 {
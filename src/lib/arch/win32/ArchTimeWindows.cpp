@@ -35,7 +35,7 @@
 
 typedef WINMMAPI DWORD (WINAPI *PTimeGetTime)(void);
 
-static double			s_freq       = 0.0;
+static UInt64			s_freq       = 0;
 static HINSTANCE		s_mmInstance = NULL;
 static PTimeGetTime		s_tgt        = NULL;
 
@@ -46,11 +46,11 @@ static PTimeGetTime		s_tgt        = NULL;
 
 ArchTimeWindows::ArchTimeWindows()
 {
-	assert(s_freq == 0.0 || s_mmInstance == NULL);
+	assert(s_freq == 0 || s_mmInstance == NULL);
 
 	LARGE_INTEGER freq;
 	if (QueryPerformanceFrequency(&freq) && freq.QuadPart != 0) {
-		s_freq = 1.0 / static_cast<double>(freq.QuadPart);
+		s_freq = static_cast<UInt64>(freq.QuadPart);
 	}
 	else {
 		// load winmm.dll and get timeGetTime
@@ -63,7 +63,7 @@ ArchTimeWindows::ArchTimeWindows()
 
 ArchTimeWindows::~ArchTimeWindows()
 {
-	s_freq = 0.0;
+	s_freq = 0;
 	if (s_mmInstance == NULL) {
 		FreeLibrary(reinterpret_cast<HMODULE>(s_mmInstance));
 		s_tgt        = NULL;
@@ -73,17 +73,33 @@ ArchTimeWindows::~ArchTimeWindows()
 
 double
 ArchTimeWindows::time()
+{
+	return 1.0e-9 * static_cast<double>(ticks());
+}
+
+UInt64
+ArchTimeWindows::ticks()
 {
 	// get time.  we try three ways, in order of descending precision
-	if (s_freq != 0.0) {
+	if (s_freq != 0) {
+		// split the conversion so it doesn't overflow
 		LARGE_INTEGER c;
 		QueryPerformanceCounter(&c);
-		return s_freq * static_cast<double>(c.QuadPart);
+		UInt64 count = static_cast<UInt64>(c.QuadPart);
+		return (count / s_freq) * 1000000000 +
+				(count % s_freq) * 1000000000 / s_freq;
 	}
 	else if (s_tgt != NULL) {
-		return 0.001 * static_cast<double>(s_tgt());
+		return static_cast<UInt64>(s_tgt()) * 1000000;
 	}
 	else {
-		return 0.001 * static_cast<double>(GetTickCount());
+		return static_cast<UInt64>(GetTickCount()) * 1000000;
 	}
 }
+
+UInt64
+ArchTimeWindows::coarseTicks()
+{
+	// the performance counter is cheap enough
+	return ticks();
+}
@@ -46,7 +46,8 @@ public:
 	enum {
 		kNone				= 0x00,	//!< No flags
 		kDeliverImmediately	= 0x01,	//!< Dispatch and free event immediately
-		kDontFreeData		= 0x02	//!< Don't free data in deleteData
+		kDontFreeData		= 0x02,	//!< Don't free data in deleteData
+		kCollapse			= 0x04	//!< Replace undelivered event, see IEventQueue::addEvent()
 	};
 
 	Event();
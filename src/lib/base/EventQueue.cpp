@@ -58,6 +58,14 @@ interrupt(Arch::ESignal, void* data)
 	events->addEvent(Event(Event::kQuit));
 }
 
+// convert a duration in seconds to ticks of the monotonic clock
+static
+UInt64
+toTicks(double seconds)
+{
+	return static_cast<UInt64>(seconds * 1.0e9 + 0.5);
+}
+
 
 //
 // EventQueue
@@ -65,27 +73,6 @@ interrupt(Arch::ESignal, void* data)
 
 EventQueue::EventQueue() :
 	m_systemTarget(0),
-	m_nextType(Event::kLast),
-	m_typesForClient(NULL),
-	m_typesForIStream(NULL),
-	m_typesForIpcClient(NULL),
-	m_typesForIpcClientProxy(NULL),
-	m_typesForIpcServer(NULL),
-	m_typesForIpcServerProxy(NULL),
-	m_typesForIDataSocket(NULL),
-	m_typesForIListenSocket(NULL),
-	m_typesForISocket(NULL),
-	m_typesForOSXScreen(NULL),
-	m_typesForClientListener(NULL),
-	m_typesForClientProxy(NULL),
-	m_typesForClientProxyUnknown(NULL),
-	m_typesForServer(NULL),
-	m_typesForServerApp(NULL),
-	m_typesForIKeyState(NULL),
-	m_typesForIPrimaryScreen(NULL),
-	m_typesForIScreen(NULL),
-	m_typesForClipboard(NULL),
-	m_typesForFile(NULL),
 	m_readyMutex(new Mutex),
 	m_readyCondVar(new CondVar<bool>(m_readyMutex, false))
 {
@@ -132,19 +119,6 @@ EventQueue::loop()
 	}
 }
 
-Event::Type
-EventQueue::registerTypeOnce(Event::Type& type, const char* name)
-{
-	ArchMutexLock lock(m_mutex);
-	if (type == Event::kUnknown) {
-		m_typeMap.insert(std::make_pair(m_nextType, name));
-		m_nameMap.insert(std::make_pair(name, m_nextType));
-		LOG((CLOG_DEBUG1 "registered event type %s as %d", name, m_nextType));
-		type = m_nextType++;
-	}
-	return type;
-}
-
 const char*
 EventQueue::getTypeName(Event::Type type)
 {
@@ -162,12 +136,12 @@ EventQueue::getTypeName(Event::Type type)
 		return "timer";
 
 	default:
-		TypeMap::const_iterator i = m_typeMap.find(type);
-		if (i == m_typeMap.end()) {
+		const char* name = EventTypes::getTypeName(type);
+		if (name == NULL) {
 			return "<unknown>";
 		}
 		else {
-			return i->second;
+			return name;
 		}
 	}
 }
@@ -192,6 +166,7 @@ EventQueue::adoptBuffer(IEventQueueBuffer* buffer)
 	}
 	m_events.clear();
 	m_oldEventIDs.clear();
+	m_collapsible.clear();
 
 	// use new buffer
 	m_buffer = buffer;
@@ -304,9 +279,24 @@ void
 EventQueue::addEventToBuffer(const Event& event)
 {
 	ArchMutexLock lock(m_mutex);
+
+	// replace an undelivered instance of a collapsible event
+	CollapseKey key(event.getType(), event.getTarget());
+	if ((event.getFlags() & Event::kCollapse) != 0) {
+		CollapseTable::iterator index = m_collapsible.find(key);
+		if (index != m_collapsible.end()) {
+			Event& queued = m_events[index->second];
+			Event::deleteData(queued);
+			queued = event;
+			return;
+		}
+	}
 	
 	// store the event's data locally
 	UInt32 eventID = saveEvent(event);
+	if ((event.getFlags() & Event::kCollapse) != 0) {
+		m_collapsible[key] = eventID;
+	}
 	
 	// add it
 	if (!m_buffer->addEvent(eventID)) {
@@ -327,11 +317,8 @@ EventQueue::newTimer(double duration, void* target)
 	}
 	ArchMutexLock lock(m_mutex);
 	m_timers.insert(timer);
-	// initial duration is requested duration plus whatever's on
-	// the clock currently because the latter will be subtracted
-	// the next time we check for timers.
-	m_timerQueue.push(Timer(timer, duration,
-							duration + m_time.getTime(), target, false));
+	m_timerQueue.push(Timer(timer, toTicks(duration),
+							ARCH->ticks(), target, false));
 	return timer;
 }
 
@@ -346,11 +333,8 @@ EventQueue::newOneShotTimer(double duration, void* target)
 	}
 	ArchMutexLock lock(m_mutex);
 	m_timers.insert(timer);
-	// initial duration is requested duration plus whatever's on
-	// the clock currently because the latter will be subtracted
-	// the next time we check for timers.
-	m_timerQueue.push(Timer(timer, duration,
-							duration + m_time.getTime(), target, true));
+	m_timerQueue.push(Timer(timer, toTicks(duration),
+							ARCH->ticks(), target, true));
 	return timer;
 }
 
@@ -478,6 +462,9 @@ EventQueue::removeEvent(UInt32 eventID)
 	// get data
 	Event event = index->second;
 	m_events.erase(index);
+	if ((event.getFlags() & Event::kCollapse) != 0) {
+		m_collapsible.erase(CollapseKey(event.getType(), event.getTarget()));
+	}
 
 	// save old id for reuse
 	m_oldEventIDs.push_back(eventID);
@@ -495,18 +482,9 @@ EventQueue::hasTimerExpired(Event& event)
 		return false;
 	}
 
-	// get time elapsed since last check
-	const double time = m_time.getTime();
-	m_time.reset();
-
-	// countdown elapsed time
-	for (TimerQueue::iterator index = m_timerQueue.begin();
-							index != m_timerQueue.end(); ++index) {
-		(*index) -= time;
-	}
-
 	// done if no timers are expired
-	if (m_timerQueue.top() > 0.0) {
+	const UInt64 now = ARCH->ticks();
+	if (m_timerQueue.top().getDeadline() > now) {
 		return false;
 	}
 
@@ -515,9 +493,9 @@ EventQueue::hasTimerExpired(Event& event)
 	m_timerQueue.pop();
 
 	// prepare event and reset the timer's clock
-	timer.fillEvent(m_timerEvent);
+	timer.fillEvent(m_timerEvent, now);
 	event = Event(Event::kTimer, timer.getTarget(), &m_timerEvent);
-	timer.reset();
+	timer.reset(now);
 
 	// reinsert timer into queue if it's not a one-shot
 	if (!timer.isOneShot()) {
@@ -536,20 +514,18 @@ EventQueue::getNextTimerTimeout() const
 	if (m_timerQueue.empty()) {
 		return -1.0;
 	}
-	if (m_timerQueue.top() <= 0.0) {
+	const UInt64 deadline = m_timerQueue.top().getDeadline();
+	const UInt64 now      = ARCH->ticks();
+	if (deadline <= now) {
 		return 0.0;
 	}
-	return m_timerQueue.top();
+	return 1.0e-9 * static_cast<double>(deadline - now);
 }
 
 Event::Type
 EventQueue::getRegisteredType(const String& name) const
 {
-	NameMap::const_iterator found = m_nameMap.find(name);
-	if (found != m_nameMap.end())
-		return found->second;
-
-	return Event::kUnknown;
+	return EventTypes::getTypeByName(name.c_str());
 }
 
 void*
@@ -576,15 +552,15 @@ EventQueue::waitForReady() const
 // EventQueue::Timer
 //
 
-EventQueue::Timer::Timer(EventQueueTimer* timer, double timeout,
-				double initialTime, void* target, bool oneShot) :
+EventQueue::Timer::Timer(EventQueueTimer* timer, UInt64 timeout,
+				UInt64 now, void* target, bool oneShot) :
 	m_timer(timer),
 	m_timeout(timeout),
 	m_target(target),
 	m_oneShot(oneShot),
-	m_time(initialTime)
+	m_deadline(now + timeout)
 {
-	assert(m_timeout > 0.0);
+	assert(m_timeout > 0);
 }
 
 EventQueue::Timer::~Timer()
@@ -593,21 +569,15 @@ EventQueue::Timer::~Timer()
 }
 
 void
-EventQueue::Timer::reset()
+EventQueue::Timer::reset(UInt64 now)
 {
-	m_time = m_timeout;
+	m_deadline = now + m_timeout;
 }
 
-EventQueue::Timer&
-EventQueue::Timer::operator-=(double dt)
+UInt64
+EventQueue::Timer::getDeadline() const
 {
-	m_time -= dt;
-	return *this;
-}
-
-EventQueue::Timer::operator double() const
-{
-	return m_time;
+	return m_deadline;
 }
 
 bool
@@ -629,17 +599,25 @@ EventQueue::Timer::getTarget() const
 }
 
 void
-EventQueue::Timer::fillEvent(TimerEvent& event) const
+EventQueue::Timer::fillEvent(TimerEvent& event, UInt64 now) const
 {
+	// the count includes any whole periods missed since the deadline
 	event.m_timer = m_timer;
 	event.m_count = 0;
-	if (m_time <= 0.0) {
-		event.m_count = static_cast<UInt32>((m_timeout - m_time) / m_timeout);
+	if (m_deadline <= now) {
+		event.m_count = static_cast<UInt32>(
+							(now - m_deadline + m_timeout) / m_timeout);
 	}
 }
 
 bool
 EventQueue::Timer::operator<(const Timer& t) const
 {
-	return m_time < t.m_time;
+	return m_deadline < t.m_deadline;
+}
+
+bool
+EventQueue::Timer::operator>(const Timer& t) const
+{
+	return m_deadline > t.m_deadline;
 }
@@ -22,8 +22,8 @@
 #include "arch/IArchMultithread.h"
 #include "base/IEventQueue.h"
 #include "base/Event.h"
+#include "base/EventTypes.h"
 #include "base/PriorityQueue.h"
-#include "base/Stopwatch.h"
 #include "common/stdmap.h"
 #include "common/stdset.h"
 
@@ -56,8 +56,6 @@ public:
 							void* target, IEventJob* handler);
 	virtual void		removeHandler(Event::Type type, void* target);
 	virtual void		removeHandlers(void* target);
-	virtual Event::Type
-						registerTypeOnce(Event::Type& type, const char* name);
 	virtual bool		isEmpty() const;
 	virtual IEventJob*	getHandler(Event::Type type, void* target) const;
 	virtual const char*	getTypeName(Event::Type type);
@@ -74,40 +72,42 @@ private:
 	void				addEventToBuffer(const Event& event);
 	
 private:
+	// timeouts and deadlines are in ticks of the monotonic clock
 	class Timer {
 	public:
-		Timer(EventQueueTimer*, double timeout, double initialTime,
+		Timer(EventQueueTimer*, UInt64 timeout, UInt64 now,
 							void* target, bool oneShot);
 		~Timer();
 
-		void			reset();
-
-		Timer&			operator-=(double);
+		//! Start the next period from \p now
+		void			reset(UInt64 now);
 
-						operator double() const;
+		//! Get the time the timer expires
+		UInt64			getDeadline() const;
 
 		bool			isOneShot() const;
 		EventQueueTimer*
 						getTimer() const;
 		void*			getTarget() const;
-		void			fillEvent(TimerEvent&) const;
+		void			fillEvent(TimerEvent&, UInt64 now) const;
 
 		bool			operator<(const Timer&) const;
+		bool			operator>(const Timer&) const;
 
 	private:
 		EventQueueTimer*	m_timer;
-		double				m_timeout;
+		UInt64				m_timeout;
 		void*				m_target;
 		bool				m_oneShot;
-		double				m_time;
+		UInt64				m_deadline;
 	};
 
 	typedef std::set<EventQueueTimer*> Timers;
 	typedef PriorityQueue<Timer> TimerQueue;
 	typedef std::map<UInt32, Event> EventTable;
 	typedef std::vector<UInt32> EventIDList;
-	typedef std::map<Event::Type, const char*> TypeMap;
-	typedef std::map<String, Event::Type> NameMap;
+	typedef std::pair<Event::Type, void*> CollapseKey;
+	typedef std::map<CollapseKey, UInt32> CollapseTable;
 	typedef std::map<Event::Type, IEventJob*> TypeHandlerTable;
 	typedef std::map<void*, TypeHandlerTable> HandlerTable;
 
@@ -115,10 +115,6 @@ private:
 	ArchMutex			m_mutex;
 
 	// registered events
-	Event::Type		m_nextType;
-	TypeMap			m_typeMap;
-	NameMap			m_nameMap;
-
 	// buffer of events
 	IEventQueueBuffer*	m_buffer;
 
@@ -126,8 +122,10 @@ private:
 	EventTable			m_events;
 	EventIDList		m_oldEventIDs;
 
+	// ids of queued collapsible events
+	CollapseTable		m_collapsible;
+
 	// timers
-	Stopwatch			m_time;
 	Timers				m_timers;
 	TimerQueue			m_timerQueue;
 	TimerEvent			m_timerEvent;
@@ -161,26 +159,26 @@ public:
 	FileEvents&					forFile();
 
 private:
-	ClientEvents*				m_typesForClient;
-	IStreamEvents*				m_typesForIStream;
-	IpcClientEvents*			m_typesForIpcClient;
-	IpcClientProxyEvents*		m_typesForIpcClientProxy;
-	IpcServerEvents*			m_typesForIpcServer;
-	IpcServerProxyEvents*		m_typesForIpcServerProxy;
-	IDataSocketEvents*			m_typesForIDataSocket;
-	IListenSocketEvents*		m_typesForIListenSocket;
-	ISocketEvents*				m_typesForISocket;
-	OSXScreenEvents*			m_typesForOSXScreen;
-	ClientListenerEvents*		m_typesForClientListener;
-	ClientProxyEvents*			m_typesForClientProxy;
-	ClientProxyUnknownEvents*	m_typesForClientProxyUnknown;
-	ServerEvents*				m_typesForServer;
-	ServerAppEvents*			m_typesForServerApp;
-	IKeyStateEvents*			m_typesForIKeyState;
-	IPrimaryScreenEvents*		m_typesForIPrimaryScreen;
-	IScreenEvents*				m_typesForIScreen;
-	ClipboardEvents*			m_typesForClipboard;
-	FileEvents*					m_typesForFile;
+	ClientEvents				m_typesForClient;
+	IStreamEvents				m_typesForIStream;
+	IpcClientEvents				m_typesForIpcClient;
+	IpcClientProxyEvents		m_typesForIpcClientProxy;
+	IpcServerEvents				m_typesForIpcServer;
+	IpcServerProxyEvents		m_typesForIpcServerProxy;
+	IDataSocketEvents			m_typesForIDataSocket;
+	IListenSocketEvents			m_typesForIListenSocket;
+	ISocketEvents				m_typesForISocket;
+	OSXScreenEvents				m_typesForOSXScreen;
+	ClientListenerEvents		m_typesForClientListener;
+	ClientProxyEvents			m_typesForClientProxy;
+	ClientProxyUnknownEvents	m_typesForClientProxyUnknown;
+	ServerEvents				m_typesForServer;
+	ServerAppEvents				m_typesForServerApp;
+	IKeyStateEvents				m_typesForIKeyState;
+	IPrimaryScreenEvents		m_typesForIPrimaryScreen;
+	IScreenEvents				m_typesForIScreen;
+	ClipboardEvents				m_typesForClipboard;
+	FileEvents					m_typesForFile;
 	Mutex*						m_readyMutex;
 	CondVar<bool>*				m_readyCondVar;
 	std::queue<Event>			m_pending;
@@ -189,9 +187,5 @@ private:
 #define EVENT_TYPE_ACCESSOR(type_)											\
 type_##Events&																\
 EventQueue::for##type_() {												\
-	if (m_typesFor##type_ == NULL) {										\
-		m_typesFor##type_ = new type_##Events();							\
-		m_typesFor##type_->setEvents(dynamic_cast<IEventQueue*>(this));		\
-	}																		\
-	return *m_typesFor##type_;												\
+	return m_typesFor##type_;												\
 }
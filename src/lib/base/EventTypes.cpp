@@ -16,186 +16,124 @@
  */
 
 #include "base/EventTypes.h"
-#include "base/IEventQueue.h"
 
-#include <assert.h>
 #include <stddef.h>
-
-EventTypes::EventTypes() :
-	m_events(NULL)
+#include <string.h>
+
+// names of the event types, in the order of EEventType
+static const char*		s_typeNames[] = {
+	"ClientEvents::connected",
+	"ClientEvents::connectionFailed",
+	"ClientEvents::disconnected",
+
+	"IStreamEvents::inputReady",
+	"IStreamEvents::outputFlushed",
+	"IStreamEvents::outputError",
+	"IStreamEvents::inputShutdown",
+	"IStreamEvents::outputShutdown",
+
+	"IpcClientEvents::connected",
+	"IpcClientEvents::messageReceived",
+
+	"IpcClientProxyEvents::messageReceived",
+	"IpcClientProxyEvents::disconnected",
+
+	"IpcServerProxyEvents::messageReceived",
+
+	"IDataSocketEvents::connected",
+	"IDataSocketEvents::connectionFailed",
+
+	"IListenSocketEvents::connecting",
+
+	"ISocketEvents::disconnected",
+	"ISocketEvents::stopRetry",
+
+	"OSXScreenEvents::confirmSleep",
+
+	"ClientListenerEvents::connected",
+
+	"ClientProxyEvents::ready",
+	"ClientProxyEvents::disconnected",
+
+	"ClientProxyUnknownEvents::success",
+	"ClientProxyUnknownEvents::failure",
+
+	"ServerEvents::error",
+	"ServerEvents::connected",
+	"ServerEvents::disconnected",
+	"ServerEvents::switchToScreen",
+	"ServerEvents::switchInDirection",
+	"ServerEvents::keyboardBroadcast",
+	"ServerEvents::lockCursorToScreen",
+	"ServerEvents::screenSwitched",
+	"ServerEvents::clipboardSent",
+	"ServerEvents::clipboardRefresh",
+	"ServerEvents::clipboardPrefetch",
+	"ServerEvents::clipboardMarshalled",
+	"ServerEvents::clipboardRefreshed",
+
+	"ServerAppEvents::reloadConfig",
+	"ServerAppEvents::forceReconnect",
+	"ServerAppEvents::resetServer",
+
+	"IKeyStateEvents::keyDown",
+	"IKeyStateEvents::keyUp",
+	"IKeyStateEvents::keyRepeat",
+
+	"IPrimaryScreenEvents::buttonDown",
+	"IPrimaryScreenEvents::buttonUp",
+	"IPrimaryScreenEvents::motionOnPrimary",
+	"IPrimaryScreenEvents::motionOnSecondary",
+	"IPrimaryScreenEvents::wheel",
+	"IPrimaryScreenEvents::screensaverActivated",
+	"IPrimaryScreenEvents::screensaverDeactivated",
+	"IPrimaryScreenEvents::hotKeyDown",
+	"IPrimaryScreenEvents::hotKeyUp",
+	"IPrimaryScreenEvents::fakeInputBegin",
+	"IPrimaryScreenEvents::fakeInputEnd",
+
+	"IScreenEvents::error",
+	"IScreenEvents::shapeChanged",
+	"IScreenEvents::suspend",
+	"IScreenEvents::resume",
+
+	"IpcServerEvents::clientConnected",
+	"IpcServerEvents::messageReceived",
+
+	"ClipboardEvents::clipboardGrabbed",
+	"ClipboardEvents::clipboardChanged",
+	"ClipboardEvents::clipboardSending",
+
+	"FileEvents::fileChunkSending",
+	"FileEvents::fileRecieveCompleted",
+	"FileEvents::keepAlive",
+	"FileEvents::fileTransferProgress",
+	"FileEvents::fileSendFinished",
+};
+
+static const size_t		kTypeCount = sizeof(s_typeNames) / sizeof(s_typeNames[0]);
+
+// fails to compile unless there's exactly one name per event type
+typedef char			TypeNamesMatchTypes[
+							kTypeCount == kEventTypeEnd - Event::kLast ? 1 : -1];
+
+const char*
+EventTypes::getTypeName(Event::Type type)
 {
+	if (type < static_cast<Event::Type>(Event::kLast) ||
+		type >= static_cast<Event::Type>(kEventTypeEnd)) {
+		return NULL;
+	}
+	return s_typeNames[type - Event::kLast];
 }
 
-IEventQueue*
-EventTypes::getEvents() const
+Event::Type
+EventTypes::getTypeByName(const char* name)
 {
-	assert(m_events != NULL);
-	return m_events;
+	for (size_t i = 0; i < kTypeCount; ++i) {
+		if (strcmp(s_typeNames[i], name) == 0) {
+			return static_cast<Event::Type>(Event::kLast + i);
+		}
+	}
+	return Event::kUnknown;
 }
-
-void
-EventTypes::setEvents(IEventQueue* events)
-{
-	m_events = events;
-}
-
-//
-// Client
-//
-
-REGISTER_EVENT(Client, connected)
-REGISTER_EVENT(Client, connectionFailed)
-REGISTER_EVENT(Client, disconnected)
-
-//
-// IStream
-//
-
-REGISTER_EVENT(IStream, inputReady)
-REGISTER_EVENT(IStream, outputFlushed)
-REGISTER_EVENT(IStream, outputError)
-REGISTER_EVENT(IStream, inputShutdown)
-REGISTER_EVENT(IStream, outputShutdown)
-
-//
-// IpcClient
-//
-
-REGISTER_EVENT(IpcClient, connected)
-REGISTER_EVENT(IpcClient, messageReceived)
-
-//
-// IpcClientProxy
-//
-
-REGISTER_EVENT(IpcClientProxy, messageReceived)
-REGISTER_EVENT(IpcClientProxy, disconnected)
-
-//
-// IpcServerProxy
-//
-
-REGISTER_EVENT(IpcServerProxy, messageReceived)
-
-//
-// IDataSocket
-//
-
-REGISTER_EVENT(IDataSocket, connected)
-REGISTER_EVENT(IDataSocket, connectionFailed)
-
-//
-// IListenSocket
-//
-
-REGISTER_EVENT(IListenSocket, connecting)
-
-//
-// ISocket
-//
-
-REGISTER_EVENT(ISocket, disconnected)
-REGISTER_EVENT(ISocket, stopRetry)
-
-//
-// OSXScreen
-//
-
-REGISTER_EVENT(OSXScreen, confirmSleep)
-
-//
-// ClientListener
-//
-
-REGISTER_EVENT(ClientListener, connected)
-
-//
-// ClientProxy
-//
-
-REGISTER_EVENT(ClientProxy, ready)
-REGISTER_EVENT(ClientProxy, disconnected)
-
-//
-// ClientProxyUnknown
-//
-
-REGISTER_EVENT(ClientProxyUnknown, success)
-REGISTER_EVENT(ClientProxyUnknown, failure)
-
-//
-// Server
-//
-
-REGISTER_EVENT(Server, error)
-REGISTER_EVENT(Server, connected)
-REGISTER_EVENT(Server, disconnected)
-REGISTER_EVENT(Server, switchToScreen)
-REGISTER_EVENT(Server, switchInDirection)
-REGISTER_EVENT(Server, keyboardBroadcast)
-REGISTER_EVENT(Server, lockCursorToScreen)
-REGISTER_EVENT(Server, screenSwitched)
-
-//
-// ServerApp
-//
-
-REGISTER_EVENT(ServerApp, reloadConfig)
-REGISTER_EVENT(ServerApp, forceReconnect)
-REGISTER_EVENT(ServerApp, resetServer)
-
-//
-// IKeyState
-//
-
-REGISTER_EVENT(IKeyState, keyDown)
-REGISTER_EVENT(IKeyState, keyUp)
-REGISTER_EVENT(IKeyState, keyRepeat)
-
-//
-// IPrimaryScreen
-//
-
-REGISTER_EVENT(IPrimaryScreen, buttonDown)
-REGISTER_EVENT(IPrimaryScreen, buttonUp)
-REGISTER_EVENT(IPrimaryScreen, motionOnPrimary)
-REGISTER_EVENT(IPrimaryScreen, motionOnSecondary)
-REGISTER_EVENT(IPrimaryScreen, wheel)
-REGISTER_EVENT(IPrimaryScreen, screensaverActivated)
-REGISTER_EVENT(IPrimaryScreen, screensaverDeactivated)
-REGISTER_EVENT(IPrimaryScreen, hotKeyDown)
-REGISTER_EVENT(IPrimaryScreen, hotKeyUp)
-REGISTER_EVENT(IPrimaryScreen, fakeInputBegin)
-REGISTER_EVENT(IPrimaryScreen, fakeInputEnd)
-
-//
-// IScreen
-//
-
-REGISTER_EVENT(IScreen, error)
-REGISTER_EVENT(IScreen, shapeChanged)
-REGISTER_EVENT(IScreen, suspend)
-REGISTER_EVENT(IScreen, resume)
-
-//
-// IpcServer
-//
-
-REGISTER_EVENT(IpcServer, clientConnected)
-REGISTER_EVENT(IpcServer, messageReceived)
-
-//
-// Clipboard
-//
-
-REGISTER_EVENT(Clipboard, clipboardGrabbed)
-REGISTER_EVENT(Clipboard, clipboardChanged)
-REGISTER_EVENT(Clipboard, clipboardSending)
-
-//
-// File
-//
-
-REGISTER_EVENT(File, fileChunkSending)
-REGISTER_EVENT(File, fileRecieveCompleted)
-REGISTER_EVENT(File, keepAlive)
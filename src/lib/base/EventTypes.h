@@ -19,34 +19,125 @@
 
 #include "base/Event.h"
 
-class IEventQueue;
+//! Event type ids
+/*!
+Every event type has an id fixed at compile time, so the accessors
+below are constants and checking an event's type is an integer compare.
+The names are in a static table in EventTypes.cpp, in the same order.
+*/
+enum EEventType {
+	kClientConnected = Event::kLast,
+	kClientConnectionFailed,
+	kClientDisconnected,
+
+	kIStreamInputReady,
+	kIStreamOutputFlushed,
+	kIStreamOutputError,
+	kIStreamInputShutdown,
+	kIStreamOutputShutdown,
+
+	kIpcClientConnected,
+	kIpcClientMessageReceived,
+
+	kIpcClientProxyMessageReceived,
+	kIpcClientProxyDisconnected,
+
+	kIpcServerProxyMessageReceived,
+
+	kIDataSocketConnected,
+	kIDataSocketConnectionFailed,
+
+	kIListenSocketConnecting,
+
+	kISocketDisconnected,
+	kISocketStopRetry,
+
+	kOSXScreenConfirmSleep,
+
+	kClientListenerConnected,
+
+	kClientProxyReady,
+	kClientProxyDisconnected,
+
+	kClientProxyUnknownSuccess,
+	kClientProxyUnknownFailure,
+
+	kServerError,
+	kServerConnected,
+	kServerDisconnected,
+	kServerSwitchToScreen,
+	kServerSwitchInDirection,
+	kServerKeyboardBroadcast,
+	kServerLockCursorToScreen,
+	kServerScreenSwitched,
+	kServerClipboardSent,
+	kServerClipboardRefresh,
+	kServerClipboardPrefetch,
+	kServerClipboardMarshalled,
+	kServerClipboardRefreshed,
+
+	kServerAppReloadConfig,
+	kServerAppForceReconnect,
+	kServerAppResetServer,
+
+	kIKeyStateKeyDown,
+	kIKeyStateKeyUp,
+	kIKeyStateKeyRepeat,
+
+	kIPrimaryScreenButtonDown,
+	kIPrimaryScreenButtonUp,
+	kIPrimaryScreenMotionOnPrimary,
+	kIPrimaryScreenMotionOnSecondary,
+	kIPrimaryScreenWheel,
+	kIPrimaryScreenScreensaverActivated,
+	kIPrimaryScreenScreensaverDeactivated,
+	kIPrimaryScreenHotKeyDown,
+	kIPrimaryScreenHotKeyUp,
+	kIPrimaryScreenFakeInputBegin,
+	kIPrimaryScreenFakeInputEnd,
+
+	kIScreenError,
+	kIScreenShapeChanged,
+	kIScreenSuspend,
+	kIScreenResume,
+
+	kIpcServerClientConnected,
+	kIpcServerMessageReceived,
+
+	kClipboardClipboardGrabbed,
+	kClipboardClipboardChanged,
+	kClipboardClipboardSending,
+
+	kFileFileChunkSending,
+	kFileFileRecieveCompleted,
+	kFileKeepAlive,
+	kFileFileTransferProgress,
+	kFileFileSendFinished,
+
+	kEventTypeEnd
+};
 
 class EventTypes {
 public:
-	EventTypes();
-	void				setEvents(IEventQueue* events);
-
-protected:
-	IEventQueue*		getEvents() const;
+	//! Get name of event type
+	/*!
+	Returns the name of \p type, or NULL if it isn't one of the types
+	above.
+	*/
+	static const char*	getTypeName(Event::Type type);
 
-private:
-	IEventQueue*		m_events;
+	//! Get event type by name
+	/*!
+	Returns the type with the given \p name, or \c Event::kUnknown if
+	there's none.  The name must be fully qualified, as returned by
+	getTypeName() (e.g. "IDataSocketEvents::connected"), since
+	the same name is used by several classes.
+	*/
+	static Event::Type	getTypeByName(const char* name);
 };
 
-#define REGISTER_EVENT(type_, name_)									\
-Event::Type															\
-type_##Events::name_()													\
-{																		\
-	return getEvents()->registerTypeOnce(m_##name_, __FUNCTION__);			\
-}
-
 class ClientEvents : public EventTypes {
 public:
-	ClientEvents() :
-		m_connected(Event::kUnknown),
-		m_connectionFailed(Event::kUnknown),
-		m_disconnected(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
@@ -55,14 +146,14 @@ public:
 	Returns the connected event type.  This is sent when the client has
 	successfully connected to the server.
 	*/
-	Event::Type		connected();
+	Event::Type		connected() { return kClientConnected; }
 
 	//! Get connection failed event type
 	/*!
 	Returns the connection failed event type.  This is sent when the
 	server fails for some reason.  The event data is a FailInfo*.
 	*/
-	Event::Type		connectionFailed();
+	Event::Type		connectionFailed() { return kClientConnectionFailed; }
 
 	//! Get disconnected event type
 	/*!
@@ -70,25 +161,13 @@ public:
 	has disconnected from the server (and only after having successfully
 	connected).
 	*/
-	Event::Type		disconnected();
+	Event::Type		disconnected() { return kClientDisconnected; }
 
 	//@}
-
-private:
-	Event::Type		m_connected;
-	Event::Type		m_connectionFailed;
-	Event::Type		m_disconnected;
 };
 
 class IStreamEvents : public EventTypes {
 public:
-	IStreamEvents() :
-		m_inputReady(Event::kUnknown),
-		m_outputFlushed(Event::kUnknown),
-		m_outputError(Event::kUnknown),
-		m_inputShutdown(Event::kUnknown),
-		m_outputShutdown(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
@@ -97,7 +176,7 @@ public:
 	Returns the input ready event type.  A stream sends this event
 	when \c read() will return with data.
 	*/
-	Event::Type		inputReady();
+	Event::Type		inputReady() { return kIStreamInputReady; }
 
 	//! Get output flushed event type
 	/*!
@@ -107,14 +186,14 @@ public:
 	\c close() will not discard any data and \c flush() will return
 	immediately.
 	*/
-	Event::Type		outputFlushed();
+	Event::Type		outputFlushed() { return kIStreamOutputFlushed; }
 
 	//! Get output error event type
 	/*!
 	Returns the output error event type.  A stream sends this event
 	when a write has failed.
 	*/
-	Event::Type		outputError();
+	Event::Type		outputError() { return kIStreamOutputError; }
 
 	//! Get input shutdown event type
 	/*!
@@ -122,7 +201,7 @@ public:
 	input side of the stream has shutdown.  When the input has
 	shutdown, no more data will ever be available to read.
 	*/
-	Event::Type		inputShutdown();
+	Event::Type		inputShutdown() { return kIStreamInputShutdown; }
 
 	//! Get output shutdown event type
 	/*!
@@ -131,107 +210,66 @@ public:
 	shutdown, no more data can ever be written to the stream.  Any
 	attempt to do so will generate a output error event.
 	*/
-	Event::Type		outputShutdown();
+	Event::Type		outputShutdown() { return kIStreamOutputShutdown; }
 
 	//@}
-		
-private:
-	Event::Type		m_inputReady;
-	Event::Type		m_outputFlushed;
-	Event::Type		m_outputError;
-	Event::Type		m_inputShutdown;
-	Event::Type		m_outputShutdown;
 };
 
 class IpcClientEvents : public EventTypes {
 public:
-	IpcClientEvents() :
-		m_connected(Event::kUnknown),
-		m_messageReceived(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
 	//! Raised when the socket is connected.
-	Event::Type		connected();
+	Event::Type		connected() { return kIpcClientConnected; }
 
 	//! Raised when a message is received.
-	Event::Type		messageReceived();
+	Event::Type		messageReceived() { return kIpcClientMessageReceived; }
 
 	//@}
-	
-private:
-	Event::Type		m_connected;
-	Event::Type		m_messageReceived;
 };
 
 class IpcClientProxyEvents : public EventTypes {
 public:
-	IpcClientProxyEvents() :
-		m_messageReceived(Event::kUnknown),
-		m_disconnected(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
 	//! Raised when the server receives a message from a client.
-	Event::Type		messageReceived();
+	Event::Type		messageReceived() { return kIpcClientProxyMessageReceived; }
 
 	//! Raised when the client disconnects from the server.
-	Event::Type		disconnected();
+	Event::Type		disconnected() { return kIpcClientProxyDisconnected; }
 		
 	//@}
-
-private:
-	Event::Type		m_messageReceived;
-	Event::Type		m_disconnected;
 };
 
 class IpcServerEvents : public EventTypes {
 public:
-	IpcServerEvents() :
-		m_clientConnected(Event::kUnknown),
-		m_messageReceived(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
 	//! Raised when we have created the client proxy.
-	Event::Type		clientConnected();
+	Event::Type		clientConnected() { return kIpcServerClientConnected; }
 	
 	//! Raised when a message is received through a client proxy.
-	Event::Type		messageReceived();
+	Event::Type		messageReceived() { return kIpcServerMessageReceived; }
 
 	//@}
-
-private:
-	Event::Type		m_clientConnected;
-	Event::Type		m_messageReceived;
 };
 
 class IpcServerProxyEvents : public EventTypes {
 public:
-	IpcServerProxyEvents() :
-		m_messageReceived(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
 	//! Raised when the client receives a message from the server.
-	Event::Type		messageReceived();
+	Event::Type		messageReceived() { return kIpcServerProxyMessageReceived; }
 
 	//@}
-
-private:
-	Event::Type		m_messageReceived;
 };
 
 class IDataSocketEvents : public EventTypes {
 public:
-	IDataSocketEvents() :
-		m_connected(Event::kUnknown),
-		m_connectionFailed(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
@@ -240,7 +278,7 @@ public:
 	Returns the socket connected event type.  A socket sends this
 	event when a remote connection has been established.
 	*/
-	Event::Type		connected();
+	Event::Type		connected() { return kIDataSocketConnected; }
 
 	//! Get connection failed event type
 	/*!
@@ -248,20 +286,13 @@ public:
 	this event when an attempt to connect to a remote port has failed.
 	The data is a pointer to a ConnectionFailedInfo.
 	*/
-	Event::Type		connectionFailed();
+	Event::Type		connectionFailed() { return kIDataSocketConnectionFailed; }
 
 	//@}
-
-private:
-	Event::Type		m_connected;
-	Event::Type		m_connectionFailed;
 };
 
 class IListenSocketEvents : public EventTypes {
 public:
-	IListenSocketEvents() :
-		m_connecting(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
@@ -270,20 +301,13 @@ public:
 	Returns the socket connecting event type.  A socket sends this
 	event when a remote connection is waiting to be accepted.
 	*/
-	Event::Type		connecting();
+	Event::Type		connecting() { return kIListenSocketConnecting; }
 
 	//@}
-
-private:
-	Event::Type		m_connecting;
 };
 
 class ISocketEvents : public EventTypes {
 public:
-	ISocketEvents() :
-		m_disconnected(Event::kUnknown),
-		m_stopRetry(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
@@ -293,43 +317,30 @@ public:
 	event when the remote side of the socket has disconnected or
 	shutdown both input and output.
 	*/
-	Event::Type		disconnected();
+	Event::Type		disconnected() { return kISocketDisconnected; }
 
 	//! Get stop retry event type
 	/*!
 	 Returns the stop retry event type.  This is sent when the client
 	 doesn't want to reconnect after it disconnects from the server.
 	 */
-	Event::Type		stopRetry();
+	Event::Type		stopRetry() { return kISocketStopRetry; }
 
 	//@}
-
-private:
-	Event::Type		m_disconnected;
-	Event::Type		m_stopRetry;
 };
 
 class OSXScreenEvents : public EventTypes {
 public:
-	OSXScreenEvents() :
-		m_confirmSleep(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
-	Event::Type		confirmSleep();
+	Event::Type		confirmSleep() { return kOSXScreenConfirmSleep; }
 
 	//@}
-
-private:
-	Event::Type		m_confirmSleep;
 };
 
 class ClientListenerEvents : public EventTypes {
 public:
-	ClientListenerEvents() :
-		m_connected(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 		
@@ -338,20 +349,13 @@ public:
 	Returns the connected event type.  This is sent whenever a
 	a client connects.
 	*/
-	Event::Type		connected();
+	Event::Type		connected() { return kClientListenerConnected; }
 
 	//@}
-
-private:
-	Event::Type		m_connected;
 };
 
 class ClientProxyEvents : public EventTypes {
 public:
-	ClientProxyEvents() :
-		m_ready(Event::kUnknown),
-		m_disconnected(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
@@ -361,28 +365,20 @@ public:
 	completed the initial handshake.  Until it is sent, the client is
 	not fully connected.
 	*/
-	Event::Type		ready();
+	Event::Type		ready() { return kClientProxyReady; }
 
 	//! Get disconnect event type
 	/*!
 	Returns the disconnect event type.  This is sent when the client
 	disconnects or is disconnected.  The target is getEventTarget().
 	*/
-	Event::Type		disconnected();
+	Event::Type		disconnected() { return kClientProxyDisconnected; }
 
 	//@}
-
-private:
-	Event::Type		m_ready;
-	Event::Type		m_disconnected;
 };
 
 class ClientProxyUnknownEvents : public EventTypes {
 public:
-	ClientProxyUnknownEvents() :
-		m_success(Event::kUnknown),
-		m_failure(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
@@ -391,34 +387,20 @@ public:
 	Returns the success event type.  This is sent when the client has
 	correctly responded to the hello message.  The target is this.
 	*/
-	Event::Type		success();
+	Event::Type		success() { return kClientProxyUnknownSuccess; }
 
 	//! Get failure event type
 	/*!
 	Returns the failure event type.  This is sent when a client fails
 	to correctly respond to the hello message.  The target is this.
 	*/
-	Event::Type		failure();
+	Event::Type		failure() { return kClientProxyUnknownFailure; }
 
 	//@}
-		
-private:
-	Event::Type		m_success;
-	Event::Type		m_failure;
 };
 
 class ServerEvents : public EventTypes {
 public:
-	ServerEvents() :
-		m_error(Event::kUnknown),
-		m_connected(Event::kUnknown),
-		m_disconnected(Event::kUnknown),
-		m_switchToScreen(Event::kUnknown),
-		m_switchInDirection(Event::kUnknown),
-		m_keyboardBroadcast(Event::kUnknown),
-		m_lockCursorToScreen(Event::kUnknown),
-		m_screenSwitched(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
@@ -427,7 +409,7 @@ public:
 	Returns the error event type.  This is sent when the server fails
 	for some reason.
 	*/
-	Event::Type		error();
+	Event::Type		error() { return kServerError; }
 
 	//! Get connected event type
 	/*!
@@ -435,14 +417,14 @@ public:
 	has connected.  The event data is a \c ScreenConnectedInfo* that
 	indicates the connected screen.
 	*/
-	Event::Type		connected();
+	Event::Type		connected() { return kServerConnected; }
 
 	//! Get disconnected event type
 	/*!
 	Returns the disconnected event type.  This is sent when all the
 	clients have disconnected.
 	*/
-	Event::Type		disconnected();
+	Event::Type		disconnected() { return kServerDisconnected; }
 
 	//! Get switch to screen event type
 	/*!
@@ -450,7 +432,7 @@ public:
 	by switching screens.  The event data is a \c SwitchToScreenInfo*
 	that indicates the target screen.
 	*/
-	Event::Type		switchToScreen();
+	Event::Type		switchToScreen() { return kServerSwitchToScreen; }
 
 	//! Get switch in direction event type
 	/*!
@@ -458,7 +440,7 @@ public:
 	by switching screens.  The event data is a \c SwitchInDirectionInfo*
 	that indicates the target direction.
 	*/
-	Event::Type		switchInDirection();
+	Event::Type		switchInDirection() { return kServerSwitchInDirection; }
 
 	//! Get keyboard broadcast event type
 	/*!
@@ -466,7 +448,7 @@ public:
 	to this by turning on keyboard broadcasting or turning it off.  The
 	event data is a \c KeyboardBroadcastInfo*.
 	*/
-	Event::Type		keyboardBroadcast();
+	Event::Type		keyboardBroadcast() { return kServerKeyboardBroadcast; }
 
 	//! Get lock cursor event type
 	/*!
@@ -474,159 +456,141 @@ public:
 	by locking the cursor to the active screen or unlocking it.  The
 	event data is a \c LockCursorToScreenInfo*.
 	*/
-	Event::Type		lockCursorToScreen();
+	Event::Type		lockCursorToScreen() { return kServerLockCursorToScreen; }
 
 	//! Get screen switched event type
 	/*!
 	Returns the screen switched event type.  This is raised when the
 	screen has been switched to a client.
 	*/
-	Event::Type		screenSwitched();
+	Event::Type		screenSwitched() { return kServerScreenSwitched; }
+
+	//! Get clipboard sent event type
+	/*!
+	Returns the clipboard sent event type.  This is sent by the thread
+	sending the clipboards to the active screen when it's done, whether
+	or not the send was interrupted.
+	*/
+	Event::Type		clipboardSent() { return kServerClipboardSent; }
+
+	//! Get clipboard refresh event type
+	/*!
+	Returns the clipboard refresh event type.  The server responds to
+	this by reading the clipboards owned by the primary screen and
+	sending them to the active screen.  It is posted when leaving the
+	primary screen so the switch doesn't wait for the clipboards.
+	*/
+	Event::Type		clipboardRefresh() { return kServerClipboardRefresh; }
+
+	//! Get clipboard prefetch event type
+	/*!
+	Returns the clipboard prefetch event type.  It is posted when the
+	cursor is predicted to cross to a neighbor soon.  The server
+	responds by starting to send the clipboards there, so reading them
+	doesn't hold up the motion that made the prediction.
+	*/
+	Event::Type		clipboardPrefetch() { return kServerClipboardPrefetch; }
+
+	//! Get clipboard marshalled event type
+	/*!
+	Returns the clipboard marshalled event type.  This is sent by the
+	server's bulk loop when it has marshalled a changed clipboard.  The
+	server responds by taking the new clipboard if it's still current.
+	*/
+	Event::Type		clipboardMarshalled() { return kServerClipboardMarshalled; }
+
+	//! Get clipboard refreshed event type
+	/*!
+	Returns the clipboard refreshed event type.  This is sent by the
+	server's bulk loop after the clipboards read for a refresh have
+	been marshalled.  The event data is the screen to send them to, or
+	NULL for the active screen, and isn't freed.
+	*/
+	Event::Type		clipboardRefreshed() { return kServerClipboardRefreshed; }
 
 	//@}
-		
-private:
-	Event::Type		m_error;
-	Event::Type		m_connected;
-	Event::Type		m_disconnected;
-	Event::Type		m_switchToScreen;
-	Event::Type		m_switchInDirection;
-	Event::Type		m_keyboardBroadcast;
-	Event::Type		m_lockCursorToScreen;
-	Event::Type		m_screenSwitched;
 };
 
 class ServerAppEvents : public EventTypes {
 public:
-	ServerAppEvents() :
-		m_reloadConfig(Event::kUnknown),
-		m_forceReconnect(Event::kUnknown),
-		m_resetServer(Event::kUnknown) { }
 		
 	//! @name accessors
 	//@{
 		
-	Event::Type		reloadConfig();
-	Event::Type		forceReconnect();
-	Event::Type		resetServer();
+	Event::Type		reloadConfig() { return kServerAppReloadConfig; }
+	Event::Type		forceReconnect() { return kServerAppForceReconnect; }
+	Event::Type		resetServer() { return kServerAppResetServer; }
 
 	//@}
-		
-private:
-	Event::Type		m_reloadConfig;
-	Event::Type		m_forceReconnect;
-	Event::Type		m_resetServer;
 };
 
 class IKeyStateEvents : public EventTypes {
 public:
-	IKeyStateEvents() :
-		m_keyDown(Event::kUnknown),
-		m_keyUp(Event::kUnknown),
-		m_keyRepeat(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
 	//! Get key down event type.  Event data is KeyInfo*, count == 1.
-	Event::Type		keyDown();
+	Event::Type		keyDown() { return kIKeyStateKeyDown; }
 
 	//! Get key up event type.  Event data is KeyInfo*, count == 1.
-	Event::Type		keyUp();
+	Event::Type		keyUp() { return kIKeyStateKeyUp; }
 
 	//! Get key repeat event type.  Event data is KeyInfo*.
-	Event::Type		keyRepeat();
+	Event::Type		keyRepeat() { return kIKeyStateKeyRepeat; }
 
 	//@}
-		
-private:
-	Event::Type		m_keyDown;
-	Event::Type		m_keyUp;
-	Event::Type		m_keyRepeat;
 };
 
 class IPrimaryScreenEvents : public EventTypes {
 public:
-	IPrimaryScreenEvents() :
-		m_buttonDown(Event::kUnknown),
-		m_buttonUp(Event::kUnknown),
-		m_motionOnPrimary(Event::kUnknown),
-		m_motionOnSecondary(Event::kUnknown),
-		m_wheel(Event::kUnknown),
-		m_screensaverActivated(Event::kUnknown),
-		m_screensaverDeactivated(Event::kUnknown),
-		m_hotKeyDown(Event::kUnknown),
-		m_hotKeyUp(Event::kUnknown),
-		m_fakeInputBegin(Event::kUnknown),
-		m_fakeInputEnd(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 	
 	//!  button down event type.  Event data is ButtonInfo*.
-	Event::Type		buttonDown();
+	Event::Type		buttonDown() { return kIPrimaryScreenButtonDown; }
 
 	//!  button up event type.  Event data is ButtonInfo*.
-	Event::Type		buttonUp();
+	Event::Type		buttonUp() { return kIPrimaryScreenButtonUp; }
 
 	//!  mouse motion on the primary screen event type
 	/*!
 	Event data is MotionInfo* and the values are an absolute position.
 	*/
-	Event::Type		motionOnPrimary();
+	Event::Type		motionOnPrimary() { return kIPrimaryScreenMotionOnPrimary; }
 
 	//!  mouse motion on a secondary screen event type
 	/*!
 	Event data is MotionInfo* and the values are motion deltas not
 	absolute coordinates.
 	*/
-	Event::Type		motionOnSecondary();
+	Event::Type		motionOnSecondary() { return kIPrimaryScreenMotionOnSecondary; }
 
 	//!  mouse wheel event type.  Event data is WheelInfo*.
-	Event::Type		wheel();
+	Event::Type		wheel() { return kIPrimaryScreenWheel; }
 
 	//!  screensaver activated event type
-	Event::Type		screensaverActivated();
+	Event::Type		screensaverActivated() { return kIPrimaryScreenScreensaverActivated; }
 
 	//!  screensaver deactivated event type
-	Event::Type		screensaverDeactivated();
+	Event::Type		screensaverDeactivated() { return kIPrimaryScreenScreensaverDeactivated; }
 
 	//!  hot key down event type.  Event data is HotKeyInfo*.
-	Event::Type		hotKeyDown();
+	Event::Type		hotKeyDown() { return kIPrimaryScreenHotKeyDown; }
 
 	//!  hot key up event type.  Event data is HotKeyInfo*.
-	Event::Type		hotKeyUp();
+	Event::Type		hotKeyUp() { return kIPrimaryScreenHotKeyUp; }
 
 	//!  start of fake input event type
-	Event::Type		fakeInputBegin();
+	Event::Type		fakeInputBegin() { return kIPrimaryScreenFakeInputBegin; }
 
 	//!  end of fake input event type
-	Event::Type		fakeInputEnd();
+	Event::Type		fakeInputEnd() { return kIPrimaryScreenFakeInputEnd; }
 
 	//@}
-
-private:
-	Event::Type		m_buttonDown;
-	Event::Type		m_buttonUp;
-	Event::Type		m_motionOnPrimary;
-	Event::Type		m_motionOnSecondary;
-	Event::Type		m_wheel;
-	Event::Type		m_screensaverActivated;
-	Event::Type		m_screensaverDeactivated;
-	Event::Type		m_hotKeyDown;
-	Event::Type		m_hotKeyUp;
-	Event::Type		m_fakeInputBegin;
-	Event::Type		m_fakeInputEnd;
 };
 
 class IScreenEvents : public EventTypes {
 public:
-	IScreenEvents() :
-		m_error(Event::kUnknown),
-		m_shapeChanged(Event::kUnknown),
-		m_suspend(Event::kUnknown),
-		m_resume(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
@@ -635,45 +599,34 @@ public:
 	Returns the error event type.  This is sent whenever the screen has
 	failed for some reason (e.g. the X Windows server died).
 	*/
-	Event::Type		error();
+	Event::Type		error() { return kIScreenError; }
 
 	//! Get shape changed event type
 	/*!
 	Returns the shape changed event type.  This is sent whenever the
 	screen's shape changes.
 	*/
-	Event::Type		shapeChanged();
+	Event::Type		shapeChanged() { return kIScreenShapeChanged; }
 
 	//! Get suspend event type
 	/*!
 	Returns the suspend event type. This is sent whenever the system goes
 	to sleep or a user session is deactivated (fast user switching).
 	*/
-	Event::Type		suspend();
+	Event::Type		suspend() { return kIScreenSuspend; }
 	
 	//! Get resume event type
 	/*!
 	Returns the resume event type. This is sent whenever the system wakes
 	up or a user session is activated (fast user switching).
 	*/
-	Event::Type		resume();
+	Event::Type		resume() { return kIScreenResume; }
 
 	//@}
-		
-private:
-	Event::Type		m_error;
-	Event::Type		m_shapeChanged;
-	Event::Type		m_suspend;
-	Event::Type		m_resume;
 };
 
 class ClipboardEvents : public EventTypes {
 public:
-	ClipboardEvents() :
-		m_clipboardGrabbed(Event::kUnknown),
-		m_clipboardChanged(Event::kUnknown),
-		m_clipboardSending(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
@@ -683,7 +636,7 @@ public:
 	clipboard is grabbed by some other application so we don't own it
 	anymore.  The data is a pointer to a ClipboardInfo.
 	*/
-	Event::Type		clipboardGrabbed();
+	Event::Type		clipboardGrabbed() { return kClipboardClipboardGrabbed; }
 
 	//! Get clipboard changed event type
 	/*!
@@ -691,46 +644,45 @@ public:
 	contents of the clipboard has changed.  The data is a pointer to a
 	IScreen::ClipboardInfo.
 	*/
-	Event::Type		clipboardChanged();
+	Event::Type		clipboardChanged() { return kClipboardClipboardChanged; }
 
 	//! Clipboard sending event type
 	/*!
 	Returns the clipboard sending event type. This is used to send 
 	clipboard chunks.
 	*/
-	Event::Type		clipboardSending();
+	Event::Type		clipboardSending() { return kClipboardClipboardSending; }
 
 	//@}
-
-private:
-	Event::Type		m_clipboardGrabbed;
-	Event::Type		m_clipboardChanged;
-	Event::Type		m_clipboardSending;
 };
 
 class FileEvents : public EventTypes {
 public:
-	FileEvents() :
-		m_fileChunkSending(Event::kUnknown),
-		m_fileRecieveCompleted(Event::kUnknown),
-		m_keepAlive(Event::kUnknown) { }
-
 	//! @name accessors
 	//@{
 
 	//! Sending a file chunk
-	Event::Type		fileChunkSending();
+	Event::Type		fileChunkSending() { return kFileFileChunkSending; }
 
 	//! Completed receiving a file
-	Event::Type		fileRecieveCompleted();
+	Event::Type		fileRecieveCompleted() { return kFileFileRecieveCompleted; }
 
 	//! Send a keep alive
-	Event::Type		keepAlive();
+	Event::Type		keepAlive() { return kFileKeepAlive; }
 
-	//@}
+	//! Progress of a file transfer
+	/*!
+	Sent periodically while sending files and when each file has been
+	sent.  The event data is a FileTransferProgress*.
+	*/
+	Event::Type		fileTransferProgress() { return kFileFileTransferProgress; }
 
-private:
-	Event::Type		m_fileChunkSending;
-	Event::Type		m_fileRecieveCompleted;
-	Event::Type		m_keepAlive;
+	//! Finished sending files
+	/*!
+	Sent by the thread sending files once it is done, whether or not
+	the files were all sent.
+	*/
+	Event::Type		fileSendFinished() { return kFileFileSendFinished; }
+
+	//@}
 };
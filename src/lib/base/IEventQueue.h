@@ -99,7 +99,12 @@ public:
 
 	//! Add event to queue
 	/*!
-	Adds \p event to the end of the queue.
+	Adds \p event to the end of the queue.  If \p event has the
+	\c Event::kCollapse flag and an undelivered event with that flag,
+	type and target is already queued then \p event replaces it in
+	place, and the replaced event's data is freed.  Use this for events
+	where only the latest matters, so a busy queue doesn't grow with
+	redundant copies.
 	*/
 	virtual void		addEvent(const Event& event) = 0;
 
@@ -168,16 +173,6 @@ public:
 	*/
 	virtual void		removeHandlers(void* target) = 0;
 
-	//! Creates a new event type
-	/*!
-	If \p type contains \c kUnknown then it is set to a unique event
-	type id otherwise it is left alone.  The final value of \p type
-	is returned.
-	*/
-	virtual Event::Type
-						registerTypeOnce(Event::Type& type,
-							const char* name) = 0;
-
 	//! Wait for event queue to become ready
 	/*!
 	Blocks on the current thread until the event queue is ready for events to
@@ -0,0 +1,217 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2013 Synergy Si Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/MemoryBudget.h"
+#include "base/Log.h"
+#include "arch/Arch.h"
+
+static const char*		s_categoryNames[] = {
+	"stream buffers",
+	"clipboards",
+	"file transfers"
+};
+
+//
+// MemoryBudget
+//
+
+MemoryBudget*			MemoryBudget::s_instance = NULL;
+
+MemoryBudget::MemoryBudget() :
+	m_limit(0),
+	m_total(0),
+	m_warned(false)
+{
+	assert(s_instance == NULL);
+
+	for (int i = 0; i < kNumCategories; ++i) {
+		m_used[i] = 0;
+	}
+	m_mutex    = ARCH->newMutex();
+	s_instance = this;
+}
+
+MemoryBudget::~MemoryBudget()
+{
+	s_instance = NULL;
+	ARCH->closeMutex(m_mutex);
+}
+
+void
+MemoryBudget::setLimit(size_t bytes)
+{
+	if (s_instance == NULL) {
+		return;
+	}
+
+	ArchMutexLock lock(s_instance->m_mutex);
+	s_instance->m_limit  = bytes;
+	s_instance->m_warned = false;
+}
+
+bool
+MemoryBudget::reserve(ECategory category, size_t bytes)
+{
+	if (s_instance == NULL) {
+		return true;
+	}
+
+	{
+		ArchMutexLock lock(s_instance->m_mutex);
+		if (s_instance->m_limit == 0 ||
+			s_instance->m_total + bytes <= s_instance->m_limit) {
+			s_instance->m_used[category] += bytes;
+			s_instance->m_total          += bytes;
+			return true;
+		}
+	}
+
+	s_instance->checkExhausted();
+	return false;
+}
+
+void
+MemoryBudget::charge(ECategory category, size_t bytes)
+{
+	if (s_instance == NULL) {
+		return;
+	}
+
+	{
+		ArchMutexLock lock(s_instance->m_mutex);
+		s_instance->m_used[category] += bytes;
+		s_instance->m_total          += bytes;
+		if (s_instance->m_limit == 0 ||
+			s_instance->m_total < s_instance->m_limit) {
+			return;
+		}
+	}
+
+	s_instance->checkExhausted();
+}
+
+void
+MemoryBudget::release(ECategory category, size_t bytes)
+{
+	if (s_instance == NULL) {
+		return;
+	}
+
+	ArchMutexLock lock(s_instance->m_mutex);
+
+	// memory charged before the budget existed may be released after,
+	// so don't underflow
+	if (bytes > s_instance->m_used[category]) {
+		bytes = s_instance->m_used[category];
+	}
+	s_instance->m_used[category] -= bytes;
+	s_instance->m_total          -= bytes;
+
+	// warn again next time only once well clear of the limit
+	if (s_instance->m_total < s_instance->m_limit / 4 * 3) {
+		s_instance->m_warned = false;
+	}
+}
+
+bool
+MemoryBudget::isExhausted()
+{
+	if (s_instance == NULL) {
+		return false;
+	}
+
+	ArchMutexLock lock(s_instance->m_mutex);
+	return (s_instance->m_limit != 0 &&
+			s_instance->m_total >= s_instance->m_limit);
+}
+
+bool
+MemoryBudget::isAvailable(size_t bytes)
+{
+	if (s_instance == NULL) {
+		return true;
+	}
+
+	ArchMutexLock lock(s_instance->m_mutex);
+	return (s_instance->m_limit == 0 ||
+			s_instance->m_total + bytes <= s_instance->m_limit);
+}
+
+size_t
+MemoryBudget::getUsed(ECategory category)
+{
+	if (s_instance == NULL) {
+		return 0;
+	}
+
+	ArchMutexLock lock(s_instance->m_mutex);
+	return s_instance->m_used[category];
+}
+
+size_t
+MemoryBudget::getUsed()
+{
+	if (s_instance == NULL) {
+		return 0;
+	}
+
+	ArchMutexLock lock(s_instance->m_mutex);
+	return s_instance->m_total;
+}
+
+size_t
+MemoryBudget::getLimit()
+{
+	if (s_instance == NULL) {
+		return 0;
+	}
+
+	ArchMutexLock lock(s_instance->m_mutex);
+	return s_instance->m_limit;
+}
+
+const char*
+MemoryBudget::getCategoryName(ECategory category)
+{
+	assert(category >= 0 && category < kNumCategories);
+	return s_categoryNames[category];
+}
+
+void
+MemoryBudget::checkExhausted()
+{
+	size_t used[kNumCategories];
+	size_t limit;
+	{
+		ArchMutexLock lock(m_mutex);
+		if (m_warned) {
+			return;
+		}
+		m_warned = true;
+		limit    = m_limit;
+		for (int i = 0; i < kNumCategories; ++i) {
+			used[i] = m_used[i];
+		}
+	}
+
+	// log outside the lock;  log outputters may send over the network
+	LOG((CLOG_WARN "memory limit of %u kB reached: %s %u kB, %s %u kB, %s %u kB",
+		(unsigned int)(limit / 1024),
+		s_categoryNames[kStreamBuffers], (unsigned int)(used[kStreamBuffers] / 1024),
+		s_categoryNames[kClipboards], (unsigned int)(used[kClipboards] / 1024),
+		s_categoryNames[kFileTransfers], (unsigned int)(used[kFileTransfers] / 1024)));
+}
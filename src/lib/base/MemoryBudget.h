@@ -0,0 +1,127 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2013 Synergy Si Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "arch/IArchMultithread.h"
+#include "common/basic_types.h"
+
+#include <cstddef>
+
+//! Process-wide memory budget
+/*!
+This class accounts for the memory held by stream buffers, clipboard
+copies and file transfers, the things that grow with the size of the
+data users copy around.  Producers reserve() before allocating and
+back off or reject the work when the budget is exhausted.  Memory that
+can't be refused (because it's already been read off a socket, say) is
+charge()d instead, which always succeeds but counts toward the limit.
+
+Like Log there's one instance per process;  the static methods act on
+it.  When no instance exists, or the limit is zero, nothing is
+accounted and every reservation succeeds.  All methods are thread safe.
+*/
+class MemoryBudget {
+public:
+	//! Accounting categories
+	enum ECategory {
+		kStreamBuffers,			//!< Socket input and output buffers
+		kClipboards,			//!< Clipboard copies and chunks
+		kFileTransfers,			//!< File transfer chunks
+		kNumCategories
+	};
+
+	MemoryBudget();
+	~MemoryBudget();
+
+	//! @name manipulators
+	//@{
+
+	//! Set the limit
+	/*!
+	Sets the budget to \p bytes.  Zero means unlimited.
+	*/
+	static void			setLimit(size_t bytes);
+
+	//! Reserve memory
+	/*!
+	Accounts \p bytes against \p category if that doesn't take the
+	total past the limit and returns true.  Otherwise accounts nothing
+	and returns false.
+	*/
+	static bool			reserve(ECategory category, size_t bytes);
+
+	//! Charge memory
+	/*!
+	Accounts \p bytes against \p category even if that takes the total
+	past the limit.
+	*/
+	static void			charge(ECategory category, size_t bytes);
+
+	//! Release memory
+	/*!
+	Returns \p bytes previously reserved or charged to \p category.
+	*/
+	static void			release(ECategory category, size_t bytes);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Test if the budget is used up
+	/*!
+	Returns true if the total in use is at or past the limit.
+	Producers should stop producing until it isn't.
+	*/
+	static bool			isExhausted();
+
+	//! Test if memory is available
+	/*!
+	Returns true if \p bytes could be reserved right now.  Use this to
+	refuse work up front, before any of it is received.
+	*/
+	static bool			isAvailable(size_t bytes);
+
+	//! Get memory in use by a category
+	static size_t		getUsed(ECategory category);
+
+	//! Get total memory in use
+	static size_t		getUsed();
+
+	//! Get the limit
+	/*!
+	Returns the limit in bytes, or zero if unlimited.
+	*/
+	static size_t		getLimit();
+
+	//! Get the name of a category
+	static const char*	getCategoryName(ECategory category);
+
+	//@}
+
+private:
+	void				checkExhausted();
+
+private:
+	static MemoryBudget* s_instance;
+
+	ArchMutex			m_mutex;
+	size_t				m_limit;
+	size_t				m_total;
+	size_t				m_used[kNumCategories];
+	bool				m_warned;
+};
@@ -24,12 +24,12 @@
 //
 
 Stopwatch::Stopwatch(bool triggered) :
-	m_mark(0.0),
+	m_mark(0),
 	m_triggered(triggered),
 	m_stopped(triggered)
 {
 	if (!triggered) {
-		m_mark = ARCH->time();
+		m_mark = getClock();
 	}
 }
 
@@ -42,15 +42,15 @@ double
 Stopwatch::reset()
 {
 	if (m_stopped) {
-		const double dt = m_mark;
-		m_mark = 0.0;
-		return dt;
+		const UInt64 dt = m_mark;
+		m_mark = 0;
+		return toSeconds(dt);
 	}
 	else {
-		const double t	= ARCH->time();
-		const double dt = t - m_mark;
+		const UInt64 t  = getClock();
+		const UInt64 dt = t - m_mark;
 		m_mark = t;
-		return dt;
+		return toSeconds(dt);
 	}
 }
 
@@ -62,7 +62,7 @@ Stopwatch::stop()
 	}
 
 	// save the elapsed time
-	m_mark	  = ARCH->time() - m_mark;
+	m_mark	  = getClock() - m_mark;
 	m_stopped = true;
 }
 
@@ -75,7 +75,7 @@ Stopwatch::start()
 	}
 
 	// set the mark such that it reports the time elapsed at stop()
-	m_mark	  = ARCH->time() - m_mark;
+	m_mark	  = getClock() - m_mark;
 	m_stopped = false;
 }
 
@@ -90,15 +90,15 @@ double
 Stopwatch::getTime()
 {
 	if (m_triggered) {
-		const double dt = m_mark;
+		const UInt64 dt = m_mark;
 		start();
-		return dt;
+		return toSeconds(dt);
 	}
 	else if (m_stopped) {
-		return m_mark;
+		return toSeconds(m_mark);
 	}
 	else {
-		return ARCH->time() - m_mark;
+		return toSeconds(getClock() - m_mark);
 	}
 }
 
@@ -117,10 +117,10 @@ double
 Stopwatch::getTime() const
 {
 	if (m_stopped) {
-		return m_mark;
+		return toSeconds(m_mark);
 	}
 	else {
-		return ARCH->time() - m_mark;
+		return toSeconds(getClock() - m_mark);
 	}
 }
 
@@ -128,3 +128,15 @@ Stopwatch::operator double() const
 {
 	return getTime();
 }
+
+UInt64
+Stopwatch::getClock() const
+{
+	return ARCH->ticks();
+}
+
+double
+Stopwatch::toSeconds(UInt64 ticks)
+{
+	return 1.0e-9 * static_cast<double>(ticks);
+}
@@ -19,11 +19,13 @@
 #pragma once
 
 #include "common/common.h"
+#include "common/basic_types.h"
 
 //! A timer class
 /*!
 This class measures time intervals.  All time interval measurement
-should use this class.
+should use this class.  It counts whole ticks of the monotonic clock,
+so it isn't affected by changes to the wall clock.
 */
 class Stopwatch {
 public:
@@ -100,10 +102,12 @@ public:
 	//@}
 
 private:
-	double				getClock() const;
+	UInt64				getClock() const;
+	static double		toSeconds(UInt64 ticks);
 
 private:
-	double				m_mark;
+	// the start time while running, the elapsed time while stopped
+	UInt64				m_mark;
 	bool				m_triggered;
 	bool				m_stopped;
 };
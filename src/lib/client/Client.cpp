@@ -20,6 +20,7 @@
 
 #include "../plugin/ns/SecureSocket.h"
 #include "client/ServerProxy.h"
+#include "client/StandbyConnection.h"
 #include "synergy/Screen.h"
 #include "synergy/Clipboard.h"
 #include "synergy/FileChunk.h"
@@ -29,11 +30,14 @@
 #include "synergy/protocol_types.h"
 #include "synergy/XSynergy.h"
 #include "synergy/StreamChunker.h"
+#include "synergy/TokenBucket.h"
 #include "synergy/IPlatformScreen.h"
 #include "mt/Thread.h"
 #include "net/TCPSocket.h"
 #include "net/IDataSocket.h"
 #include "net/ISocketFactory.h"
+#include "net/XSocket.h"
+#include "io/IFileSender.h"
 #include "arch/Arch.h"
 #include "base/Log.h"
 #include "base/IEventQueue.h"
@@ -60,6 +64,9 @@ Client::Client(
 	m_mock(false),
 	m_name(name),
 	m_serverAddress(address),
+	m_serverIndex(0),
+	m_standby(NULL),
+	m_standbyIndex(0),
 	m_socketFactory(socketFactory),
 	m_screen(screen),
 	m_stream(NULL),
@@ -72,10 +79,15 @@ Client::Client(
 	m_events(events),
 	m_sendFileThread(NULL),
 	m_writeToDropDirThread(NULL),
+	m_fileResumePending(false),
 	m_socket(NULL),
 	m_useSecureNetwork(false),
 	m_args(args),
-	m_sendClipboardThread(NULL)
+	m_sendClipboardThread(NULL),
+	m_bandwidth(new TokenBucket),
+	m_sendFromFile(false),
+	m_dragInfoTimer(NULL),
+	m_dragInfoCount(0)
 {
 	assert(m_socketFactory != NULL);
 	assert(m_screen        != NULL);
@@ -91,6 +103,7 @@ Client::Client(
 								&Client::handleResume));
 
 	if (m_args.m_enableDragDrop) {
+		StreamChunker::init();
 		m_events->adoptHandler(m_events->forFile().fileChunkSending(),
 								this,
 								new TMethodEventJob<Client>(this,
@@ -99,6 +112,14 @@ Client::Client(
 								this,
 								new TMethodEventJob<Client>(this,
 									&Client::handleFileRecieveCompleted));
+		m_events->adoptHandler(m_events->forFile().fileTransferProgress(),
+								this,
+								new TMethodEventJob<Client>(this,
+									&Client::handleFileTransferProgress));
+		m_events->adoptHandler(m_events->forFile().fileSendFinished(),
+								this,
+								new TMethodEventJob<Client>(this,
+									&Client::handleFileSendFinished));
 	}
 
 	if (m_args.m_enableCrypto) {
@@ -107,6 +128,18 @@ Client::Client(
 			LOG((CLOG_NOTE "crypto disabled because of ns plugin not available"));
 		}
 	}
+
+	// the given server comes first, then the standbys in order
+	m_serverAddresses.push_back(m_serverAddress);
+	for (size_t i = 0; i < m_args.m_standbyAddresses.size(); ++i) {
+		try {
+			m_serverAddresses.push_back(NetworkAddress(
+				m_args.m_standbyAddresses[i], kDefaultPort));
+		}
+		catch (XSocketAddress& e) {
+			LOG((CLOG_WARN "ignoring standby server: %s", e.what()));
+		}
+	}
 }
 
 Client::~Client()
@@ -120,11 +153,18 @@ Client::~Client()
 	m_events->removeHandler(m_events->forIScreen().resume(),
 							  getEventTarget());
 
+	if (m_dragInfoTimer != NULL) {
+		m_events->removeHandler(Event::kTimer, m_dragInfoTimer);
+		m_events->deleteTimer(m_dragInfoTimer);
+	}
+
 	cleanupTimer();
 	cleanupScreen();
+	cleanupStandby();
 	cleanupConnecting();
 	cleanupConnection();
 	delete m_socketFactory;
+	delete m_bandwidth;
 }
 
 void
@@ -186,6 +226,7 @@ Client::disconnect(const char* msg)
 	m_connectOnResume = false;
 	cleanupTimer();
 	cleanupScreen();
+	cleanupStandby();
 	cleanupConnecting();
 	cleanupConnection();
 	if (msg != NULL) {
@@ -196,12 +237,29 @@ Client::disconnect(const char* msg)
 	}
 }
 
+void
+Client::serverLost(const char* msg)
+{
+	if (!failover()) {
+		disconnect(msg);
+	}
+}
+
 void
 Client::handshakeComplete()
 {
 	m_ready = true;
 	m_screen->enable();
 	sendEvent(m_events->forClient().connected(), NULL);
+	setupStandby();
+
+	// ask the server to finish a file it was sending when we lost it
+	if (m_args.m_enableDragDrop) {
+		FileTransferResume resume;
+		if (m_fileReceive.getResumePoint(resume)) {
+			m_server->fileResumeRequest(resume);
+		}
+	}
 }
 
 bool
@@ -272,14 +330,15 @@ Client::leave()
 		m_sendClipboardThread = NULL;
 	}
 
+	StreamChunker::resetClipboardInterrupt();
 	m_sendClipboardThread = new Thread(
 								new TMethodJob<Client>(
 									this,
 									&Client::sendClipboardThread,
 									NULL));
 
-	if (!m_receivedFileData.empty()) {
-		m_receivedFileData.clear();
+	if (!m_fileReceive.getData().empty()) {
+		m_fileReceive.abortTransfer();
 		LOG((CLOG_DEBUG "file transmission interrupted"));
 	}
 
@@ -303,9 +362,14 @@ Client::grabClipboard(ClipboardID id)
 }
 
 void
-Client::setClipboardDirty(ClipboardID, bool)
+Client::setClipboardDirty(ClipboardID id, bool dirty)
 {
-	assert(0 && "shouldn't be called");
+	// the server couldn't apply our last update.  send the clipboard
+	// again on the next leave even if it hasn't changed.
+	if (dirty) {
+		m_sentClipboard[id] = false;
+		m_timeClipboard[id] = 0;
+	}
 }
 
 void
@@ -436,10 +500,25 @@ Client::sendFileChunk(const void* data)
 {
 	FileChunk* chunk = reinterpret_cast<FileChunk*>(const_cast<void*>(data));
 	LOG((CLOG_DEBUG1 "send file chunk"));
-	assert(m_server != NULL);
+
+	// stop sending if the connection was lost.  the server can ask to
+	// resume once we're back.
+	if (m_server == NULL) {
+		StreamChunker::interruptFile();
+		StreamChunker::fileChunkSent(chunk->m_dataSize);
+		return;
+	}
+
+	// the server needs the file names before the files
+	if (m_dragInfoTimer != NULL) {
+		sendPendingDragInfo();
+	}
 
 	// relay
 	m_server->fileChunkSending(chunk->m_chunk[0], &chunk->m_chunk[1], chunk->m_dataSize);
+
+	// let the sender thread queue more data
+	StreamChunker::fileChunkSent(chunk->m_dataSize);
 }
 
 void
@@ -583,24 +662,94 @@ Client::cleanupStream()
 	// PacketStreamFilter doen't adopt secure socket, because
 	// we need to tell the dynamic lib that allocated this object
 	// to do the deletion.
-	if (m_useSecureNetwork) {
-		ARCH->plugin().invoke(s_pluginNames[kSecureSocket], "deleteSocket", NULL);
+	if (m_useSecureNetwork && m_socket != NULL) {
+		void* args[2] = { m_socket, NULL };
+		ARCH->plugin().invoke(s_pluginNames[kSecureSocket], "deleteSocket", args);
 	}
+	m_socket = NULL;
 }
 
 void
-Client::handleConnected(const Event&, void*)
+Client::setupStandby()
 {
-	LOG((CLOG_DEBUG1 "connected;  wait for hello"));
-	cleanupConnecting();
+	if (m_standby != NULL || m_serverAddresses.size() < 2) {
+		return;
+	}
+
+	m_standbyIndex = (m_serverIndex + 1) % m_serverAddresses.size();
+	m_standby = new StandbyConnection(m_serverAddresses[m_standbyIndex],
+							m_socketFactory, m_useSecureNetwork, m_events);
+}
+
+void
+Client::cleanupStandby()
+{
+	delete m_standby;
+	m_standby = NULL;
+}
+
+bool
+Client::failover()
+{
+	if (m_standby == NULL) {
+		return false;
+	}
+
+	if (!m_standby->isReady()) {
+		// reconnect to the standby server first
+		cleanupStandby();
+		nextServer();
+		return false;
+	}
+
+	LOG((CLOG_NOTE "lost server, switching to standby '%s'",
+		m_standby->getAddress().getHostname().c_str()));
+	cleanupTimer();
+	cleanupScreen();
+	cleanupConnection();
+
+	// take over the standby connection.  the server's hello is already
+	// waiting so we can answer it without another round trip.
+	m_stream        = m_standby->orphanStream(m_socket);
+	m_serverIndex   = m_standbyIndex;
+	m_serverAddress = m_standby->getAddress();
+	cleanupStandby();
+
 	setupConnection();
+	resetClipboards();
+	handleHello(Event(), NULL);
+	return true;
+}
 
-	// reset clipboard state
+void
+Client::nextServer()
+{
+	if (m_serverAddresses.size() < 2) {
+		return;
+	}
+
+	m_serverIndex   = (m_serverIndex + 1) % m_serverAddresses.size();
+	m_serverAddress = m_serverAddresses[m_serverIndex];
+	LOG((CLOG_DEBUG "next server is '%s'", m_serverAddress.getHostname().c_str()));
+}
+
+void
+Client::resetClipboards()
+{
 	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
 		m_ownClipboard[id]  = false;
 		m_sentClipboard[id] = false;
 		m_timeClipboard[id] = 0;
 	}
+}
+
+void
+Client::handleConnected(const Event&, void*)
+{
+	LOG((CLOG_DEBUG1 "connected;  wait for hello"));
+	cleanupConnecting();
+	setupConnection();
+	resetClipboards();
 
 	m_socket->secureConnect();
 }
@@ -615,6 +764,7 @@ Client::handleConnectionFailed(const Event& event, void*)
 	cleanupConnecting();
 	cleanupStream();
 	LOG((CLOG_DEBUG1 "connection failed"));
+	nextServer();
 	sendConnectionFailedEvent(info->m_what.c_str());
 	delete info;
 }
@@ -627,12 +777,17 @@ Client::handleConnectTimeout(const Event&, void*)
 	cleanupConnection();
 	cleanupStream();
 	LOG((CLOG_DEBUG1 "connection timed out"));
+	nextServer();
 	sendConnectionFailedEvent("Timed out");
 }
 
 void
 Client::handleOutputError(const Event&, void*)
 {
+	if (failover()) {
+		return;
+	}
+
 	cleanupTimer();
 	cleanupScreen();
 	cleanupConnection();
@@ -643,6 +798,10 @@ Client::handleOutputError(const Event&, void*)
 void
 Client::handleDisconnected(const Event&, void*)
 {
+	if (failover()) {
+		return;
+	}
+
 	cleanupTimer();
 	cleanupScreen();
 	cleanupConnection();
@@ -742,22 +901,55 @@ Client::handleResume(const Event&, void*)
 void
 Client::handleFileChunkSending(const Event& event, void*)
 {
-	sendFileChunk(event.getData());
+	sendFileChunk(static_cast<FileChunk*>(event.getDataObject()));
 }
 
 void
 Client::handleFileRecieveCompleted(const Event& event, void*)
 {
-	onFileRecieveCompleted();
+	onFileRecieveCompleted(static_cast<FileReceived*>(event.getDataObject()));
 }
 
 void
-Client::onFileRecieveCompleted()
+Client::handleFileTransferProgress(const Event& event, void*)
 {
-	if (isReceivedFileSizeValid()) {
+	FileTransferProgress* progress =
+		static_cast<FileTransferProgress*>(event.getDataObject());
+
+	LOG((CLOG_DEBUG "sending file %u/%u, sent=%s total=%s rate=%.1fkB/s",
+		progress->m_fileIndex + 1, progress->m_fileCount,
+		synergy::string::sizeTypeToString(progress->m_bytesSent).c_str(),
+		synergy::string::sizeTypeToString(progress->m_bytesTotal).c_str(),
+		progress->m_bytesPerSecond / 1024.0));
+}
+
+void
+Client::handleFileSendFinished(const Event&, void*)
+{
+	if (m_fileResumePending && m_sendFileThread == NULL) {
+		startFileResume();
+	}
+}
+
+void
+Client::onFileRecieveCompleted(FileReceived* received)
+{
+	UInt32 index = received->m_fileIndex;
+
+	if (index < m_dragFileList.size()) {
+		// hand the data over to the writer so the next file in the
+		// session can be received while this one is written
+		DroppedFile* file = new DroppedFile(
+								m_dragFileList.at(index).getFilename());
+		file->m_data.swap(received->m_data);
+
 		m_writeToDropDirThread = new Thread(
 			new TMethodJob<Client>(
-				this, &Client::writeToDropDirThread));
+				this, &Client::writeToDropDirThread, file));
+	}
+
+	if (index + 1 >= m_dragFileList.size()) {
+		m_dragFileList.clear();
 	}
 }
 
@@ -781,16 +973,20 @@ Client::handleStopRetry(const Event&, void*)
 }
 
 void
-Client::writeToDropDirThread(void*)
+Client::writeToDropDirThread(void* data)
 {
 	LOG((CLOG_DEBUG "starting write to drop dir thread"));
 
+	DroppedFile* file = reinterpret_cast<DroppedFile*>(data);
+
 	while (m_screen->isFakeDraggingStarted()) {
 		ARCH->sleep(.1f);
 	}
 	
-	DropHelper::writeToDir(m_screen->getDropTarget(), m_dragFileList,
-					m_receivedFileData);
+	DropHelper::writeToDir(m_screen->getDropTarget(), file->m_filename,
+					file->m_data);
+
+	delete file;
 }
 
 void
@@ -807,41 +1003,143 @@ Client::dragInfoReceived(UInt32 fileNum, String data)
 	m_screen->startDraggingFiles(m_dragFileList);
 }
 
-bool
-Client::isReceivedFileSizeValid()
+void
+Client::sendFileToServer(const char* filename)
 {
-	return m_expectedFileSize == m_receivedFileData.size();
+	String name(filename);
+	DragInformation di;
+	di.setFilename(name);
+	DragFileList fileList;
+	fileList.push_back(di);
+
+	sendFilesToServer(fileList);
 }
 
 void
-Client::sendFileToServer(const char* filename)
+Client::sendFilesToServer(const DragFileList& fileList)
 {
 	if (m_sendFileThread != NULL) {
 		StreamChunker::interruptFile();
 	}
 	
+	// remember the session so the server can ask to resume it.  the
+	// thread owns its copy.
+	m_fileSession = StreamChunker::newSession(fileList);
+	m_sendFromFile = (synergy::getFileSender(m_stream) != NULL);
 	m_sendFileThread = new Thread(
 		new TMethodJob<Client>(
 			this, &Client::sendFileThread,
-			reinterpret_cast<void*>(const_cast<char*>(filename))));
+			new FileTransferSession(m_fileSession)));
 }
 
 void
-Client::sendFileThread(void* filename)
+Client::sendFileThread(void* data)
 {
+	FileTransferSession* session = reinterpret_cast<FileTransferSession*>(data);
+
 	try {
-		char* name  = reinterpret_cast<char*>(filename);
-		StreamChunker::sendFile(name, m_events, this);
+		StreamChunker::sendFiles(*session, m_events, this, m_bandwidth,
+			m_sendFromFile);
 	}
 	catch (std::runtime_error error) {
 		LOG((CLOG_ERR "failed sending file chunks: %s", error.what()));
 	}
 
+	delete session;
 	m_sendFileThread = NULL;
+	m_events->addEvent(Event(m_events->forFile().fileSendFinished(), this));
+}
+
+void
+Client::fileResumeRequested(const FileTransferResume& resume)
+{
+	if (!m_args.m_enableDragDrop) {
+		LOG((CLOG_DEBUG "drag drop not enabled, ignoring file resume."));
+		return;
+	}
+
+	m_fileSession.m_resume = resume;
+	m_fileResumePending = true;
+
+	// stop the old transfer and continue once its thread is done, so
+	// their chunks don't mix
+	if (m_sendFileThread != NULL) {
+		StreamChunker::interruptFile();
+		return;
+	}
+
+	startFileResume();
+}
+
+void
+Client::startFileResume()
+{
+	m_fileResumePending = false;
+	m_sendFromFile = (synergy::getFileSender(m_stream) != NULL);
+
+	// the thread owns its copy of the session
+	m_sendFileThread = new Thread(
+		new TMethodJob<Client>(
+			this, &Client::resumeFileThread,
+			new FileTransferSession(m_fileSession)));
+}
+
+void
+Client::resumeFileThread(void* data)
+{
+	FileTransferSession* session = reinterpret_cast<FileTransferSession*>(data);
+
+	try {
+		StreamChunker::resumeFiles(*session, m_events, this, m_bandwidth,
+			m_sendFromFile);
+	}
+	catch (std::runtime_error error) {
+		LOG((CLOG_ERR "failed resuming file chunks: %s", error.what()));
+	}
+
+	delete session;
+	m_sendFileThread = NULL;
+	m_events->addEvent(Event(m_events->forFile().fileSendFinished(), this));
 }
 
 void
 Client::sendDragInfo(UInt32 fileCount, String& info, size_t size)
 {
-	m_server->sendDragInfo(fileCount, info.c_str(), size);
+	// a newer drag replaces one still waiting to be sent
+	m_dragInfoCount = fileCount;
+	m_dragInfo.assign(info.c_str(), size);
+
+	double wait = m_bandwidth->take(size);
+	if (wait <= 0.0) {
+		sendPendingDragInfo();
+	}
+	else if (m_dragInfoTimer == NULL) {
+		// wait on a timer rather than hold up the event thread
+		m_dragInfoTimer = m_events->newOneShotTimer(wait, NULL);
+		m_events->adoptHandler(Event::kTimer, m_dragInfoTimer,
+							new TMethodEventJob<Client>(this,
+								&Client::handleDragInfoTimer));
+	}
+}
+
+void
+Client::handleDragInfoTimer(const Event&, void*)
+{
+	sendPendingDragInfo();
+}
+
+void
+Client::sendPendingDragInfo()
+{
+	if (m_dragInfoTimer != NULL) {
+		m_events->removeHandler(Event::kTimer, m_dragInfoTimer);
+		m_events->deleteTimer(m_dragInfoTimer);
+		m_dragInfoTimer = NULL;
+	}
+
+	if (m_server != NULL && !m_dragInfo.empty()) {
+		m_server->sendDragInfo(m_dragInfoCount, m_dragInfo.c_str(),
+			m_dragInfo.size());
+	}
+	m_dragInfo.clear();
 }
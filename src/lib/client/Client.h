@@ -22,14 +22,19 @@
 
 #include "synergy/IClipboard.h"
 #include "synergy/DragInformation.h"
+#include "synergy/FileChunk.h"
+#include "synergy/StreamChunker.h"
 #include "synergy/INode.h"
 #include "synergy/ClientArgs.h"
 #include "net/NetworkAddress.h"
 #include "base/EventTypes.h"
+#include "common/stdvector.h"
 
 class EventQueueTimer;
 namespace synergy { class Screen; }
 class ServerProxy;
+class StandbyConnection;
+class TokenBucket;
 class IDataSocket;
 class ISocketFactory;
 namespace synergy { class IStream; }
@@ -54,7 +59,8 @@ public:
 	/*!
 	This client will attempt to connect to the server using \p name
 	as its name and \p address as the server's address and \p factory
-	to create the socket.  \p screen is	the local screen.
+	to create the socket.  \p screen is	the local screen.  The
+	standby servers in \p args are used if the server goes down.
 	*/
 	Client(IEventQueue* events,
 							const String& name, const NetworkAddress& address,
@@ -63,6 +69,10 @@ public:
 							ClientArgs& args);
 	~Client();
 
+#ifdef TEST_ENV
+	Client(ClientArgs& args) : m_mock(true), m_args(args) { }
+#endif
+
 	//! @name manipulators
 	//@{
 
@@ -79,6 +89,14 @@ public:
 	*/
 	void				disconnect(const char* msg);
 
+	//! Notify of lost server
+	/*!
+	Called when the server stops responding or closes the connection.
+	Switches to the standby server if its connection is ready,
+	otherwise disconnects with the optional error message.
+	*/
+	void				serverLost(const char* msg);
+
 	//! Notify of handshake complete
 	/*!
 	Notifies the client that the connection handshake has completed.
@@ -90,8 +108,25 @@ public:
 
 	//! Create a new thread and use it to send file to Server
 	void				sendFileToServer(const char* filename);
+
+	//! Create a new thread and use it to send files to Server
+	/*!
+	Sends every file in \p fileList as a single transfer session.
+	*/
+	void				sendFilesToServer(const DragFileList& fileList);
+
+	//! Resume sending files to Server
+	/*!
+	Called when the server asks to resume an unfinished transfer after
+	reconnecting.
+	*/
+	void				fileResumeRequested(const FileTransferResume& resume);
 	
 	//! Send dragging file information back to server
+	/*!
+	The information is held back on a timer while the bandwidth limit
+	is in debt, and goes before any file chunk sent after it.
+	*/
 	void				sendDragInfo(UInt32 fileCount, String& info, size_t size);
 	
 	//@}
@@ -118,18 +153,19 @@ public:
 	*/
 	NetworkAddress		getServerAddress() const;
 	
-	//! Return true if recieved file size is valid
-	bool				isReceivedFileSizeValid();
-
-	//! Return expected file size
-	size_t&				getExpectedFileSize() { return m_expectedFileSize; }
-
-	//! Return received file data
-	String&				getReceivedFileData() { return m_receivedFileData; }
+	//! Return the file being received from the server
+	FileReceiveState&	getFileReceiveState() { return m_fileReceive; }
 
 	//! Return drag file list
 	DragFileList		getDragFileList() { return m_dragFileList; }
 
+	//! Return bulk data rate limit
+	/*!
+	Returns the bucket that paces clipboard and file data sent to the
+	server.  The rate is set by the server's options.
+	*/
+	TokenBucket*		getBandwidth() const { return m_bandwidth; }
+
 	//@}
 
 	// IScreen overrides
@@ -167,6 +203,8 @@ private:
 	void				sendConnectionFailedEvent(const char* msg);
 	void				sendFileChunk(const void* data);
 	void				sendFileThread(void*);
+	void				resumeFileThread(void*);
+	void				startFileResume();
 	void				writeToDropDirThread(void*);
 	void				setupConnecting();
 	void				setupConnection();
@@ -177,6 +215,11 @@ private:
 	void				cleanupScreen();
 	void				cleanupTimer();
 	void				cleanupStream();
+	void				setupStandby();
+	void				cleanupStandby();
+	bool				failover();
+	void				nextServer();
+	void				resetClipboards();
 	void				handleConnected(const Event&, void*);
 	void				handleConnectionFailed(const Event&, void*);
 	void				handleConnectTimeout(const Event&, void*);
@@ -189,8 +232,12 @@ private:
 	void				handleResume(const Event& event, void*);
 	void				handleFileChunkSending(const Event&, void*);
 	void				handleFileRecieveCompleted(const Event&, void*);
+	void				handleFileTransferProgress(const Event&, void*);
+	void				handleFileSendFinished(const Event&, void*);
+	void				handleDragInfoTimer(const Event&, void*);
+	void				sendPendingDragInfo();
 	void				handleStopRetry(const Event&, void*);
-	void				onFileRecieveCompleted();
+	void				onFileRecieveCompleted(FileReceived*);
 	void				sendClipboardThread(void*);
 
 public:
@@ -199,6 +246,10 @@ public:
 private:
 	String				m_name;
 	NetworkAddress		m_serverAddress;
+	std::vector<NetworkAddress>	m_serverAddresses;
+	size_t				m_serverIndex;
+	StandbyConnection*	m_standby;
+	size_t				m_standbyIndex;
 	ISocketFactory*		m_socketFactory;
 	synergy::Screen*	m_screen;
 	synergy::IStream*	m_stream;
@@ -213,14 +264,22 @@ private:
 	IClipboard::Time	m_timeClipboard[kClipboardEnd];
 	String				m_dataClipboard[kClipboardEnd];
 	IEventQueue*		m_events;
-	std::size_t			m_expectedFileSize;
-	String				m_receivedFileData;
+	FileReceiveState	m_fileReceive;
 	DragFileList		m_dragFileList;
 	String				m_dragFileExt;
 	Thread*				m_sendFileThread;
 	Thread*				m_writeToDropDirThread;
+	FileTransferSession	m_fileSession;
+	bool				m_fileResumePending;
 	TCPSocket*			m_socket;
 	bool				m_useSecureNetwork;
 	ClientArgs&			m_args;
 	Thread*				m_sendClipboardThread;
+	TokenBucket*		m_bandwidth;
+	bool				m_sendFromFile;
+
+	// drag information waiting for bandwidth
+	EventQueueTimer*	m_dragInfoTimer;
+	UInt32				m_dragInfoCount;
+	String				m_dragInfo;
 };
@@ -22,6 +22,7 @@
 #include "synergy/FileChunk.h"
 #include "synergy/ClipboardChunk.h"
 #include "synergy/StreamChunker.h"
+#include "synergy/TokenBucket.h"
 #include "synergy/Clipboard.h"
 #include "synergy/ProtocolUtil.h"
 #include "synergy/option_types.h"
@@ -34,6 +35,15 @@
 
 #include <memory>
 
+static
+bool
+isRepeatableKey(KeyID id)
+{
+	// modifiers and locks never auto-repeat
+	return !((id >= kKeyShift_L && id <= kKeyHyper_R) ||
+			id == kKeyAltGr || id == kKeyNumLock || id == kKeyScrollLock);
+}
+
 //
 // ServerProxy
 //
@@ -51,6 +61,13 @@ ServerProxy::ServerProxy(Client* client, synergy::IStream* stream, IEventQueue*
 	m_ignoreMouse(false),
 	m_keepAliveAlarm(0.0),
 	m_keepAliveAlarmTimer(NULL),
+	m_keyRepeatLocal(false),
+	m_keyRepeatDelay(kKeyRepeatDelay),
+	m_keyRepeatRate(kKeyRepeatRate),
+	m_repeatKey(kKeyNone),
+	m_repeatMask(0),
+	m_repeatButton(0),
+	m_keyRepeatTimer(NULL),
 	m_parser(&ServerProxy::parseHandshakeMessage),
 	m_events(events)
 {
@@ -78,6 +95,7 @@ ServerProxy::ServerProxy(Client* client, synergy::IStream* stream, IEventQueue*
 
 ServerProxy::~ServerProxy()
 {
+	stopKeyRepeat();
 	setKeepAliveRate(-1.0);
 	m_events->removeHandler(m_events->forIStream().inputReady(),
 							m_stream->getEventTarget());
@@ -107,12 +125,50 @@ ServerProxy::setKeepAliveRate(double rate)
 	resetKeepAliveAlarm();
 }
 
+void
+ServerProxy::startKeyRepeat(KeyID id, KeyModifierMask mask, KeyButton button)
+{
+	m_repeatKey    = id;
+	m_repeatMask   = mask;
+	m_repeatButton = button;
+	setKeyRepeatTimer(m_keyRepeatDelay);
+}
+
+void
+ServerProxy::stopKeyRepeat()
+{
+	if (m_keyRepeatTimer != NULL) {
+		m_events->removeHandler(Event::kTimer, m_keyRepeatTimer);
+		m_events->deleteTimer(m_keyRepeatTimer);
+		m_keyRepeatTimer = NULL;
+	}
+	m_repeatKey    = kKeyNone;
+	m_repeatMask   = 0;
+	m_repeatButton = 0;
+}
+
+void
+ServerProxy::setKeyRepeatTimer(double timeout)
+{
+	if (m_keyRepeatTimer != NULL) {
+		m_events->removeHandler(Event::kTimer, m_keyRepeatTimer);
+		m_events->deleteTimer(m_keyRepeatTimer);
+	}
+	m_keyRepeatTimer = m_events->newOneShotTimer(timeout, NULL);
+	m_events->adoptHandler(Event::kTimer, m_keyRepeatTimer,
+							new TMethodEventJob<ServerProxy>(this,
+								&ServerProxy::handleKeyRepeat));
+}
+
 void
 ServerProxy::handleData(const Event&, void*)
 {
 	// handle messages until there are no more.  first read message code.
 	UInt8 code[4];
 	UInt32 n = m_stream->read(code, 4);
+	if (n != 0) {
+		m_lastMessage.reset();
+	}
 	while (n != 0) {
 		// verify we got an entire code
 		if (n != 4) {
@@ -179,7 +235,7 @@ ServerProxy::parseHandshakeMessage(const UInt8* code)
 	else if (memcmp(code, kMsgCClose, 4) == 0) {
 		// server wants us to hangup
 		LOG((CLOG_DEBUG1 "recv close"));
-		m_client->disconnect(NULL);
+		m_client->serverLost(NULL);
 		return kDisconnect;
 	}
 
@@ -303,11 +359,17 @@ ServerProxy::parseMessage(const UInt8* code)
 	else if (memcmp(code, kMsgDDragInfo, 4) == 0) {
 		dragInfoReceived();
 	}
+	else if (memcmp(code, kMsgDFileResume, 4) == 0) {
+		fileResumeReceived();
+	}
+	else if (memcmp(code, kMsgDClipboardAck, 4) == 0) {
+		clipboardAckReceived();
+	}
 
 	else if (memcmp(code, kMsgCClose, 4) == 0) {
 		// server wants us to hangup
 		LOG((CLOG_DEBUG1 "recv close"));
-		m_client->disconnect(NULL);
+		m_client->serverLost(NULL);
 		return kDisconnect;
 	}
 	else if (memcmp(code, kMsgEBad, 4) == 0) {
@@ -335,7 +397,25 @@ void
 ServerProxy::handleKeepAliveAlarm(const Event&, void*)
 {
 	LOG((CLOG_NOTE "server is dead"));
-	m_client->disconnect("server is not responding");
+	m_client->serverLost("server is not responding");
+}
+
+void
+ServerProxy::handleKeyRepeat(const Event&, void*)
+{
+	// the server tells us every kKeyRepeatHoldRate seconds that the key
+	// is still held.  if we haven't heard from it in a while then the
+	// connection has stalled and the release may never arrive, so stop
+	// rather than repeat forever.
+	if (m_lastMessage.getTime() > kKeyRepeatTimeout) {
+		LOG((CLOG_DEBUG "no message from server in %.3fs, stop repeating key id=0x%08x", m_lastMessage.getTime(), m_repeatKey));
+		stopKeyRepeat();
+		return;
+	}
+
+	LOG((CLOG_DEBUG2 "local key repeat id=0x%08x, mask=0x%04x, button=0x%04x", m_repeatKey, m_repeatMask, m_repeatButton));
+	m_client->keyRepeat(m_repeatKey, m_repeatMask, 1, m_repeatButton);
+	setKeyRepeatTimer(1.0 / m_keyRepeatRate);
 }
 
 void
@@ -363,7 +443,18 @@ ServerProxy::onClipboardChanged(ClipboardID id, const IClipboard* clipboard)
 	String data = IClipboard::marshall(clipboard);
 	LOG((CLOG_DEBUG "sending clipboard %d seqnum=%d", id, m_seqNum));
 
-	StreamChunker::sendClipboard(data, data.size(), id, m_seqNum, m_events, this);
+	String delta;
+	UInt32 baseHash = 0;
+	UInt32 targetHash = 0;
+	if (m_clipboardHistory.prepareSend(id, data, delta, baseHash, targetHash)) {
+		LOG((CLOG_DEBUG "sending clipboard %d as delta size=%d", id, delta.size()));
+		StreamChunker::sendClipboardDelta(delta, baseHash, targetHash,
+			id, m_seqNum, m_events, this, m_client->getBandwidth());
+	}
+	else {
+		StreamChunker::sendClipboard(data, data.size(), id, m_seqNum, m_events, this,
+			m_client->getBandwidth());
+	}
 
 	LOG((CLOG_DEBUG "sent clipboard size=%d", data.size()));
 }
@@ -530,6 +621,9 @@ ServerProxy::enter()
 	m_dyMouse               = 0;
 	m_seqNum                = seqNum;
 
+	// keys held on another screen don't repeat here
+	stopKeyRepeat();
+
 	// forward
 	m_client->enter(x, y, seqNum, static_cast<KeyModifierMask>(mask), false);
 }
@@ -543,6 +637,9 @@ ServerProxy::leave()
 	// send last mouse motion
 	flushCompressedMouse();
 
+	// stop repeating any held key
+	stopKeyRepeat();
+
 	// forward
 	m_client->leave();
 }
@@ -551,18 +648,23 @@ void
 ServerProxy::setClipboard()
 {
 	// parse
-	static String dataCached;
 	ClipboardID id;
 	UInt32 seq;
 	
-	int r = ClipboardChunk::assemble(m_stream, dataCached, id, seq);
+	int r = ClipboardChunk::assemble(m_stream, m_clipboardReceive, id, seq);
 
 	if (r == kStart) {
-		size_t size = ClipboardChunk::getExpectedSize();
+		size_t size = m_clipboardReceive.getExpectedSize();
 		LOG((CLOG_DEBUG "receiving clipboard %d size=%d", id, size));
 	}
 	else if (r == kFinish) {
+		String& dataCached = m_clipboardReceive.getData();
 		LOG((CLOG_DEBUG "received clipboard %d size=%d", id, dataCached.size()));
+
+		if (!clipboardReceived(id, dataCached)) {
+			LOG((CLOG_WARN "dropped clipboard %d, could not apply delta", id));
+			return;
+		}
 		
 		// forward
 		Clipboard clipboard;
@@ -573,6 +675,44 @@ ServerProxy::setClipboard()
 	}
 }
 
+bool
+ServerProxy::clipboardReceived(ClipboardID id, String& data)
+{
+	UInt32 hash;
+	if (m_clipboardReceive.isDelta()) {
+		hash = m_clipboardHistory.receivedDelta(id, data,
+					m_clipboardReceive.getBaseHash(),
+					m_clipboardReceive.getTargetHash());
+	}
+	else {
+		hash = m_clipboardHistory.receivedFull(id, data);
+	}
+
+	LOG((CLOG_DEBUG2 "send clipboard %d ack hash=%08x", id, hash));
+	ProtocolUtil::writef(m_stream, kMsgDClipboardAck, id, hash);
+	return (hash != 0);
+}
+
+void
+ServerProxy::clipboardAckReceived()
+{
+	// parse
+	ClipboardID id;
+	UInt32 hash;
+	ProtocolUtil::readf(m_stream, kMsgDClipboardAck + 4, &id, &hash);
+	LOG((CLOG_DEBUG2 "recv clipboard %d ack hash=%08x", id, hash));
+
+	// validate
+	if (id >= kClipboardEnd) {
+		return;
+	}
+
+	if (!m_clipboardHistory.acknowledged(id, hash)) {
+		// the server missed this update.  send it in full next time.
+		m_client->setClipboardDirty(id, true);
+	}
+}
+
 void
 ServerProxy::grabClipboard()
 {
@@ -612,6 +752,11 @@ ServerProxy::keyDown()
 
 	// forward
 	m_client->keyDown(id2, mask2, button);
+
+	// the most recently pressed key is the one that repeats
+	if (m_keyRepeatLocal && isRepeatableKey(id2)) {
+		startKeyRepeat(id2, mask2, button);
+	}
 }
 
 void
@@ -657,6 +802,11 @@ ServerProxy::keyUp()
 		mask2 != static_cast<KeyModifierMask>(mask))
 		LOG((CLOG_DEBUG1 "key up translated to id=0x%08x, mask=0x%04x", id2, mask2));
 
+	// stop repeating the key before releasing it
+	if (m_keyRepeatTimer != NULL && button == m_repeatButton) {
+		stopKeyRepeat();
+	}
+
 	// forward
 	m_client->keyUp(id2, mask2, button);
 }
@@ -793,6 +943,15 @@ ServerProxy::resetOptions()
 	// reset keep alive
 	setKeepAliveRate(kKeepAliveRate);
 
+	// reset key repeat
+	stopKeyRepeat();
+	m_keyRepeatLocal = false;
+	m_keyRepeatDelay = kKeyRepeatDelay;
+	m_keyRepeatRate  = kKeyRepeatRate;
+
+	// reset bandwidth limit
+	m_client->getBandwidth()->setRate(0.0);
+
 	// reset modifier translation table
 	for (KeyModifierID id = 0; id < kKeyModifierIDLast; ++id) {
 		m_modifierTranslationTable[id] = id;
@@ -810,7 +969,10 @@ ServerProxy::setOptions()
 	// forward
 	m_client->setOptions(options);
 
-	// update modifier table
+	// update modifier table.  the bandwidth limit may be sent twice,
+	// once for this screen and once globally;  the lower one wins.
+	bool hasBandwidth = false;
+	UInt32 bandwidth  = 0;
 	for (UInt32 i = 0, n = (UInt32)options.size(); i < n; i += 2) {
 		KeyModifierID id = kKeyModifierIDNull;
 		if (options[i] == kOptionModifierMapForShift) {
@@ -835,12 +997,40 @@ ServerProxy::setOptions()
 			// update keep alive
 			setKeepAliveRate(1.0e-3 * static_cast<double>(options[i + 1]));
 		}
+		else if (options[i] == kOptionClientKeyRepeat) {
+			m_keyRepeatLocal = (options[i + 1] != 0);
+			if (!m_keyRepeatLocal) {
+				stopKeyRepeat();
+			}
+			LOG((CLOG_DEBUG1 "local key repeat %s", m_keyRepeatLocal ? "on" : "off"));
+		}
+		else if (options[i] == kOptionKeyRepeatDelay) {
+			SInt32 delay = static_cast<SInt32>(options[i + 1]);
+			m_keyRepeatDelay = (delay > 0) ? 1.0e-3 * delay : kKeyRepeatDelay;
+		}
+		else if (options[i] == kOptionKeyRepeatRate) {
+			SInt32 rate = static_cast<SInt32>(options[i + 1]);
+			m_keyRepeatRate = (rate > 0) ? static_cast<double>(rate) : kKeyRepeatRate;
+		}
+		else if (options[i] == kOptionBandwidthLimit) {
+			UInt32 limit = options[i + 1];
+			if (limit != 0 && (bandwidth == 0 || limit < bandwidth)) {
+				bandwidth = limit;
+			}
+			hasBandwidth = true;
+		}
 		if (id != kKeyModifierIDNull) {
 			m_modifierTranslationTable[id] =
 				static_cast<KeyModifierID>(options[i + 1]);
 			LOG((CLOG_DEBUG1 "modifier %d mapped to %d", id, m_modifierTranslationTable[id]));
 		}
 	}
+
+	if (hasBandwidth) {
+		// kilobytes per second
+		m_client->getBandwidth()->setRate(1024.0 * bandwidth);
+		LOG((CLOG_DEBUG1 "bandwidth limit %u kB/s", bandwidth));
+	}
 }
 
 void
@@ -862,17 +1052,29 @@ ServerProxy::infoAcknowledgment()
 void
 ServerProxy::fileChunkReceived()
 {
-	int result = FileChunk::assemble(
-					m_stream,
-					m_client->getReceivedFileData(),
-					m_client->getExpectedFileSize());
+	FileReceiveState& state = m_client->getFileReceiveState();
+	int result = FileChunk::assemble(m_stream, state);
 
 	if (result == kFinish) {
-		m_events->addEvent(Event(m_events->forFile().fileRecieveCompleted(), m_client));
+		FileReceived* file = new FileReceived;
+		file->m_fileIndex = state.getFileIndex();
+		file->m_data.swap(state.getData());
+
+		Event event(m_events->forFile().fileRecieveCompleted(), m_client);
+		event.setDataObject(file);
+		m_events->addEvent(event);
+	}
+	else if (result == kError) {
+		// a chunk failed its checksum, ask for the rest again
+		FileTransferResume resume;
+		if (state.getResumePoint(resume)) {
+			fileResumeRequest(resume);
+		}
 	}
 	else if (result == kStart) {
-		if (m_client->getDragFileList().size() > 0) {
-			String filename = m_client->getDragFileList().at(0).getFilename();
+		UInt32 index = state.getFileIndex();
+		if (m_client->getDragFileList().size() > index) {
+			String filename = m_client->getDragFileList().at(index).getFilename();
 			LOG((CLOG_DEBUG "start receiving %s", filename.c_str()));
 		}
 	}
@@ -892,13 +1094,19 @@ ServerProxy::dragInfoReceived()
 void
 ServerProxy::handleClipboardSendingEvent(const Event& event, void*)
 {
-	ClipboardChunk::send(m_stream, event.getData());
+	ClipboardChunk::send(m_stream,
+		static_cast<ClipboardChunk*>(event.getDataObject()));
 }
 
 void
 ServerProxy::fileChunkSending(UInt8 mark, char* data, size_t dataSize)
 {
-	FileChunk::send(m_stream, mark, data, dataSize);
+	if (mark == kDataFileRange) {
+		FileChunk::sendRange(m_stream, data, dataSize);
+	}
+	else {
+		FileChunk::send(m_stream, mark, data, dataSize);
+	}
 }
 
 void
@@ -907,3 +1115,27 @@ ServerProxy::sendDragInfo(UInt32 fileCount, const char* info, size_t size)
 	String data(info, size);
 	ProtocolUtil::writef(m_stream, kMsgDDragInfo, fileCount, &data);
 }
+
+void
+ServerProxy::fileResumeRequest(const FileTransferResume& resume)
+{
+	String offset = synergy::string::sizeTypeToString(resume.m_offset);
+	LOG((CLOG_DEBUG "send file resume transfer=%u file=%u offset=%s", resume.m_id, resume.m_fileIndex, offset.c_str()));
+	ProtocolUtil::writef(m_stream, kMsgDFileResume,
+		resume.m_id, resume.m_fileIndex, resume.m_checksum, &offset);
+}
+
+void
+ServerProxy::fileResumeReceived()
+{
+	FileTransferResume resume;
+	String offset;
+	if (!ProtocolUtil::readf(m_stream, kMsgDFileResume + 4,
+			&resume.m_id, &resume.m_fileIndex, &resume.m_checksum, &offset)) {
+		return;
+	}
+	resume.m_offset = synergy::string::stringToSizeType(offset);
+
+	LOG((CLOG_DEBUG "recv file resume transfer=%u file=%u offset=%s", resume.m_id, resume.m_fileIndex, offset.c_str()));
+	m_client->fileResumeRequested(resume);
+}
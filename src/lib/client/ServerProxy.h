@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include "synergy/ClipboardChunk.h"
+#include "synergy/ClipboardHistory.h"
 #include "synergy/clipboard_types.h"
 #include "synergy/key_types.h"
 #include "base/Event.h"
@@ -27,6 +29,7 @@
 class Client;
 class ClientInfo;
 class EventQueueTimer;
+class FileTransferResume;
 class IClipboard;
 namespace synergy { class IStream; }
 class IEventQueue;
@@ -59,6 +62,9 @@ public:
 
 	// sending dragging information to server
 	void				sendDragInfo(UInt32 fileCount, const char* info, size_t size);
+
+	// asking the server to resume an unfinished file transfer
+	void				fileResumeRequest(const FileTransferResume& resume);
 	
 #ifdef TEST_ENV
 	void				handleDataForTest() { handleData(Event(), NULL); }
@@ -78,6 +84,11 @@ private:
 	void				resetKeepAliveAlarm();
 	void				setKeepAliveRate(double);
 
+	// local key auto-repeat
+	void				startKeyRepeat(KeyID, KeyModifierMask, KeyButton);
+	void				stopKeyRepeat();
+	void				setKeyRepeatTimer(double timeout);
+
 	// modifier key translation
 	KeyID				translateKey(KeyID) const;
 	KeyModifierMask			translateModifierMask(KeyModifierMask) const;
@@ -85,6 +96,7 @@ private:
 	// event handlers
 	void				handleData(const Event&, void*);
 	void				handleKeepAliveAlarm(const Event&, void*);
+	void				handleKeyRepeat(const Event&, void*);
 
 	// message handlers
 	void				enter();
@@ -106,6 +118,9 @@ private:
 	void				infoAcknowledgment();
 	void				fileChunkReceived();
 	void				dragInfoReceived();
+	void				fileResumeReceived();
+	void				clipboardAckReceived();
+	bool				clipboardReceived(ClipboardID, String& data);
 	void				handleClipboardSendingEvent(const Event&, void*);
 
 private:
@@ -115,6 +130,8 @@ private:
 	synergy::IStream*	m_stream;
 
 	UInt32				m_seqNum;
+	ClipboardHistory	m_clipboardHistory;
+	ClipboardReceiveState	m_clipboardReceive;
 
 	bool				m_compressMouse;
 	bool				m_compressMouseRelative;
@@ -128,6 +145,15 @@ private:
 	double				m_keepAliveAlarm;
 	EventQueueTimer*	m_keepAliveAlarmTimer;
 
+	bool				m_keyRepeatLocal;
+	double				m_keyRepeatDelay;
+	double				m_keyRepeatRate;
+	KeyID				m_repeatKey;
+	KeyModifierMask		m_repeatMask;
+	KeyButton			m_repeatButton;
+	EventQueueTimer*	m_keyRepeatTimer;
+	Stopwatch			m_lastMessage;
+
 	MessageParser		m_parser;
 	IEventQueue*		m_events;
 };
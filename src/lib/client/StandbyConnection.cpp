@@ -0,0 +1,262 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2013 Synergy Si Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "client/StandbyConnection.h"
+
+#include "synergy/PacketStreamFilter.h"
+#include "synergy/ProtocolUtil.h"
+#include "synergy/protocol_types.h"
+#include "net/TCPSocket.h"
+#include "net/IDataSocket.h"
+#include "net/ISocketFactory.h"
+#include "arch/Arch.h"
+#include "base/Log.h"
+#include "base/IEventQueue.h"
+#include "base/TMethodEventJob.h"
+#include "common/PluginVersion.h"
+
+// time allowed to connect and receive the hello, as for the active
+// connection
+static const double		kConnectTimeout = 15.0;
+
+// time between attempts to reconnect a failed standby
+static const double		kRetryTime = 5.0;
+
+//
+// StandbyConnection
+//
+
+StandbyConnection::StandbyConnection(const NetworkAddress& address,
+				ISocketFactory* socketFactory, bool secure,
+				IEventQueue* events) :
+	m_address(address),
+	m_socketFactory(socketFactory),
+	m_secure(secure),
+	m_events(events),
+	m_state(kWaiting),
+	m_stream(NULL),
+	m_socket(NULL),
+	m_timer(NULL)
+{
+	assert(m_socketFactory != NULL);
+
+	connect();
+}
+
+StandbyConnection::~StandbyConnection()
+{
+	cleanupTimer();
+	cleanupStream();
+}
+
+synergy::IStream*
+StandbyConnection::orphanStream(TCPSocket*& socket)
+{
+	assert(m_state == kReady);
+
+	cleanupTimer();
+	removeStreamHandlers();
+
+	synergy::IStream* stream = m_stream;
+	socket   = m_socket;
+	m_stream = NULL;
+	m_socket = NULL;
+	m_state  = kWaiting;
+	return stream;
+}
+
+bool
+StandbyConnection::isReady() const
+{
+	return (m_state == kReady);
+}
+
+const NetworkAddress&
+StandbyConnection::getAddress() const
+{
+	return m_address;
+}
+
+void
+StandbyConnection::connect()
+{
+	assert(m_stream == NULL);
+
+	try {
+		// resolve every time in case the address has changed
+		m_address.resolve();
+		LOG((CLOG_DEBUG "connecting standby to '%s'",
+			m_address.getHostname().c_str()));
+
+		IDataSocket* socket = m_socketFactory->create(m_secure);
+		m_socket = dynamic_cast<TCPSocket*>(socket);
+		m_stream = new PacketStreamFilter(m_events, socket, !m_secure);
+
+		void* target = m_stream->getEventTarget();
+		m_events->adoptHandler(m_events->forIDataSocket().connected(),
+							target,
+							new TMethodEventJob<StandbyConnection>(this,
+								&StandbyConnection::handleConnected));
+		m_events->adoptHandler(m_events->forIDataSocket().connectionFailed(),
+							target,
+							new TMethodEventJob<StandbyConnection>(this,
+								&StandbyConnection::handleConnectionFailed));
+		m_events->adoptHandler(m_events->forIStream().inputReady(),
+							target,
+							new TMethodEventJob<StandbyConnection>(this,
+								&StandbyConnection::handleHello));
+		m_events->adoptHandler(m_events->forISocket().disconnected(),
+							target,
+							new TMethodEventJob<StandbyConnection>(this,
+								&StandbyConnection::handleDisconnected));
+		m_events->adoptHandler(m_events->forIStream().inputShutdown(),
+							target,
+							new TMethodEventJob<StandbyConnection>(this,
+								&StandbyConnection::handleDisconnected));
+		m_events->adoptHandler(m_events->forIStream().outputError(),
+							target,
+							new TMethodEventJob<StandbyConnection>(this,
+								&StandbyConnection::handleDisconnected));
+
+		m_state = kConnecting;
+		setupTimer(kConnectTimeout);
+		socket->connect(m_address);
+	}
+	catch (XBase& e) {
+		fail(e.what());
+	}
+}
+
+void
+StandbyConnection::fail(const char* what)
+{
+	LOG((CLOG_DEBUG "standby connection to '%s' failed: %s",
+		m_address.getHostname().c_str(), what));
+
+	cleanupStream();
+	m_state = kWaiting;
+	setupTimer(kRetryTime);
+}
+
+void
+StandbyConnection::setupTimer(double timeout)
+{
+	cleanupTimer();
+	m_timer = m_events->newOneShotTimer(timeout, NULL);
+	m_events->adoptHandler(Event::kTimer, m_timer,
+							new TMethodEventJob<StandbyConnection>(this,
+								&StandbyConnection::handleTimer));
+}
+
+void
+StandbyConnection::cleanupTimer()
+{
+	if (m_timer != NULL) {
+		m_events->removeHandler(Event::kTimer, m_timer);
+		m_events->deleteTimer(m_timer);
+		m_timer = NULL;
+	}
+}
+
+void
+StandbyConnection::cleanupStream()
+{
+	if (m_stream == NULL) {
+		return;
+	}
+
+	removeStreamHandlers();
+	delete m_stream;
+
+	// the packet filter doesn't adopt a secure socket.  the plugin
+	// that made it has to delete it.
+	if (m_secure && m_socket != NULL) {
+		void* args[2] = { m_socket, NULL };
+		ARCH->plugin().invoke(s_pluginNames[kSecureSocket], "deleteSocket", args);
+	}
+
+	m_stream = NULL;
+	m_socket = NULL;
+}
+
+void
+StandbyConnection::removeStreamHandlers()
+{
+	void* target = m_stream->getEventTarget();
+	m_events->removeHandler(m_events->forIDataSocket().connected(), target);
+	m_events->removeHandler(m_events->forIDataSocket().connectionFailed(), target);
+	m_events->removeHandler(m_events->forIStream().inputReady(), target);
+	m_events->removeHandler(m_events->forISocket().disconnected(), target);
+	m_events->removeHandler(m_events->forIStream().inputShutdown(), target);
+	m_events->removeHandler(m_events->forIStream().outputError(), target);
+}
+
+void
+StandbyConnection::handleConnected(const Event&, void*)
+{
+	LOG((CLOG_DEBUG1 "standby connected;  wait for hello"));
+	m_socket->secureConnect();
+}
+
+void
+StandbyConnection::handleConnectionFailed(const Event& event, void*)
+{
+	IDataSocket::ConnectionFailedInfo* info =
+		static_cast<IDataSocket::ConnectionFailedInfo*>(event.getData());
+	fail(info->m_what.c_str());
+	delete info;
+}
+
+void
+StandbyConnection::handleHello(const Event&, void*)
+{
+	if (m_state == kReady) {
+		return;
+	}
+
+	// leave the hello for the client to answer when it takes over
+	LOG((CLOG_NOTE "standby connection to '%s' ready",
+		m_address.getHostname().c_str()));
+	m_state = kReady;
+	setupTimer(kKeepAliveRate);
+}
+
+void
+StandbyConnection::handleDisconnected(const Event&, void*)
+{
+	fail("disconnected");
+}
+
+void
+StandbyConnection::handleTimer(const Event&, void*)
+{
+	switch (m_state) {
+	case kWaiting:
+		cleanupTimer();
+		connect();
+		break;
+
+	case kConnecting:
+		fail("timed out");
+		break;
+
+	case kReady:
+		ProtocolUtil::writef(m_stream, kMsgCKeepAlive);
+		setupTimer(kKeepAliveRate);
+		break;
+	}
+}
@@ -0,0 +1,99 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2013 Synergy Si Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "net/NetworkAddress.h"
+#include "base/Event.h"
+
+class EventQueueTimer;
+class ISocketFactory;
+class IEventQueue;
+class TCPSocket;
+namespace synergy { class IStream; }
+
+//! Standby connection to a backup server
+/*!
+Holds a connection to a backup server so the client can switch to it
+as soon as it loses the active server.  The connection is made and
+secured and the server's hello is received but not answered, so
+taking it over needs no further round trip.  Until then keep alives
+stop the server from timing the connection out.  A failed connection
+is retried.
+*/
+class StandbyConnection {
+public:
+	StandbyConnection(const NetworkAddress& address,
+							ISocketFactory* socketFactory, bool secure,
+							IEventQueue* events);
+	~StandbyConnection();
+
+	//! @name manipulators
+	//@{
+
+	//! Take over the connection
+	/*!
+	Returns the connection's stream, with the server's hello waiting
+	to be read, and sets \p socket to the socket under it.  The caller
+	adopts both.  Must only be called when isReady().
+	*/
+	synergy::IStream*	orphanStream(TCPSocket*& socket);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Test if ready
+	/*!
+	Returns true iff the server's hello has been received.
+	*/
+	bool				isReady() const;
+
+	//! Get the server address
+	const NetworkAddress&	getAddress() const;
+
+	//@}
+
+private:
+	enum EState {
+		kWaiting,
+		kConnecting,
+		kReady
+	};
+
+	void				connect();
+	void				fail(const char* what);
+	void				setupTimer(double timeout);
+	void				cleanupTimer();
+	void				cleanupStream();
+	void				removeStreamHandlers();
+	void				handleConnected(const Event&, void*);
+	void				handleConnectionFailed(const Event&, void*);
+	void				handleHello(const Event&, void*);
+	void				handleDisconnected(const Event&, void*);
+	void				handleTimer(const Event&, void*);
+
+private:
+	NetworkAddress		m_address;
+	ISocketFactory*		m_socketFactory;
+	bool				m_secure;
+	IEventQueue*		m_events;
+	EState				m_state;
+	synergy::IStream*	m_stream;
+	TCPSocket*			m_socket;
+	EventQueueTimer*	m_timer;
+};
@@ -81,6 +81,13 @@ typedef signed TYPE_OF_SIZE_4	SInt32;
 typedef unsigned TYPE_OF_SIZE_1	UInt8;
 typedef unsigned TYPE_OF_SIZE_2	UInt16;
 typedef unsigned TYPE_OF_SIZE_4	UInt32;
+#if defined(_MSC_VER)
+typedef signed __int64			SInt64;
+typedef unsigned __int64		UInt64;
+#else
+typedef signed long long		SInt64;
+typedef unsigned long long		UInt64;
+#endif
 #endif
 #endif
 //
@@ -0,0 +1,81 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/IInterface.h"
+#include "common/basic_types.h"
+
+#include <cstddef>
+
+class IJob;
+
+namespace synergy {
+
+class IStream;
+
+//! Stream that can send straight from a file
+/*!
+A stream implements this, as well as IStream, if it can send file data
+without copying it through its buffers.  Use getFileSender() to find it
+behind a stream.
+*/
+class IFileSender : public IInterface {
+public:
+	//! @name manipulators
+	//@{
+
+	//! Write from a file to stream
+	/*!
+	Write \c headerSize bytes from \c header followed by \c size bytes
+	of the file open on \c fd starting at \c offset, as if by a single
+	\c write().  The file bytes are sent without being copied through
+	the stream's buffers.  Returns false, doing nothing, if the stream
+	can't do this;  the caller must then read the file and \c write()
+	it.  Otherwise the stream keeps its own duplicate of \c fd and
+	takes ownership of \c done, which it runs once the file bytes have
+	been sent or discarded, and of \c truncated.  If the file ends
+	before \c size bytes the stream runs \c truncated and sends zeros
+	for the rest, so what follows in the stream stays framed.  Both
+	jobs may be run on another thread.
+	*/
+	virtual bool		writeFile(const void* header, UInt32 headerSize,
+							int fd, size_t offset, UInt32 size,
+							IJob* done, IJob* truncated) = 0;
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Test if file data can be sent
+	/*!
+	Returns true if \c writeFile() would send from the file now.  It
+	can't when the stream has to encrypt the data itself.
+	*/
+	virtual bool		canSendFile() = 0;
+
+	//@}
+};
+
+//! Get the file sender of a stream
+/*!
+Returns \p stream as an IFileSender, or NULL if it isn't one or can't
+send from a file now.
+*/
+IFileSender*			getFileSender(IStream* stream);
+
+}
@@ -114,6 +114,15 @@ public:
 	*/
 	virtual UInt32		getSize() const = 0;
 
+	//! Get bytes waiting to be sent
+	/*!
+	Returns the number of bytes written to the stream that haven't
+	been sent yet, including any the kernel is still holding if the
+	stream can find that out.  Some streams may not be able to
+	determine this and will always return zero.
+	*/
+	virtual UInt32		getUnsentSize() const = 0;
+
 	//@}
 };
 
@@ -17,6 +17,7 @@
  */
 
 #include "io/StreamBuffer.h"
+#include "base/MemoryBudget.h"
 
 //
 // StreamBuffer
@@ -33,7 +34,7 @@ StreamBuffer::StreamBuffer() :
 
 StreamBuffer::~StreamBuffer()
 {
-	// do nothing
+	MemoryBudget::release(MemoryBudget::kStreamBuffers, m_size);
 }
 
 const void*
@@ -67,6 +68,7 @@ StreamBuffer::pop(UInt32 n)
 {
 	// discard all chunks if n is greater than or equal to m_size
 	if (n >= m_size) {
+		MemoryBudget::release(MemoryBudget::kStreamBuffers, m_size);
 		m_size     = 0;
 		m_headUsed = 0;
 		m_chunks.clear();
@@ -75,6 +77,7 @@ StreamBuffer::pop(UInt32 n)
 
 	// update size
 	m_size -= n;
+	MemoryBudget::release(MemoryBudget::kStreamBuffers, n);
 
 	// discard chunks until more than n bytes would've been discarded
 	ChunkList::iterator scan = m_chunks.begin();
@@ -103,6 +106,10 @@ StreamBuffer::write(const void* vdata, UInt32 n)
 	}
 	m_size += n;
 
+	// the data is already here so it can't be refused.  producers
+	// check MemoryBudget::isExhausted() to stop adding more.
+	MemoryBudget::charge(MemoryBudget::kStreamBuffers, n);
+
 	// cast data to bytes
 	const UInt8* data = reinterpret_cast<const UInt8*>(vdata);
 
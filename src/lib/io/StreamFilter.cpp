@@ -80,6 +80,25 @@ StreamFilter::shutdownOutput()
 	getStream()->shutdownOutput();
 }
 
+bool
+StreamFilter::writeFile(const void* header, UInt32 headerSize,
+				int fd, size_t offset, UInt32 size,
+				IJob* done, IJob* truncated)
+{
+	synergy::IFileSender* sender = synergy::getFileSender(getStream());
+	if (sender == NULL) {
+		return false;
+	}
+	return sender->writeFile(header, headerSize, fd, offset, size,
+							done, truncated);
+}
+
+bool
+StreamFilter::canSendFile()
+{
+	return (synergy::getFileSender(getStream()) != NULL);
+}
+
 void*
 StreamFilter::getEventTarget() const
 {
@@ -98,6 +117,12 @@ StreamFilter::getSize() const
 	return getStream()->getSize();
 }
 
+UInt32
+StreamFilter::getUnsentSize() const
+{
+	return getStream()->getUnsentSize();
+}
+
 synergy::IStream*
 StreamFilter::getStream() const
 {
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "io/IStream.h"
+#include "io/IFileSender.h"
 #include "base/IEventQueue.h"
 
 //! A stream filter
@@ -26,7 +27,7 @@
 This class wraps a stream.  Subclasses provide indirect access
 to the wrapped stream, typically performing some filtering.
 */
-class StreamFilter : public synergy::IStream {
+class StreamFilter : public synergy::IStream, public synergy::IFileSender {
 public:
 	/*!
 	Create a wrapper around \c stream.  Iff \c adoptStream is true then
@@ -48,6 +49,14 @@ public:
 	virtual void*		getEventTarget() const;
 	virtual bool		isReady() const;
 	virtual UInt32		getSize() const;
+	virtual UInt32		getUnsentSize() const;
+
+	// IFileSender overrides
+	// These forward to the underlying stream if it's a file sender.
+	virtual bool		writeFile(const void* header, UInt32 headerSize,
+							int fd, size_t offset, UInt32 size,
+							IJob* done, IJob* truncated);
+	virtual bool		canSendFile();
 
 	//! Get the stream
 	/*!
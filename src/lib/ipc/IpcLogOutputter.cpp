@@ -50,7 +50,7 @@ IpcLogOutputter::IpcLogOutputter(IpcServer& ipcServer, EIpcClientType clientType
 	m_bufferRateWriteLimit(kBufferRateWriteLimit),
 	m_bufferRateTimeLimit(kBufferRateTimeLimit),
 	m_bufferWriteCount(0),
-	m_bufferRateStart(ARCH->time()),
+	m_bufferRateStart(ARCH->coarseTicks()),
 	m_clientType(clientType),
 	m_runningMutex(ARCH->newMutex())
 {
@@ -117,7 +117,8 @@ IpcLogOutputter::appendBuffer(const String& text)
 {
 	ArchMutexLock lock(m_bufferMutex);
 
-	double elapsed = ARCH->time() - m_bufferRateStart;
+	// this runs for every log line, so a rough time will do
+	double elapsed = 1.0e-9 * (ARCH->coarseTicks() - m_bufferRateStart);
 	if (elapsed < m_bufferRateTimeLimit) {
 		if (m_bufferWriteCount >= m_bufferRateWriteLimit) {
 			// discard the log line if we've logged too much.
@@ -126,7 +127,7 @@ IpcLogOutputter::appendBuffer(const String& text)
 	}
 	else {
 		m_bufferWriteCount = 0;
-		m_bufferRateStart = ARCH->time();
+		m_bufferRateStart = ARCH->coarseTicks();
 	}
 
 	if (m_buffer.size() >= m_bufferMaxSize) {
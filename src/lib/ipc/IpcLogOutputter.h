@@ -113,7 +113,7 @@ private:
 	UInt16				m_bufferRateWriteLimit;
 	double				m_bufferRateTimeLimit;
 	UInt16				m_bufferWriteCount;
-	double				m_bufferRateStart;
+	UInt64				m_bufferRateStart;
 	bool				m_useThread;
 	EIpcClientType		m_clientType;
 	ArchMutex			m_runningMutex;
@@ -70,4 +70,5 @@ public:
 	virtual bool		isReady() const = 0;
 	virtual bool		isFatal() const = 0;
 	virtual UInt32		getSize() const = 0;
+	virtual UInt32		getUnsentSize() const = 0;
 };
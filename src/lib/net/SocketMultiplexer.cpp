@@ -27,13 +27,12 @@
 #include "arch/XArch.h"
 #include "base/Log.h"
 #include "base/TMethodJob.h"
-#include "common/stdvector.h"
 
 //
 // SocketMultiplexer
 //
 
-SocketMultiplexer::SocketMultiplexer() :
+SocketMultiplexer::SocketMultiplexer(bool reactor) :
 	m_mutex(new Mutex),
 	m_thread(NULL),
 	m_update(false),
@@ -48,23 +47,28 @@ SocketMultiplexer::SocketMultiplexer() :
 	// in the jobs list.
 	m_cursorMark = reinterpret_cast<ISocketMultiplexerJob*>(this);
 
-	// start thread
-	m_thread = new Thread(new TMethodJob<SocketMultiplexer>(
+	// start thread, unless the caller will be doing the polling
+	if (!reactor) {
+		m_thread = new Thread(new TMethodJob<SocketMultiplexer>(
 								this, &SocketMultiplexer::serviceThread));
+	}
 }
 
 SocketMultiplexer::~SocketMultiplexer()
 {
-	m_thread->cancel();
-	m_thread->unblockPollSocket();
-	m_thread->wait();
-	delete m_thread;
+	if (m_thread != NULL) {
+		m_thread->cancel();
+		m_thread->unblockPollSocket();
+		m_thread->wait();
+		delete m_thread;
+	}
 	delete m_jobsReady;
 	delete m_jobListLock;
 	delete m_jobListLockLocked;
 	delete m_jobListLocker;
 	delete m_jobListLockLocker;
 	delete m_mutex;
+	releasePolledSockets();
 
 	// clean up jobs
 	for (SocketJobMap::iterator i = m_socketJobMap.begin();
@@ -82,8 +86,11 @@ SocketMultiplexer::addSocket(ISocket* socket, ISocketMultiplexerJob* job)
 	// prevent other threads from locking the job list
 	lockJobListLock();
 
-	// break thread out of poll
-	m_thread->unblockPollSocket();
+	// break thread out of poll.  a reactor's poller doesn't hold the
+	// job list while polling.
+	if (m_thread != NULL) {
+		m_thread->unblockPollSocket();
+	}
 
 	// lock the job list
 	lockJobList();
@@ -119,8 +126,11 @@ SocketMultiplexer::removeSocket(ISocket* socket)
 	// prevent other threads from locking the job list
 	lockJobListLock();
 
-	// break thread out of poll
-	m_thread->unblockPollSocket();
+	// break thread out of poll.  a reactor's poller doesn't hold the
+	// job list while polling.
+	if (m_thread != NULL) {
+		m_thread->unblockPollSocket();
+	}
 
 	// lock the job list
 	lockJobList();
@@ -141,11 +151,70 @@ SocketMultiplexer::removeSocket(ISocket* socket)
 	unlockJobList();
 }
 
+void
+SocketMultiplexer::beginPoll(PollEntries& entries)
+{
+	assert(m_thread == NULL);
+
+	// lock the job list
+	lockJobListLock();
+	lockJobList();
+
+	// collect poll entries.  hold on to their sockets so another thread
+	// can't close one while we poll it.
+	if (m_update) {
+		releasePolledSockets();
+		updatePollEntries(entries);
+		for (size_t i = 0; i < entries.size(); ++i) {
+			m_polledSockets.push_back(ARCH->copySocket(entries[i].m_socket));
+		}
+	}
+
+	// don't hold up threads adding or removing sockets while we poll
+	unlockJobList();
+}
+
+bool
+SocketMultiplexer::endPoll(PollEntries& entries)
+{
+	assert(m_thread == NULL);
+
+	// lock the job list
+	lockJobListLock();
+	lockJobList();
+
+	// the entries are out of step with the jobs if the sockets changed
+	// while we polled.  polling is level triggered so the next poll,
+	// with rebuilt entries, sees the same events.
+	bool ready = false;
+	if (!m_update) {
+		for (size_t i = 0; i < entries.size(); ++i) {
+			if (entries[i].m_revents != 0) {
+				ready = true;
+				break;
+			}
+		}
+	}
+	if (ready) {
+		runJobs(entries);
+	}
+	deleteRemovedJobs();
+
+	// unlock the job list
+	unlockJobList();
+	return ready;
+}
+
+bool
+SocketMultiplexer::isReactor() const
+{
+	return (m_thread == NULL);
+}
+
 void
 SocketMultiplexer::serviceThread(void*)
 {
-	std::vector<IArchNetwork::PollEntry> pfds;
-	IArchNetwork::PollEntry pfd;
+	PollEntries pfds;
 
 	// service the connections
 	for (;;) {
@@ -164,30 +233,7 @@ SocketMultiplexer::serviceThread(void*)
 		lockJobList();
 
 		// collect poll entries
-		if (m_update) {
-			m_update = false;
-			pfds.clear();
-			pfds.reserve(m_socketJobMap.size());
-
-			JobCursor cursor    = newCursor();
-			JobCursor jobCursor = nextCursor(cursor);
-			while (jobCursor != m_socketJobs.end()) {
-				ISocketMultiplexerJob* job = *jobCursor;
-				if (job != NULL) {
-					pfd.m_socket = job->getSocket();
-					pfd.m_events = 0;
-					if (job->isReadable()) {
-						pfd.m_events |= IArchNetwork::kPOLLIN;
-					}
-					if (job->isWritable()) {
-						pfd.m_events |= IArchNetwork::kPOLLOUT;
-					}
-					pfds.push_back(pfd);
-				}				
-				jobCursor = nextCursor(cursor);
-			}
-			deleteCursor(cursor);
-		}
+		updatePollEntries(pfds);
 
 		int status;
 		try {
@@ -205,55 +251,100 @@ SocketMultiplexer::serviceThread(void*)
 		}
 
 		if (status != 0) {
-			// iterate over socket jobs, invoking each and saving the
-			// new job.
-			UInt32 i             = 0;
-			JobCursor cursor    = newCursor();
-			JobCursor jobCursor = nextCursor(cursor);
-			while (i < pfds.size() && jobCursor != m_socketJobs.end()) {
-				if (*jobCursor != NULL) {
-					// get poll state
-					unsigned short revents = pfds[i].m_revents;
-					bool read  = ((revents & IArchNetwork::kPOLLIN) != 0);
-					bool write = ((revents & IArchNetwork::kPOLLOUT) != 0);
-					bool error = ((revents & (IArchNetwork::kPOLLERR |
-											  IArchNetwork::kPOLLNVAL)) != 0);
-
-					// run job
-					ISocketMultiplexerJob* job    = *jobCursor;
-					ISocketMultiplexerJob* newJob = job->run(read, write, error);
-
-					// save job, if different
-					if (newJob != job) {
-						Lock lock(m_mutex);
-						delete job;
-						*jobCursor = newJob;
-						m_update   = true;
-					}
-					++i;
-				}
-
-				// next job
-				jobCursor = nextCursor(cursor);
-			}
-			deleteCursor(cursor);
+			runJobs(pfds);
 		}
 
 		// delete any removed socket jobs
-		for (SocketJobMap::iterator i = m_socketJobMap.begin();
-							i != m_socketJobMap.end();) {
-			if (*(i->second) == NULL) {
-				m_socketJobs.erase(i->second);
-				m_socketJobMap.erase(i++);
-				m_update = true;
+		deleteRemovedJobs();
+
+		// unlock the job list
+		unlockJobList();
+	}
+}
+
+void
+SocketMultiplexer::updatePollEntries(PollEntries& pfds)
+{
+	if (!m_update) {
+		return;
+	}
+
+	m_update = false;
+	pfds.clear();
+	pfds.reserve(m_socketJobMap.size());
+
+	IArchNetwork::PollEntry pfd;
+	JobCursor cursor    = newCursor();
+	JobCursor jobCursor = nextCursor(cursor);
+	while (jobCursor != m_socketJobs.end()) {
+		ISocketMultiplexerJob* job = *jobCursor;
+		if (job != NULL) {
+			pfd.m_socket  = job->getSocket();
+			pfd.m_events  = 0;
+			pfd.m_revents = 0;
+			if (job->isReadable()) {
+				pfd.m_events |= IArchNetwork::kPOLLIN;
 			}
-			else {
-				++i;
+			if (job->isWritable()) {
+				pfd.m_events |= IArchNetwork::kPOLLOUT;
 			}
+			pfds.push_back(pfd);
 		}
+		jobCursor = nextCursor(cursor);
+	}
+	deleteCursor(cursor);
+}
 
-		// unlock the job list
-		unlockJobList();
+void
+SocketMultiplexer::runJobs(const PollEntries& pfds)
+{
+	// iterate over socket jobs, invoking each and saving the
+	// new job.
+	UInt32 i             = 0;
+	JobCursor cursor    = newCursor();
+	JobCursor jobCursor = nextCursor(cursor);
+	while (i < pfds.size() && jobCursor != m_socketJobs.end()) {
+		if (*jobCursor != NULL) {
+			// get poll state
+			unsigned short revents = pfds[i].m_revents;
+			bool read  = ((revents & IArchNetwork::kPOLLIN) != 0);
+			bool write = ((revents & IArchNetwork::kPOLLOUT) != 0);
+			bool error = ((revents & (IArchNetwork::kPOLLERR |
+									  IArchNetwork::kPOLLNVAL)) != 0);
+
+			// run job
+			ISocketMultiplexerJob* job    = *jobCursor;
+			ISocketMultiplexerJob* newJob = job->run(read, write, error);
+
+			// save job, if different
+			if (newJob != job) {
+				Lock lock(m_mutex);
+				delete job;
+				*jobCursor = newJob;
+				m_update   = true;
+			}
+			++i;
+		}
+
+		// next job
+		jobCursor = nextCursor(cursor);
+	}
+	deleteCursor(cursor);
+}
+
+void
+SocketMultiplexer::deleteRemovedJobs()
+{
+	for (SocketJobMap::iterator i = m_socketJobMap.begin();
+						i != m_socketJobMap.end();) {
+		if (*(i->second) == NULL) {
+			m_socketJobs.erase(i->second);
+			m_socketJobMap.erase(i++);
+			m_update = true;
+		}
+		else {
+			++i;
+		}
 	}
 }
 
@@ -290,6 +381,20 @@ SocketMultiplexer::deleteCursor(JobCursor cursor)
 	m_socketJobs.erase(cursor);
 }
 
+void
+SocketMultiplexer::releasePolledSockets()
+{
+	for (size_t i = 0; i < m_polledSockets.size(); ++i) {
+		try {
+			ARCH->closeSocket(m_polledSockets[i]);
+		}
+		catch (XArchNetwork&) {
+			// ignore
+		}
+	}
+	m_polledSockets.clear();
+}
+
 void
 SocketMultiplexer::lockJobListLock()
 {
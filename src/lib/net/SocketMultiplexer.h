@@ -21,6 +21,7 @@
 #include "arch/IArchNetwork.h"
 #include "common/stdlist.h"
 #include "common/stdmap.h"
+#include "common/stdvector.h"
 
 template <class T>
 class CondVar;
@@ -32,10 +33,18 @@ class ISocketMultiplexerJob;
 //! Socket multiplexer
 /*!
 A socket multiplexer services multiple sockets simultaneously.
+
+Normally the sockets are serviced on a thread of the multiplexer's own.
+A multiplexer created as a reactor has no thread;  instead whoever waits
+for platform events polls the sockets along with its own descriptors,
+using \c beginPoll() and \c endPoll(), so socket data is handled on
+that thread without waking another.
 */
 class SocketMultiplexer {
 public:
-	SocketMultiplexer();
+	typedef std::vector<IArchNetwork::PollEntry> PollEntries;
+
+	SocketMultiplexer(bool reactor = false);
 	~SocketMultiplexer();
 
 	//! @name manipulators
@@ -45,10 +54,38 @@ public:
 
 	void				removeSocket(ISocket*);
 
+	//! Start a poll of the sockets
+	/*!
+	Only for reactors.  Fills \p entries with the sockets to poll and
+	what to poll them for.  The caller must poll them, set \c m_revents
+	on each entry and call \c endPoll() with the same \p entries.  Keep
+	\p entries between polls;  it's only rebuilt when the sockets change.
+	The job list isn't locked during the poll, so other threads can add
+	and remove sockets meanwhile;  the sockets in \p entries stay open
+	until the next poll.
+	*/
+	void				beginPoll(PollEntries& entries);
+
+	//! Finish a poll of the sockets
+	/*!
+	Runs the jobs for sockets with events in \p entries.  If sockets
+	were added or removed during the poll then \p entries no longer
+	match the jobs and no job is run;  the next poll sees the same
+	events.  Returns true if any job ran.
+	*/
+	bool				endPoll(PollEntries& entries);
+
 	//@}
 	//! @name accessors
 	//@{
 
+	//! Test if sockets are polled by the caller
+	/*!
+	Returns true if this multiplexer has no thread of its own and its
+	sockets must be polled with \c beginPoll() and \c endPoll().
+	*/
+	bool				isReactor() const;
+
 	// maybe belongs on ISocketMultiplexer
 	static SocketMultiplexer*
 						getInstance();
@@ -68,6 +105,13 @@ private:
 	// false.  only the service thread sets m_polling.
 	void				serviceThread(void*);
 
+	// rebuild the poll entries if the jobs have changed, run the jobs
+	// with events after a poll, and drop removed jobs.  the job list
+	// must be locked.
+	void				updatePollEntries(PollEntries&);
+	void				runJobs(const PollEntries&);
+	void				deleteRemovedJobs();
+
 	// create, iterate, and destroy a cursor.  a cursor is used to
 	// safely iterate through the job list while other threads modify
 	// the list.  it works by inserting a dummy item in the list and
@@ -94,6 +138,9 @@ private:
 	// unlock the job list and the lock out on locking.
 	void				unlockJobList();
 
+	// drop the references a reactor holds on the sockets it polls
+	void				releasePolledSockets();
+
 private:
 	Mutex*				m_mutex;
 	Thread*				m_thread;
@@ -108,4 +155,8 @@ private:
 	SocketJobMap		m_socketJobMap;
 	ISocketMultiplexerJob*
 						m_cursorMark;
+
+	// sockets in a reactor's poll entries.  they're referenced so they
+	// aren't closed while the job list is unlocked for the poll.
+	std::vector<ArchSocket>	m_polledSockets;
 };
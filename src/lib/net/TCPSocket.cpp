@@ -28,10 +28,28 @@
 #include "base/Log.h"
 #include "base/IEventQueue.h"
 #include "base/IEventJob.h"
+#include "base/IJob.h"
+#include "base/MemoryBudget.h"
 
 #include <cstring>
 #include <cstdlib>
 #include <memory>
+#include <algorithm>
+#if HAVE_SYS_SENDFILE_H
+#	include <unistd.h>
+#endif
+
+// most the kernel may hold unsent before we stop handing it more
+static const int kNotSentLowWater = 16 * 1024;
+
+// input a socket may buffer before it's throttled for the memory budget.
+// the budget is shared, so this keeps a socket that's only carrying
+// control messages (e.g. keep-alives) from being throttled because of
+// bulk data piling up elsewhere.
+static const UInt32 kThrottleInputSize = 64 * 1024;
+
+// sent in place of the rest of a file that ended early
+static const UInt8 s_zeros[4096] = { 0 };
 
 //
 // TCPSocket
@@ -104,7 +122,7 @@ TCPSocket::close()
 
 	// clear buffers and enter disconnected state
 	if (m_connected) {
-		sendEvent(m_events->forISocket().disconnected());
+		sendEvent(kISocketDisconnected);
 	}
 	onDisconnected();
 
@@ -131,21 +149,34 @@ TCPSocket::getEventTarget() const
 UInt32
 TCPSocket::read(void* buffer, UInt32 n)
 {
-	// copy data directly from our input buffer
-	Lock lock(&m_mutex);
-	UInt32 size = m_inputBuffer.getSize();
-	if (n > size) {
-		n = size;
-	}
-	if (buffer != NULL && n != 0) {
-		memcpy(buffer, m_inputBuffer.peek(n), n);
+	bool resume = false;
+	{
+		// copy data directly from our input buffer
+		Lock lock(&m_mutex);
+		UInt32 size = m_inputBuffer.getSize();
+		if (n > size) {
+			n = size;
+		}
+		if (buffer != NULL && n != 0) {
+			memcpy(buffer, m_inputBuffer.peek(n), n);
+		}
+		m_inputBuffer.pop(n);
+
+		// if no more data and we cannot read or write then send disconnected
+		if (n > 0 && m_inputBuffer.getSize() == 0 && !m_readable && !m_writable) {
+			sendEvent(kISocketDisconnected);
+			m_connected = false;
+		}
+
+		// resume reading once the reader has caught up
+		if (m_inputThrottled && m_inputBuffer.getSize() == 0) {
+			m_inputThrottled = false;
+			resume           = true;
+		}
 	}
-	m_inputBuffer.pop(n);
 
-	// if no more data and we cannot read or write then send disconnected
-	if (n > 0 && m_inputBuffer.getSize() == 0 && !m_readable && !m_writable) {
-		sendEvent(m_events->forISocket().disconnected());
-		m_connected = false;
+	if (resume) {
+		setJob(newJob());
 	}
 
 	return n;
@@ -160,7 +191,7 @@ TCPSocket::write(const void* buffer, UInt32 n)
 
 		// must not have shutdown output
 		if (!m_writable) {
-			sendEvent(m_events->forIStream().outputError());
+			sendEvent(kIStreamOutputError);
 			return;
 		}
 
@@ -170,8 +201,67 @@ TCPSocket::write(const void* buffer, UInt32 n)
 		}
 
 		// copy data to the output buffer
-		wasEmpty = (m_outputBuffer.getSize() == 0);
+		wasEmpty = !hasOutput();
 		m_outputBuffer.write(buffer, n);
+		if (!m_fileRanges.empty()) {
+			m_outputAfterRanges += n;
+		}
+
+		// there's data to write
+		m_flushed = false;
+	}
+
+	// make sure we're waiting to write
+	if (wasEmpty) {
+		setJob(newJob());
+	}
+}
+
+bool
+TCPSocket::writeFile(const void* header, UInt32 headerSize,
+				int fd, size_t offset, UInt32 size,
+				IJob* done, IJob* truncated)
+{
+#if HAVE_SYS_SENDFILE_H
+	bool wasEmpty;
+	{
+		Lock lock(&m_mutex);
+
+		if (!canSendFile()) {
+			return false;
+		}
+
+		// must not have shutdown output
+		if (!m_writable) {
+			sendEvent(kIStreamOutputError);
+			done->run();
+			delete done;
+			delete truncated;
+			return true;
+		}
+
+		// keep the file open for as long as the range is queued
+		FileRange range;
+		range.m_fd = ::dup(fd);
+		if (range.m_fd == -1) {
+			return false;
+		}
+		range.m_offset = offset;
+		range.m_size      = size;
+		range.m_done      = done;
+		range.m_truncated = truncated;
+
+		// the header goes in the output buffer ahead of the range
+		wasEmpty = !hasOutput();
+		m_outputBuffer.write(header, headerSize);
+		if (m_fileRanges.empty()) {
+			range.m_before = m_outputBuffer.getSize();
+		}
+		else {
+			range.m_before = m_outputAfterRanges + headerSize;
+		}
+		m_fileRanges.push_back(range);
+		m_outputAfterRanges = 0;
 
 		// there's data to write
 		m_flushed = false;
@@ -181,17 +271,71 @@ TCPSocket::write(const void* buffer, UInt32 n)
 	if (wasEmpty) {
 		setJob(newJob());
 	}
+	return true;
+#else
+	return false;
+#endif
 }
 
 void
 TCPSocket::flush()
 {
+	// a reactor only sends when the caller's thread next polls, so
+	// waiting here would wait forever.  send the output from here.
+	if (m_socketMultiplexer->isReactor()) {
+		flushInline();
+		return;
+	}
+
 	Lock lock(&m_mutex);
 	while (m_flushed == false) {
 		m_flushed.wait();
 	}
 }
 
+void
+TCPSocket::flushInline()
+{
+	for (;;) {
+		UInt32 unsent;
+		{
+			Lock lock(&m_mutex);
+			if (m_flushed || m_socket == NULL || !m_connected || !m_writable) {
+				return;
+			}
+			unsent = getOutputSize();
+		}
+
+		// wait until the socket takes more.  a hangup is reported with
+		// none of the events we know about, so treat that as an error.
+		IArchNetwork::PollEntry entry;
+		entry.m_socket  = m_socket;
+		entry.m_events  = IArchNetwork::kPOLLOUT;
+		entry.m_revents = 0;
+		int status = ARCH->pollSocket(&entry, 1, -1);
+		if (status == 0) {
+			continue;
+		}
+		bool error = (status < 0 || entry.m_revents == 0 ||
+						(entry.m_revents & (IArchNetwork::kPOLLERR |
+											IArchNetwork::kPOLLNVAL)) != 0);
+
+		// the job we get back replaces the one the reactor polls with,
+		// e.g. to stop polling for write once the output is flushed
+		ISocketMultiplexerJob* job = serviceConnected(NULL, false, true, error);
+		if (job != NULL) {
+			setJob(job);
+		}
+
+		// give up if nothing could be written (e.g. a secure socket
+		// that isn't ready);  the reactor sends the rest when it polls
+		Lock lock(&m_mutex);
+		if (!m_flushed && getOutputSize() == unsent) {
+			return;
+		}
+	}
+}
+
 void
 TCPSocket::shutdownInput()
 {
@@ -209,7 +353,7 @@ TCPSocket::shutdownInput()
 
 		// shutdown buffer for reading
 		if (m_readable) {
-			sendEvent(m_events->forIStream().inputShutdown());
+			sendEvent(kIStreamInputShutdown);
 			onInputShutdown();
 			useNewJob = true;
 		}
@@ -236,7 +380,7 @@ TCPSocket::shutdownOutput()
 
 		// shutdown buffer for writing
 		if (m_writable) {
-			sendEvent(m_events->forIStream().outputShutdown());
+			sendEvent(kIStreamOutputShutdown);
 			onOutputShutdown();
 			useNewJob = true;
 		}
@@ -268,6 +412,20 @@ TCPSocket::getSize() const
 	return m_inputBuffer.getSize();
 }
 
+UInt32
+TCPSocket::getUnsentSize() const
+{
+	Lock lock(&m_mutex);
+	UInt32 size = getOutputSize();
+	if (m_socket != NULL && m_connected) {
+		int queued = ARCH->getUnsentOnSocket(m_socket);
+		if (queued > 0) {
+			size += static_cast<UInt32>(queued);
+		}
+	}
+	return size;
+}
+
 void
 TCPSocket::connect(const NetworkAddress& addr)
 {
@@ -282,7 +440,7 @@ TCPSocket::connect(const NetworkAddress& addr)
 
 		try {
 			if (ARCH->connectSocket(m_socket, addr.getAddress())) {
-				sendEvent(m_events->forIDataSocket().connected());
+				sendEvent(kIDataSocketConnected);
 				onConnected();
 			}
 			else {
@@ -301,15 +459,23 @@ void
 TCPSocket::init()
 {
 	// default state
-	m_connected = false;
-	m_readable  = false;
-	m_writable  = false;
+	m_connected      = false;
+	m_readable       = false;
+	m_writable       = false;
+	m_inputThrottled = false;
+	m_writeRetrySize = 0;
+	m_outputAfterRanges = 0;
 
 	try {
 		// turn off Nagle algorithm.  we send lots of very short messages
 		// that should be sent without (much) delay.  for example, the
 		// mouse motion messages are much less useful if they're delayed.
 		ARCH->setNoDelayOnSocket(m_socket, true);
+
+		// keep the kernel send queue short.  data it hasn't taken stays
+		// in our output buffer, where the sender can see how far behind
+		// the connection is and skip stale input instead of queueing it.
+		ARCH->setNotSentLowWaterOnSocket(m_socket, kNotSentLowWater);
 	}
 	catch (XArchNetwork& e) {
 		try {
@@ -353,13 +519,14 @@ TCPSocket::newJob()
 								m_socket, m_readable, m_writable);
 	}
 	else {
-		if (!(m_readable || (m_writable && (m_outputBuffer.getSize() > 0)))) {
+		bool readable = (m_readable && !m_inputThrottled);
+		if (!(readable || (m_writable && hasOutput()))) {
 			return NULL;
 		}
 		return new TSocketMultiplexerMethodJob<TCPSocket>(
 								this, &TCPSocket::serviceConnected,
-								m_socket, m_readable,
-								m_writable && (m_outputBuffer.getSize() > 0));
+								m_socket, readable,
+								m_writable && hasOutput());
 	}
 }
 
@@ -367,14 +534,14 @@ void
 TCPSocket::sendConnectionFailedEvent(const char* msg)
 {
 	ConnectionFailedInfo* info = new ConnectionFailedInfo(msg);
-	m_events->addEvent(Event(m_events->forIDataSocket().connectionFailed(),
+	m_events->addEvent(Event(kIDataSocketConnectionFailed,
 							getEventTarget(), info, Event::kDontFreeData));
 }
 
 void
-TCPSocket::sendEvent(Event::Type type)
+TCPSocket::sendEvent(Event::Type type, Event::Flags flags)
 {
-	m_events->addEvent(Event(type, getEventTarget(), NULL));
+	m_events->addEvent(Event(type, getEventTarget(), NULL, flags));
 }
 
 void
@@ -396,6 +563,7 @@ void
 TCPSocket::onOutputShutdown()
 {
 	m_outputBuffer.pop(m_outputBuffer.getSize());
+	finishFileRanges();
 	m_writable = false;
 
 	// we're now flushed
@@ -412,6 +580,93 @@ TCPSocket::onDisconnected()
 	m_connected = false;
 }
 
+bool
+TCPSocket::hasOutput() const
+{
+	return (m_outputBuffer.getSize() > 0 || !m_fileRanges.empty());
+}
+
+UInt32
+TCPSocket::getOutputSize() const
+{
+	// note -- must have m_mutex locked on entry
+
+	UInt32 size = m_outputBuffer.getSize();
+	for (FileRangeList::const_iterator i = m_fileRanges.begin();
+							i != m_fileRanges.end(); ++i) {
+		size += i->m_size;
+	}
+	return size;
+}
+
+bool
+TCPSocket::sendFileRange()
+{
+	// note -- must have m_mutex locked on entry
+
+	FileRange& range = m_fileRanges.front();
+	size_t n;
+	if (range.m_fd != -1) {
+		bool fileEnded;
+		n = ARCH->sendFileOnSocket(m_socket,
+							range.m_fd, range.m_offset, range.m_size, fileEnded);
+		if (fileEnded) {
+			// the file was truncated under us.  the receiver was told
+			// the size of the range, so fill it in with zeros.
+			LOG((CLOG_WARN "file ended %d bytes early, sending zeros", range.m_size));
+#if HAVE_SYS_SENDFILE_H
+			::close(range.m_fd);
+#endif
+			range.m_fd = -1;
+			range.m_truncated->run();
+		}
+	}
+	else {
+		n = ARCH->writeSocket(m_socket, s_zeros,
+							std::min<size_t>(range.m_size, sizeof(s_zeros)));
+	}
+	range.m_offset += n;
+	range.m_size   -= static_cast<UInt32>(n);
+	if (range.m_size > 0) {
+		return false;
+	}
+
+	closeFileRange(range);
+	m_fileRanges.pop_front();
+
+	// output written after the last range no longer waits for any
+	if (m_fileRanges.empty()) {
+		m_outputAfterRanges = 0;
+	}
+	return true;
+}
+
+void
+TCPSocket::closeFileRange(FileRange& range)
+{
+#if HAVE_SYS_SENDFILE_H
+	if (range.m_fd != -1) {
+		::close(range.m_fd);
+	}
+#endif
+	range.m_done->run();
+	delete range.m_done;
+	delete range.m_truncated;
+}
+
+void
+TCPSocket::finishFileRanges()
+{
+	// the file data is discarded but whoever queued it is still told
+	// it's done with
+	for (FileRangeList::iterator i = m_fileRanges.begin();
+							i != m_fileRanges.end(); ++i) {
+		closeFileRange(*i);
+	}
+	m_fileRanges.clear();
+	m_outputAfterRanges = 0;
+}
+
 ISocketMultiplexerJob*
 TCPSocket::serviceConnecting(ISocketMultiplexerJob* job,
 				bool, bool write, bool error)
@@ -448,7 +703,7 @@ TCPSocket::serviceConnecting(ISocketMultiplexerJob* job,
 	}
 
 	if (write) {
-		sendEvent(m_events->forIDataSocket().connected());
+		sendEvent(kIDataSocketConnected);
 		onConnected();
 		return newJob();
 	}
@@ -463,52 +718,55 @@ TCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 	Lock lock(&m_mutex);
 
 	if (error) {
-		sendEvent(m_events->forISocket().disconnected());
+		sendEvent(kISocketDisconnected);
 		onDisconnected();
 		return newJob();
 	}
 
 	bool needNewJob = false;
-	
-	static bool s_retry = false;
-	static int s_retrySize = 0;
-	static void* s_staticBuffer = NULL;
 
 	if (write) {
 		try {
-			// write data
-			int bufferSize = 0;
+			// write data straight from the output buffer.  a secure write
+			// that must be retried is retried with the same bytes, which
+			// stay at the front of the buffer until written.
+			UInt32 bufferSize = m_outputBuffer.getSize();
+			if (!m_fileRanges.empty()) {
+				// stop at the next file range and send it once the
+				// output ahead of it has been written
+				bufferSize = m_fileRanges.front().m_before;
+				if (bufferSize == 0 && m_writeRetrySize == 0) {
+					if (sendFileRange() && !hasOutput()) {
+						sendEvent(kIStreamOutputFlushed, Event::kCollapse);
+						m_flushed = true;
+						m_flushed.broadcast();
+						return newJob();
+					}
+					return job;
+				}
+			}
+			if (m_writeRetrySize != 0) {
+				bufferSize = m_writeRetrySize;
+			}
 			int bytesWrote = 0;
 			int status = 0;
 
-			if (s_retry) {
-				bufferSize = s_retrySize;
-			}
-			else {
-				bufferSize = m_outputBuffer.getSize();
-				s_staticBuffer = malloc(bufferSize);
-				memcpy(s_staticBuffer, m_outputBuffer.peek(bufferSize), bufferSize);
- 			}
-
 			if (bufferSize == 0) {
 				return job;
 			}
+			const void* buffer = m_outputBuffer.peek(bufferSize);
 
 			if (isSecure()) {
 				if (isSecureReady()) {
-					status = secureWrite(s_staticBuffer, bufferSize, bytesWrote);
+					status = secureWrite(buffer, bufferSize, bytesWrote);
 					if (status > 0) {
-						s_retry = false;
-						bufferSize = 0;
-						free(s_staticBuffer);
-						s_staticBuffer = NULL;
+						m_writeRetrySize = 0;
 					}
 					else if (status < 0) {
 						return NULL;
 					}
 					else if (status == 0) {
-						s_retry = true;
-						s_retrySize = bufferSize;
+						m_writeRetrySize = bufferSize;
 						return newJob();
 					}
 				}
@@ -517,17 +775,17 @@ TCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 				}
 			}
 			else {
-				bytesWrote = (UInt32)ARCH->writeSocket(m_socket, s_staticBuffer, bufferSize);
-				bufferSize = 0;
-				free(s_staticBuffer);
-				s_staticBuffer = NULL;
+				bytesWrote = (UInt32)ARCH->writeSocket(m_socket, buffer, bufferSize);
 			}
 
 			// discard written data
 			if (bytesWrote > 0) {
 				m_outputBuffer.pop(bytesWrote);
-				if (m_outputBuffer.getSize() == 0) {
-					sendEvent(m_events->forIStream().outputFlushed());
+				if (!m_fileRanges.empty()) {
+					m_fileRanges.front().m_before -= bytesWrote;
+				}
+				if (!hasOutput()) {
+					sendEvent(kIStreamOutputFlushed, Event::kCollapse);
 					m_flushed = true;
 					m_flushed.broadcast();
 					needNewJob = true;
@@ -538,9 +796,9 @@ TCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 			// remote read end of stream hungup.  our output side
 			// has therefore shutdown.
 			onOutputShutdown();
-			sendEvent(m_events->forIStream().outputShutdown());
+			sendEvent(kIStreamOutputShutdown);
 			if (!m_readable && m_inputBuffer.getSize() == 0) {
-				sendEvent(m_events->forISocket().disconnected());
+				sendEvent(kISocketDisconnected);
 				m_connected = false;
 			}
 			needNewJob = true;
@@ -548,15 +806,15 @@ TCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 		catch (XArchNetworkDisconnected&) {
 			// stream hungup
 			onDisconnected();
-			sendEvent(m_events->forISocket().disconnected());
+			sendEvent(kISocketDisconnected);
 			needNewJob = true;
 		}
 		catch (XArchNetwork& e) {
 			// other write error
 			LOG((CLOG_WARN "error writing socket: %s", e.what()));
 			onDisconnected();
-			sendEvent(m_events->forIStream().outputError());
-			sendEvent(m_events->forISocket().disconnected());
+			sendEvent(kIStreamOutputError);
+			sendEvent(kISocketDisconnected);
 			needNewJob = true;
 		}
 	}
@@ -593,6 +851,20 @@ TCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 				do {
 					m_inputBuffer.write(buffer, bytesRead);
 
+					// leave the rest in the kernel while over the memory
+					// budget and this socket is holding a lot of it;  the
+					// peer's sends then back up.  not for secure sockets
+					// since data already decrypted into the ssl buffer
+					// wouldn't wake us up again.
+					if (!isSecure() &&
+						m_inputBuffer.getSize() >= kThrottleInputSize &&
+						MemoryBudget::isExhausted()) {
+						LOG((CLOG_DEBUG1 "memory budget exhausted, throttling socket input"));
+						m_inputThrottled = true;
+						needNewJob       = true;
+						break;
+					}
+
 					if (isSecure() && isSecureReady()) {
 						status = secureRead(buffer, sizeof(buffer), bytesRead);
 						if (status < 0) {
@@ -607,16 +879,16 @@ TCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 
 				// send input ready if input buffer was empty
 				if (wasEmpty) {
-					sendEvent(m_events->forIStream().inputReady());
+					sendEvent(kIStreamInputReady, Event::kCollapse);
 				}
 			}
 			else {
 				// remote write end of stream hungup.  our input side
 				// has therefore shutdown but don't flush our buffer
 				// since there's still data to be read.
-				sendEvent(m_events->forIStream().inputShutdown());
+				sendEvent(kIStreamInputShutdown);
 				if (!m_writable && m_inputBuffer.getSize() == 0) {
-					sendEvent(m_events->forISocket().disconnected());
+					sendEvent(kISocketDisconnected);
 					m_connected = false;
 				}
 				m_readable = false;
@@ -625,7 +897,7 @@ TCPSocket::serviceConnected(ISocketMultiplexerJob* job,
 		}
 		catch (XArchNetworkDisconnected&) {
 			// stream hungup
-			sendEvent(m_events->forISocket().disconnected());
+			sendEvent(kISocketDisconnected);
 			onDisconnected();
 			needNewJob = true;
 		}
@@ -19,13 +19,16 @@
 #pragma once
 
 #include "net/IDataSocket.h"
+#include "io/IFileSender.h"
 #include "io/StreamBuffer.h"
 #include "mt/CondVar.h"
 #include "mt/Mutex.h"
 #include "arch/IArchNetwork.h"
+#include "common/stddeque.h"
 
 class Mutex;
 class Thread;
+class IJob;
 class ISocketMultiplexerJob;
 class IEventQueue;
 class SocketMultiplexer;
@@ -34,7 +37,7 @@ class SocketMultiplexer;
 /*!
 A data socket using TCP.
 */
-class TCPSocket : public IDataSocket {
+class TCPSocket : public IDataSocket, public synergy::IFileSender {
 public:
 	TCPSocket(IEventQueue* events, SocketMultiplexer* socketMultiplexer);
 	TCPSocket(IEventQueue* events, SocketMultiplexer* socketMultiplexer, ArchSocket socket);
@@ -54,10 +57,17 @@ public:
 	virtual bool		isReady() const;
 	virtual bool		isFatal() const;
 	virtual UInt32		getSize() const;
+	virtual UInt32		getUnsentSize() const;
 
 	// IDataSocket overrides
 	virtual void		connect(const NetworkAddress&);
 
+	// IFileSender overrides
+	virtual bool		writeFile(const void* header, UInt32 headerSize,
+							int fd, size_t offset, UInt32 size,
+							IJob* done, IJob* truncated);
+	virtual bool		canSendFile() { return !isSecure(); }
+
 	virtual void		secureConnect() {}
 	virtual void		secureAccept() {}
 	virtual void		setFingerprintFilename(String& f) {}
@@ -78,9 +88,23 @@ protected:
 
 	Mutex&				getMutex() { return m_mutex; }
 
-	void				sendEvent(Event::Type);
+	void				sendEvent(Event::Type, Event::Flags = Event::kNone);
 
 private:
+	// file data queued by writeFile().  it's sent once the m_before
+	// bytes of the output buffer ahead of it have been written.  m_fd
+	// is -1 once the file has ended early and the rest is zeros.
+	class FileRange {
+	public:
+		UInt32			m_before;
+		int				m_fd;
+		size_t			m_offset;
+		UInt32			m_size;
+		IJob*			m_done;
+		IJob*			m_truncated;
+	};
+	typedef std::deque<FileRange> FileRangeList;
+
 	void				init();
 
 	void				sendConnectionFailedEvent(const char*);
@@ -89,6 +113,13 @@ private:
 	void				onOutputShutdown();
 	void				onDisconnected();
 
+	bool				hasOutput() const;
+	UInt32				getOutputSize() const;
+	void				flushInline();
+	bool				sendFileRange();
+	void				closeFileRange(FileRange&);
+	void				finishFileRanges();
+
 	ISocketMultiplexerJob*
 						serviceConnecting(ISocketMultiplexerJob*,
 							bool, bool, bool);
@@ -107,6 +138,15 @@ private:
 	StreamBuffer		m_outputBuffer;
 	CondVar<bool>		m_flushed;
 	bool				m_connected;
+	bool				m_inputThrottled;
+
+	// bytes a secure write must be retried with, 0 if none is pending
+	UInt32				m_writeRetrySize;
+
+	// file ranges waiting to be sent and the bytes of the output buffer
+	// written after the last of them
+	FileRangeList		m_fileRanges;
+	UInt32				m_outputAfterRanges;
 	IEventQueue*		m_events;
 	SocketMultiplexer*	m_socketMultiplexer;
 };
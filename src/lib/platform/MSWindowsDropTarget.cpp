@@ -91,7 +91,7 @@ MSWindowsDropTarget::queryDataObject(IDataObject* dataObject)
 }
 
 void
-MSWindowsDropTarget::setDraggingFilename(char* const filename)
+MSWindowsDropTarget::setDraggingFilename(const std::string& filename)
 {
 	m_dragFilename = filename;
 }
@@ -123,22 +123,32 @@ getDropData(IDataObject* dataObject)
 
 			// data object global handler contains:
 			// DROPFILESfilename1 filename2 two spaces as the end
-			// TODO: get multiple filenames
+			// the files are passed on one per line
+			std::string files;
 			wchar_t* wcData = (wchar_t*)((LPBYTE)data + sizeof(DROPFILES));
+			while (*wcData != L'\0') {
+				size_t length = wcslen(wcData);
 
-			// convert wchar to char
-			char* filename = new char[wcslen(wcData) + 1];
-			filename[wcslen(wcData)] = '\0';
-			wcstombs(filename, wcData, wcslen(wcData));
+				// convert wchar to char
+				char* filename = new char[length + 1];
+				filename[length] = '\0';
+				wcstombs(filename, wcData, length);
 
-			MSWindowsDropTarget::instance().setDraggingFilename(filename);
+				if (!files.empty()) {
+					files.append("\n");
+				}
+				files.append(filename);
+				delete[] filename;
+
+				wcData += length + 1;
+			}
+
+			MSWindowsDropTarget::instance().setDraggingFilename(files);
 			
 			GlobalUnlock(stgMed.hGlobal);
 
 			// release the data using the COM API
 			ReleaseStgMedium(&stgMed);
-
-			delete[] filename;
 		}
 	}
 }
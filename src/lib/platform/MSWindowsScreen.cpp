@@ -388,17 +388,17 @@ MSWindowsScreen::leave()
 void
 MSWindowsScreen::sendDragThread(void*)
 {
-	String& draggingFilename = getDraggingFilename();
-	size_t size = draggingFilename.size();
-
-	if (draggingFilename.empty() == false) {
+	DragFileList fileList;
+	if (DragInformation::parseDraggingFiles(fileList,
+			getDraggingFilename()) > 0) {
 		ClientApp& app = ClientApp::instance();
 		Client* client = app.getClientPtr();
-		UInt32 fileCount = 1;
-		LOG((CLOG_DEBUG "send dragging info to server: %s", draggingFilename.c_str()));
-		client->sendDragInfo(fileCount, draggingFilename, size);
+		String info;
+		UInt32 fileCount = DragInformation::setupDragInfo(fileList, info);
+		LOG((CLOG_DEBUG "send dragging info to server: %s", info.c_str()));
+		client->sendDragInfo(fileCount, info, info.size());
 		LOG((CLOG_DEBUG "send dragging file to server"));
-		client->sendFileToServer(draggingFilename.c_str());
+		client->sendFilesToServer(fileList);
 	}
 	
 	m_draggingStarted = false;
@@ -1940,11 +1940,19 @@ MSWindowsScreen::getDraggingFilename()
 		ShowWindow(m_dropWindow, SW_HIDE);
 
 		if (!filename.empty()) {
-			if (DragInformation::isFileValid(filename)) {
-				m_draggingFilename = filename;
+			DragFileList fileList;
+			DragInformation::parseDraggingFiles(fileList, filename);
+
+			bool valid = true;
+			for (size_t i = 0; i < fileList.size(); ++i) {
+				if (!DragInformation::isFileValid(fileList[i].getFilename())) {
+					LOG((CLOG_DEBUG "drag file name is invalid: %s",
+						fileList[i].getFilename().c_str()));
+					valid = false;
+				}
 			}
-			else {
-				LOG((CLOG_DEBUG "drag file name is invalid: %s", filename.c_str()));
+			if (valid) {
+				m_draggingFilename = filename;
 			}
 		}
 
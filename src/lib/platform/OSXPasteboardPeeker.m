@@ -30,7 +30,7 @@ getDraggedFileURL()
 	NSArray* files = [pboard propertyListForType:NSFilenamesPboardType];
 	for (id file in files) {
 		[string appendString: (NSString*)file];
-		[string appendString: @"\0"];
+		[string appendString: @"\n"];
 	}
 	
 	return (CFStringRef)string;
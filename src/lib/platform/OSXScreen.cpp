@@ -905,23 +905,20 @@ OSXScreen::leave()
 		String& fileList = getDraggingFilename();
 		
 		if (!m_isPrimary) {
-			if (fileList.empty() == false) {
+			DragFileList dragFileList;
+			if (DragInformation::parseDraggingFiles(
+					dragFileList, fileList) > 0) {
 				ClientApp& app = ClientApp::instance();
 				Client* client = app.getClientPtr();
 				
-				DragInformation di;
-				di.setFilename(fileList);
-				DragFileList dragFileList;
-				dragFileList.push_back(di);
 				String info;
 				UInt32 fileCount = DragInformation::setupDragInfo(
 					dragFileList, info);
 				client->sendDragInfo(fileCount, info, info.size());
 				LOG((CLOG_DEBUG "send dragging file to server"));
 				
-				// TODO: what to do with multiple file or even
-				// a folder
-				client->sendFileToServer(fileList.c_str());
+				// TODO: what to do with a folder
+				client->sendFilesToServer(dragFileList);
 			}
 		}
 		m_draggingStarted = false;
@@ -49,24 +49,24 @@ XWindowsClipboard::XWindowsClipboard(Display* display,
 	m_timeLost(0)
 {
 	// get some atoms
-	m_atomTargets         = XInternAtom(m_display, "TARGETS", False);
-	m_atomMultiple        = XInternAtom(m_display, "MULTIPLE", False);
-	m_atomTimestamp       = XInternAtom(m_display, "TIMESTAMP", False);
-	m_atomInteger         = XInternAtom(m_display, "INTEGER", False);
-	m_atomAtom            = XInternAtom(m_display, "ATOM", False);
-	m_atomAtomPair        = XInternAtom(m_display, "ATOM_PAIR", False);
-	m_atomData            = XInternAtom(m_display, "CLIP_TEMPORARY", False);
-	m_atomINCR            = XInternAtom(m_display, "INCR", False);
-	m_atomMotifClipLock   = XInternAtom(m_display, "_MOTIF_CLIP_LOCK", False);
-	m_atomMotifClipHeader = XInternAtom(m_display, "_MOTIF_CLIP_HEADER", False);
-	m_atomMotifClipAccess = XInternAtom(m_display,
-								"_MOTIF_CLIP_LOCK_ACCESS_VALID", False);
-	m_atomGDKSelection    = XInternAtom(m_display, "GDK_SELECTION", False);
+	m_atomTargets         = XWindowsUtil::getAtom(m_display, "TARGETS");
+	m_atomMultiple        = XWindowsUtil::getAtom(m_display, "MULTIPLE");
+	m_atomTimestamp       = XWindowsUtil::getAtom(m_display, "TIMESTAMP");
+	m_atomInteger         = XWindowsUtil::getAtom(m_display, "INTEGER");
+	m_atomAtom            = XWindowsUtil::getAtom(m_display, "ATOM");
+	m_atomAtomPair        = XWindowsUtil::getAtom(m_display, "ATOM_PAIR");
+	m_atomData            = XWindowsUtil::getAtom(m_display, "CLIP_TEMPORARY");
+	m_atomINCR            = XWindowsUtil::getAtom(m_display, "INCR");
+	m_atomMotifClipLock   = XWindowsUtil::getAtom(m_display, "_MOTIF_CLIP_LOCK");
+	m_atomMotifClipHeader = XWindowsUtil::getAtom(m_display, "_MOTIF_CLIP_HEADER");
+	m_atomMotifClipAccess = XWindowsUtil::getAtom(m_display,
+								"_MOTIF_CLIP_LOCK_ACCESS_VALID");
+	m_atomGDKSelection    = XWindowsUtil::getAtom(m_display, "GDK_SELECTION");
 
 	// set selection atom based on clipboard id
 	switch (id) {
 	case kClipboardClipboard:
-		m_selection = XInternAtom(m_display, "CLIPBOARD", False);
+		m_selection = XWindowsUtil::getAtom(m_display, "CLIPBOARD");
 		break;
 
 	case kClipboardSelection:
@@ -711,7 +711,7 @@ XWindowsClipboard::motifFillCache()
 	// get the Motif item property from the root window
 	char name[18 + 20];
 	sprintf(name, "_MOTIF_CLIP_ITEM_%d", header->m_item);
-    Atom atomItem = XInternAtom(m_display, name, False);
+    Atom atomItem = XWindowsUtil::getAtom(m_display, name);
 	data = "";
 	if (!XWindowsUtil::getWindowProperty(m_display, root,
 								atomItem, &data,
@@ -739,7 +739,7 @@ XWindowsClipboard::motifFillCache()
 	for (SInt32 i = 0; i < numFormats; ++i) {
 		// get Motif format property from the root window
 		sprintf(name, "_MOTIF_CLIP_ITEM_%d", formats[i]);
-    	Atom atomFormat = XInternAtom(m_display, name, False);
+    	Atom atomFormat = XWindowsUtil::getAtom(m_display, name);
 		String data;
 		if (!XWindowsUtil::getWindowProperty(m_display, root,
 									atomFormat, &data,
@@ -821,7 +821,7 @@ XWindowsClipboard::motifGetSelection(const MotifClipFormat* format,
 	// part that i don't know.
 	char name[18 + 20];
 	sprintf(name, "_MOTIF_CLIP_ITEM_%d", format->m_data);
-   	Atom target = XInternAtom(m_display, name, False);
+   	Atom target = XWindowsUtil::getAtom(m_display, name);
 	Window root = RootWindow(m_display, DefaultScreen(m_display));
 	return XWindowsUtil::getWindowProperty(m_display, root,
 								target, data,
@@ -1281,10 +1281,11 @@ XWindowsClipboard::CICCCMGetClipboard::readClipboard(Display* display,
 	assert(actualTarget != NULL);
 	assert(data         != NULL);
 
+	XWindowsUtil::RoundTripCounter roundTrips("clipboard request");
 	LOG((CLOG_DEBUG1 "request selection=%s, target=%s, window=%x", XWindowsUtil::atomToString(display, selection).c_str(), XWindowsUtil::atomToString(display, target).c_str(), m_requestor));
 
-	m_atomNone = XInternAtom(display, "NONE", False);
-	m_atomIncr = XInternAtom(display, "INCR", False);
+	m_atomNone = XWindowsUtil::getAtom(display, "NONE");
+	m_atomIncr = XWindowsUtil::getAtom(display, "INCR");
 
 	// save output pointers
 	m_actualTarget = actualTarget;
@@ -1298,17 +1299,18 @@ XWindowsClipboard::CICCCMGetClipboard::readClipboard(Display* display,
 	XDeleteProperty(display, m_requestor, m_property);
 
 	// select window for property changes
-	XWindowAttributes attr;
-	XGetWindowAttributes(display, m_requestor, &attr);
-	XSelectInput(display, m_requestor,
-								attr.your_event_mask | PropertyChangeMask);
+	long eventMask = XWindowsUtil::getEventMask(display, m_requestor);
+	XWindowsUtil::setEventMask(display, m_requestor,
+								eventMask | PropertyChangeMask);
 
 	// request data conversion
 	XConvertSelection(display, selection, target,
 								m_property, m_requestor, m_time);
 
-	// synchronize with server before we start following timeout countdown
-	XSync(display, False);
+	// send the requests.  we don't need to wait for the server to
+	// process them;  the timeout below doesn't start until we first
+	// look for the reply.
+	XFlush(display);
 
 	// Xlib inexplicably omits the ability to wait for an event with
 	// a timeout.  (it's inexplicable because there's no portable way
@@ -1358,7 +1360,7 @@ XWindowsClipboard::CICCCMGetClipboard::readClipboard(Display* display,
 	}
 
 	// restore mask
-	XSelectInput(display, m_requestor, attr.your_event_mask);
+	XWindowsUtil::setEventMask(display, m_requestor, eventMask);
 
 	// return success or failure
 	LOG((CLOG_DEBUG1 "request %s", m_failed ? "failed" : "succeeded"));
@@ -18,6 +18,8 @@
 
 #include "platform/XWindowsClipboardBMPConverter.h"
 
+#include "platform/XWindowsUtil.h"
+
 // BMP file header structure
 struct CBMPHeader {
 public:
@@ -73,7 +75,7 @@ toLE(UInt8*& dst, UInt32 src)
 
 XWindowsClipboardBMPConverter::XWindowsClipboardBMPConverter(
 				Display* display) :
-	m_atom(XInternAtom(display, "image/bmp", False))
+	m_atom(XWindowsUtil::getAtom(display, "image/bmp"))
 {
 	// do nothing
 }
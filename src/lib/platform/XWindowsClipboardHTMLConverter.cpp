@@ -18,6 +18,7 @@
 
 #include "platform/XWindowsClipboardHTMLConverter.h"
 
+#include "platform/XWindowsUtil.h"
 #include "base/Unicode.h"
 
 //
@@ -26,7 +27,7 @@
 
 XWindowsClipboardHTMLConverter::XWindowsClipboardHTMLConverter(
 				Display* display, const char* name) :
-	m_atom(XInternAtom(display, name, False))
+	m_atom(XWindowsUtil::getAtom(display, name))
 {
 	// do nothing
 }
@@ -18,13 +18,15 @@
 
 #include "platform/XWindowsClipboardUTF8Converter.h"
 
+#include "platform/XWindowsUtil.h"
+
 //
 // XWindowsClipboardUTF8Converter
 //
 
 XWindowsClipboardUTF8Converter::XWindowsClipboardUTF8Converter(
 				Display* display, const char* name) :
-	m_atom(XInternAtom(display, name, False))
+	m_atom(XWindowsUtil::getAtom(display, name))
 {
 	// do nothing
 }
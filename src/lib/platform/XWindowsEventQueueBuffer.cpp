@@ -18,8 +18,11 @@
 
 #include "platform/XWindowsEventQueueBuffer.h"
 
+#include "platform/XWindowsUtil.h"
+
 #include "mt/Lock.h"
 #include "mt/Thread.h"
+#include "arch/Arch.h"
 #include "base/Event.h"
 #include "base/IEventQueue.h"
 
@@ -53,16 +56,21 @@ class EventQueueTimer { };
 //
 
 XWindowsEventQueueBuffer::XWindowsEventQueueBuffer(
-		Display* display, Window window, IEventQueue* events) :
+		Display* display, Window window, IEventQueue* events,
+		SocketMultiplexer* reactor) :
 	m_events(events),
 	m_display(display),
 	m_window(window),
-	m_waiting(false)
+	m_waiting(false),
+	m_reactor(reactor),
+	m_servicing(false)
 {
+	assert(m_reactor == NULL || m_reactor->isReactor());
+
 	assert(m_display != NULL);
 	assert(m_window  != None);
 
-	m_userEvent = XInternAtom(m_display, "SYNERGY_USER_EVENT", False);
+	m_userEvent = XWindowsUtil::getAtom(m_display, "SYNERGY_USER_EVENT");
 	// set up for pipe hack
 	int result = pipe(m_pipefd);
 	assert(result == 0);
@@ -164,7 +172,12 @@ XWindowsEventQueueBuffer::waitForEvent(double dtimeout)
 
 	while (((dtimeout < 0.0) || (remaining > 0)) && QLength(m_display)==0 && retval==0){
 #if HAVE_POLL
-	retval = poll(pfds, 2, TIMEOUT_DELAY); //16ms = 60hz, but we make it > to play nicely with the cpu
+	if (m_reactor != NULL) {
+		retval = pollWithSockets(pfds, TIMEOUT_DELAY);
+	}
+	else {
+		retval = poll(pfds, 2, TIMEOUT_DELAY); //16ms = 60hz, but we make it > to play nicely with the cpu
+	}
  	if (pfds[1].revents & POLLIN) {
  		ssize_t read_response = read(m_pipefd[0], buf, 15);
 		
@@ -200,8 +213,26 @@ XWindowsEventQueueBuffer::waitForEvent(double dtimeout)
 IEventQueueBuffer::Type
 XWindowsEventQueueBuffer::getEvent(Event& event, UInt32& dataID)
 {
+	// service the reactor's sockets on every pass.  waitForEvent() isn't
+	// called while X events are pending, so a busy X connection would
+	// otherwise keep the sockets from being read.
+#if HAVE_POLL
+	if (m_reactor != NULL) {
+		serviceSockets();
+	}
+#endif
+
 	Lock lock(&m_mutex);
 
+	// events from the reactor's sockets come first.  they were added
+	// after anything already sent through the X server but there's
+	// no ordering between the two.
+	if (!m_inlineEvents.empty()) {
+		dataID = m_inlineEvents.front();
+		m_inlineEvents.pop_front();
+		return kUser;
+	}
+
 	// push out pending events
 	flush();
 
@@ -232,8 +263,16 @@ XWindowsEventQueueBuffer::addEvent(UInt32 dataID)
 	xevent.xclient.format       = 32;
 	xevent.xclient.data.l[0]    = static_cast<long>(dataID);
 
-	// save the message
 	Lock lock(&m_mutex);
+
+	// a socket being serviced in waitForEvent() is on our thread, so
+	// there's no one to wake and no need to go via the X server
+	if (m_servicing) {
+		m_inlineEvents.push_back(dataID);
+		return true;
+	}
+
+	// save the message
 	m_postedEvents.push_back(xevent);
 
 	// if we're currently waiting for an event then send saved events to
@@ -262,7 +301,7 @@ bool
 XWindowsEventQueueBuffer::isEmpty() const
 {
 	Lock lock(&m_mutex);
-	return (XPending(m_display) == 0 );
+	return (m_inlineEvents.empty() && XPending(m_display) == 0 );
 }
 
 EventQueueTimer*
@@ -289,3 +328,89 @@ XWindowsEventQueueBuffer::flush()
 	XFlush(m_display);
 	m_postedEvents.clear();
 }
+
+#if HAVE_POLL
+void
+XWindowsEventQueueBuffer::serviceSockets()
+{
+	struct pollfd pfds[2];
+	pfds[0].fd     = ConnectionNumber(m_display);
+	pfds[0].events = POLLIN;
+	pfds[1].fd     = m_pipefd[0];
+	pfds[1].events = POLLIN;
+	pollWithSockets(pfds, 0);
+}
+
+int
+XWindowsEventQueueBuffer::pollWithSockets(struct pollfd* pfds, int timeout)
+{
+	// the X connection and wake pipe, then the reactor's sockets
+	m_reactor->beginPoll(m_socketEntries);
+	m_pollFds.resize(2 + m_socketEntries.size());
+	m_pollFds[0] = pfds[0];
+	m_pollFds[1] = pfds[1];
+	for (size_t i = 0; i < m_socketEntries.size(); ++i) {
+		const IArchNetwork::PollEntry& entry = m_socketEntries[i];
+		struct pollfd& pfd = m_pollFds[2 + i];
+		pfd.fd      = ARCH->getPollFdOnSocket(entry.m_socket);
+		pfd.events  = 0;
+		pfd.revents = 0;
+		if ((entry.m_events & IArchNetwork::kPOLLIN) != 0) {
+			pfd.events |= POLLIN;
+		}
+		if ((entry.m_events & IArchNetwork::kPOLLOUT) != 0) {
+			pfd.events |= POLLOUT;
+		}
+	}
+
+	int n = poll(&m_pollFds[0], static_cast<nfds_t>(m_pollFds.size()), timeout);
+	pfds[0].revents = (n > 0) ? m_pollFds[0].revents : 0;
+	pfds[1].revents = (n > 0) ? m_pollFds[1].revents : 0;
+
+	// translate back
+	for (size_t i = 0; i < m_socketEntries.size(); ++i) {
+		IArchNetwork::PollEntry& entry = m_socketEntries[i];
+		short revents  = (n > 0) ? m_pollFds[2 + i].revents : 0;
+		entry.m_revents = 0;
+		if ((revents & POLLIN) != 0) {
+			entry.m_revents |= IArchNetwork::kPOLLIN;
+		}
+		if ((revents & POLLOUT) != 0) {
+			entry.m_revents |= IArchNetwork::kPOLLOUT;
+		}
+		if ((revents & POLLERR) != 0) {
+			entry.m_revents |= IArchNetwork::kPOLLERR;
+		}
+		if ((revents & POLLNVAL) != 0) {
+			entry.m_revents |= IArchNetwork::kPOLLNVAL;
+		}
+	}
+
+	// service the sockets right here.  events they add are queued for
+	// this thread instead of waking it through the X server.
+	{
+		Lock lock(&m_mutex);
+		m_servicing = true;
+	}
+	m_reactor->endPoll(m_socketEntries);
+	Lock lock(&m_mutex);
+	m_servicing = false;
+
+	if (n < 0) {
+		return n;
+	}
+
+	// only count what should stop the wait
+	int ready = 0;
+	if (pfds[0].revents != 0) {
+		++ready;
+	}
+	if (pfds[1].revents != 0) {
+		++ready;
+	}
+	if (!m_inlineEvents.empty()) {
+		++ready;
+	}
+	return ready;
+}
+#endif
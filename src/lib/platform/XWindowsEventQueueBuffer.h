@@ -18,22 +18,32 @@
 
 #pragma once
 
+#include "net/SocketMultiplexer.h"
 #include "mt/Mutex.h"
 #include "base/IEventQueueBuffer.h"
 #include "common/stdvector.h"
+#include "common/stddeque.h"
 
 #if X_DISPLAY_MISSING
 #	error X11 is required to build synergy
 #else
 #	include <X11/Xlib.h>
 #endif
+#if HAVE_POLL
+#	include <poll.h>
+#endif
 
 class IEventQueue;
 
 //! Event queue buffer for X11
+/*!
+If \p reactor isn't NULL then its sockets are polled along with the X
+connection and serviced on the thread waiting for events.
+*/
 class XWindowsEventQueueBuffer : public IEventQueueBuffer {
 public:
-	XWindowsEventQueueBuffer(Display*, Window, IEventQueue* events);
+	XWindowsEventQueueBuffer(Display*, Window, IEventQueue* events,
+							SocketMultiplexer* reactor);
 	virtual ~XWindowsEventQueueBuffer();
 
 	// IEventQueueBuffer overrides
@@ -48,6 +58,10 @@ public:
 
 private:
 	void				flush();
+#if HAVE_POLL
+	void				serviceSockets();
+	int					pollWithSockets(struct pollfd* pfds, int timeout);
+#endif
 
 private:
 	typedef std::vector<XEvent> EventList;
@@ -61,4 +75,17 @@ private:
 	bool				m_waiting;
 	int					m_pipefd[2];
 	IEventQueue*		m_events;
+
+	// reactor sockets.  events added while servicing them are kept
+	// here rather than sent through the X server and back.
+	typedef std::deque<UInt32> InlineEvents;
+	SocketMultiplexer*	m_reactor;
+	SocketMultiplexer::PollEntries
+						m_socketEntries;
+#if HAVE_POLL
+	std::vector<struct pollfd>
+						m_pollFds;
+#endif
+	bool				m_servicing;
+	InlineEvents		m_inlineEvents;
 };
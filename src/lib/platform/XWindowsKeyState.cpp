@@ -75,8 +75,10 @@ XWindowsKeyState::init(Display* display, bool useXKB)
 	XGetKeyboardControl(m_display, &m_keyboardState);
 #if HAVE_XKB_EXTENSION
 	if (useXKB) {
-		m_xkb = XkbGetMap(m_display, XkbKeyActionsMask | XkbKeyBehaviorsMask |
-								XkbAllClientInfoMask, XkbUseCoreKbd);
+		// only allocate the descriptor here.  the keyboard map itself
+		// is fetched by getKeyMap() when the key map is first built,
+		// so we don't transfer the whole map twice while starting up.
+		m_xkb = XkbGetMap(m_display, 0, XkbUseCoreKbd);
 	}
 	else {
 		m_xkb = NULL;
@@ -177,6 +179,7 @@ XWindowsKeyState::pollActiveModifiers() const
 	Window root = DefaultRootWindow(m_display), window;
 	int xRoot, yRoot, xWindow, yWindow;
 	unsigned int state = 0;
+	XWindowsUtil::countRoundTrip();
 	if (XQueryPointer(m_display, root, &root, &window,
 			&xRoot, &yRoot, &xWindow, &yWindow, &state) == False) {
 		state = 0;
@@ -195,6 +198,7 @@ XWindowsKeyState::pollActiveGroup() const
 #if HAVE_XKB_EXTENSION
 	if (m_xkb != NULL) {
 		XkbStateRec state;
+		XWindowsUtil::countRoundTrip();
 		if (XkbGetState(m_display, XkbUseCoreKbd, &state) == Success) {
 			return state.group;
 		}
@@ -207,6 +211,7 @@ void
 XWindowsKeyState::pollPressedKeys(KeyButtonSet& pressedKeys) const
 {
 	char keys[32];
+	XWindowsUtil::countRoundTrip();
 	XQueryKeymap(m_display, keys);
 	for (UInt32 i = 0; i < 32; ++i) {
 		for (UInt32 j = 0; j < 8; ++j) {
@@ -241,6 +246,7 @@ XWindowsKeyState::getKeyMap(synergy::KeyMap& keyMap)
 void
 XWindowsKeyState::fakeKey(const Keystroke& keystroke)
 {
+	XWindowsUtil::RoundTripCounter roundTrips("fake key");
 	switch (keystroke.m_type) {
 	case Keystroke::kButton:
 		LOG((CLOG_DEBUG1 "  %03x (%08x) %s", keystroke.m_data.m_button.m_button, keystroke.m_data.m_button.m_client, keystroke.m_data.m_button.m_press ? "down" : "up"));
@@ -264,10 +270,7 @@ XWindowsKeyState::fakeKey(const Keystroke& keystroke)
 			LOG((CLOG_DEBUG1 "  group %d", keystroke.m_data.m_group.m_group));
 #if HAVE_XKB_EXTENSION
 			if (m_xkb != NULL) {
-				if (XkbLockGroup(m_display, XkbUseCoreKbd,
-							keystroke.m_data.m_group.m_group) == False) {
-					LOG((CLOG_DEBUG1 "XkbLockGroup request not sent"));
-				}
+				lockGroup(keystroke.m_data.m_group.m_group);
 			}
 			else
 #endif
@@ -279,11 +282,8 @@ XWindowsKeyState::fakeKey(const Keystroke& keystroke)
 			LOG((CLOG_DEBUG1 "  group %+d", keystroke.m_data.m_group.m_group));
 #if HAVE_XKB_EXTENSION
 			if (m_xkb != NULL) {
-				if (XkbLockGroup(m_display, XkbUseCoreKbd,
-							getEffectiveGroup(pollActiveGroup(),
-								keystroke.m_data.m_group.m_group)) == False) {
-					LOG((CLOG_DEBUG1 "XkbLockGroup request not sent"));
-				}
+				lockGroup(getEffectiveGroup(pollActiveGroup(),
+								keystroke.m_data.m_group.m_group));
 			}
 			else
 #endif
@@ -296,6 +296,22 @@ XWindowsKeyState::fakeKey(const Keystroke& keystroke)
 	XFlush(m_display);
 }
 
+#if HAVE_XKB_EXTENSION
+void
+XWindowsKeyState::lockGroup(SInt32 group)
+{
+	if (XkbLockGroup(m_display, XkbUseCoreKbd, group) == False) {
+		LOG((CLOG_DEBUG1 "XkbLockGroup request not sent"));
+	}
+	else if (m_group >= 0) {
+		// assume the lock works rather than asking.  XkbStateNotify
+		// will correct us if it doesn't.  this keeps a run of relative
+		// group changes from working off a stale group.
+		m_group = group;
+	}
+}
+#endif
+
 void
 XWindowsKeyState::updateKeysymMap(synergy::KeyMap& keyMap)
 {
@@ -122,6 +122,9 @@ private:
 	bool				hasModifiersXKB() const;
 	int					getEffectiveGroup(KeyCode, int group) const;
 	UInt32				getGroupFromState(unsigned int state) const;
+#if HAVE_XKB_EXTENSION
+	void				lockGroup(SInt32 group);
+#endif
 
 	static void			remapKeyModifiers(KeyID, SInt32,
 							synergy::KeyMap::KeyItem&, void*);
@@ -44,11 +44,6 @@
 #	define XK_MISCELLANY
 #	define XK_XKB_KEYS
 #	include <X11/keysymdef.h>
-#	if HAVE_X11_EXTENSIONS_DPMS_H
-		extern "C" {
-#		include <X11/extensions/dpms.h>
-		}
-#	endif
 #	if HAVE_X11_EXTENSIONS_XTEST_H
 #		include <X11/extensions/XTest.h>
 #	else
@@ -63,6 +58,9 @@
 #	if HAVE_X11_EXTENSIONS_XRANDR_H
 #		include <X11/extensions/Xrandr.h>
 #	endif
+#	if HAVE_X11_EXTENSIONS_XFIXES_H
+#		include <X11/extensions/Xfixes.h>
+#	endif
 #	if HAVE_XKB_EXTENSION
 #		include <X11/XKBlib.h>
 #	endif
@@ -73,6 +71,10 @@
 
 static int xi_opcode;
 
+// time a clipboard must keep its new owner before it's read.  copying
+// repeatedly only reads the last copy.
+static const double		kClipboardSnapshotDelay = 0.1;
+
 //
 // XWindowsScreen
 //
@@ -95,7 +97,8 @@ XWindowsScreen::XWindowsScreen(
 		bool isPrimary,
 		bool disableXInitThreads,
 		int mouseScrollDelta,
-		IEventQueue* events) :
+		IEventQueue* events,
+		SocketMultiplexer* reactor) :
 	m_isPrimary(isPrimary),
 	m_mouseScrollDelta(mouseScrollDelta),
 	m_display(NULL),
@@ -113,12 +116,22 @@ XWindowsScreen::XWindowsScreen(
 	m_ic(NULL),
 	m_lastKeycode(0),
 	m_sequenceNumber(0),
+	m_xfixes(false),
+	m_xfixesEventBase(0),
+	m_clipboardSnapshotTimer(NULL),
 	m_screensaver(NULL),
 	m_screensaverNotify(false),
+	m_keyboardControlStale(true),
 	m_xtestIsXineramaUnaware(true),
 	m_preserveFocus(false),
 	m_xkb(false),
 	m_xi2detected(false),
+	m_rawMotionDeferred(false),
+	m_xi2Wheel(false),
+	m_wheelX(0.0),
+	m_wheelY(0.0),
+	m_fakeWheelX(0),
+	m_fakeWheelY(0),
 	m_xrandr(false),
 	m_events(events),
 	PlatformScreen(events)
@@ -141,6 +154,7 @@ XWindowsScreen::XWindowsScreen(
 
 	try {
 		m_display     = openDisplay(displayName);
+		XWindowsUtil::internAtoms(m_display);
 		m_root        = DefaultRootWindow(m_display);
 		saveShape();
 		m_window      = openWindow();
@@ -185,6 +199,9 @@ XWindowsScreen::XWindowsScreen(
 	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
 		m_clipboard[id] = new XWindowsClipboard(m_display, m_window, id);
 	}
+	if (m_isPrimary) {
+		selectClipboardOwnerEvents();
+	}
 
 	// install event handlers
 	m_events->adoptHandler(Event::kSystem, m_events->getSystemTarget(),
@@ -193,7 +210,7 @@ XWindowsScreen::XWindowsScreen(
 
 	// install the platform event queue
 	m_events->adoptBuffer(new XWindowsEventQueueBuffer(
-		m_display, m_window, m_events));
+		m_display, m_window, m_events, reactor));
 }
 
 XWindowsScreen::~XWindowsScreen()
@@ -203,6 +220,10 @@ XWindowsScreen::~XWindowsScreen()
 
 	m_events->adoptBuffer(NULL);
 	m_events->removeHandler(Event::kSystem, m_events->getSystemTarget());
+	if (m_clipboardSnapshotTimer != NULL) {
+		m_events->removeHandler(Event::kTimer, m_clipboardSnapshotTimer);
+		m_events->deleteTimer(m_clipboardSnapshotTimer);
+	}
 	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
 		delete m_clipboard[id];
 	}
@@ -231,10 +252,7 @@ XWindowsScreen::enable()
 {
 	if (!m_isPrimary) {
 		// get the keyboard control state
-		XKeyboardState keyControl;
-		XGetKeyboardControl(m_display, &keyControl);
-		m_autoRepeat = (keyControl.global_auto_repeat == AutoRepeatModeOn);
-		m_keyState->setAutoRepeat(keyControl);
+		updateKeyboardControl();
 
 		// move hider window under the cursor center
 		XMoveWindow(m_display, m_window, m_xCenter, m_yCenter);
@@ -269,6 +287,10 @@ XWindowsScreen::disable()
 void
 XWindowsScreen::enter()
 {
+	XWindowsUtil::RoundTripCounter roundTrips("enter");
+
+	// this also turns the display back on if DPMS turned it off, since
+	// we don't actually cause physical hardware input to trigger that
 	screensaver(false);
 
 	// release input context focus
@@ -283,21 +305,6 @@ XWindowsScreen::enter()
 		XSetInputFocus(m_display, m_lastFocus, m_lastFocusRevert, CurrentTime);
 	}
 
-	#if HAVE_X11_EXTENSIONS_DPMS_H
-	// Force the DPMS to turn screen back on since we don't
-	// actually cause physical hardware input to trigger it
-	int dummy;
-	CARD16 powerlevel;
-	BOOL enabled;
-	if (DPMSQueryExtension(m_display, &dummy, &dummy) &&
-	    DPMSCapable(m_display) &&
-	    DPMSInfo(m_display, &powerlevel, &enabled))
-	{
-		if (enabled && powerlevel != DPMSModeOn)
-			DPMSForceLevel(m_display, DPMSModeOn);
-	}
-	#endif
-	
 	// unmap the hider/grab window.  this also ungrabs the mouse and
 	// keyboard if they're grabbed.
 	XUnmapWindow(m_display, m_window);
@@ -308,12 +315,9 @@ XWindowsScreen::enter()
 	XSetInputFocus(m_display, PointerRoot, PointerRoot, CurrentTime);
 */
 
-	if (!m_isPrimary) {
+	if (!m_isPrimary && m_keyboardControlStale) {
 		// get the keyboard control state
-		XKeyboardState keyControl;
-		XGetKeyboardControl(m_display, &keyControl);
-		m_autoRepeat = (keyControl.global_auto_repeat == AutoRepeatModeOn);
-		m_keyState->setAutoRepeat(keyControl);
+		updateKeyboardControl();
 
 		// turn off auto-repeat.  we do this so fake key press events don't
 		// cause the local server to generate their own auto-repeats of
@@ -321,6 +325,12 @@ XWindowsScreen::enter()
 		//XAutoRepeatOff(m_display);
 	}
 
+	// partial wheel motion from before doesn't carry over
+	m_wheelX     = 0.0;
+	m_wheelY     = 0.0;
+	m_fakeWheelX = 0;
+	m_fakeWheelY = 0;
+
 	// now on screen
 	m_isOnScreen = true;
 }
@@ -376,6 +386,12 @@ XWindowsScreen::leave()
 		m_filtered.clear();
 	}
 
+	// partial wheel motion from before doesn't carry over
+	m_wheelX     = 0.0;
+	m_wheelY     = 0.0;
+	m_fakeWheelX = 0;
+	m_fakeWheelY = 0;
+
 	// now off screen
 	m_isOnScreen = false;
 
@@ -516,6 +532,7 @@ XWindowsScreen::getCursorPos(SInt32& x, SInt32& y) const
 	Window root, window;
 	int mx, my, xWindow, yWindow;
 	unsigned int mask;
+	XWindowsUtil::countRoundTrip();
 	if (XQueryPointer(m_display, m_root, &root, &window,
 								&mx, &my, &xWindow, &yWindow, &mask)) {
 		x = mx;
@@ -536,8 +553,13 @@ XWindowsScreen::reconfigure(UInt32)
 void
 XWindowsScreen::warpCursor(SInt32 x, SInt32 y)
 {
-	// warp mouse
+	XWindowsUtil::RoundTripCounter roundTrips("warp");
+
+	// warp mouse and wait for the server to process it, so the events
+	// it generated are in our queue
 	warpCursorNoFlush(x, y);
+	XWindowsUtil::countRoundTrip();
+	XSync(m_display, False);
 
 	// remove all input events before and including warp
 	XEvent event;
@@ -806,6 +828,7 @@ XWindowsScreen::isAnyMouseButtonDown(UInt32& buttonID) const
 	Window root, window;
 	int xRoot, yRoot, xWindow, yWindow;
 	unsigned int state;
+	XWindowsUtil::countRoundTrip();
 	if (XQueryPointer(m_display, m_root, &root, &window,
 								&xRoot, &yRoot, &xWindow, &yWindow, &state)) {
 		return ((state & (Button1Mask | Button2Mask | Button3Mask |
@@ -860,49 +883,70 @@ XWindowsScreen::fakeMouseRelativeMove(SInt32 dx, SInt32 dy) const
 }
 
 void
-XWindowsScreen::fakeMouseWheel(SInt32, SInt32 yDelta) const
-{
-	// XXX -- support x-axis scrolling
-	if (yDelta == 0) {
+XWindowsScreen::fakeMouseWheel(SInt32 xDelta, SInt32 yDelta) const
+{
+	// smooth scrolling sends fractions of a click.  keep what doesn't
+	// add up to a whole click for next time.
+	m_fakeWheelX += xDelta;
+	m_fakeWheelY += yDelta;
+	const SInt32 xClicks = m_fakeWheelX / m_mouseScrollDelta;
+	const SInt32 yClicks = m_fakeWheelY / m_mouseScrollDelta;
+	m_fakeWheelX -= xClicks * m_mouseScrollDelta;
+	m_fakeWheelY -= yClicks * m_mouseScrollDelta;
+	if (xClicks == 0 && yClicks == 0) {
 		return;
 	}
 
-	// choose button depending on rotation direction
-	const unsigned int xButton = mapButtonToX(static_cast<ButtonID>(
-												(yDelta >= 0) ? -1 : -2));
-	if (xButton == 0) {
-		// If we get here, then the XServer does not support the scroll
-		// wheel buttons, so send PageUp/PageDown keystrokes instead.
-		// Patch by Tom Chadwick.
-		KeyCode keycode = 0;
-		if (yDelta >= 0) {
-			keycode = XKeysymToKeycode(m_display, XK_Page_Up);
+	// choose buttons depending on rotation direction.  X buttons 6 and
+	// 7 scroll left and right, which mapButtonToX() has for 4 and 5.
+	// horizontal clicks go first since they have no fallback below.
+	if (xClicks != 0) {
+		fakeWheelClicks(mapButtonToX(static_cast<ButtonID>(
+								(xClicks >= 0) ? 5 : 4)), xClicks);
+	}
+
+	if (yClicks != 0) {
+		const unsigned int yButton = mapButtonToX(static_cast<ButtonID>(
+												(yClicks >= 0) ? -1 : -2));
+		if (yButton != 0) {
+			fakeWheelClicks(yButton, yClicks);
 		}
 		else {
-			keycode = XKeysymToKeycode(m_display, XK_Page_Down);
-		}
-		if (keycode != 0) {
-			XTestFakeKeyEvent(m_display, keycode, True,  CurrentTime);
-			XTestFakeKeyEvent(m_display, keycode, False, CurrentTime);
+			// If we get here, then the XServer does not support the scroll
+			// wheel buttons, so send PageUp/PageDown keystrokes instead.
+			// Patch by Tom Chadwick.
+			KeyCode keycode = 0;
+			if (yClicks >= 0) {
+				keycode = XKeysymToKeycode(m_display, XK_Page_Up);
+			}
+			else {
+				keycode = XKeysymToKeycode(m_display, XK_Page_Down);
+			}
+			if (keycode != 0) {
+				XTestFakeKeyEvent(m_display, keycode, True,  CurrentTime);
+				XTestFakeKeyEvent(m_display, keycode, False, CurrentTime);
+			}
 		}
-		return;
 	}
 
-	// now use absolute value of delta
-	if (yDelta < 0) {
-		yDelta = -yDelta;
-	}
+	// send all the clicks with one flush
+	XFlush(m_display);
+}
 
-	if (yDelta < m_mouseScrollDelta) {
-		LOG((CLOG_WARN "Wheel scroll delta (%d) smaller than threshold (%d)", yDelta, m_mouseScrollDelta));
+void
+XWindowsScreen::fakeWheelClicks(unsigned int xButton, SInt32 clicks) const
+{
+	if (xButton == 0) {
+		// the X server doesn't have the button
+		return;
 	}
-
-	// send as many clicks as necessary
-	for (; yDelta >= m_mouseScrollDelta; yDelta -= m_mouseScrollDelta) {
+	if (clicks < 0) {
+		clicks = -clicks;
+	}
+	for (; clicks > 0; --clicks) {
 		XTestFakeButtonEvent(m_display, xButton, True, CurrentTime);
 		XTestFakeButtonEvent(m_display, xButton, False, CurrentTime);
 	}
-	XFlush(m_display);
 }
 
 Display*
@@ -948,6 +992,13 @@ XWindowsScreen::openDisplay(const char* displayName)
 				XkbSelectEventDetails(display, XkbUseCoreKbd,
 								XkbStateNotifyMask,
 								XkbGroupStateMask, XkbGroupStateMask);
+
+				// tell us when auto-repeat changes so we needn't ask
+				// every time we enter the screen
+				XkbSelectEventDetails(display, XkbUseCoreKbd,
+								XkbControlsNotify,
+								XkbRepeatKeysMask | XkbPerKeyRepeatMask,
+								XkbRepeatKeysMask | XkbPerKeyRepeatMask);
 			}
 		}
 	}
@@ -1139,9 +1190,8 @@ XWindowsScreen::openIM()
 	m_lastKeycode = 0;
 
 	// select events on our window that IM requires
-	XWindowAttributes attr;
-	XGetWindowAttributes(m_display, m_window, &attr);
-	XSelectInput(m_display, m_window, attr.your_event_mask | mask);
+	XWindowsUtil::setEventMask(m_display, m_window,
+				XWindowsUtil::getEventMask(m_display, m_window) | mask);
 }
 
 void
@@ -1181,6 +1231,11 @@ XWindowsScreen::handleSystemEvent(const Event& event, void*)
 	XEvent* xevent = reinterpret_cast<XEvent*>(event.getData());
 	assert(xevent != NULL);
 
+	// wheel motion collected from earlier events goes before this one
+	if (!isWheelBatchEvent(xevent)) {
+		flushWheel();
+	}
+
 	// update key state
 	bool isRepeat = false;
 	if (m_isPrimary) {
@@ -1270,26 +1325,45 @@ XWindowsScreen::handleSystemEvent(const Event& event, void*)
 			if (XGetEventData(m_display, cookie) &&
 				cookie->type == GenericEvent &&
 				cookie->extension == xi_opcode) {
+			if (cookie->evtype == XI_RawButtonPress) {
+				onRawButton(static_cast<XIRawEvent*>(cookie->data));
+				XFreeEventData(m_display, cookie);
+				if (QLength(m_display) == 0) {
+					flushWheel();
+				}
+				return;
+			}
+			if (cookie->evtype == XI_HierarchyChanged) {
+				// a device may have come or gone
+				queryScrollValuators();
+				XFreeEventData(m_display, cookie);
+				return;
+			}
+			if (cookie->evtype == XI_RawMotion &&
+				!onRawScroll(static_cast<XIRawEvent*>(cookie->data))) {
+				// only the wheel moved.  send it once we've read
+				// everything the X server has sent so far.
+				XFreeEventData(m_display, cookie);
+				if (QLength(m_display) == 0) {
+					flushWheel();
+				}
+				if (m_rawMotionDeferred && !isRawMotionQueued()) {
+					onRawMotion();
+				}
+				return;
+			}
 			if (cookie->evtype == XI_RawMotion) {
-				// Get current pointer's position
-				Window root, child;
-				XMotionEvent xmotion;
-				xmotion.type = MotionNotify;
-				xmotion.send_event = False; // Raw motion
-				xmotion.display = m_display;
-				xmotion.window = m_window;
-				/* xmotion's time, state and is_hint are not used */
-				unsigned int msk;
-					xmotion.same_screen = XQueryPointer(
-						m_display, m_root, &xmotion.root, &xmotion.subwindow,
-						&xmotion.x_root,
-						&xmotion.y_root,
-						&xmotion.x,
-						&xmotion.y,
-						&msk);
-					onMouseMove(xmotion);
-					XFreeEventData(m_display, cookie);
-					return;
+				flushWheel();
+				XFreeEventData(m_display, cookie);
+
+				// the next raw motion will ask where the pointer is
+				if (isRawMotionQueued()) {
+					m_rawMotionDeferred = true;
+				}
+				else {
+					onRawMotion();
+				}
+				return;
 			}
         		XFreeEventData(m_display, cookie);
 		}
@@ -1321,10 +1395,14 @@ XWindowsScreen::handleSystemEvent(const Event& event, void*)
 			// we just lost the selection.  that means someone else
 			// grabbed the selection so this screen is now the
 			// selection owner.  report that to the receiver.
+			// with XFixes the new owner is reported along with every
+			// other owner change.
 			ClipboardID id = getClipboardID(xevent->xselectionclear.selection);
 			if (id != kClipboardEnd) {
 				m_clipboard[id]->lost(xevent->xselectionclear.time);
-				sendClipboardEvent(m_events->forClipboard().clipboardGrabbed(), id);
+				if (!m_xfixes) {
+					sendClipboardEvent(m_events->forClipboard().clipboardGrabbed(), id);
+				}
 				return;
 			}
 		}
@@ -1417,10 +1495,25 @@ XWindowsScreen::handleSystemEvent(const Event& event, void*)
 				LOG((CLOG_INFO "group change: %d", xkbEvent->state.group));
 				m_keyState->setActiveGroup((SInt32)xkbEvent->state.group);
 				return;
+
+			case XkbControlsNotify:
+				LOG((CLOG_DEBUG1 "keyboard controls changed"));
+				m_keyboardControlStale = true;
+				return;
 			}
 		}
 #endif
 
+#if HAVE_X11_EXTENSIONS_XFIXES_H
+		if (m_xfixes &&
+			xevent->type == m_xfixesEventBase + XFixesSelectionNotify) {
+			XFixesSelectionNotifyEvent* notify =
+				reinterpret_cast<XFixesSelectionNotifyEvent*>(xevent);
+			onClipboardOwnerChanged(notify->selection, notify->owner);
+			return;
+		}
+#endif
+
 #if HAVE_X11_EXTENSIONS_XRANDR_H
 		if (m_xrandr) {
 			if (xevent->type == m_xrandrEventBase + RRScreenChangeNotify
@@ -1559,6 +1652,10 @@ void
 XWindowsScreen::onMousePress(const XButtonEvent& xbutton)
 {
 	LOG((CLOG_DEBUG1 "event: ButtonPress button=%d", xbutton.button));
+	if (m_xi2Wheel && xbutton.button >= 4 && xbutton.button <= 7) {
+		// raw events report the wheel
+		return;
+	}
 	ButtonID button      = mapButtonFromX(&xbutton);
 	KeyModifierMask mask = m_keyState->mapModifiersFromX(xbutton.state);
 	if (button != kButtonNone) {
@@ -1570,6 +1667,10 @@ void
 XWindowsScreen::onMouseRelease(const XButtonEvent& xbutton)
 {
 	LOG((CLOG_DEBUG1 "event: ButtonRelease button=%d", xbutton.button));
+	if (m_xi2Wheel && xbutton.button >= 4 && xbutton.button <= 7) {
+		// raw events report the wheel
+		return;
+	}
 	ButtonID button      = mapButtonFromX(&xbutton);
 	KeyModifierMask mask = m_keyState->mapModifiersFromX(xbutton.state);
 	if (button != kButtonNone) {
@@ -1577,13 +1678,53 @@ XWindowsScreen::onMouseRelease(const XButtonEvent& xbutton)
 	}
 	else if (xbutton.button == 4) {
 		// wheel forward (away from user)
-		sendEvent(m_events->forIPrimaryScreen().wheel(), WheelInfo::alloc(0, 120));
+		m_wheelY += 120.0;
 	}
 	else if (xbutton.button == 5) {
 		// wheel backward (toward user)
-		sendEvent(m_events->forIPrimaryScreen().wheel(), WheelInfo::alloc(0, -120));
+		m_wheelY -= 120.0;
 	}
 	// XXX -- support x-axis scrolling
+
+	// send the wheel once we've read everything the X server has sent
+	if (QLength(m_display) == 0) {
+		flushWheel();
+	}
+}
+
+bool
+XWindowsScreen::isWheelBatchEvent(const XEvent* xevent) const
+{
+	if (xevent->type == ButtonPress || xevent->type == ButtonRelease) {
+		const unsigned int button = xevent->xbutton.button;
+		return (button == 4 || button == 5 ||
+				(m_xi2Wheel && (button == 6 || button == 7)));
+	}
+#ifdef HAVE_XI2
+	if (m_xi2detected && xevent->type == GenericEvent &&
+		xevent->xcookie.extension == xi_opcode) {
+		// raw motion may only be the wheel, which onRawScroll() finds out
+		return (xevent->xcookie.evtype == XI_RawMotion ||
+				xevent->xcookie.evtype == XI_RawButtonPress);
+	}
+#endif
+	return false;
+}
+
+void
+XWindowsScreen::flushWheel()
+{
+	// whole units only;  smooth scrolling leaves a fraction for later
+	const SInt32 xDelta = static_cast<SInt32>(m_wheelX);
+	const SInt32 yDelta = static_cast<SInt32>(m_wheelY);
+	if (xDelta == 0 && yDelta == 0) {
+		return;
+	}
+	m_wheelX -= xDelta;
+	m_wheelY -= yDelta;
+
+	LOG((CLOG_DEBUG1 "event: wheel delta=%+d,%+d", xDelta, yDelta));
+	sendEvent(m_events->forIPrimaryScreen().wheel(), WheelInfo::alloc(xDelta, yDelta));
 }
 
 void
@@ -1703,6 +1844,68 @@ XWindowsScreen::getClipboardID(Atom selection) const
 	return kClipboardEnd;
 }
 
+void
+XWindowsScreen::selectClipboardOwnerEvents()
+{
+#if HAVE_X11_EXTENSIONS_XFIXES_H
+	int dummyError;
+	m_xfixes = XFixesQueryExtension(m_display,
+							&m_xfixesEventBase, &dummyError);
+	if (!m_xfixes) {
+		LOG((CLOG_DEBUG "XFixes not available, clipboards are read on leaving the screen"));
+		return;
+	}
+
+	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+		XFixesSelectSelectionInput(m_display, m_window,
+							m_clipboard[id]->getSelection(),
+							XFixesSetSelectionOwnerNotifyMask);
+	}
+#endif
+}
+
+void
+XWindowsScreen::onClipboardOwnerChanged(Atom selection, Window owner)
+{
+	// ignore our own grabs;  those come from another screen
+	ClipboardID id = getClipboardID(selection);
+	if (id == kClipboardEnd || owner == m_clipboard[id]->getWindow()) {
+		return;
+	}
+
+	LOG((CLOG_DEBUG1 "clipboard %d owner is now 0x%08x", id, owner));
+	sendClipboardEvent(m_events->forClipboard().clipboardGrabbed(), id);
+
+	// read the new clipboard once it settles, rather than when the
+	// cursor leaves the screen.  the primary selection is left out
+	// since its contents change while text is selected without a new
+	// owner being reported.
+	if (id != kClipboardClipboard) {
+		return;
+	}
+	if (m_clipboardSnapshotTimer != NULL) {
+		m_events->removeHandler(Event::kTimer, m_clipboardSnapshotTimer);
+		m_events->deleteTimer(m_clipboardSnapshotTimer);
+	}
+	m_clipboardSnapshotTimer =
+		m_events->newOneShotTimer(kClipboardSnapshotDelay, NULL);
+	m_events->adoptHandler(Event::kTimer, m_clipboardSnapshotTimer,
+							new TMethodEventJob<XWindowsScreen>(this,
+								&XWindowsScreen::handleClipboardSnapshotTimer));
+}
+
+void
+XWindowsScreen::handleClipboardSnapshotTimer(const Event&, void*)
+{
+	m_events->removeHandler(Event::kTimer, m_clipboardSnapshotTimer);
+	m_events->deleteTimer(m_clipboardSnapshotTimer);
+	m_clipboardSnapshotTimer = NULL;
+
+	// the receiver reads the clipboard now and prepares it for sending
+	sendClipboardEvent(m_events->forClipboard().clipboardChanged(),
+							kClipboardClipboard);
+}
+
 void
 XWindowsScreen::processClipboardRequest(Window requestor,
 				Time time, Atom property)
@@ -1940,9 +2143,11 @@ XWindowsScreen::warpCursorNoFlush(SInt32 x, SInt32 y)
 	// warp mouse
 	XWarpPointer(m_display, None, m_root, 0, 0, 0, 0, x, y);
 
-	// send an event that we can recognize after the mouse warp
+	// send an event that we can recognize after the mouse warp.  no
+	// need to wait for the server;  the events bracket the warp
+	// wherever they turn up in the queue.
 	XSendEvent(m_display, m_window, False, 0, &eventAfter);
-	XSync(m_display, False);
+	XFlush(m_display);
 
 	LOG((CLOG_DEBUG2 "warped to %d,%d", x, y));
 }
@@ -2056,6 +2261,19 @@ XWindowsScreen::refreshKeyboard(XEvent* event)
 	m_keyState->updateKeyState();
 }
 
+void
+XWindowsScreen::updateKeyboardControl()
+{
+	XKeyboardState keyControl;
+	XWindowsUtil::countRoundTrip();
+	XGetKeyboardControl(m_display, &keyControl);
+	m_autoRepeat = (keyControl.global_auto_repeat == AutoRepeatModeOn);
+	m_keyState->setAutoRepeat(keyControl);
+
+	// without XKB we can't tell when it changes
+	m_keyboardControlStale = !m_xkb;
+}
+
 
 //
 // XWindowsScreen::HotKeyItem
@@ -2087,6 +2305,15 @@ XWindowsScreen::detectXI2()
 void
 XWindowsScreen::selectXIRawMotion()
 {
+#if defined(XIScrollClass)
+	// XI 2.1 reports smooth scrolling as valuators and flags the wheel
+	// clicks the X server emulates from them
+	int major = 2;
+	int minor = 1;
+	m_xi2Wheel = (XIQueryVersion(m_display, &major, &minor) == Success &&
+					(major > 2 || minor >= 1));
+#endif
+
 	XIEventMask mask;
 
 	mask.deviceid = XIAllDevices;
@@ -2096,7 +2323,177 @@ XWindowsScreen::selectXIRawMotion()
 	memset(mask.mask, 0, 2);
     XISetMask(mask.mask, XI_RawKeyRelease);
 	XISetMask(mask.mask, XI_RawMotion);
+	if (m_xi2Wheel) {
+		XISetMask(mask.mask, XI_RawButtonPress);
+	}
 	XISelectEvents(m_display, DefaultRootWindow(m_display), &mask, 1);
 	free(mask.mask);
+
+	if (m_xi2Wheel) {
+		// find the scroll valuators, and again whenever devices change
+		mask.deviceid = XIAllDevices;
+		mask.mask_len = XIMaskLen(XI_HierarchyChanged);
+		mask.mask     = (unsigned char*)calloc(mask.mask_len, sizeof(char));
+		XISetMask(mask.mask, XI_HierarchyChanged);
+		XISelectEvents(m_display, DefaultRootWindow(m_display), &mask, 1);
+		free(mask.mask);
+
+		queryScrollValuators();
+	}
+}
+
+void
+XWindowsScreen::queryScrollValuators()
+{
+	m_scrollValuators.clear();
+
+#if defined(XIScrollClass)
+	int count;
+	XIDeviceInfo* devices = XIQueryDevice(m_display, XIAllDevices, &count);
+	if (devices == NULL) {
+		return;
+	}
+
+	for (int i = 0; i < count; ++i) {
+		for (int j = 0; j < devices[i].num_classes; ++j) {
+			if (devices[i].classes[j]->type != XIScrollClass) {
+				continue;
+			}
+			const XIScrollClassInfo* info =
+				reinterpret_cast<const XIScrollClassInfo*>(
+									devices[i].classes[j]);
+			if (info->increment == 0.0) {
+				continue;
+			}
+			ScrollValuator valuator;
+			valuator.m_deviceID  = devices[i].deviceid;
+			valuator.m_number    = info->number;
+			valuator.m_vertical  = (info->scroll_type == XIScrollTypeVertical);
+			valuator.m_increment = info->increment;
+			m_scrollValuators.push_back(valuator);
+		}
+	}
+	XIFreeDeviceInfo(devices);
+
+	LOG((CLOG_DEBUG "found %d scroll valuators",
+		static_cast<int>(m_scrollValuators.size())));
+#endif
+}
+
+bool
+XWindowsScreen::onRawScroll(const XIRawEvent* raw)
+{
+	if (m_scrollValuators.empty()) {
+		return true;
+	}
+
+	// add up the scroll valuators, in 120ths of a notch like the
+	// wheel.  report if anything else moved.
+	bool moved = false;
+	int value  = 0;
+	for (int i = 0; i < raw->valuators.mask_len * 8; ++i) {
+		if (!XIMaskIsSet(raw->valuators.mask, i)) {
+			continue;
+		}
+
+		const ScrollValuator* valuator = NULL;
+		for (ScrollValuators::const_iterator j = m_scrollValuators.begin();
+							j != m_scrollValuators.end(); ++j) {
+			if (j->m_deviceID == raw->sourceid && j->m_number == i) {
+				valuator = &*j;
+				break;
+			}
+		}
+
+		if (valuator == NULL) {
+			moved = true;
+		}
+		else if (!m_isOnScreen) {
+			double notches = raw->valuators.values[value] /
+								valuator->m_increment;
+			if (valuator->m_vertical) {
+				// positive is down, the wheel's backward
+				m_wheelY -= 120.0 * notches;
+			}
+			else {
+				m_wheelX += 120.0 * notches;
+			}
+		}
+		++value;
+	}
+	return moved;
+}
+
+bool
+XWindowsScreen::isRawMotionQueued() const
+{
+	if (QLength(m_display) == 0) {
+		return false;
+	}
+
+	// the cookie's type is filled in even before we get its data
+	XEvent xevent;
+	XPeekEvent(m_display, &xevent);
+	return (xevent.xcookie.type == GenericEvent &&
+			xevent.xcookie.extension == xi_opcode &&
+			xevent.xcookie.evtype == XI_RawMotion);
+}
+
+void
+XWindowsScreen::onRawMotion()
+{
+	m_rawMotionDeferred = false;
+
+	// Get current pointer's position
+	XMotionEvent xmotion;
+	xmotion.type = MotionNotify;
+	xmotion.send_event = False; // Raw motion
+	xmotion.display = m_display;
+	xmotion.window = m_window;
+	/* xmotion's time, state and is_hint are not used */
+	unsigned int msk;
+	XWindowsUtil::countRoundTrip();
+	xmotion.same_screen = XQueryPointer(
+		m_display, m_root, &xmotion.root, &xmotion.subwindow,
+		&xmotion.x_root,
+		&xmotion.y_root,
+		&xmotion.x,
+		&xmotion.y,
+		&msk);
+	onMouseMove(xmotion);
+}
+
+void
+XWindowsScreen::onRawButton(const XIRawEvent* raw)
+{
+	// the wheel only matters when we're sending it to a client
+	if (m_isOnScreen) {
+		return;
+	}
+
+#if defined(XIPointerEmulated)
+	// clicks emulated from scroll valuators were counted by onRawScroll()
+	if ((raw->flags & XIPointerEmulated) != 0) {
+		return;
+	}
+#endif
+
+	switch (raw->detail) {
+	case 4:
+		m_wheelY += 120.0;
+		break;
+
+	case 5:
+		m_wheelY -= 120.0;
+		break;
+
+	case 6:
+		m_wheelX -= 120.0;
+		break;
+
+	case 7:
+		m_wheelX += 120.0;
+		break;
+	}
 }
 #endif
@@ -27,18 +27,23 @@
 #	error X11 is required to build synergy
 #else
 #	include <X11/Xlib.h>
+#	ifdef HAVE_XI2
+#		include <X11/extensions/XInput2.h>
+#	endif
 #endif
 
+class EventQueueTimer;
 class XWindowsClipboard;
 class XWindowsKeyState;
 class XWindowsScreenSaver;
+class SocketMultiplexer;
 
 //! Implementation of IPlatformScreen for X11
 class XWindowsScreen : public PlatformScreen {
 public:
 	XWindowsScreen(const char* displayName, bool isPrimary,
 		bool disableXInitThreads, int mouseScrollDelta,
-		IEventQueue* events);
+		IEventQueue* events, SocketMultiplexer* reactor);
 	virtual ~XWindowsScreen();
 
 	//! @name manipulators
@@ -110,6 +115,11 @@ private:
 	// terminate a selection request
 	void				destroyClipboardRequest(Window window);
 
+	// watch for other programs taking the clipboards
+	void				selectClipboardOwnerEvents();
+	void				onClipboardOwnerChanged(Atom selection, Window owner);
+	void				handleClipboardSnapshotTimer(const Event&, void*);
+
 	// X I/O error handler
 	void				onError();
 	static int			ioErrorHandler(Display*);
@@ -136,9 +146,24 @@ private:
 	void				onMouseRelease(const XButtonEvent&);
 	void				onMouseMove(const XMotionEvent&);
 
+	// wheel motion is collected over a batch of X events and sent as
+	// one wheel event.  fakeWheelClicks() clicks an X wheel button.
+	bool				isWheelBatchEvent(const XEvent*) const;
+	void				flushWheel();
+	void				fakeWheelClicks(unsigned int xButton,
+							SInt32 clicks) const;
+
 	bool				detectXI2();
 #ifdef HAVE_XI2
 	void				selectXIRawMotion();
+	void				queryScrollValuators();
+	bool				onRawScroll(const XIRawEvent*);
+	void				onRawButton(const XIRawEvent*);
+
+	// raw motion doesn't say where the pointer is, so we have to ask.
+	// we only ask once for a run of queued raw motion events.
+	bool				isRawMotionQueued() const;
+	void				onRawMotion();
 #endif
 	void				selectEvents(Window) const;
 	void				doSelectEvents(Window) const;
@@ -150,6 +175,7 @@ private:
 	void				warpCursorNoFlush(SInt32 x, SInt32 y);
 
 	void				refreshKeyboard(XEvent*);
+	void				updateKeyboardControl();
 
 	static Bool			findKeyEvent(Display*, XEvent* xevent, XPointer arg);
 
@@ -211,6 +237,13 @@ private:
 	XWindowsClipboard*	m_clipboard[kClipboardEnd];
 	UInt32				m_sequenceNumber;
 
+	// XFixes extension stuff.  on the primary screen it reports every
+	// change of a clipboard's owner.  the timer runs while a changed
+	// clipboard settles before it's reported changed.
+	bool				m_xfixes;
+	int					m_xfixesEventBase;
+	EventQueueTimer*	m_clipboardSnapshotTimer;
+
 	// screen saver stuff
 	XWindowsScreenSaver*	m_screensaver;
 	bool				m_screensaverNotify;
@@ -222,6 +255,10 @@ private:
 	// true if global auto-repeat was enabled before we turned it off
 	bool				m_autoRepeat;
 
+	// true if the keyboard control state must be read before entering.
+	// with XKB we're told when it changes, otherwise it's always read.
+	bool				m_keyboardControlStale;
+
 	// stuff to workaround xtest being xinerama unaware.  attempting
 	// to fake a mouse motion under xinerama may behave strangely,
 	// especially if screen 0 is not at 0,0 or if faking a motion on
@@ -238,6 +275,26 @@ private:
 	int					m_xkbEventBase;
 
 	bool				m_xi2detected;
+	bool				m_rawMotionDeferred;
+
+	// wheel stuff.  on a primary screen with XI 2.1 the wheel is read
+	// from raw events, including smooth scrolling valuators, and core
+	// wheel button events are ignored.  partial notches are kept until
+	// they add up.
+	bool				m_xi2Wheel;
+	double				m_wheelX, m_wheelY;
+	mutable SInt32		m_fakeWheelX, m_fakeWheelY;
+#ifdef HAVE_XI2
+	struct ScrollValuator {
+	public:
+		int				m_deviceID;
+		int				m_number;
+		bool			m_vertical;
+		double			m_increment;
+	};
+	typedef std::vector<ScrollValuator> ScrollValuators;
+	ScrollValuators		m_scrollValuators;
+#endif
 
 	// XRandR extension stuff
 	bool                m_xrandr;
@@ -65,6 +65,7 @@ XWindowsScreenSaver::XWindowsScreenSaver(
 	m_eventTarget(eventTarget),
 	m_xscreensaver(None),
 	m_xscreensaverActive(false),
+	m_watchingRoot(false),
 	m_dpms(false),
 	m_disabled(false),
 	m_suppressDisable(false),
@@ -73,14 +74,14 @@ XWindowsScreenSaver::XWindowsScreenSaver(
 	m_events(events)
 {
 	// get atoms
-	m_atomScreenSaver           = XInternAtom(m_display,
-										"SCREENSAVER", False);
-	m_atomScreenSaverVersion    = XInternAtom(m_display,
-										"_SCREENSAVER_VERSION", False);
-	m_atomScreenSaverActivate   = XInternAtom(m_display,
-										"ACTIVATE", False);
-	m_atomScreenSaverDeactivate = XInternAtom(m_display,
-										"DEACTIVATE", False);
+	m_atomScreenSaver           = XWindowsUtil::getAtom(m_display,
+										"SCREENSAVER");
+	m_atomScreenSaverVersion    = XWindowsUtil::getAtom(m_display,
+										"_SCREENSAVER_VERSION");
+	m_atomScreenSaverActivate   = XWindowsUtil::getAtom(m_display,
+										"ACTIVATE");
+	m_atomScreenSaverDeactivate = XWindowsUtil::getAtom(m_display,
+										"DEACTIVATE");
 
 	// check for DPMS extension.  this is an alternative screen saver
 	// that powers down the display.
@@ -108,6 +109,7 @@ XWindowsScreenSaver::XWindowsScreenSaver(
 		LOG((CLOG_DEBUG "didn't set root event mask"));
 		m_rootEventMask = 0;
 	}
+	m_watchingRoot = !error;
 
 	// get the built-in settings
 	XGetScreenSaver(m_display, &m_timeout, &m_interval,
@@ -289,8 +291,11 @@ XWindowsScreenSaver::deactivate()
 		enableDPMS(false);
 	}
 
-	// try xscreensaver
-	findXScreenSaver();
+	// try xscreensaver.  this is called on every screen enter so don't
+	// search for it if we'd have seen it start.
+	if (!m_watchingRoot) {
+		findXScreenSaver();
+	}
 	if (m_xscreensaver != None) {
 		sendXScreenSaverCommand(m_atomScreenSaverDeactivate);
 		return;
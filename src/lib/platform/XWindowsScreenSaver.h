@@ -130,6 +130,10 @@ private:
 	// old event mask on root window
 	long				m_rootEventMask;
 
+	// true if top-level windows are watched, in which case a new
+	// xscreensaver window is found by its events
+	bool				m_watchingRoot;
+
 	// potential xscreensaver windows being watched
 	WatchList			m_watchWindows;
 
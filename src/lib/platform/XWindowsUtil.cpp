@@ -1286,11 +1286,48 @@ static const KeySym s_map1008FF[] =
 };
 
 
+// atoms interned up front by XWindowsUtil::internAtoms().  others are
+// interned the first time they're used.
+static const char* const s_knownAtoms[] = {
+	"ACTIVATE",
+	"ATOM",
+	"ATOM_PAIR",
+	"CLIPBOARD",
+	"CLIP_TEMPORARY",
+	"DEACTIVATE",
+	"GDK_SELECTION",
+	"INCR",
+	"INTEGER",
+	"MULTIPLE",
+	"NONE",
+	"SCREENSAVER",
+	"STRING",
+	"SYNERGY_USER_EVENT",
+	"TARGETS",
+	"TIMESTAMP",
+	"UTF8_STRING",
+	"_MOTIF_CLIP_HEADER",
+	"_MOTIF_CLIP_LOCK",
+	"_MOTIF_CLIP_LOCK_ACCESS_VALID",
+	"_SCREENSAVER_VERSION",
+	"image/bmp",
+	"text/html",
+	"text/plain",
+	"text/plain;charset=ISO-10646-UCS-2",
+	"text/plain;charset=UTF-8",
+	"text/unicode"
+};
+
+
 //
 // XWindowsUtil
 //
 
 XWindowsUtil::KeySymMap	XWindowsUtil::s_keySymToUCS4;
+XWindowsUtil::AtomMap	XWindowsUtil::s_atoms;
+XWindowsUtil::AtomNameMap	XWindowsUtil::s_atomNames;
+XWindowsUtil::EventMaskMap	XWindowsUtil::s_eventMasks;
+UInt32					XWindowsUtil::s_roundTrips = 0;
 
 bool
 XWindowsUtil::getWindowProperty(Display* display, Window window,
@@ -1430,12 +1467,11 @@ Time
 XWindowsUtil::getCurrentTime(Display* display, Window window)
 {
 	// select property events on window
-	XWindowAttributes attr;
-	XGetWindowAttributes(display, window, &attr);
-	XSelectInput(display, window, attr.your_event_mask | PropertyChangeMask);
+	long eventMask = getEventMask(display, window);
+	setEventMask(display, window, eventMask | PropertyChangeMask);
 
 	// make a property name to receive dummy change
-	Atom atom = XInternAtom(display, "TIMESTAMP", False);
+	Atom atom = getAtom(display, "TIMESTAMP");
 
 	// do a zero-length append to get the current time
 	unsigned char dummy;
@@ -1453,16 +1489,84 @@ XWindowsUtil::getCurrentTime(Display* display, Window window)
 	XEvent xevent;
 	XIfEvent(display, &xevent, &XWindowsUtil::propertyNotifyPredicate,
 								(XPointer)&filter);
+	countRoundTrip();
 	assert(xevent.type             == PropertyNotify);
 	assert(xevent.xproperty.window == window);
 	assert(xevent.xproperty.atom   == atom);
 
 	// restore event mask
-	XSelectInput(display, window, attr.your_event_mask);
+	setEventMask(display, window, eventMask);
 
 	return xevent.xproperty.time;
 }
 
+void
+XWindowsUtil::internAtoms(Display* display)
+{
+	s_atoms.clear();
+	s_atomNames.clear();
+	s_eventMasks.clear();
+
+	const int n = static_cast<int>(sizeof(s_knownAtoms) /
+									sizeof(s_knownAtoms[0]));
+	Atom atoms[sizeof(s_knownAtoms) / sizeof(s_knownAtoms[0])];
+	countRoundTrip();
+	if (XInternAtoms(display, const_cast<char**>(s_knownAtoms),
+								n, False, atoms) == 0) {
+		// leave them to getAtom()
+		return;
+	}
+	for (int i = 0; i < n; ++i) {
+		s_atoms[s_knownAtoms[i]] = atoms[i];
+		s_atomNames[atoms[i]]    = s_knownAtoms[i];
+	}
+}
+
+Atom
+XWindowsUtil::getAtom(Display* display, const char* name)
+{
+	AtomMap::const_iterator i = s_atoms.find(name);
+	if (i != s_atoms.end()) {
+		return i->second;
+	}
+
+	countRoundTrip();
+	Atom atom = XInternAtom(display, name, False);
+	if (atom != None) {
+		s_atoms[name]     = atom;
+		s_atomNames[atom] = name;
+	}
+	return atom;
+}
+
+long
+XWindowsUtil::getEventMask(Display* display, Window window)
+{
+	EventMaskMap::const_iterator i = s_eventMasks.find(window);
+	if (i != s_eventMasks.end()) {
+		return i->second;
+	}
+
+	countRoundTrip();
+	XWindowAttributes attr;
+	XGetWindowAttributes(display, window, &attr);
+	s_eventMasks[window] = attr.your_event_mask;
+	return attr.your_event_mask;
+}
+
+void
+XWindowsUtil::setEventMask(Display* display, Window window, long mask)
+{
+	XSelectInput(display, window, mask);
+	s_eventMasks[window] = mask;
+}
+
+void
+XWindowsUtil::countRoundTrip()
+{
+	++s_roundTrips;
+}
+
 KeyID
 XWindowsUtil::mapKeySymToKeyID(KeySym k)
 {
@@ -1613,13 +1717,20 @@ XWindowsUtil::atomToString(Display* display, Atom atom)
 		return "None";
 	}
 
+	AtomNameMap::const_iterator i = s_atomNames.find(atom);
+	if (i != s_atomNames.end()) {
+		return synergy::string::sprintf("%s (%d)", i->second.c_str(), (int)atom);
+	}
+
 	bool error = false;
 	XWindowsUtil::ErrorLock lock(display, &error);
+	countRoundTrip();
 	char* name = XGetAtomName(display, atom);
 	if (error) {
 		return synergy::string::sprintf("<UNKNOWN> (%d)", (int)atom);
 	}
 	else {
+		s_atomNames[atom] = name;
 		String msg = synergy::string::sprintf("%s (%d)", name, (int)atom);
 		XFree(name);
 		return msg;
@@ -1629,11 +1740,30 @@ XWindowsUtil::atomToString(Display* display, Atom atom)
 String
 XWindowsUtil::atomsToString(Display* display, const Atom* atom, UInt32 num)
 {
+	String msg;
+
+	// use the names we know if we know them all
+	UInt32 known = 0;
+	while (known < num && (atom[known] == None ||
+				s_atomNames.find(atom[known]) != s_atomNames.end())) {
+		++known;
+	}
+	if (known == num) {
+		for (UInt32 i = 0; i < num; ++i) {
+			msg += atomToString(display, atom[i]);
+			msg += ", ";
+		}
+		if (msg.size() > 2) {
+			msg.erase(msg.size() - 2);
+		}
+		return msg;
+	}
+
 	char** names = new char*[num];
 	bool error = false;
 	XWindowsUtil::ErrorLock lock(display, &error);
+	countRoundTrip();
 	XGetAtomNames(display, const_cast<Atom*>(atom), (int)num, names);
-	String msg;
 	if (error) {
 		for (UInt32 i = 0; i < num; ++i) {
 			msg += synergy::string::sprintf("<UNKNOWN> (%d), ", (int)atom[i]);
@@ -1738,6 +1868,7 @@ XWindowsUtil::ErrorLock::~ErrorLock()
 {
 	// make sure everything finishes before uninstalling handler
 	if (m_display != NULL) {
+		countRoundTrip();
 		XSync(m_display, False);
 	}
 
@@ -1749,9 +1880,12 @@ XWindowsUtil::ErrorLock::~ErrorLock()
 void
 XWindowsUtil::ErrorLock::install(ErrorHandler handler, void* data)
 {
-	// make sure everything finishes before installing handler
+	// rather than waiting for earlier requests to finish, note the
+	// first request that's ours.  internalHandler() passes errors for
+	// earlier ones on.
+	m_firstRequest = 0;
 	if (m_display != NULL) {
-		XSync(m_display, False);
+		m_firstRequest = NextRequest(m_display);
 	}
 
 	// install handler
@@ -1766,8 +1900,17 @@ XWindowsUtil::ErrorLock::install(ErrorHandler handler, void* data)
 int
 XWindowsUtil::ErrorLock::internalHandler(Display* display, XErrorEvent* event)
 {
-	if (s_top != NULL && s_top->m_handler != NULL) {
-		s_top->m_handler(display, event, s_top->m_userData);
+	// find the lock that was installed when the failed request was made
+	for (ErrorLock* lock = s_top; lock != NULL; lock = lock->m_next) {
+		if (event->serial >= lock->m_firstRequest) {
+			if (lock->m_handler != NULL) {
+				lock->m_handler(display, event, lock->m_userData);
+			}
+			return 0;
+		}
+		if (lock->m_next == NULL && lock->m_oldXHandler != NULL) {
+			return lock->m_oldXHandler(display, event);
+		}
 	}
 	return 0;
 }
@@ -1784,3 +1927,21 @@ XWindowsUtil::ErrorLock::saveHandler(Display*, XErrorEvent* e, void* flag)
 	LOG((CLOG_DEBUG1 "flagging X error: %d", e->error_code));
 	*reinterpret_cast<bool*>(flag) = true;
 }
+
+
+//
+// XWindowsUtil::RoundTripCounter
+//
+
+XWindowsUtil::RoundTripCounter::RoundTripCounter(const char* operation) :
+	m_operation(operation),
+	m_start(s_roundTrips)
+{
+	// do nothing
+}
+
+XWindowsUtil::RoundTripCounter::~RoundTripCounter()
+{
+	LOG((CLOG_DEBUG2 "%s: %d X round trips",
+				m_operation, static_cast<int>(s_roundTrips - m_start)));
+}
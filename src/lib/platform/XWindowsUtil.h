@@ -63,6 +63,42 @@ public:
 	*/
 	static Time			getCurrentTime(Display*, Window);
 
+	//! Intern atoms
+	/*!
+	Interns all the atoms synergy knows it'll need with a single request
+	and caches them for \c getAtom() and \c atomToString().  Call this
+	after opening the display;  it forgets what was cached before.
+	*/
+	static void			internAtoms(Display*);
+
+	//! Get atom
+	/*!
+	Returns the atom named \p name.  Only asks the X server the first
+	time a name is used.
+	*/
+	static Atom			getAtom(Display*, const char* name);
+
+	//! Get event mask
+	/*!
+	Returns the events we've selected on our own \p window.  Only asks
+	the X server the first time, so once a window is passed here its
+	events must only be selected with \c setEventMask().
+	*/
+	static long			getEventMask(Display*, Window window);
+
+	//! Set event mask
+	/*!
+	Selects \p mask events on our own \p window.
+	*/
+	static void			setEventMask(Display*, Window window, long mask);
+
+	//! Count a round trip
+	/*!
+	Call this where we make a request that waits for a reply from the X
+	server.  \c RoundTripCounter reports the count per operation.
+	*/
+	static void			countRoundTrip();
+
 	//! Convert KeySym to KeyID
 	/*!
 	Converts a KeySym to the equivalent KeyID.  Returns kKeyNone if the
@@ -79,7 +115,8 @@ public:
 
 	//! Convert Atom to its string
 	/*!
-	Converts \p atom to its string representation.
+	Converts \p atom to its string representation.  Names are cached,
+	so this is cheap enough to use in log messages.
 	*/
 	static String		atomToString(Display*, Atom atom);
 
@@ -128,6 +165,10 @@ public:
 	
 	ErrorLock() ignores errors
 	ErrorLock(bool* flag) sets *flag to true if any error occurs
+
+	Only errors for requests made while the lock is installed are
+	handled by it.  Errors for earlier requests go to the handler that
+	was installed when they were made.
 	*/
 	class ErrorLock {
 	public:
@@ -165,9 +206,25 @@ public:
 		void*			m_userData;
 		XErrorHandler	m_oldXHandler;
 		ErrorLock*		m_next;
+		unsigned long	m_firstRequest;
 		static ErrorLock*	s_top;
 	};
 
+	//! X round trip counter
+	/*!
+	Logs how many X round trips were counted while this object existed,
+	to check that an input or clipboard operation stays in its budget.
+	*/
+	class RoundTripCounter {
+	public:
+		RoundTripCounter(const char* operation);
+		~RoundTripCounter();
+
+	private:
+		const char*		m_operation;
+		UInt32			m_start;
+	};
+
 private:
 	class PropertyNotifyPredicateInfo {
 	public:
@@ -182,6 +239,13 @@ private:
 
 private:
 	typedef std::map<KeySym, UInt32> KeySymMap;
+	typedef std::map<String, Atom> AtomMap;
+	typedef std::map<Atom, String> AtomNameMap;
+	typedef std::map<Window, long> EventMaskMap;
 
 	static KeySymMap	s_keySymToUCS4;
+	static AtomMap		s_atoms;
+	static AtomNameMap	s_atomNames;
+	static EventMaskMap	s_eventMasks;
+	static UInt32		s_roundTrips;
 };
@@ -59,7 +59,8 @@ SecureSocket::SecureSocket(
 		SocketMultiplexer* socketMultiplexer) :
 	TCPSocket(events, socketMultiplexer),
 	m_secureReady(false),
-	m_fatal(false)
+	m_fatal(false),
+	m_kernelTlsSend(false)
 {
 }
 
@@ -69,7 +70,8 @@ SecureSocket::SecureSocket(
 		ArchSocket socket) :
 	TCPSocket(events, socketMultiplexer, socket),
 	m_secureReady(false),
-	m_fatal(false)
+	m_fatal(false),
+	m_kernelTlsSend(false)
 {
 }
 
@@ -261,7 +263,36 @@ SecureSocket::initContext(bool server)
 
 	if (m_ssl->m_context == NULL) {
 		showError();
+		return;
 	}
+
+	// data is written straight from the socket's output buffer, which
+	// may have moved by the time a write is retried
+	SSL_CTX_set_mode(m_ssl->m_context, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+#if defined(SSL_OP_ENABLE_KTLS)
+	// have the kernel encrypt and decrypt records after the handshake.
+	// openssl then uses plain reads and writes on the socket.  if the
+	// kernel has no tls module or can't do the cipher it quietly stays
+	// in user space.
+	SSL_CTX_set_options(m_ssl->m_context, SSL_OP_ENABLE_KTLS);
+#endif
+}
+
+void
+SecureSocket::setKernelTls(bool enable)
+{
+#if defined(SSL_OP_ENABLE_KTLS)
+	if (m_ssl->m_context == NULL) {
+		return;
+	}
+	if (enable) {
+		SSL_CTX_set_options(m_ssl->m_context, SSL_OP_ENABLE_KTLS);
+	}
+	else {
+		SSL_CTX_clear_options(m_ssl->m_context, SSL_OP_ENABLE_KTLS);
+	}
+#endif
 }
 
 void
@@ -307,6 +338,7 @@ SecureSocket::secureAccept(int socket)
 			showSecureCipherInfo();
 		}
 		showSecureConnectInfo();
+		checkKernelTls();
 		return 1;
 	}
 
@@ -372,6 +404,7 @@ SecureSocket::secureConnect(int socket)
 		showSecureCipherInfo();
 	}
 	showSecureConnectInfo();
+	checkKernelTls();
 	return 1;
 }
 
@@ -678,10 +711,14 @@ SecureSocket::showSecureCipherInfo()
 		showCipherStackDesc(sStack);
 	}
 
-	// m_ssl->m_ssl->session->ciphers is not forward compatable, In future release
-	// of OpenSSL, it's not visible, need to use SSL_get_client_ciphers() instead
+	// the session is opaque from openssl 1.1, which is also the first
+	// with kernel tls
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+	STACK_OF(SSL_CIPHER) * cStack = SSL_get_client_ciphers(m_ssl->m_ssl);
+#else
 	STACK_OF(SSL_CIPHER) * cStack = m_ssl->m_ssl->session->ciphers;
-		if (cStack == NULL) {
+#endif
+	if (cStack == NULL) {
 		LOG((CLOG_DEBUG1 "remote cipher list not available"));
 	}
 	else {
@@ -714,3 +751,22 @@ SecureSocket::showSecureConnectInfo()
 		}
 	return;
 }
+
+void
+SecureSocket::checkKernelTls()
+{
+	m_kernelTlsSend = false;
+#if defined(SSL_OP_ENABLE_KTLS)
+	bool send = (BIO_get_ktls_send(SSL_get_wbio(m_ssl->m_ssl)) != 0);
+	bool recv = (BIO_get_ktls_recv(SSL_get_rbio(m_ssl->m_ssl)) != 0);
+	m_kernelTlsSend = send;
+	if (send || recv) {
+		LOG((CLOG_INFO "kernel tls offload enabled for%s%s",
+			send ? " send" : "", recv ? " receive" : ""));
+	}
+	if (send && recv) {
+		return;
+	}
+#endif
+	LOG((CLOG_DEBUG "using user space tls"));
+}
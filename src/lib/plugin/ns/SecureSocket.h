@@ -50,9 +50,17 @@ public:
 	bool				isSecure() { return true; }
 	int					secureRead(void* buffer, int size, int& read);
 	int					secureWrite(const void* buffer, int size, int& wrote);
+	bool				canSendFile() { return m_kernelTlsSend; }
 	void				initSsl(bool server);
 	bool				loadCertificates(String& CertFile);
 
+	//! Allow kernel tls offload
+	/*!
+	Offload is tried by default.  Call after initSsl() and before the
+	handshake to change that.
+	*/
+	void				setKernelTls(bool enable);
+
 private:
 	// SSL
 	void				initContext(bool server);
@@ -80,9 +88,13 @@ private:
 	void				showSecureConnectInfo();
 	void				showSecureLibInfo();
 	void				showSecureCipherInfo();
+	void				checkKernelTls();
 
 private:
 	Ssl*				m_ssl;
 	bool				m_secureReady;
 	bool				m_fatal;
+
+	// the kernel encrypts what we send, so files can be sent directly
+	bool				m_kernelTlsSend;
 };
@@ -26,9 +26,12 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <set>
 #include <iterator>
 
-SecureSocket* g_secureSocket = NULL;
+// a client may hold a standby connection as well as its active one
+typedef std::set<SecureSocket*> SecureSocketSet;
+SecureSocketSet g_secureSockets;
 SecureListenSocket* g_secureListenSocket = NULL;
 Arch* g_arch = NULL;
 Log* g_log = NULL;
@@ -79,12 +82,10 @@ invoke(const char* command, void** args)
 	}
 
 	if (strcmp(command, "getSocket") == 0) {
-		if (g_secureSocket != NULL) {
-			delete g_secureSocket;
-		}
-		g_secureSocket = new SecureSocket(arg1, arg2);
-		g_secureSocket->initSsl(false);
-		return g_secureSocket;
+		SecureSocket* socket = new SecureSocket(arg1, arg2);
+		socket->initSsl(false);
+		g_secureSockets.insert(socket);
+		return socket;
 	}
 	else if (strcmp(command, "getListenSocket") == 0) {
 		if (g_secureListenSocket != NULL) {
@@ -94,9 +95,15 @@ invoke(const char* command, void** args)
 		return g_secureListenSocket;
 	}
 	else if (strcmp(command, "deleteSocket") == 0) {
-		if (g_secureSocket != NULL) {
-			delete g_secureSocket;
-			g_secureSocket = NULL;
+		// delete the given socket.  only cleanup() deletes them all.
+		SecureSocket* socket = NULL;
+		if (args != NULL) {
+			socket = reinterpret_cast<SecureSocket*>(args[0]);
+		}
+		SecureSocketSet::iterator i = g_secureSockets.find(socket);
+		if (socket != NULL && i != g_secureSockets.end()) {
+			delete socket;
+			g_secureSockets.erase(i);
 		}
 	}
 	else if (strcmp(command, "deleteListenSocket") == 0) {
@@ -115,9 +122,11 @@ invoke(const char* command, void** args)
 void
 cleanup()
 {
-	if (g_secureSocket != NULL) {
-		delete g_secureSocket;
+	for (SecureSocketSet::iterator i = g_secureSockets.begin();
+			i != g_secureSockets.end(); ++i) {
+		delete *i;
 	}
+	g_secureSockets.clear();
 
 	if (g_secureListenSocket != NULL) {
 		delete g_secureListenSocket;
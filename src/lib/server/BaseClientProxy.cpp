@@ -25,7 +25,8 @@
 BaseClientProxy::BaseClientProxy(const String& name) :
 	m_name(name),
 	m_x(0),
-	m_y(0)
+	m_y(0),
+	m_bandwidth(NULL)
 {
 	// do nothing
 }
@@ -42,6 +43,12 @@ BaseClientProxy::setJumpCursorPos(SInt32 x, SInt32 y)
 	m_y = y;
 }
 
+void
+BaseClientProxy::setBandwidth(TokenBucket* bandwidth)
+{
+	m_bandwidth = bandwidth;
+}
+
 void
 BaseClientProxy::getJumpCursorPos(SInt32& x, SInt32& y) const
 {
@@ -49,6 +56,12 @@ BaseClientProxy::getJumpCursorPos(SInt32& x, SInt32& y) const
 	y = m_y;
 }
 
+TokenBucket*
+BaseClientProxy::getBandwidth() const
+{
+	return m_bandwidth;
+}
+
 String
 BaseClientProxy::getName() const
 {
@@ -22,6 +22,8 @@
 #include "base/String.h"
 
 namespace synergy { class IStream; }
+class FileTransferResume;
+class TokenBucket;
 
 //! Generic proxy for client or primary
 class BaseClientProxy : public IClient {
@@ -41,6 +43,14 @@ public:
 	*/
 	void				setJumpCursorPos(SInt32 x, SInt32 y);
 
+	//! Set bandwidth limit
+	/*!
+	Set the bucket that bulk data (clipboard and files) sent to the
+	client is paced by.  The bucket is owned by the caller and must
+	outlive the proxy.  NULL means unlimited.
+	*/
+	void				setBandwidth(TokenBucket* bandwidth);
+
 	//@}
 	//! @name accessors
 	//@{
@@ -51,6 +61,12 @@ public:
 	*/
 	void				getJumpCursorPos(SInt32& x, SInt32& y) const;
 
+	//! Get bandwidth limit
+	/*!
+	Return the bucket set by setBandwidth().
+	*/
+	TokenBucket*		getBandwidth() const;
+
 	//! Get cursor position
 	/*!
 	Return if this proxy is for client or primary.
@@ -89,6 +105,7 @@ public:
 	virtual void		sendDragInfo(UInt32 fileCount, const char* info,
 							size_t size) = 0;
 	virtual void		fileChunkSending(UInt8 mark, char* data, size_t dataSize) = 0;
+	virtual void		fileResumeRequest(const FileTransferResume& resume) = 0;
 	virtual String		getName() const;
 	virtual synergy::IStream*
 						getStream() const = 0;
@@ -96,4 +113,5 @@ public:
 private:
 	String				m_name;
 	SInt32				m_x, m_y;
+	TokenBucket*		m_bandwidth;
 };
@@ -0,0 +1,118 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/BulkLoop.h"
+
+#include "mt/CondVar.h"
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+#include "mt/Thread.h"
+#include "base/IJob.h"
+#include "base/TMethodJob.h"
+#include "base/Log.h"
+
+//
+// BulkLoop
+//
+
+BulkLoop::BulkLoop() :
+	m_mutex(new Mutex),
+	m_jobsChanged(new CondVarBase(m_mutex)),
+	m_jobsDone(new CondVarBase(m_mutex)),
+	m_running(false),
+	m_stopping(false),
+	m_thread(NULL)
+{
+	m_thread = new Thread(new TMethodJob<BulkLoop>(this, &BulkLoop::loop));
+}
+
+BulkLoop::~BulkLoop()
+{
+	{
+		Lock lock(m_mutex);
+		m_stopping = true;
+		m_jobsChanged->broadcast();
+	}
+	m_thread->wait();
+	delete m_thread;
+
+	// jobs that didn't get to run are dropped, freeing their data
+	for (JobQueue::iterator index = m_jobs.begin();
+								index != m_jobs.end(); ++index) {
+		delete *index;
+	}
+
+	delete m_jobsDone;
+	delete m_jobsChanged;
+	delete m_mutex;
+}
+
+void
+BulkLoop::post(IJob* job)
+{
+	Lock lock(m_mutex);
+	m_jobs.push_back(job);
+	m_jobsChanged->signal();
+}
+
+void
+BulkLoop::flush()
+{
+	Lock lock(m_mutex);
+	while ((!m_jobs.empty() || m_running) && !m_stopping) {
+		m_jobsDone->wait();
+	}
+}
+
+void
+BulkLoop::loop(void*)
+{
+	LOG((CLOG_DEBUG1 "bulk loop started"));
+
+	for (;;) {
+		IJob* job;
+		{
+			Lock lock(m_mutex);
+			while (m_jobs.empty() && !m_stopping) {
+				m_jobsChanged->wait();
+			}
+			if (m_stopping) {
+				break;
+			}
+			job = m_jobs.front();
+			m_jobs.pop_front();
+			m_running = true;
+		}
+
+		// run without the lock so jobs can be posted meanwhile
+		job->run();
+		delete job;
+		{
+			Lock lock(m_mutex);
+			m_running = false;
+			m_jobsDone->broadcast();
+		}
+	}
+
+	// nothing left to wait for
+	{
+		Lock lock(m_mutex);
+		m_jobsDone->broadcast();
+	}
+
+	LOG((CLOG_DEBUG1 "bulk loop stopped"));
+}
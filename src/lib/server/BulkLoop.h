@@ -0,0 +1,74 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "common/stddeque.h"
+
+class IJob;
+class Mutex;
+class CondVarBase;
+class Thread;
+
+//! Server bulk work loop
+/*!
+Runs jobs one at a time, in the order they're posted, on a thread of
+its own.  The server posts slow work (e.g. marshalling large
+clipboards) here so it doesn't hold up the event loop routing input.
+Jobs share nothing with the event loop while they run;  they get
+copies of what they need and hand their results back by adding events
+to the event queue.
+*/
+class BulkLoop {
+public:
+	BulkLoop();
+	~BulkLoop();
+
+	//! @name manipulators
+	//@{
+
+	//! Post a job
+	/*!
+	Adopts \p job and runs it after any jobs posted before it.  Jobs
+	still queued when the loop is destroyed are deleted without running,
+	so a job should own (and free) the data it works on.
+	*/
+	void				post(IJob* job);
+
+	//! Wait for posted jobs
+	/*!
+	Returns once every job posted before the call has run.  The server
+	calls this before freeing something a queued job may still use.
+	*/
+	void				flush();
+
+	//@}
+
+private:
+	void				loop(void*);
+
+private:
+	typedef std::deque<IJob*> JobQueue;
+
+	Mutex*				m_mutex;
+	CondVarBase*		m_jobsChanged;
+	CondVarBase*		m_jobsDone;
+	JobQueue			m_jobs;
+	bool				m_running;
+	bool				m_stopping;
+	Thread*				m_thread;
+};
@@ -18,15 +18,26 @@
 
 #include "server/ClientProxy1_0.h"
 
+#include "synergy/FileChunk.h"
 #include "synergy/ProtocolUtil.h"
 #include "synergy/XSynergy.h"
 #include "io/IStream.h"
+#include "mt/Lock.h"
 #include "base/Log.h"
 #include "base/IEventQueue.h"
 #include "base/TMethodEventJob.h"
 
 #include <cstring>
 
+// bytes waiting to go out before mouse motion is coalesced.  a motion
+// message is 12 bytes, so this is well over a hundred of them.
+static const UInt32 kMotionBacklog = 2048;
+
+// how often the backlog is sampled while the mouse moves or motion is
+// held back, and the longest motion is held
+static const double kMotionSampleInterval = 0.005;
+static const double kMotionMaxHold = 0.05;
+
 //
 // ClientProxy1_0
 //
@@ -35,7 +46,14 @@ ClientProxy1_0::ClientProxy1_0(const String& name, synergy::IStream* stream, IEv
 	ClientProxy(name, stream),
 	m_heartbeatTimer(NULL),
 	m_parser(&ClientProxy1_0::parseHandshakeMessage),
-	m_events(events)
+	m_events(events),
+	m_motionPending(false),
+	m_motionX(0),
+	m_motionY(0),
+	m_motionAge(),
+	m_motionTimer(NULL),
+	m_motionMoved(false),
+	m_backedUp(false)
 {
 	// install event handlers
 	m_events->adoptHandler(m_events->forIStream().inputReady(),
@@ -54,6 +72,10 @@ ClientProxy1_0::ClientProxy1_0(const String& name, synergy::IStream* stream, IEv
 							stream->getEventTarget(),
 							new TMethodEventJob<ClientProxy1_0>(this,
 								&ClientProxy1_0::handleWriteError, NULL));
+	m_events->adoptHandler(m_events->forIStream().outputFlushed(),
+							stream->getEventTarget(),
+							new TMethodEventJob<ClientProxy1_0>(this,
+								&ClientProxy1_0::handleOutputFlushed, NULL));
 	m_events->adoptHandler(Event::kTimer, this,
 							new TMethodEventJob<ClientProxy1_0>(this,
 								&ClientProxy1_0::handleFlatline, NULL));
@@ -89,10 +111,13 @@ ClientProxy1_0::removeHandlers()
 							getStream()->getEventTarget());
 	m_events->removeHandler(m_events->forIStream().outputShutdown(),
 							getStream()->getEventTarget());
+	m_events->removeHandler(m_events->forIStream().outputFlushed(),
+							getStream()->getEventTarget());
 	m_events->removeHandler(Event::kTimer, this);
 
-	// remove timer
+	// remove timers
 	removeHeartbeatTimer();
+	removeMotionTimer();
 }
 
 void
@@ -188,7 +213,8 @@ ClientProxy1_0::parseMessage(const UInt8* code)
 	if (memcmp(code, kMsgDInfo, 4) == 0) {
 		if (recvInfo()) {
 			m_events->addEvent(
-							Event(m_events->forIScreen().shapeChanged(), getEventTarget()));
+							Event(m_events->forIScreen().shapeChanged(),
+								getEventTarget(), NULL, Event::kCollapse));
 			return true;
 		}
 		return false;
@@ -232,6 +258,7 @@ ClientProxy1_0::handleFlatline(const Event&, void*)
 bool
 ClientProxy1_0::getClipboard(ClipboardID id, IClipboard* clipboard) const
 {
+	Lock lock(&m_clipboardMutex);
 	Clipboard::copy(clipboard, &m_clipboard[id].m_clipboard);
 	return true;
 }
@@ -257,6 +284,10 @@ void
 ClientProxy1_0::enter(SInt32 xAbs, SInt32 yAbs,
 				UInt32 seqNum, KeyModifierMask mask, bool)
 {
+	// the enter position replaces any motion we were holding
+	m_motionPending = false;
+	removeMotionTimer();
+
 	LOG((CLOG_DEBUG1 "send enter to \"%s\", %d,%d %d %04x", getName().c_str(), xAbs, yAbs, seqNum, mask));
 	ProtocolUtil::writef(getStream(), kMsgCEnter,
 								xAbs, yAbs, seqNum, mask);
@@ -265,6 +296,8 @@ ClientProxy1_0::enter(SInt32 xAbs, SInt32 yAbs,
 bool
 ClientProxy1_0::leave()
 {
+	flushMotion();
+
 	LOG((CLOG_DEBUG1 "send leave to \"%s\"", getName().c_str()));
 	ProtocolUtil::writef(getStream(), kMsgCLeave);
 
@@ -297,6 +330,7 @@ ClientProxy1_0::setClipboardDirty(ClipboardID id, bool dirty)
 void
 ClientProxy1_0::keyDown(KeyID key, KeyModifierMask mask, KeyButton)
 {
+	flushMotion();
 	LOG((CLOG_DEBUG1 "send key down to \"%s\" id=%d, mask=0x%04x", getName().c_str(), key, mask));
 	ProtocolUtil::writef(getStream(), kMsgDKeyDown1_0, key, mask);
 }
@@ -305,6 +339,7 @@ void
 ClientProxy1_0::keyRepeat(KeyID key, KeyModifierMask mask,
 				SInt32 count, KeyButton)
 {
+	flushMotion();
 	LOG((CLOG_DEBUG1 "send key repeat to \"%s\" id=%d, mask=0x%04x, count=%d", getName().c_str(), key, mask, count));
 	ProtocolUtil::writef(getStream(), kMsgDKeyRepeat1_0, key, mask, count);
 }
@@ -312,6 +347,7 @@ ClientProxy1_0::keyRepeat(KeyID key, KeyModifierMask mask,
 void
 ClientProxy1_0::keyUp(KeyID key, KeyModifierMask mask, KeyButton)
 {
+	flushMotion();
 	LOG((CLOG_DEBUG1 "send key up to \"%s\" id=%d, mask=0x%04x", getName().c_str(), key, mask));
 	ProtocolUtil::writef(getStream(), kMsgDKeyUp1_0, key, mask);
 }
@@ -319,6 +355,7 @@ ClientProxy1_0::keyUp(KeyID key, KeyModifierMask mask, KeyButton)
 void
 ClientProxy1_0::mouseDown(ButtonID button)
 {
+	flushMotion();
 	LOG((CLOG_DEBUG1 "send mouse down to \"%s\" id=%d", getName().c_str(), button));
 	ProtocolUtil::writef(getStream(), kMsgDMouseDown, button);
 }
@@ -326,17 +363,110 @@ ClientProxy1_0::mouseDown(ButtonID button)
 void
 ClientProxy1_0::mouseUp(ButtonID button)
 {
+	flushMotion();
 	LOG((CLOG_DEBUG1 "send mouse up to \"%s\" id=%d", getName().c_str(), button));
 	ProtocolUtil::writef(getStream(), kMsgDMouseUp, button);
 }
 
 void
 ClientProxy1_0::mouseMove(SInt32 xAbs, SInt32 yAbs)
+{
+	// if the connection can't keep up then queueing every position only
+	// delays the newest one.  hold on to the latest position instead and
+	// send it once the backlog drains.  asking the stream for its backlog
+	// isn't cheap, so it's sampled on a timer while the mouse moves
+	// rather than on every move.
+	m_motionMoved = true;
+	addMotionTimer();
+	if (m_motionPending || m_backedUp) {
+		if (!m_motionPending) {
+			m_motionPending = true;
+			m_motionAge.reset();
+		}
+		m_motionX = xAbs;
+		m_motionY = yAbs;
+		return;
+	}
+
+	writeMotion(xAbs, yAbs);
+}
+
+void
+ClientProxy1_0::writeMotion(SInt32 xAbs, SInt32 yAbs)
 {
 	LOG((CLOG_DEBUG2 "send mouse move to \"%s\" %d,%d", getName().c_str(), xAbs, yAbs));
 	ProtocolUtil::writef(getStream(), kMsgDMouseMove, xAbs, yAbs);
 }
 
+void
+ClientProxy1_0::flushMotion()
+{
+	if (m_motionPending) {
+		m_motionPending = false;
+		writeMotion(m_motionX, m_motionY);
+	}
+}
+
+void
+ClientProxy1_0::sampleBacklog()
+{
+	m_backedUp = (getStream()->getUnsentSize() > kMotionBacklog);
+}
+
+void
+ClientProxy1_0::handleMotionTimer(const Event&, void*)
+{
+	sampleBacklog();
+
+	// send once the backlog drains, but don't let the pointer freeze
+	// on a connection that never catches up
+	if (m_motionPending) {
+		if (!m_backedUp || m_motionAge.getTime() >= kMotionMaxHold) {
+			flushMotion();
+		}
+	}
+
+	// stop sampling once the mouse stops on a connection that keeps up
+	else if (!m_motionMoved && !m_backedUp) {
+		removeMotionTimer();
+	}
+	m_motionMoved = false;
+}
+
+void
+ClientProxy1_0::handleOutputFlushed(const Event&, void*)
+{
+	// the stream's buffer emptied so the backlog may have drained.
+	// there's nothing to learn if it wasn't backed up.
+	if (m_backedUp) {
+		sampleBacklog();
+		if (!m_backedUp) {
+			flushMotion();
+		}
+	}
+}
+
+void
+ClientProxy1_0::addMotionTimer()
+{
+	if (m_motionTimer == NULL) {
+		m_motionTimer = m_events->newTimer(kMotionSampleInterval, NULL);
+		m_events->adoptHandler(Event::kTimer, m_motionTimer,
+							new TMethodEventJob<ClientProxy1_0>(this,
+								&ClientProxy1_0::handleMotionTimer));
+	}
+}
+
+void
+ClientProxy1_0::removeMotionTimer()
+{
+	if (m_motionTimer != NULL) {
+		m_events->removeHandler(Event::kTimer, m_motionTimer);
+		m_events->deleteTimer(m_motionTimer);
+		m_motionTimer = NULL;
+	}
+}
+
 void
 ClientProxy1_0::mouseRelativeMove(SInt32, SInt32)
 {
@@ -347,6 +477,7 @@ void
 ClientProxy1_0::mouseWheel(SInt32, SInt32 yDelta)
 {
 	// clients prior to 1.3 only support the y axis
+	flushMotion();
 	LOG((CLOG_DEBUG2 "send mouse wheel to \"%s\" %+d", getName().c_str(), yDelta));
 	ProtocolUtil::writef(getStream(), kMsgDMouseWheel1_0, yDelta);
 }
@@ -363,6 +494,15 @@ ClientProxy1_0::fileChunkSending(UInt8 mark, char* data, size_t dataSize)
 {
 	// ignore -- not supported in protocol 1.0
 	LOG((CLOG_DEBUG "fileChunkSending not supported"));
+	if (mark == kDataFileRange) {
+		FileChunk::discardRange(data, dataSize);
+	}
+}
+
+void
+ClientProxy1_0::fileResumeRequest(const FileTransferResume& resume)
+{
+	// ignore -- not supported before protocol 1.9
 }
 
 void
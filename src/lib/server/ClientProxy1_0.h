@@ -21,6 +21,8 @@
 #include "server/ClientProxy.h"
 #include "synergy/Clipboard.h"
 #include "synergy/protocol_types.h"
+#include "mt/Mutex.h"
+#include "base/Stopwatch.h"
 
 class Event;
 class EventQueueTimer;
@@ -60,6 +62,7 @@ public:
 	virtual void		setOptions(const OptionsList& options);
 	virtual void		sendDragInfo(UInt32 fileCount, const char* info, size_t size);
 	virtual void		fileChunkSending(UInt8 mark, char* data, size_t dataSize);
+	virtual void		fileResumeRequest(const FileTransferResume& resume);
 
 protected:
 	virtual bool		parseHandshakeMessage(const UInt8* code);
@@ -71,6 +74,15 @@ protected:
 	virtual void		addHeartbeatTimer();
 	virtual void		removeHeartbeatTimer();
 	virtual bool		recvClipboard();
+
+	//! Send held back mouse motion
+	/*!
+	Writes the latest mouse position if motion was coalesced while the
+	connection was backed up.  Other input must call this first so the
+	client sees events in the order they happened.
+	*/
+	void				flushMotion();
+
 private:
 	void				disconnect();
 	void				removeHandlers();
@@ -79,6 +91,13 @@ private:
 	void				handleDisconnect(const Event&, void*);
 	void				handleWriteError(const Event&, void*);
 	void				handleFlatline(const Event&, void*);
+	void				handleMotionTimer(const Event&, void*);
+	void				handleOutputFlushed(const Event&, void*);
+
+	void				writeMotion(SInt32 xAbs, SInt32 yAbs);
+	void				sampleBacklog();
+	void				addMotionTimer();
+	void				removeMotionTimer();
 
 	bool				recvInfo();
 	bool				recvGrabClipboard();
@@ -96,6 +115,10 @@ protected:
 
 	ClientClipboard	m_clipboard[kClipboardEnd];
 
+	// guards the contents of m_clipboard.  the server reads them on its
+	// bulk loop and they're set by its clipboard sending thread.
+	Mutex				m_clipboardMutex;
+
 private:
 	typedef bool (ClientProxy1_0::*MessageParser)(const UInt8*);
 
@@ -104,4 +127,16 @@ private:
 	EventQueueTimer*	m_heartbeatTimer;
 	MessageParser		m_parser;
 	IEventQueue*		m_events;
+
+	// mouse motion held back while the connection is backed up
+	bool				m_motionPending;
+	SInt32				m_motionX;
+	SInt32				m_motionY;
+	Stopwatch			m_motionAge;
+
+	// samples the backlog while the mouse moves.  m_backedUp is the
+	// last sample and m_motionMoved is true if the mouse moved since.
+	EventQueueTimer*	m_motionTimer;
+	bool				m_motionMoved;
+	bool				m_backedUp;
 };
@@ -41,6 +41,7 @@ ClientProxy1_1::~ClientProxy1_1()
 void
 ClientProxy1_1::keyDown(KeyID key, KeyModifierMask mask, KeyButton button)
 {
+	flushMotion();
 	LOG((CLOG_DEBUG1 "send key down to \"%s\" id=%d, mask=0x%04x, button=0x%04x", getName().c_str(), key, mask, button));
 	ProtocolUtil::writef(getStream(), kMsgDKeyDown, key, mask, button);
 }
@@ -49,6 +50,7 @@ void
 ClientProxy1_1::keyRepeat(KeyID key, KeyModifierMask mask,
 				SInt32 count, KeyButton button)
 {
+	flushMotion();
 	LOG((CLOG_DEBUG1 "send key repeat to \"%s\" id=%d, mask=0x%04x, count=%d, button=0x%04x", getName().c_str(), key, mask, count, button));
 	ProtocolUtil::writef(getStream(), kMsgDKeyRepeat, key, mask, count, button);
 }
@@ -56,6 +58,7 @@ ClientProxy1_1::keyRepeat(KeyID key, KeyModifierMask mask,
 void
 ClientProxy1_1::keyUp(KeyID key, KeyModifierMask mask, KeyButton button)
 {
+	flushMotion();
 	LOG((CLOG_DEBUG1 "send key up to \"%s\" id=%d, mask=0x%04x, button=0x%04x", getName().c_str(), key, mask, button));
 	ProtocolUtil::writef(getStream(), kMsgDKeyUp, key, mask, button);
 }
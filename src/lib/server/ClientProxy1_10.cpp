@@ -0,0 +1,102 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_10.h"
+
+#include "server/Server.h"
+#include "synergy/ClipboardChunk.h"
+#include "synergy/StreamChunker.h"
+#include "synergy/ProtocolUtil.h"
+#include "base/Log.h"
+
+#include <cstring>
+
+//
+// ClientProxy1_10
+//
+
+ClientProxy1_10::ClientProxy1_10(const String& name, synergy::IStream* stream, Server* server, IEventQueue* events) :
+	ClientProxy1_9(name, stream, server, events),
+	m_events(events)
+{
+	// do nothing
+}
+
+ClientProxy1_10::~ClientProxy1_10()
+{
+	// do nothing
+}
+
+bool
+ClientProxy1_10::parseMessage(const UInt8* code)
+{
+	if (memcmp(code, kMsgDClipboardAck, 4) == 0) {
+		clipboardAckReceived();
+		return true;
+	}
+
+	return ClientProxy1_9::parseMessage(code);
+}
+
+bool
+ClientProxy1_10::sendClipboard(ClipboardID id, String& data)
+{
+	String delta;
+	UInt32 baseHash = 0;
+	UInt32 targetHash = 0;
+	if (m_clipboardHistory.prepareSend(id, data, delta, baseHash, targetHash)) {
+		return StreamChunker::sendClipboardDelta(delta, baseHash, targetHash,
+					id, 0, m_events, this, getBandwidth());
+	}
+
+	return ClientProxy1_9::sendClipboard(id, data);
+}
+
+bool
+ClientProxy1_10::clipboardReceived(ClipboardID id, String& data)
+{
+	UInt32 hash;
+	if (m_clipboardReceive.isDelta()) {
+		hash = m_clipboardHistory.receivedDelta(id, data,
+					m_clipboardReceive.getBaseHash(),
+					m_clipboardReceive.getTargetHash());
+	}
+	else {
+		hash = m_clipboardHistory.receivedFull(id, data);
+	}
+
+	LOG((CLOG_DEBUG2 "send clipboard %d ack to \"%s\" hash=%08x", id, getName().c_str(), hash));
+	ProtocolUtil::writef(getStream(), kMsgDClipboardAck, id, hash);
+	return (hash != 0);
+}
+
+void
+ClientProxy1_10::clipboardAckReceived()
+{
+	ClipboardID id;
+	UInt32 hash;
+	if (!ProtocolUtil::readf(getStream(), kMsgDClipboardAck + 4, &id, &hash) ||
+		id >= kClipboardEnd) {
+		return;
+	}
+
+	LOG((CLOG_DEBUG2 "recv clipboard %d ack from \"%s\" hash=%08x", id, getName().c_str(), hash));
+	if (!m_clipboardHistory.acknowledged(id, hash)) {
+		// the client missed this update.  send it in full next time.
+		m_clipboard[id].m_dirty = true;
+	}
+}
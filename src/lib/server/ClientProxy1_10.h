@@ -0,0 +1,44 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "server/ClientProxy1_9.h"
+#include "synergy/ClipboardHistory.h"
+
+class Server;
+class IEventQueue;
+
+//! Proxy for client implementing protocol version 1.10
+class ClientProxy1_10 : public ClientProxy1_9 {
+public:
+	ClientProxy1_10(const String& name, synergy::IStream* adoptedStream, Server* server, IEventQueue* events);
+	~ClientProxy1_10();
+
+	virtual bool		parseMessage(const UInt8* code);
+
+protected:
+	virtual bool		sendClipboard(ClipboardID id, String& data);
+	virtual bool		clipboardReceived(ClipboardID id, String& data);
+
+private:
+	void				clipboardAckReceived();
+
+private:
+	IEventQueue*		m_events;
+	ClipboardHistory	m_clipboardHistory;
+};
@@ -39,6 +39,7 @@ ClientProxy1_2::~ClientProxy1_2()
 void
 ClientProxy1_2::mouseRelativeMove(SInt32 xRel, SInt32 yRel)
 {
+	flushMotion();
 	LOG((CLOG_DEBUG2 "send mouse relative move to \"%s\" %d,%d", getName().c_str(), xRel, yRel));
 	ProtocolUtil::writef(getStream(), kMsgDMouseRelMove, xRel, yRel);
 }
@@ -48,6 +48,7 @@ ClientProxy1_3::~ClientProxy1_3()
 void
 ClientProxy1_3::mouseWheel(SInt32 xDelta, SInt32 yDelta)
 {
+	flushMotion();
 	LOG((CLOG_DEBUG2 "send mouse wheel to \"%s\" %+d,%+d", getName().c_str(), xDelta, yDelta));
 	ProtocolUtil::writef(getStream(), kMsgDMouseWheel, xDelta, yDelta);
 }
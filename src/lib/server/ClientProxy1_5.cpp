@@ -33,6 +33,7 @@
 
 ClientProxy1_5::ClientProxy1_5(const String& name, synergy::IStream* stream, Server* server, IEventQueue* events) :
 	ClientProxy1_4(name, stream, server, events),
+	m_skipFile(false),
 	m_events(events)
 {
 
@@ -58,6 +59,74 @@ ClientProxy1_5::sendDragInfo(UInt32 fileCount, const char* info, size_t size)
 void
 ClientProxy1_5::fileChunkSending(UInt8 mark, char* data, size_t dataSize)
 {
+	sendLegacyFileChunk(mark, data, dataSize, false);
+}
+
+void
+ClientProxy1_5::sendLegacyFileChunk(UInt8 mark, char* data, size_t dataSize,
+				bool multiFile)
+{
+	// clients older than 1.9 can't check or resume transfers and ones
+	// older than 1.8 only understand a single file per drag.  send files
+	// as plain transfers and drop what the client can't receive.
+	if (mark == kDataTransferStart) {
+		UInt32 id = 0;
+		UInt32 index = 0;
+		size_t size = 0;
+		size_t offset = 0;
+		if (!FileChunk::parseTransferStart(String(data, dataSize), id, index, size, offset)) {
+			LOG((CLOG_ERR "invalid file transfer header"));
+			m_skipFile = true;
+			return;
+		}
+
+		m_skipFile = (offset > 0 || (!multiFile && index > 0));
+		if (m_skipFile) {
+			LOG((CLOG_DEBUG "client can't receive file %u, skipping", index));
+			return;
+		}
+
+		String header;
+		if (multiFile) {
+			header = synergy::string::sprintf("%u,", index);
+			mark = kDataFileStart;
+		}
+		else {
+			mark = kDataStart;
+		}
+		header.append(synergy::string::sizeTypeToString(size));
+		FileChunk::send(getStream(), mark,
+			const_cast<char*>(header.c_str()), header.size());
+		return;
+	}
+	else if (mark == kDataStart || mark == kDataFileStart) {
+		m_skipFile = false;
+	}
+	else if (m_skipFile) {
+		if (mark == kDataFileRange) {
+			FileChunk::discardRange(data, dataSize);
+		}
+		return;
+	}
+	else if (mark == kDataFileRange) {
+		FileChunk::sendRange(getStream(), data, dataSize);
+		return;
+	}
+	else if (mark == kDataAbort) {
+		// the client can't be told the file was cut short
+		mark = kDataEnd;
+	}
+	else if (mark == kDataCheckedChunk) {
+		if (dataSize < 4) {
+			return;
+		}
+
+		// strip the checksum
+		mark = kDataChunk;
+		data += 4;
+		dataSize -= 4;
+	}
+
 	FileChunk::send(getStream(), mark, data, dataSize);
 }
 
@@ -81,18 +150,29 @@ void
 ClientProxy1_5::fileChunkReceived()
 {
 	Server* server = getServer();
-	int result = FileChunk::assemble(
-					getStream(),
-					server->getReceivedFileData(),
-					server->getExpectedFileSize());
-	
+	FileReceiveState& state = server->getFileReceiveState(getName());
+	int result = FileChunk::assemble(getStream(), state);
 
 	if (result == kFinish) {
-		m_events->addEvent(Event(m_events->forFile().fileRecieveCompleted(), server));
+		FileReceived* file = new FileReceived;
+		file->m_fileIndex = state.getFileIndex();
+		file->m_data.swap(state.getData());
+
+		Event event(m_events->forFile().fileRecieveCompleted(), server);
+		event.setDataObject(file);
+		m_events->addEvent(event);
+	}
+	else if (result == kError) {
+		// a chunk failed its checksum, ask for the rest again
+		FileTransferResume resume;
+		if (state.getResumePoint(resume)) {
+			fileResumeRequest(resume);
+		}
 	}
 	else if (result == kStart) {
-		if (server->getFakeDragFileList().size() > 0) {
-			String filename = server->getFakeDragFileList().at(0).getFilename();
+		UInt32 index = state.getFileIndex();
+		if (server->getFakeDragFileList().size() > index) {
+			String filename = server->getFakeDragFileList().at(index).getFilename();
 			LOG((CLOG_DEBUG "start receiving %s", filename.c_str()));
 		}
 	}
@@ -36,6 +36,13 @@ public:
 	void				fileChunkReceived();
 	void				dragInfoReceived();
 
+protected:
+	//! Send a file chunk in the format of protocol 1.5 or 1.8
+	void				sendLegacyFileChunk(UInt8 mark, char* data,
+							size_t dataSize, bool multiFile);
+
 private:
+	// true while dropping a file the client can't receive
+	bool				m_skipFile;
 	IEventQueue*		m_events;
 };
@@ -22,6 +22,7 @@
 #include "synergy/StreamChunker.h"
 #include "synergy/ClipboardChunk.h"
 #include "io/IStream.h"
+#include "mt/Lock.h"
 #include "base/TMethodEventJob.h"
 #include "base/Log.h"
 
@@ -50,44 +51,72 @@ ClientProxy1_6::setClipboard(ClipboardID id, const IClipboard* clipboard)
 	if (m_clipboard[id].m_dirty) {
 		// this clipboard is now clean
 		m_clipboard[id].m_dirty = false;
-		Clipboard::copy(&m_clipboard[id].m_clipboard, clipboard);
-
-		String data = m_clipboard[id].m_clipboard.marshall();
+		String data;
+		{
+			Lock lock(&m_clipboardMutex);
+			Clipboard::copy(&m_clipboard[id].m_clipboard, clipboard);
+			data = m_clipboard[id].m_clipboard.marshall();
+		}
 
 		size_t size = data.size();
 		LOG((CLOG_DEBUG "sending clipboard %d to \"%s\"", id, getName().c_str()));
 
-		StreamChunker::sendClipboard(data, size, id, 0, m_events, this);
+		if (!sendClipboard(id, data)) {
+			// the client didn't get all of it, send it again next time
+			m_clipboard[id].m_dirty = true;
+			return;
+		}
 
 		LOG((CLOG_DEBUG "sent clipboard size=%d", size));
 	}
 }
 
+bool
+ClientProxy1_6::sendClipboard(ClipboardID id, String& data)
+{
+	return StreamChunker::sendClipboard(data, data.size(), id, 0, m_events,
+				this, getBandwidth());
+}
+
+bool
+ClientProxy1_6::clipboardReceived(ClipboardID, String&)
+{
+	return true;
+}
+
 void
 ClientProxy1_6::handleClipboardSendingEvent(const Event& event, void*)
 {
-	ClipboardChunk::send(getStream(), event.getData());
+	ClipboardChunk::send(getStream(),
+		static_cast<ClipboardChunk*>(event.getDataObject()));
 }
 
 bool
 ClientProxy1_6::recvClipboard()
 {
 	// parse message
-	static String dataCached;
 	ClipboardID id;
 	UInt32 seq;
 
-	int r = ClipboardChunk::assemble(getStream(), dataCached, id, seq);
+	int r = ClipboardChunk::assemble(getStream(), m_clipboardReceive, id, seq);
 
 	if (r == kStart) {
-		size_t size = ClipboardChunk::getExpectedSize();
+		size_t size = m_clipboardReceive.getExpectedSize();
 		LOG((CLOG_DEBUG "receiving clipboard %d size=%d", id, size));
 	}
 	else if (r == kFinish) {
+		String& dataCached = m_clipboardReceive.getData();
+		if (!clipboardReceived(id, dataCached)) {
+			return true;
+		}
+
 		LOG((CLOG_DEBUG "received client \"%s\" clipboard %d seqnum=%d, size=%d",
 				getName().c_str(), id, seq, dataCached.size()));
 		// save clipboard
-		m_clipboard[id].m_clipboard.unmarshall(dataCached, 0);
+		{
+			Lock lock(&m_clipboardMutex);
+			m_clipboard[id].m_clipboard.unmarshall(dataCached, 0);
+		}
 		m_clipboard[id].m_sequenceNumber = seq;
 		
 		// notify
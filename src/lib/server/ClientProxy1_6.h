@@ -18,6 +18,7 @@
 #pragma once
 
 #include "server/ClientProxy1_5.h"
+#include "synergy/ClipboardChunk.h"
 
 class Server;
 class IEventQueue;
@@ -31,6 +32,24 @@ public:
 	virtual void		setClipboard(ClipboardID id, const IClipboard* clipboard);
 	virtual bool		recvClipboard();
 
+protected:
+	//! Send marshalled clipboard data
+	/*!
+	Returns false if the send was interrupted.
+	*/
+	virtual bool		sendClipboard(ClipboardID id, String& data);
+
+	//! Handle a received clipboard
+	/*!
+	Called with the marshalled data of each clipboard received before
+	it's used.  Returns false to drop it.
+	*/
+	virtual bool		clipboardReceived(ClipboardID id, String& data);
+
+protected:
+	// the clipboard coming in from this client
+	ClipboardReceiveState	m_clipboardReceive;
+
 private:
 	void				handleClipboardSendingEvent(const Event&, void*);
 
@@ -0,0 +1,135 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_7.h"
+
+#include "synergy/ProtocolUtil.h"
+#include "synergy/option_types.h"
+#include "base/Log.h"
+#include "base/IEventQueue.h"
+#include "base/TMethodEventJob.h"
+
+//
+// ClientProxy1_7
+//
+
+ClientProxy1_7::ClientProxy1_7(const String& name, synergy::IStream* stream, Server* server, IEventQueue* events) :
+	ClientProxy1_6(name, stream, server, events),
+	m_localKeyRepeat(false),
+	m_keyHoldTimer(NULL),
+	m_events(events)
+{
+	// do nothing
+}
+
+ClientProxy1_7::~ClientProxy1_7()
+{
+	removeKeyHoldTimer();
+}
+
+bool
+ClientProxy1_7::leave()
+{
+	m_heldKeys.clear();
+	removeKeyHoldTimer();
+	return ClientProxy1_6::leave();
+}
+
+void
+ClientProxy1_7::keyDown(KeyID key, KeyModifierMask mask, KeyButton button)
+{
+	ClientProxy1_6::keyDown(key, mask, button);
+
+	if (m_localKeyRepeat) {
+		m_heldKeys.insert(button);
+		addKeyHoldTimer();
+	}
+}
+
+void
+ClientProxy1_7::keyRepeat(KeyID key, KeyModifierMask mask,
+				SInt32 count, KeyButton button)
+{
+	// the client generates its own repeats
+	if (!m_localKeyRepeat) {
+		ClientProxy1_6::keyRepeat(key, mask, count, button);
+	}
+}
+
+void
+ClientProxy1_7::keyUp(KeyID key, KeyModifierMask mask, KeyButton button)
+{
+	ClientProxy1_6::keyUp(key, mask, button);
+
+	m_heldKeys.erase(button);
+	if (m_heldKeys.empty()) {
+		removeKeyHoldTimer();
+	}
+}
+
+void
+ClientProxy1_7::resetOptions()
+{
+	m_localKeyRepeat = false;
+	m_heldKeys.clear();
+	removeKeyHoldTimer();
+	ClientProxy1_6::resetOptions();
+}
+
+void
+ClientProxy1_7::setOptions(const OptionsList& options)
+{
+	ClientProxy1_6::setOptions(options);
+
+	// check options
+	for (UInt32 i = 0, n = (UInt32)options.size(); i < n; i += 2) {
+		if (options[i] == kOptionClientKeyRepeat) {
+			m_localKeyRepeat = (options[i + 1] != 0);
+			LOG((CLOG_DEBUG1 "client \"%s\" key repeat is %s", getName().c_str(), m_localKeyRepeat ? "local" : "remote"));
+		}
+	}
+}
+
+void
+ClientProxy1_7::addKeyHoldTimer()
+{
+	if (m_keyHoldTimer == NULL) {
+		m_keyHoldTimer = m_events->newTimer(kKeyRepeatHoldRate, NULL);
+		m_events->adoptHandler(Event::kTimer, m_keyHoldTimer,
+							new TMethodEventJob<ClientProxy1_7>(this,
+								&ClientProxy1_7::handleKeyHold, NULL));
+	}
+}
+
+void
+ClientProxy1_7::removeKeyHoldTimer()
+{
+	if (m_keyHoldTimer != NULL) {
+		m_events->removeHandler(Event::kTimer, m_keyHoldTimer);
+		m_events->deleteTimer(m_keyHoldTimer);
+		m_keyHoldTimer = NULL;
+	}
+}
+
+void
+ClientProxy1_7::handleKeyHold(const Event&, void*)
+{
+	// let the client know its keys are still held.  it stops repeating
+	// if it doesn't hear from us for kKeyRepeatTimeout seconds.
+	LOG((CLOG_DEBUG2 "send key hold to \"%s\" keys=%d", getName().c_str(), m_heldKeys.size()));
+	ProtocolUtil::writef(getStream(), kMsgCNoop);
+}
@@ -0,0 +1,54 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "server/ClientProxy1_6.h"
+#include "common/stdset.h"
+
+class Server;
+class IEventQueue;
+
+//! Proxy for client implementing protocol version 1.7
+class ClientProxy1_7 : public ClientProxy1_6 {
+public:
+	ClientProxy1_7(const String& name, synergy::IStream* adoptedStream, Server* server, IEventQueue* events);
+	~ClientProxy1_7();
+
+	// IClient overrides
+	virtual bool		leave();
+	virtual void		keyDown(KeyID, KeyModifierMask, KeyButton);
+	virtual void		keyRepeat(KeyID, KeyModifierMask,
+							SInt32 count, KeyButton);
+	virtual void		keyUp(KeyID, KeyModifierMask, KeyButton);
+	virtual void		resetOptions();
+	virtual void		setOptions(const OptionsList& options);
+
+private:
+	void				addKeyHoldTimer();
+	void				removeKeyHoldTimer();
+	void				handleKeyHold(const Event&, void*);
+
+private:
+	typedef std::set<KeyButton> KeyButtonSet;
+
+	// true if the client auto-repeats held keys itself
+	bool				m_localKeyRepeat;
+	KeyButtonSet		m_heldKeys;
+	EventQueueTimer*	m_keyHoldTimer;
+	IEventQueue*		m_events;
+};
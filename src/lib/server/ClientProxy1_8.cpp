@@ -0,0 +1,39 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_8.h"
+
+//
+// ClientProxy1_8
+//
+
+ClientProxy1_8::ClientProxy1_8(const String& name, synergy::IStream* stream, Server* server, IEventQueue* events) :
+	ClientProxy1_7(name, stream, server, events)
+{
+	// do nothing
+}
+
+ClientProxy1_8::~ClientProxy1_8()
+{
+	// do nothing
+}
+
+void
+ClientProxy1_8::fileChunkSending(UInt8 mark, char* data, size_t dataSize)
+{
+	sendLegacyFileChunk(mark, data, dataSize, true);
+}
@@ -0,0 +1,88 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_9.h"
+
+#include "server/Server.h"
+#include "synergy/FileChunk.h"
+#include "synergy/StreamChunker.h"
+#include "synergy/ProtocolUtil.h"
+#include "base/Log.h"
+
+#include <cstring>
+
+//
+// ClientProxy1_9
+//
+
+ClientProxy1_9::ClientProxy1_9(const String& name, synergy::IStream* stream, Server* server, IEventQueue* events) :
+	ClientProxy1_8(name, stream, server, events)
+{
+	// do nothing
+}
+
+ClientProxy1_9::~ClientProxy1_9()
+{
+	// do nothing
+}
+
+void
+ClientProxy1_9::fileChunkSending(UInt8 mark, char* data, size_t dataSize)
+{
+	// client checks and resumes transfers, send as is
+	if (mark == kDataFileRange) {
+		FileChunk::sendRange(getStream(), data, dataSize);
+	}
+	else {
+		FileChunk::send(getStream(), mark, data, dataSize);
+	}
+}
+
+void
+ClientProxy1_9::fileResumeRequest(const FileTransferResume& resume)
+{
+	String offset = synergy::string::sizeTypeToString(resume.m_offset);
+	LOG((CLOG_DEBUG "send file resume to \"%s\" transfer=%u file=%u offset=%s", getName().c_str(), resume.m_id, resume.m_fileIndex, offset.c_str()));
+	ProtocolUtil::writef(getStream(), kMsgDFileResume,
+		resume.m_id, resume.m_fileIndex, resume.m_checksum, &offset);
+}
+
+bool
+ClientProxy1_9::parseMessage(const UInt8* code)
+{
+	if (memcmp(code, kMsgDFileResume, 4) == 0) {
+		fileResumeReceived();
+		return true;
+	}
+
+	return ClientProxy1_8::parseMessage(code);
+}
+
+void
+ClientProxy1_9::fileResumeReceived()
+{
+	FileTransferResume resume;
+	String offset;
+	if (!ProtocolUtil::readf(getStream(), kMsgDFileResume + 4,
+			&resume.m_id, &resume.m_fileIndex, &resume.m_checksum, &offset)) {
+		return;
+	}
+	resume.m_offset = synergy::string::stringToSizeType(offset);
+
+	LOG((CLOG_DEBUG "recv file resume from \"%s\" transfer=%u file=%u offset=%s", getName().c_str(), resume.m_id, resume.m_fileIndex, offset.c_str()));
+	getServer()->fileResumeRequested(getName(), resume);
+}
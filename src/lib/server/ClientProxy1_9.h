@@ -0,0 +1,37 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "server/ClientProxy1_8.h"
+
+class Server;
+class IEventQueue;
+
+//! Proxy for client implementing protocol version 1.9
+class ClientProxy1_9 : public ClientProxy1_8 {
+public:
+	ClientProxy1_9(const String& name, synergy::IStream* adoptedStream, Server* server, IEventQueue* events);
+	~ClientProxy1_9();
+
+	virtual void		fileChunkSending(UInt8 mark, char* data, size_t dataSize);
+	virtual void		fileResumeRequest(const FileTransferResume& resume);
+	virtual bool		parseMessage(const UInt8* code);
+
+private:
+	void				fileResumeReceived();
+};
@@ -26,6 +26,10 @@
 #include "server/ClientProxy1_4.h"
 #include "server/ClientProxy1_5.h"
 #include "server/ClientProxy1_6.h"
+#include "server/ClientProxy1_7.h"
+#include "server/ClientProxy1_8.h"
+#include "server/ClientProxy1_9.h"
+#include "server/ClientProxy1_10.h"
 #include "synergy/protocol_types.h"
 #include "synergy/ProtocolUtil.h"
 #include "synergy/XSynergy.h"
@@ -36,12 +40,22 @@
 #include "base/IEventQueue.h"
 #include "base/TMethodEventJob.h"
 
+#include <cstring>
+
+// how many handshake timeouts a standby client may keep the connection
+// open for by sending keep alives.  with the listener's 30 second
+// timeout that's an hour, after which the client opens a new standby.
+static const UInt32		kMaxStandbyTimeouts = 120;
+
 //
 // ClientProxyUnknown
 //
 
 ClientProxyUnknown::ClientProxyUnknown(synergy::IStream* stream, double timeout, Server* server, IEventQueue* events) :
 	m_stream(stream),
+	m_timeout(timeout),
+	m_keepAlive(false),
+	m_standbyTimeouts(0),
 	m_proxy(NULL),
 	m_ready(false),
 	m_server(server),
@@ -171,13 +185,38 @@ ClientProxyUnknown::removeTimer()
 	}
 }
 
+bool
+ClientProxyUnknown::readStandbyKeepAlives()
+{
+	// a client holding this connection as a standby sends keep alives
+	// instead of answering the hello until it fails over to us.  they
+	// don't move the deadline;  the timeout restarts when it expires if
+	// any arrived since it was started.
+	while (m_stream->getSize() == 4) {
+		UInt8 code[4];
+		m_stream->read(code, 4);
+		if (memcmp(code, kMsgCKeepAlive, 4) != 0) {
+			throw XBadClient();
+		}
+
+		LOG((CLOG_DEBUG2 "standby client keep alive"));
+		m_keepAlive = true;
+	}
+
+	return m_stream->isReady();
+}
+
 void
 ClientProxyUnknown::handleData(const Event&, void*)
 {
-	LOG((CLOG_DEBUG1 "parsing hello reply"));
-
 	String name("<unknown>");
 	try {
+		if (!readStandbyKeepAlives()) {
+			return;
+		}
+
+		LOG((CLOG_DEBUG1 "parsing hello reply"));
+
 		// limit the maximum length of the hello
 		UInt32 n = m_stream->getSize();
 		if (n > kMaxHelloLength) {
@@ -232,6 +271,22 @@ ClientProxyUnknown::handleData(const Event&, void*)
 			case 6:
 				m_proxy = new ClientProxy1_6(name, m_stream, m_server, m_events);
 				break;
+
+			case 7:
+				m_proxy = new ClientProxy1_7(name, m_stream, m_server, m_events);
+				break;
+
+			case 8:
+				m_proxy = new ClientProxy1_8(name, m_stream, m_server, m_events);
+				break;
+
+			case 9:
+				m_proxy = new ClientProxy1_9(name, m_stream, m_server, m_events);
+				break;
+
+			case 10:
+				m_proxy = new ClientProxy1_10(name, m_stream, m_server, m_events);
+				break;
 			}
 		}
 
@@ -277,7 +332,22 @@ ClientProxyUnknown::handleWriteError(const Event&, void*)
 void
 ClientProxyUnknown::handleTimeout(const Event&, void*)
 {
-	LOG((CLOG_NOTE "new client is unresponsive"));
+	if (m_keepAlive && m_stream != NULL &&
+		m_standbyTimeouts < kMaxStandbyTimeouts) {
+		LOG((CLOG_DEBUG1 "holding standby client connection"));
+		m_keepAlive = false;
+		++m_standbyTimeouts;
+		m_events->deleteTimer(m_timer);
+		m_timer = m_events->newOneShotTimer(m_timeout, this);
+		return;
+	}
+
+	if (m_keepAlive) {
+		LOG((CLOG_NOTE "standby client held too long"));
+	}
+	else {
+		LOG((CLOG_NOTE "new client is unresponsive"));
+	}
 	sendFailure();
 }
 
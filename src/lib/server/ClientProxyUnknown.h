@@ -55,6 +55,7 @@ private:
 	void				addProxyHandlers();
 	void				removeHandlers();
 	void				removeTimer();
+	bool				readStandbyKeepAlives();
 	void				handleData(const Event&, void*);
 	void				handleWriteError(const Event&, void*);
 	void				handleTimeout(const Event&, void*);
@@ -64,6 +65,9 @@ private:
 private:
 	synergy::IStream*	m_stream;
 	EventQueueTimer*	m_timer;
+	double				m_timeout;
+	bool				m_keepAlive;
+	UInt32				m_standbyTimeouts;
 	ClientProxy*		m_proxy;
 	bool				m_ready;
 	Server*				m_server;
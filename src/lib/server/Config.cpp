@@ -622,7 +622,15 @@ Config::read(ConfigReadContext& context)
 	while (context.getStream()) {
 		tmp.readSection(context);
 	}
-	*this = tmp;
+
+	// take what we read rather than copying it.  the input filter is
+	// assigned so it keeps its primary client.
+	m_map.swap(tmp.m_map);
+	m_nameToCanonicalName.swap(tmp.m_nameToCanonicalName);
+	m_globalOptions.swap(tmp.m_globalOptions);
+	m_synergyAddress        = tmp.m_synergyAddress;
+	m_inputFilter           = tmp.m_inputFilter;
+	m_hasLockToScreenAction = tmp.m_hasLockToScreenAction;
 }
 
 const char*
@@ -765,6 +773,18 @@ Config::readSectionOptions(ConfigReadContext& s)
 		else if (name == "win32KeepForeground") {
 			addOption("", kOptionWin32KeepForeground, s.parseBoolean(value));
 		}
+		else if (name == "clientKeyRepeat") {
+			addOption("", kOptionClientKeyRepeat, s.parseBoolean(value));
+		}
+		else if (name == "keyRepeatDelay") {
+			addOption("", kOptionKeyRepeatDelay, s.parseInt(value));
+		}
+		else if (name == "keyRepeatRate") {
+			addOption("", kOptionKeyRepeatRate, s.parseInt(value));
+		}
+		else if (name == "bandwidthLimit") {
+			addOption("", kOptionBandwidthLimit, s.parseInt(value));
+		}
 		else {
 			handled = false;
 		}
@@ -920,6 +940,10 @@ Config::readSectionScreens(ConfigReadContext& s)
 				addOption(screen, kOptionScreenPreserveFocus,
 					s.parseBoolean(value));
 			}
+			else if (name == "bandwidthLimit") {
+				addOption(screen, kOptionBandwidthLimit,
+					s.parseInt(value));
+			}
 			else {
 				// unknown argument
 				throw XConfigRead(s, "unknown argument \"%{1}\"", name);
@@ -934,6 +958,7 @@ Config::readSectionLinks(ConfigReadContext& s)
 {
 	String line;
 	String screen;
+	Cell* cell = NULL;
 	while (s.readLine(line)) {
 		// check for end of section
 		if (line == "end") {
@@ -942,16 +967,8 @@ Config::readSectionLinks(ConfigReadContext& s)
 
 		// see if it's the next screen
 		if (line[line.size() - 1] == ':') {
-			// strip :
-			screen = line.substr(0, line.size() - 1);
-
-			// verify we know about the screen
-			if (!isScreen(screen)) {
-				throw XConfigRead(s, "unknown screen name \"%{1}\"", screen);
-			}
-			if (!isCanonicalName(screen)) {
-				throw XConfigRead(s, "cannot use screen name alias here");
-			}
+			parseScreenHeader(s, line, screen);
+			cell = &m_map.find(screen)->second;
 		}
 		else if (screen.empty()) {
 			throw XConfigRead(s, "argument before first screen");
@@ -991,10 +1008,11 @@ Config::readSectionLinks(ConfigReadContext& s)
 			if (!isScreen(dstScreen)) {
 				throw XConfigRead(s, "unknown screen name \"%{1}\"", dstScreen);
 			}
-			if (!connect(screen, dir,
-						srcInterval.first, srcInterval.second,
-						dstScreen,
-						dstInterval.first, dstInterval.second)) {
+
+			// add the link to the cell we already found.  this is what
+			// connect() does without looking the screen up again.
+			if (!cell->add(CellEdge(dir, srcInterval),
+						CellEdge(dstScreen, dir, dstInterval))) {
 				throw XConfigRead(s, "overlapping range");
 			}
 		}
@@ -1015,16 +1033,7 @@ Config::readSectionAliases(ConfigReadContext& s)
 
 		// see if it's the next screen
 		if (line[line.size() - 1] == ':') {
-			// strip :
-			screen = line.substr(0, line.size() - 1);
-
-			// verify we know about the screen
-			if (!isScreen(screen)) {
-				throw XConfigRead(s, "unknown screen name \"%{1}\"", screen);
-			}
-			if (!isCanonicalName(screen)) {
-				throw XConfigRead(s, "cannot use screen name alias here");
-			}
+			parseScreenHeader(s, line, screen);
 		}
 		else if (screen.empty()) {
 			throw XConfigRead(s, "argument before first screen");
@@ -1045,6 +1054,23 @@ Config::readSectionAliases(ConfigReadContext& s)
 }
 
 
+void
+Config::parseScreenHeader(ConfigReadContext& s,
+				const String& line, String& screen) const
+{
+	// strip :
+	screen.assign(line, 0, line.size() - 1);
+
+	// verify we know about the screen and that it isn't an alias
+	NameMap::const_iterator index = m_nameToCanonicalName.find(screen);
+	if (index == m_nameToCanonicalName.end()) {
+		throw XConfigRead(s, "unknown screen name \"%{1}\"", screen);
+	}
+	if (!CaselessCmp::equal(index->second, screen)) {
+		throw XConfigRead(s, "cannot use screen name alias here");
+	}
+}
+
 InputFilter::Condition*
 Config::parseCondition(ConfigReadContext& s,
 				const String& name, const std::vector<String>& args)
@@ -1376,6 +1402,18 @@ Config::getOptionName(OptionID id)
 	if (id == kOptionScreenPreserveFocus) {
 		return "preserveFocus";
 	}
+	if (id == kOptionClientKeyRepeat) {
+		return "clientKeyRepeat";
+	}
+	if (id == kOptionKeyRepeatDelay) {
+		return "keyRepeatDelay";
+	}
+	if (id == kOptionKeyRepeatRate) {
+		return "keyRepeatRate";
+	}
+	if (id == kOptionBandwidthLimit) {
+		return "bandwidthLimit";
+	}
 	return NULL;
 }
 
@@ -1392,7 +1430,8 @@ Config::getOptionValue(OptionID id, OptionValue value)
 		id == kOptionXTestXineramaUnaware ||
 		id == kOptionRelativeMouseMoves ||
 		id == kOptionWin32KeepForeground ||
-		id == kOptionScreenPreserveFocus) {
+		id == kOptionScreenPreserveFocus ||
+		id == kOptionClientKeyRepeat) {
 		return (value != 0) ? "true" : "false";
 	}
 	if (id == kOptionModifierMapForShift ||
@@ -1427,7 +1466,10 @@ Config::getOptionValue(OptionID id, OptionValue value)
 	if (id == kOptionHeartbeat ||
 		id == kOptionScreenSwitchCornerSize ||
 		id == kOptionScreenSwitchDelay ||
-		id == kOptionScreenSwitchTwoTap) {
+		id == kOptionScreenSwitchTwoTap ||
+		id == kOptionKeyRepeatDelay ||
+		id == kOptionKeyRepeatRate ||
+		id == kOptionBandwidthLimit) {
 		return synergy::string::sprintf("%d", value);
 	}
 	if (id == kOptionScreenSwitchCorners) {
@@ -1885,34 +1927,39 @@ bool
 ConfigReadContext::readLine(String& line)
 {
 	++m_line;
-	while (std::getline(m_stream, line)) {
-		// strip leading whitespace
-		String::size_type i = line.find_first_not_of(" \t");
-		if (i != String::npos) {
-			line.erase(0, i);
+	while (std::getline(m_stream, m_buffer)) {
+		// find the line between leading whitespace and either a comment
+		// or trailing whitespace.  we only copy what's left.
+		const char* data = m_buffer.data();
+		String::size_type b = 0;
+		String::size_type e = m_buffer.size();
+		while (b < e && (data[b] == ' ' || data[b] == '\t')) {
+			++b;
 		}
-
-		// strip comments and then trailing whitespace
-		i = line.find('#');
-		if (i != String::npos) {
-			line.erase(i);
+		for (String::size_type i = b; i < e; ++i) {
+			if (data[i] == '#') {
+				e = i;
+				break;
+			}
 		}
-		i = line.find_last_not_of(" \r\t");
-		if (i != String::npos) {
-			line.erase(i + 1);
+		while (e > b &&
+				(data[e - 1] == ' ' || data[e - 1] == '\r' ||
+				data[e - 1] == '\t')) {
+			--e;
 		}
 
 		// return non empty line
-		if (!line.empty()) {
+		if (e > b) {
 			// make sure there are no invalid characters
-			for (i = 0; i < line.length(); ++i) {
-				if (!isgraph(line[i]) && line[i] != ' ' && line[i] != '\t') {
+			for (String::size_type i = b; i < e; ++i) {
+				if (!isgraph(data[i]) && data[i] != ' ' && data[i] != '\t') {
 					throw XConfigRead(*this,
 								"invalid character %{1}",
-								synergy::string::sprintf("%#2x", line[i]));
+								synergy::string::sprintf("%#2x", data[i]));
 				}
 			}
 
+			line.assign(data + b, e - b);
 			return true;
 		}
 
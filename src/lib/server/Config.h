@@ -452,6 +452,8 @@ private:
 	void				readSectionScreens(ConfigReadContext&);
 	void				readSectionLinks(ConfigReadContext&);
 	void				readSectionAliases(ConfigReadContext&);
+	void				parseScreenHeader(ConfigReadContext&,
+							const String& line, String& screen) const;
 
 	InputFilter::Condition*
 						parseCondition(ConfigReadContext&,
@@ -523,6 +525,9 @@ private:
 private:
 	std::istream&	m_stream;
 	SInt32			m_line;
+
+	// the raw line, kept to reuse its storage
+	String			m_buffer;
 };
 
 //! Configuration stream read exception
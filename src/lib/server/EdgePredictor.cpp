@@ -0,0 +1,94 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/EdgePredictor.h"
+
+//
+// EdgePredictor
+//
+
+EdgePredictor::EdgePredictor(double lead, double minSpeed, double maxInterval) :
+	m_lead(lead),
+	m_minSpeed(minSpeed),
+	m_maxInterval(maxInterval),
+	m_xSpeed(0.0),
+	m_ySpeed(0.0)
+{
+	// do nothing
+}
+
+void
+EdgePredictor::reset()
+{
+	m_xSpeed = 0.0;
+	m_ySpeed = 0.0;
+}
+
+void
+EdgePredictor::addMotion(SInt32 dx, SInt32 dy, double dt)
+{
+	if (dt <= 0.0) {
+		return;
+	}
+
+	// average with the last few moves to smooth out jitter
+	double xSpeed = dx / dt;
+	double ySpeed = dy / dt;
+	if (dt > m_maxInterval) {
+		m_xSpeed = xSpeed;
+		m_ySpeed = ySpeed;
+	}
+	else {
+		m_xSpeed = 0.5 * (m_xSpeed + xSpeed);
+		m_ySpeed = 0.5 * (m_ySpeed + ySpeed);
+	}
+}
+
+EDirection
+EdgePredictor::predictEdge(SInt32 x, SInt32 y,
+				SInt32 ax, SInt32 ay, SInt32 aw, SInt32 ah) const
+{
+	EDirection dir = kNoDirection;
+	double lead    = m_lead;
+	if (m_xSpeed <= -m_minSpeed && (x - ax) / -m_xSpeed < lead) {
+		lead = (x - ax) / -m_xSpeed;
+		dir  = kLeft;
+	}
+	else if (m_xSpeed >= m_minSpeed && (ax + aw - 1 - x) / m_xSpeed < lead) {
+		lead = (ax + aw - 1 - x) / m_xSpeed;
+		dir  = kRight;
+	}
+	if (m_ySpeed <= -m_minSpeed && (y - ay) / -m_ySpeed < lead) {
+		dir  = kTop;
+	}
+	else if (m_ySpeed >= m_minSpeed && (ay + ah - 1 - y) / m_ySpeed < lead) {
+		dir  = kBottom;
+	}
+	return dir;
+}
+
+double
+EdgePredictor::getXSpeed() const
+{
+	return m_xSpeed;
+}
+
+double
+EdgePredictor::getYSpeed() const
+{
+	return m_ySpeed;
+}
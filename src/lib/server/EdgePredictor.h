@@ -0,0 +1,79 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "synergy/protocol_types.h"
+#include "common/basic_types.h"
+
+//! Screen edge predictor
+/*!
+Estimates the cursor's speed from its motion and predicts which edge
+of a screen it will reach soon, if any.  The server uses this to start
+sending the clipboards to a neighbor before the cursor gets there.
+*/
+class EdgePredictor {
+public:
+	//! Create a predictor
+	/*!
+	An edge is predicted when the cursor will reach it within \p lead
+	seconds moving at least \p minSpeed pixels a second.  Pauses in
+	motion longer than \p maxInterval seconds restart the estimate.
+	*/
+	EdgePredictor(double lead, double minSpeed, double maxInterval);
+
+	//! @name manipulators
+	//@{
+
+	//! Forget the speed estimate
+	void				reset();
+
+	//! Add a motion
+	/*!
+	Adds a motion of \p dx,dy pixels that took \p dt seconds.  Motions
+	that took no time are ignored.
+	*/
+	void				addMotion(SInt32 dx, SInt32 dy, double dt);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Predict the edge the cursor will reach
+	/*!
+	Returns the edge of the screen at \p ax,ay with size \p aw,ah that
+	the cursor at \p x,y will reach first, or kNoDirection if it won't
+	reach one soon.
+	*/
+	EDirection			predictEdge(SInt32 x, SInt32 y,
+							SInt32 ax, SInt32 ay, SInt32 aw, SInt32 ah) const;
+
+	//! Get the estimated horizontal speed in pixels a second
+	double				getXSpeed() const;
+
+	//! Get the estimated vertical speed in pixels a second
+	double				getYSpeed() const;
+
+	//@}
+
+private:
+	double				m_lead;
+	double				m_minSpeed;
+	double				m_maxInterval;
+	double				m_xSpeed;
+	double				m_ySpeed;
+};
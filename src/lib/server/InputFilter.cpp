@@ -1057,8 +1057,8 @@ InputFilter::operator==(const InputFilter& x) const
 								i != x.m_ruleList.end(); ++i) {
 		bList.push_back(i->format());
 	}
-	std::partial_sort(aList.begin(), aList.end(), aList.end());
-	std::partial_sort(bList.begin(), bList.end(), bList.end());
+	std::sort(aList.begin(), aList.end());
+	std::sort(bList.begin(), bList.end());
 	return (aList == bList);
 }
 
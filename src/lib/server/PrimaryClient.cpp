@@ -18,6 +18,7 @@
 
 #include "server/PrimaryClient.h"
 
+#include "synergy/FileChunk.h"
 #include "synergy/Screen.h"
 #include "synergy/Clipboard.h"
 #include "base/Log.h"
@@ -257,6 +258,15 @@ PrimaryClient::sendDragInfo(UInt32 fileCount, const char* info, size_t size)
 
 void
 PrimaryClient::fileChunkSending(UInt8 mark, char* data, size_t dataSize)
+{
+	// ignore
+	if (mark == kDataFileRange) {
+		FileChunk::discardRange(data, dataSize);
+	}
+}
+
+void
+PrimaryClient::fileResumeRequest(const FileTransferResume& resume)
 {
 	// ignore
 }
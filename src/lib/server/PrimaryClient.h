@@ -38,7 +38,7 @@ public:
 	~PrimaryClient();
 
 #ifdef TEST_ENV
-	PrimaryClient() : BaseClientProxy("") { }
+	PrimaryClient(const String& name = "") : BaseClientProxy(name) { }
 #endif
 
 	//! @name manipulators
@@ -87,7 +87,7 @@ public:
 	Return the jump zone size, the size of the regions on the edges of
 	the screen that cause the cursor to jump to another screen.
 	*/
-	SInt32				getJumpZoneSize() const;
+	virtual SInt32		getJumpZoneSize() const;
 
 	//! Get cursor center position
 	/*!
@@ -145,6 +145,7 @@ public:
 	virtual void		setOptions(const OptionsList& options);
 	virtual void		sendDragInfo(UInt32 fileCount, const char* info, size_t size);
 	virtual void		fileChunkSending(UInt8 mark, char* data, size_t dataSize);
+	virtual void		fileResumeRequest(const FileTransferResume& resume);
 
 	virtual synergy::IStream*
 						getStream() const { return NULL; }
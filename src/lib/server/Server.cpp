@@ -22,7 +22,9 @@
 #include "server/ClientProxyUnknown.h"
 #include "server/PrimaryClient.h"
 #include "server/ClientListener.h"
+#include "server/BulkLoop.h"
 #include "synergy/FileChunk.h"
+#include "synergy/ClipboardDelta.h"
 #include "synergy/IPlatformScreen.h"
 #include "synergy/DropHelper.h"
 #include "synergy/option_types.h"
@@ -30,6 +32,7 @@
 #include "synergy/XScreen.h"
 #include "synergy/XSynergy.h"
 #include "synergy/StreamChunker.h"
+#include "synergy/TokenBucket.h"
 #include "synergy/KeyState.h"
 #include "synergy/Screen.h"
 #include "synergy/PacketStreamFilter.h"
@@ -38,11 +41,13 @@
 #include "net/IDataSocket.h"
 #include "net/IListenSocket.h"
 #include "net/XSocket.h"
+#include "io/IFileSender.h"
 #include "mt/Thread.h"
 #include "arch/Arch.h"
 #include "base/TMethodJob.h"
 #include "base/IEventQueue.h"
 #include "base/Log.h"
+#include "base/MemoryBudget.h"
 #include "base/TMethodEventJob.h"
 #include "common/stdexcept.h"
 
@@ -55,6 +60,18 @@
 // Server
 //
 
+// how long grabs of a clipboard are coalesced before the other screens
+// are told about the last one
+static const double		kClipboardGrabDelay = 0.1;
+
+// the clipboards are prefetched to a neighbor when the cursor will reach
+// the edge within this time, moving at least this many pixels a second
+static const double		kClipboardPrefetchLead = 0.25;
+static const double		kClipboardPrefetchMinSpeed = 300.0;
+
+// pauses in motion longer than this restart the speed estimate
+static const double		kClipboardPrefetchMaxInterval = 0.1;
+
 Server::Server(
 		Config& config,
 		PrimaryClient* primaryClient,
@@ -90,11 +107,25 @@ Server::Server(
 	m_events(events),
 	m_sendFileThread(NULL),
 	m_writeToDropDirThread(NULL),
+	m_sendFilesPending(false),
+	m_fileResumePending(false),
 	m_ignoreFileTransfer(false),
 	m_enableDragDrop(enableDragDrop),
 	m_sendDragInfoThread(NULL),
 	m_waitDragInfoThread(true),
-	m_sendClipboardThread(NULL)
+	m_sendClipboardThread(NULL),
+	m_sendClipboardTarget(NULL),
+	m_sendClipboardPending(false),
+	m_sendClipboardStale(false),
+	m_bulkLoop(new BulkLoop),
+	m_prefetchTarget(NULL),
+	m_prefetchTime(true),
+	m_prefetchPredictor(kClipboardPrefetchLead,
+							kClipboardPrefetchMinSpeed,
+							kClipboardPrefetchMaxInterval),
+	m_bandwidth(new TokenBucket),
+	m_fileTransferBandwidth(NULL),
+	m_fileTransferFromFile(false)
 {
 	// must have a primary client and it must have a canonical name
 	assert(m_primaryClient != NULL);
@@ -112,7 +143,9 @@ Server::Server(
 			clipboard.m_clipboard.empty();
 			clipboard.m_clipboard.close();
 		}
-		clipboard.m_clipboardData   = clipboard.m_clipboard.marshall();
+		String data = clipboard.m_clipboard.marshall();
+		clipboard.m_clipboardHash   = ClipboardDelta::hash(data);
+		clipboard.m_clipboardSize   = data.size();
 	}
 
 	// install event handlers
@@ -184,7 +217,29 @@ Server::Server(
 							new TMethodEventJob<Server>(this,
 								&Server::handleFakeInputEndEvent));
 
+	m_events->adoptHandler(m_events->forServer().clipboardSent(),
+							this,
+							new TMethodEventJob<Server>(this,
+								&Server::handleClipboardSentEvent));
+	m_events->adoptHandler(m_events->forServer().clipboardRefresh(),
+							this,
+							new TMethodEventJob<Server>(this,
+								&Server::handleClipboardRefreshEvent));
+	m_events->adoptHandler(m_events->forServer().clipboardPrefetch(),
+							this,
+							new TMethodEventJob<Server>(this,
+								&Server::handleClipboardPrefetchEvent));
+	m_events->adoptHandler(m_events->forServer().clipboardMarshalled(),
+							this,
+							new TMethodEventJob<Server>(this,
+								&Server::handleClipboardMarshalledEvent));
+	m_events->adoptHandler(m_events->forServer().clipboardRefreshed(),
+							this,
+							new TMethodEventJob<Server>(this,
+								&Server::handleClipboardRefreshedEvent));
+
 	if (m_enableDragDrop) {
+		StreamChunker::init();
 		m_events->adoptHandler(m_events->forFile().fileChunkSending(),
 								this,
 								new TMethodEventJob<Server>(this,
@@ -193,6 +248,14 @@ Server::Server(
 								this,
 								new TMethodEventJob<Server>(this,
 									&Server::handleFileRecieveCompletedEvent));
+		m_events->adoptHandler(m_events->forFile().fileTransferProgress(),
+								this,
+								new TMethodEventJob<Server>(this,
+									&Server::handleFileTransferProgressEvent));
+		m_events->adoptHandler(m_events->forFile().fileSendFinished(),
+								this,
+								new TMethodEventJob<Server>(this,
+									&Server::handleFileSendFinishedEvent));
 	}
 
 	// add connection
@@ -215,6 +278,10 @@ Server::Server(
 
 Server::~Server()
 {
+	// stop the bulk loop first so no more jobs post events to us
+	delete m_bulkLoop;
+	m_bulkLoop = NULL;
+
 	if (m_mock) {
 		return;
 	}
@@ -244,8 +311,34 @@ Server::~Server()
 							m_inputFilter);
 	m_events->removeHandler(m_events->forIPrimaryScreen().fakeInputEnd(),
 							m_inputFilter);
+	m_events->removeHandler(m_events->forServer().clipboardSent(), this);
+	m_events->removeHandler(m_events->forServer().clipboardRefresh(), this);
+	m_events->removeHandler(m_events->forServer().clipboardPrefetch(), this);
+	m_events->removeHandler(m_events->forServer().clipboardMarshalled(), this);
+	m_events->removeHandler(m_events->forServer().clipboardRefreshed(), this);
 	m_events->removeHandler(Event::kTimer, this);
 	stopSwitch();
+	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+		EventQueueTimer* timer = m_clipboards[id].m_grabTimer;
+		if (timer != NULL) {
+			m_events->removeHandler(Event::kTimer, timer);
+			m_events->deleteTimer(timer);
+		}
+	}
+
+	// the sent events won't be handled now, so clean up the threads here
+	if (m_sendClipboardThread != NULL) {
+		StreamChunker::interruptClipboard();
+		m_sendClipboardThread->wait();
+		delete m_sendClipboardThread;
+		m_sendClipboardThread = NULL;
+	}
+	if (m_sendFileThread != NULL) {
+		StreamChunker::interruptFile();
+		m_sendFileThread->wait();
+		delete m_sendFileThread;
+		m_sendFileThread = NULL;
+	}
 
 	// force immediate disconnection of secondary clients
 	disconnect();
@@ -264,6 +357,12 @@ Server::~Server()
 	// disable and disconnect primary client
 	m_primaryClient->disable();
 	removeClient(m_primaryClient);
+
+	for (BandwidthList::iterator index = m_clientBandwidth.begin();
+							index != m_clientBandwidth.end(); ++index) {
+		delete index->second;
+	}
+	delete m_bandwidth;
 }
 
 bool
@@ -303,6 +402,7 @@ Server::setConfig(const Config& config)
 	for (ClientList::const_iterator index = m_clients.begin();
 								index != m_clients.end(); ++index) {
 		BaseClientProxy* client = index->second;
+		updateBandwidth(client);
 		sendOptions(client);
 	}
 
@@ -336,8 +436,18 @@ Server::adoptClient(BaseClientProxy* client)
 	LOG((CLOG_NOTE "client \"%s\" has connected", getName(client).c_str()));
 
 	// send configuration options to client
+	updateBandwidth(client);
 	sendOptions(client);
 
+	// ask the client to finish a file it was sending when it went away.
+	// a client that wasn't sending it just ignores the request.
+	if (m_enableDragDrop) {
+		FileTransferResume resume;
+		if (getFileReceiveState(getName(client)).getResumePoint(resume)) {
+			client->fileResumeRequest(resume);
+		}
+	}
+
 	// activate screen saver on new client if active on the primary screen
 	if (m_activeSaver != NULL) {
 		client->screensaver(true);
@@ -465,6 +575,13 @@ Server::switchScreen(BaseClientProxy* dst,
 	// stop waiting to switch
 	stopSwitch();
 
+	// the screen being entered must know who owns the clipboards
+	flushClipboardGrabs();
+
+	// the cursor starts over on the new screen.  a prefetch to it
+	// carries on.
+	resetClipboardPrefetch();
+
 	// record new position
 	m_x       = x;
 	m_y       = y;
@@ -484,17 +601,10 @@ Server::switchScreen(BaseClientProxy* dst,
 			return;
 		}
 
-		// update the primary client's clipboards if we're leaving the
-		// primary screen.
-		if (m_active == m_primaryClient) {
-			for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
-				ClipboardInfo& clipboard = m_clipboards[id];
-				if (clipboard.m_clipboardOwner == getName(m_primaryClient)) {
-					onClipboardChanged(m_primaryClient,
-						id, clipboard.m_clipboardSeqNum);
-				}
-			}
-		}
+		// if we're leaving the primary screen then its clipboards must
+		// be read before they're sent.  do that after entering the new
+		// screen so the switch doesn't wait for it.
+		bool refreshClipboards = (m_active == m_primaryClient);
 
 		// cut over
 		m_active = dst;
@@ -506,20 +616,15 @@ Server::switchScreen(BaseClientProxy* dst,
 		m_active->enter(x, y, m_seqNum,
 								m_primaryClient->getToggleMask(),
 								forScreensaver);
-		// if already sending clipboard, we need to interupt it, otherwise
-		// clipboard data could be corrupted on the other side
-		if (m_sendClipboardThread != NULL) {
-			StreamChunker::interruptClipboard();
-			m_sendClipboardThread->wait();
-			m_sendClipboardThread = NULL;
-		}
-		
+
 		// send the clipboard data to new active screen
-		m_sendClipboardThread = new Thread(
-										new TMethodJob<Server>(
-												this,
-												&Server::sendClipboardThread,
-												NULL));
+		if (refreshClipboards) {
+			m_events->addEvent(Event(m_events->forServer().clipboardRefresh(),
+								this));
+		}
+		else {
+			scheduleClipboardSend();
+		}
 
 		Server::SwitchToScreenInfo* info =
 			Server::SwitchToScreenInfo::alloc(m_active->getName());
@@ -1146,11 +1251,16 @@ Server::processOptions()
 	m_switchNeedsAlt = false;		// doesnt' work correct.
 
 	bool newRelativeMoves = m_relativeMoves;
+	double bandwidth = 0.0;
 	for (Config::ScreenOptions::const_iterator index = options->begin();
 								index != options->end(); ++index) {
 		const OptionID id       = index->first;
 		const OptionValue value = index->second;
-		if (id == kOptionScreenSwitchDelay) {
+		if (id == kOptionBandwidthLimit) {
+			// kilobytes per second
+			bandwidth = 1024.0 * static_cast<double>(value);
+		}
+		else if (id == kOptionScreenSwitchDelay) {
 			m_switchWaitDelay = 1.0e-3 * static_cast<double>(value);
 			if (m_switchWaitDelay < 0.0) {
 				m_switchWaitDelay = 0.0;
@@ -1181,6 +1291,8 @@ Server::processOptions()
 		stopRelativeMoves();
 	}
 	m_relativeMoves = newRelativeMoves;
+
+	m_bandwidth->setRate(bandwidth);
 }
 
 void
@@ -1237,31 +1349,78 @@ Server::handleClipboardGrabbed(const Event& event, void* vclient)
 	}
 
 	// mark screen as owning clipboard
-	LOG((CLOG_INFO "screen \"%s\" grabbed clipboard %d from \"%s\"", getName(grabber).c_str(), info->m_id, clipboard.m_clipboardOwner.c_str()));
+	LOG((CLOG_DEBUG "screen \"%s\" grabbed clipboard %d from \"%s\"", getName(grabber).c_str(), info->m_id, clipboard.m_clipboardOwner.c_str()));
 	clipboard.m_clipboardOwner  = getName(grabber);
 	clipboard.m_clipboardSeqNum = info->m_sequenceNumber;
+	clipboard.m_snapshot        = false;
+	++clipboard.m_updateCount;
 
 	// clear the clipboard data (since it's not known at this point)
 	if (clipboard.m_clipboard.open(0)) {
 		clipboard.m_clipboard.empty();
 		clipboard.m_clipboard.close();
 	}
-	clipboard.m_clipboardData = clipboard.m_clipboard.marshall();
+	String data = clipboard.m_clipboard.marshall();
+	clipboard.m_clipboardHash = ClipboardDelta::hash(data);
+	clipboard.m_clipboardSize = data.size();
+
+	// selecting text can grab a clipboard many times a second.  tell
+	// the other screens only about the last grab in a short window.
+	if (clipboard.m_grabTimer == NULL) {
+		clipboard.m_grabTimer =
+			m_events->newOneShotTimer(kClipboardGrabDelay, NULL);
+		m_events->adoptHandler(Event::kTimer, clipboard.m_grabTimer,
+							new TMethodEventJob<Server>(this,
+								&Server::handleClipboardGrabTimeout));
+	}
+}
+
+void
+Server::handleClipboardGrabTimeout(const Event& event, void*)
+{
+	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+		if (m_clipboards[id].m_grabTimer == event.getTarget()) {
+			flushClipboardGrab(id);
+			break;
+		}
+	}
+}
+
+void
+Server::flushClipboardGrab(ClipboardID id)
+{
+	ClipboardInfo& clipboard = m_clipboards[id];
+	if (clipboard.m_grabTimer == NULL) {
+		return;
+	}
+	m_events->removeHandler(Event::kTimer, clipboard.m_grabTimer);
+	m_events->deleteTimer(clipboard.m_grabTimer);
+	clipboard.m_grabTimer = NULL;
+
+	LOG((CLOG_INFO "screen \"%s\" grabbed clipboard %d", clipboard.m_clipboardOwner.c_str(), id));
 
 	// tell all other screens to take ownership of clipboard.  tell the
 	// grabber that it's clipboard isn't dirty.
 	for (ClientList::iterator index = m_clients.begin();
 								index != m_clients.end(); ++index) {
 		BaseClientProxy* client = index->second;
-		if (client == grabber) {
-			client->setClipboardDirty(info->m_id, false);
+		if (index->first == clipboard.m_clipboardOwner) {
+			client->setClipboardDirty(id, false);
 		}
 		else {
-			client->grabClipboard(info->m_id);
+			client->grabClipboard(id);
 		}
 	}
 }
 
+void
+Server::flushClipboardGrabs()
+{
+	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+		flushClipboardGrab(id);
+	}
+}
+
 void
 Server::handleClipboardChanged(const Event& event, void* vclient)
 {
@@ -1506,13 +1665,48 @@ Server::handleFakeInputEndEvent(const Event&, void*)
 void
 Server::handleFileChunkSendingEvent(const Event& event, void*)
 {
-	onFileChunkSending(event.getData());
+	onFileChunkSending(static_cast<FileChunk*>(event.getDataObject()));
 }
 
 void
 Server::handleFileRecieveCompletedEvent(const Event& event, void*)
 {
-	onFileRecieveCompleted();
+	onFileRecieveCompleted(static_cast<FileReceived*>(event.getDataObject()));
+}
+
+void
+Server::handleFileTransferProgressEvent(const Event& event, void*)
+{
+	FileTransferProgress* progress =
+		static_cast<FileTransferProgress*>(event.getDataObject());
+
+	LOG((CLOG_DEBUG "sending file %u/%u, sent=%s total=%s rate=%.1fkB/s",
+		progress->m_fileIndex + 1, progress->m_fileCount,
+		synergy::string::sizeTypeToString(progress->m_bytesSent).c_str(),
+		synergy::string::sizeTypeToString(progress->m_bytesTotal).c_str(),
+		progress->m_bytesPerSecond / 1024.0));
+}
+
+void
+Server::handleFileSendFinishedEvent(const Event&, void*)
+{
+	if (m_sendFileThread == NULL) {
+		return;
+	}
+
+	// only one send runs at a time, so this event is from the current
+	// thread, which has nothing left to do but exit.
+	m_sendFileThread->wait();
+	delete m_sendFileThread;
+	m_sendFileThread = NULL;
+
+	// a new drag supersedes resuming the last one
+	if (m_sendFilesPending) {
+		startFileSend();
+	}
+	else if (m_fileResumePending) {
+		startFileResume();
+	}
 }
 
 void
@@ -1527,32 +1721,106 @@ Server::onClipboardChanged(BaseClientProxy* sender,
 		return;
 	}
 
-	// should be the expected client
-	assert(sender == m_clients.find(clipboard.m_clipboardOwner)->second);
+	// the other screens must hear about the grab before the data
+	flushClipboardGrab(id);
 
-	// get data
-	sender->getClipboard(id, &clipboard.m_clipboard);
+	// the primary screen reports changes on its own, so another screen
+	// may have grabbed the clipboard since
+	if (getName(sender) != clipboard.m_clipboardOwner) {
+		LOG((CLOG_DEBUG "ignored screen \"%s\" update of clipboard %d (not owner)", getName(sender).c_str(), id));
+		return;
+	}
+
+	// read and marshall the new clipboard on the bulk loop.  it's sent
+	// to the active screen when it comes back.
+	marshallClipboard(sender, id, false);
+}
+
+void
+Server::marshallClipboard(BaseClientProxy* sender, ClipboardID id, bool refresh)
+{
+	ClipboardUpdate* update = new ClipboardUpdate;
+	update->m_id          = id;
+	update->m_updateCount = ++m_clipboards[id].m_updateCount;
+	update->m_sender      = sender;
+	update->m_refresh     = refresh;
+	update->m_hash        = 0;
+	update->m_size        = 0;
+
+	// client proxies guard the clipboards they hold, so those are read
+	// on the bulk loop.  reading the primary screen's clipboard may pump
+	// its event queue (e.g. waiting for an X selection conversion), so
+	// that still has to happen here.
+	if (sender == m_primaryClient) {
+		sender->getClipboard(id, &update->m_clipboard);
+		update->m_sender = NULL;
+	}
+
+	m_bulkLoop->post(new ClipboardMarshallJob(this, update));
+}
+
+void
+Server::handleClipboardMarshalledEvent(const Event& event, void*)
+{
+	ClipboardUpdate* update =
+		static_cast<ClipboardUpdate*>(event.getDataObject());
+	ClipboardInfo& clipboard = m_clipboards[update->m_id];
+
+	// drop it if the clipboard was grabbed or updated since
+	if (update->m_updateCount != clipboard.m_updateCount) {
+		LOG((CLOG_DEBUG "ignored update of clipboard %d (superseded)", update->m_id));
+		return;
+	}
+
+	// keeping another copy would take us past the memory limit
+	if (!MemoryBudget::isAvailable(update->m_size)) {
+		LOG((CLOG_WARN "ignored update of clipboard %d, %s bytes is too large for the memory limit",
+			update->m_id, synergy::string::sizeTypeToString(update->m_size).c_str()));
+		return;
+	}
+
+	// this is what the owner holds until it grabs again
+	if (!update->m_refresh) {
+		clipboard.m_snapshot = true;
+	}
+
+	if (takeClipboardData(update->m_id, update->m_hash, update->m_size)) {
+		Clipboard::copy(&clipboard.m_clipboard, &update->m_clipboard);
+
+		// send the new clipboard to the active screen.  a refresh sends
+		// its clipboards once they're all taken.
+		if (!update->m_refresh) {
+			scheduleClipboardSend();
+		}
+	}
+}
+
+bool
+Server::takeClipboardData(ClipboardID id, UInt32 hash, size_t size)
+{
+	ClipboardInfo& clipboard = m_clipboards[id];
 
 	// ignore if data hasn't changed
-	String data = clipboard.m_clipboard.marshall();
-	if (data == clipboard.m_clipboardData) {
+	if (hash == clipboard.m_clipboardHash &&
+		size == clipboard.m_clipboardSize) {
 		LOG((CLOG_DEBUG "ignored screen \"%s\" update of clipboard %d (unchanged)", clipboard.m_clipboardOwner.c_str(), id));
-		return;
+		return false;
 	}
 
 	// got new data
 	LOG((CLOG_INFO "screen \"%s\" updated clipboard %d", clipboard.m_clipboardOwner.c_str(), id));
-	clipboard.m_clipboardData = data;
+	clipboard.m_clipboardHash = hash;
+	clipboard.m_clipboardSize = size;
+	m_sendClipboardStale = true;
 
-	// tell all clients except the sender that the clipboard is dirty
+	// tell all clients except the owner that the clipboard is dirty
 	for (ClientList::const_iterator index = m_clients.begin();
 								index != m_clients.end(); ++index) {
 		BaseClientProxy* client = index->second;
-		client->setClipboardDirty(id, client != sender);
+		client->setClipboardDirty(id, index->first != clipboard.m_clipboardOwner);
 	}
 
-	// send the new clipboard to the active screen
-	m_active->setClipboard(id, &clipboard.m_clipboard);
+	return true;
 }
 
 void
@@ -1704,9 +1972,10 @@ Server::onMouseUp(ButtonID id)
 	
 	if (m_enableDragDrop) {
 		if (!m_screen->isOnScreen()) {
-			String& file = m_screen->getDraggingFilename();
-			if (!file.empty()) {
-				sendFileToClient(file.c_str());
+			DragFileList fileList;
+			if (DragInformation::parseDraggingFiles(fileList,
+					m_screen->getDraggingFilename()) > 0) {
+				sendFilesToClient(fileList);
 			}
 		}
 
@@ -1779,6 +2048,7 @@ Server::onMouseMovePrimary(SInt32 x, SInt32 y)
 	else {
 		// still on local screen
 		noSwitch(x, y);
+		prefetchClipboard(ax, ay, aw, ah);
 		return false;
 	}
 
@@ -1815,13 +2085,8 @@ Server::sendDragInfoThread(void* arg)
 {
 	BaseClientProxy* newScreen = reinterpret_cast<BaseClientProxy*>(arg);
 
-	m_dragFileList.clear();
-	String& dragFileList = m_screen->getDraggingFilename();
-	if (!dragFileList.empty()) {
-		DragInformation di;
-		di.setFilename(dragFileList);
-		m_dragFileList.push_back(di);
-	}
+	DragInformation::parseDraggingFiles(m_dragFileList,
+		m_screen->getDraggingFilename());
 			
 #if defined(__APPLE__)
 	// on mac it seems that after faking a LMB up, system would signal back
@@ -1855,16 +2120,247 @@ Server::sendDragInfo(BaseClientProxy* newScreen)
 		LOG((CLOG_DEBUG2 "sending drag information to client"));
 		LOG((CLOG_DEBUG3 "dragging file list: %s", info));
 		LOG((CLOG_DEBUG3 "dragging file list string size: %i", size));
+
+		TokenBucket* bandwidth = newScreen->getBandwidth();
+		if (bandwidth != NULL) {
+			ARCH->sleep(bandwidth->take(size));
+		}
 		newScreen->sendDragInfo(fileCount, info, size);
 	}
 }
 
 void
-Server::sendClipboardThread(void*)
+Server::scheduleClipboardSend()
+{
+	// the primary screen isn't sent anything over the network, so
+	// set its clipboards right away.  this also stops any send to the
+	// screen we just left.
+	if (m_active == m_primaryClient) {
+		StreamChunker::interruptClipboard();
+		m_sendClipboardPending = false;
+		for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+			m_primaryClient->setClipboard(id, &m_clipboards[id].m_clipboard);
+		}
+		return;
+	}
+
+	// if already sending, interrupt it, otherwise clipboard data could
+	// be corrupted on the other side.  we send again once it's done.
+	// a prefetch to the screen we just entered is left to finish;
+	// sending again afterwards only sends what's still dirty.
+	if (m_sendClipboardThread != NULL) {
+		if (m_sendClipboardTarget != m_active || m_sendClipboardStale) {
+			StreamChunker::interruptClipboard();
+		}
+		m_sendClipboardPending = true;
+		return;
+	}
+
+	startClipboardSend(m_active);
+}
+
+void
+Server::startClipboardSend(BaseClientProxy* target)
 {
+	assert(m_sendClipboardThread == NULL);
+
+	ClipboardSend* send = new ClipboardSend;
+	send->m_target = target;
 	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
-		m_active->setClipboard(id, &m_clipboards[id].m_clipboard);
+		Clipboard::copy(&send->m_clipboard[id], &m_clipboards[id].m_clipboard);
 	}
+
+	StreamChunker::resetClipboardInterrupt();
+	m_sendClipboardPending = false;
+	m_sendClipboardStale   = false;
+	m_sendClipboardTarget  = target;
+	m_sendClipboardThread  = new Thread(
+									new TMethodJob<Server>(
+											this,
+											&Server::sendClipboardThread,
+											send));
+}
+
+void
+Server::stopClipboardSend(BaseClientProxy* client)
+{
+	if (m_sendClipboardThread == NULL || m_sendClipboardTarget != client) {
+		return;
+	}
+
+	// the thread is cleaned up when its sent event is handled
+	StreamChunker::interruptClipboard();
+	m_sendClipboardThread->wait();
+	m_sendClipboardTarget = NULL;
+}
+
+void
+Server::sendClipboardThread(void* vsend)
+{
+	ClipboardSend* send = static_cast<ClipboardSend*>(vsend);
+	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+		send->m_target->setClipboard(id, &send->m_clipboard[id]);
+	}
+	delete send;
+
+	m_events->addEvent(Event(m_events->forServer().clipboardSent(), this));
+}
+
+void
+Server::handleClipboardSentEvent(const Event&, void*)
+{
+	if (m_sendClipboardThread == NULL) {
+		return;
+	}
+
+	// only one send runs at a time, so this event is from the current
+	// thread, which has nothing left to do but exit.
+	m_sendClipboardThread->wait();
+	delete m_sendClipboardThread;
+	m_sendClipboardThread = NULL;
+	m_sendClipboardTarget = NULL;
+
+	if (m_sendClipboardPending) {
+		scheduleClipboardSend();
+	}
+}
+
+void
+Server::handleClipboardRefreshEvent(const Event&, void*)
+{
+	// update the primary client's clipboards since we left the
+	// primary screen.  the active screen may have changed since.
+	if (!refreshPrimaryClipboards(NULL)) {
+		scheduleClipboardSend();
+	}
+}
+
+void
+Server::handleClipboardRefreshedEvent(const Event& event, void*)
+{
+	BaseClientProxy* target =
+		static_cast<BaseClientProxy*>(event.getData());
+	if (target == NULL) {
+		scheduleClipboardSend();
+		return;
+	}
+
+	// a prefetch.  the cursor may have turned away or crossed since.
+	if (target != m_prefetchTarget || target == m_active ||
+		m_sendClipboardThread != NULL) {
+		return;
+	}
+	startClipboardSend(target);
+}
+
+bool
+Server::refreshPrimaryClipboards(BaseClientProxy* target)
+{
+	// a clipboard the primary screen reported changing was read and
+	// marshalled then, so only the others are read here
+	bool refreshing = false;
+	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+		ClipboardInfo& clipboard = m_clipboards[id];
+		if (clipboard.m_clipboardOwner == getName(m_primaryClient) &&
+			!clipboard.m_snapshot) {
+			// the other screens must hear about the grab before the data
+			flushClipboardGrab(id);
+			marshallClipboard(m_primaryClient, id, true);
+			refreshing = true;
+		}
+	}
+
+	// the bulk loop runs jobs in order, so this comes back after the
+	// clipboards
+	if (refreshing) {
+		m_bulkLoop->post(new TMethodJob<Server>(
+							this, &Server::clipboardsRefreshed, target));
+	}
+	return refreshing;
+}
+
+void
+Server::clipboardsRefreshed(void* target)
+{
+	m_events->addEvent(Event(m_events->forServer().clipboardRefreshed(),
+							this, target, Event::kDontFreeData));
+}
+
+void
+Server::prefetchClipboard(SInt32 ax, SInt32 ay, SInt32 aw, SInt32 ah)
+{
+	// estimate the cursor's speed and find the edge it's heading for
+	double dt = m_prefetchTime.getTime();
+	m_prefetchTime.reset();
+	m_prefetchPredictor.addMotion(m_xDelta, m_yDelta, dt);
+	EDirection dir = m_prefetchPredictor.predictEdge(m_x, m_y, ax, ay, aw, ah);
+
+	BaseClientProxy* target = NULL;
+	if (dir != kNoDirection) {
+		SInt32 x = m_x, y = m_y;
+		target = getNeighbor(m_active, dir, x, y);
+	}
+	if (target == m_prefetchTarget) {
+		return;
+	}
+
+	// the cursor turned away or is heading somewhere else
+	cancelClipboardPrefetch();
+	if (target == NULL || target == m_primaryClient) {
+		return;
+	}
+
+	// remember the target even if we can't prefetch to it so we don't
+	// try again on every move.  reading the clipboards is slow so the
+	// send is started from the event loop rather than on this move.
+	m_prefetchTarget = target;
+	m_events->addEvent(Event(m_events->forServer().clipboardPrefetch(), this));
+}
+
+void
+Server::handleClipboardPrefetchEvent(const Event&, void*)
+{
+	// the cursor may have turned away or crossed since.  sends to the
+	// active screen come first.
+	BaseClientProxy* target = m_prefetchTarget;
+	if (target == NULL || target == m_active ||
+		m_sendClipboardThread != NULL) {
+		return;
+	}
+
+	// the primary screen's clipboards are only fetched when needed.
+	// the send starts once they're taken.
+	LOG((CLOG_DEBUG "prefetching clipboards to \"%s\"", getName(target).c_str()));
+	if (m_active == m_primaryClient && refreshPrimaryClipboards(target)) {
+		return;
+	}
+	startClipboardSend(target);
+}
+
+void
+Server::cancelClipboardPrefetch()
+{
+	if (m_prefetchTarget == NULL) {
+		return;
+	}
+
+	// the thread is cleaned up when its sent event is handled.  whatever
+	// wasn't sent is still dirty and is sent on entering the screen.
+	if (m_sendClipboardThread != NULL &&
+		m_sendClipboardTarget == m_prefetchTarget &&
+		m_sendClipboardTarget != m_active) {
+		LOG((CLOG_DEBUG "cancelled clipboard prefetch to \"%s\"", getName(m_prefetchTarget).c_str()));
+		StreamChunker::interruptClipboard();
+	}
+	m_prefetchTarget = NULL;
+}
+
+void
+Server::resetClipboardPrefetch()
+{
+	m_prefetchTarget = NULL;
+	m_prefetchTime.setTrigger();
+	m_prefetchPredictor.reset();
 }
 
 void
@@ -1981,6 +2477,8 @@ Server::onMouseMoveSecondary(SInt32 dx, SInt32 dy)
 				}
 			}
 
+			prefetchClipboard(ax, ay, aw, ah);
+
 			// skip rest of block
 			break;
 		}
@@ -1996,10 +2494,11 @@ Server::onMouseMoveSecondary(SInt32 dx, SInt32 dy)
 	} while (false);
 
 	if (jump) {
+		// the thread is cleaned up when its finished event is handled
 		if (m_sendFileThread != NULL) {
 			StreamChunker::interruptFile();
-			m_sendFileThread = NULL;
 		}
+		m_sendFilesPending = false;
 
 		SInt32 newX = m_x;
 		SInt32 newY = m_y;
@@ -2062,31 +2561,64 @@ Server::onFileChunkSending(const void* data)
 	LOG((CLOG_DEBUG1 "sending file chunk"));
 	assert(m_active != NULL);
 
-	// relay
- 	m_active->fileChunkSending(chunk->m_chunk[0], &chunk->m_chunk[1], chunk->m_dataSize);
+	// relay to the client the transfer was started for, whether or not
+	// it's active.  stop sending if it has gone away; it can ask to
+	// resume once it's back.
+	BaseClientProxy* client = m_active;
+	if (!m_fileTransferTarget.empty()) {
+		ClientList::const_iterator index = m_clients.find(m_fileTransferTarget);
+		if (index == m_clients.end()) {
+			StreamChunker::interruptFile();
+			StreamChunker::fileChunkSent(chunk->m_dataSize);
+			return;
+		}
+		client = index->second;
+	}
+
+ 	client->fileChunkSending(chunk->m_chunk[0], &chunk->m_chunk[1], chunk->m_dataSize);
+
+	// let the sender thread queue more data
+	StreamChunker::fileChunkSent(chunk->m_dataSize);
 }
 
 void
-Server::onFileRecieveCompleted()
+Server::onFileRecieveCompleted(FileReceived* received)
 {
-	if (isReceivedFileSizeValid()) {
+	UInt32 index = received->m_fileIndex;
+
+	if (index < m_fakeDragFileList.size()) {
+		// hand the data over to the writer so the next file in the
+		// session can be received while this one is written
+		DroppedFile* file = new DroppedFile(
+								m_fakeDragFileList.at(index).getFilename());
+		file->m_data.swap(received->m_data);
+
 		m_writeToDropDirThread = new Thread(
 									   new TMethodJob<Server>(
-															   this, &Server::writeToDropDirThread));
+															   this, &Server::writeToDropDirThread,
+															   file));
+	}
+
+	if (index + 1 >= m_fakeDragFileList.size()) {
+		m_fakeDragFileList.clear();
 	}
 }
 
 void
-Server::writeToDropDirThread(void*)
+Server::writeToDropDirThread(void* data)
 {
 	LOG((CLOG_DEBUG "starting write to drop dir thread"));
 
+	DroppedFile* file = reinterpret_cast<DroppedFile*>(data);
+
 	while (m_screen->isFakeDraggingStarted()) {
 		ARCH->sleep(.1f);
 	}
 
-	DropHelper::writeToDir(m_screen->getDropTarget(), m_fakeDragFileList,
-					m_receivedFileData);
+	DropHelper::writeToDir(m_screen->getDropTarget(), file->m_filename,
+					file->m_data);
+
+	delete file;
 }
 
 bool
@@ -2135,6 +2667,16 @@ Server::removeClient(BaseClientProxy* client)
 		return false;
 	}
 
+	// the clipboard sending thread mustn't outlive the client, nor
+	// may a bulk loop job still to read its clipboard
+	stopClipboardSend(client);
+	if (m_bulkLoop != NULL) {
+		m_bulkLoop->flush();
+	}
+	if (m_prefetchTarget == client) {
+		m_prefetchTarget = NULL;
+	}
+
 	// remove event handlers
 	m_events->removeHandler(m_events->forIScreen().shapeChanged(),
 							client->getEventTarget());
@@ -2150,6 +2692,31 @@ Server::removeClient(BaseClientProxy* client)
 	return true;
 }
 
+void
+Server::updateBandwidth(BaseClientProxy* client)
+{
+	String name = getName(client);
+
+	double bandwidth = 0.0;
+	const Config::ScreenOptions* options = m_config->getOptions(name);
+	if (options != NULL) {
+		Config::ScreenOptions::const_iterator index =
+			options->find(kOptionBandwidthLimit);
+		if (index != options->end()) {
+			// kilobytes per second
+			bandwidth = 1024.0 * static_cast<double>(index->second);
+		}
+	}
+
+	BandwidthList::iterator index = m_clientBandwidth.find(name);
+	if (index == m_clientBandwidth.end()) {
+		index = m_clientBandwidth.insert(std::make_pair(name,
+					new TokenBucket(m_bandwidth))).first;
+	}
+	index->second->setRate(bandwidth);
+	client->setBandwidth(index->second);
+}
+
 void
 Server::closeClient(BaseClientProxy* client, const char* msg)
 {
@@ -2285,9 +2852,13 @@ Server::forceLeaveClient(BaseClientProxy* client)
 
 Server::ClipboardInfo::ClipboardInfo() :
 	m_clipboard(),
-	m_clipboardData(),
 	m_clipboardOwner(),
-	m_clipboardSeqNum(0)
+	m_clipboardSeqNum(0),
+	m_grabTimer(NULL),
+	m_updateCount(0),
+	m_clipboardHash(0),
+	m_clipboardSize(0),
+	m_snapshot(false)
 {
 	// do nothing
 }
@@ -2360,38 +2931,165 @@ Server::KeyboardBroadcastInfo::alloc(State state, const String& screens)
 	return info;
 }
 
-bool
-Server::isReceivedFileSizeValid()
+FileReceiveState&
+Server::getFileReceiveState(const String& name)
 {
-	return m_expectedFileSize == m_receivedFileData.size();
+	return m_fileReceives[name];
 }
 
 void
 Server::sendFileToClient(const char* filename)
 {
+	String name(filename);
+	DragInformation di;
+	di.setFilename(name);
+	DragFileList fileList;
+	fileList.push_back(di);
+
+	sendFilesToClient(fileList);
+}
+
+void
+Server::sendFilesToClient(const DragFileList& fileList)
+{
+	m_sendFilesPending = true;
+	m_sendFilesTarget = getName(m_active);
+	m_sendFilesList = fileList;
+
+	// stop the old transfer and start this one once its thread is
+	// done, so their chunks don't mix
 	if (m_sendFileThread != NULL) {
 		StreamChunker::interruptFile();
+		return;
 	}
-	
+
+	startFileSend();
+}
+
+void
+Server::startFileSend()
+{
+	m_sendFilesPending = false;
+
+	// the screen may have disconnected while the last send finished
+	ClientList::const_iterator client = m_clients.find(m_sendFilesTarget);
+	if (client == m_clients.end()) {
+		LOG((CLOG_DEBUG "no screen \"%s\" to send files to", m_sendFilesTarget.c_str()));
+		m_sendFilesList.clear();
+		return;
+	}
+
+	m_fileTransferTarget = m_sendFilesTarget;
+	m_fileTransferBandwidth = client->second->getBandwidth();
+	m_fileTransferFromFile = canSendFromFile(m_fileTransferTarget);
+
+	// remember the session so the client can ask to resume it
+	FileTransferSession& session = m_fileSessions[m_fileTransferTarget];
+	session = StreamChunker::newSession(m_sendFilesList);
+	m_sendFilesList.clear();
+
+	// the thread owns its copy of the session
+	StreamChunker::resetFileInterrupt();
 	m_sendFileThread = new Thread(
 		new TMethodJob<Server>(
 			this, &Server::sendFileThread,
-			reinterpret_cast<void*>(const_cast<char*>(filename))));
+			new FileTransferSession(session)));
+}
+
+void
+Server::fileResumeRequested(const String& name, const FileTransferResume& resume)
+{
+	if (!m_enableDragDrop) {
+		LOG((CLOG_DEBUG "drag drop not enabled, ignoring file resume."));
+		return;
+	}
+
+	m_fileResumePending = true;
+	m_fileResumeTarget = name;
+	m_fileResume = resume;
+
+	// stop the old transfer and continue once its thread is done, so
+	// their chunks don't mix
+	if (m_sendFileThread != NULL) {
+		StreamChunker::interruptFile();
+		return;
+	}
+
+	startFileResume();
+}
+
+void
+Server::startFileResume()
+{
+	m_fileResumePending = false;
+
+	FileSessionList::iterator session = m_fileSessions.find(m_fileResumeTarget);
+	if (session == m_fileSessions.end()) {
+		LOG((CLOG_DEBUG "no file transfer to resume for \"%s\"", m_fileResumeTarget.c_str()));
+		return;
+	}
+	session->second.m_resume = m_fileResume;
+
+	m_fileTransferTarget = m_fileResumeTarget;
+	m_fileTransferBandwidth = m_bandwidth;
+	BandwidthList::const_iterator index = m_clientBandwidth.find(m_fileResumeTarget);
+	if (index != m_clientBandwidth.end()) {
+		m_fileTransferBandwidth = index->second;
+	}
+	m_fileTransferFromFile = canSendFromFile(m_fileTransferTarget);
+
+	// the thread owns its copy of the session
+	StreamChunker::resetFileInterrupt();
+	m_sendFileThread = new Thread(
+		new TMethodJob<Server>(
+			this, &Server::resumeFileThread,
+			new FileTransferSession(session->second)));
+}
+
+bool
+Server::canSendFromFile(const String& name) const
+{
+	ClientList::const_iterator client = m_clients.find(name);
+	if (client == m_clients.end()) {
+		return false;
+	}
+	return (synergy::getFileSender(client->second->getStream()) != NULL);
 }
 
 void
 Server::sendFileThread(void* data)
 {
+	FileTransferSession* session = reinterpret_cast<FileTransferSession*>(data);
+
 	try {
-		char* filename = reinterpret_cast<char*>(data);
-		LOG((CLOG_DEBUG "sending file to client, filename=%s", filename));
-		StreamChunker::sendFile(filename, m_events, this);
+		LOG((CLOG_DEBUG "sending files to client, count=%s",
+			synergy::string::sizeTypeToString(session->m_files.size()).c_str()));
+		StreamChunker::sendFiles(*session, m_events, this,
+			m_fileTransferBandwidth, m_fileTransferFromFile);
 	}
 	catch (std::runtime_error error) {
 		LOG((CLOG_ERR "failed sending file chunks, error: %s", error.what()));
 	}
 
-	m_sendFileThread = NULL;
+	delete session;
+	m_events->addEvent(Event(m_events->forFile().fileSendFinished(), this));
+}
+
+void
+Server::resumeFileThread(void* data)
+{
+	FileTransferSession* session = reinterpret_cast<FileTransferSession*>(data);
+
+	try {
+		StreamChunker::resumeFiles(*session, m_events, this,
+			m_fileTransferBandwidth, m_fileTransferFromFile);
+	}
+	catch (std::runtime_error error) {
+		LOG((CLOG_ERR "failed resuming file chunks, error: %s", error.what()));
+	}
+
+	delete session;
+	m_events->addEvent(Event(m_events->forFile().fileSendFinished(), this));
 }
 
 void
@@ -2406,3 +3104,41 @@ Server::dragInfoReceived(UInt32 fileNum, String content)
 
 	m_screen->startDraggingFiles(m_fakeDragFileList);
 }
+
+
+//
+// Server::ClipboardMarshallJob
+//
+
+Server::ClipboardMarshallJob::ClipboardMarshallJob(
+				Server* server, ClipboardUpdate* update) :
+	m_server(server),
+	m_update(update)
+{
+	// do nothing
+}
+
+Server::ClipboardMarshallJob::~ClipboardMarshallJob()
+{
+	delete m_update;
+}
+
+void
+Server::ClipboardMarshallJob::run()
+{
+	if (m_update->m_sender != NULL) {
+		m_update->m_sender->getClipboard(m_update->m_id, &m_update->m_clipboard);
+	}
+
+	// only the hash is kept to compare the next update with
+	String data = m_update->m_clipboard.marshall();
+	m_update->m_hash = ClipboardDelta::hash(data);
+	m_update->m_size = data.size();
+
+	// the event owns the update from here
+	Event event(m_server->m_events->forServer().clipboardMarshalled(),
+								m_server);
+	event.setDataObject(m_update);
+	m_update = NULL;
+	m_server->m_events->addEvent(event);
+}
@@ -19,20 +19,25 @@
 #pragma once
 
 #include "server/Config.h"
+#include "server/EdgePredictor.h"
 #include "synergy/clipboard_types.h"
 #include "synergy/Clipboard.h"
 #include "synergy/key_types.h"
 #include "synergy/mouse_types.h"
 #include "synergy/INode.h"
 #include "synergy/DragInformation.h"
+#include "synergy/FileChunk.h"
+#include "synergy/StreamChunker.h"
 #include "base/Event.h"
 #include "base/Stopwatch.h"
 #include "base/EventTypes.h"
+#include "base/IJob.h"
 #include "common/stdmap.h"
 #include "common/stdset.h"
 #include "common/stdvector.h"
 
 class BaseClientProxy;
+class BulkLoop;
 class EventQueueTimer;
 class PrimaryClient;
 class InputFilter;
@@ -40,6 +45,7 @@ namespace synergy { class Screen; }
 class IEventQueue;
 class Thread;
 class ClientListener;
+class TokenBucket;
 
 //! Synergy server
 /*!
@@ -110,8 +116,12 @@ public:
 	~Server();
 
 #ifdef TEST_ENV
-	Server() : m_mock(true), m_config(NULL) { }
+	Server() : m_mock(true), m_config(NULL), m_bulkLoop(NULL),
+		m_prefetchPredictor(0.0, 0.0, 0.0) { }
 	void setActive(BaseClientProxy* active) {	m_active = active; }
+	void jumpTo(BaseClientProxy* screen) { jumpToScreen(screen); }
+	void moveOnPrimary(SInt32 x, SInt32 y) { onMouseMovePrimary(x, y); }
+	bool isSendingClipboard() const { return m_sendClipboardThread != NULL; }
 #endif
 
 	//! @name manipulators
@@ -144,6 +154,21 @@ public:
 	//! Create a new thread and use it to send file to client
 	void				sendFileToClient(const char* filename);
 
+	//! Create a new thread and use it to send files to client
+	/*!
+	Sends every file in \p fileList to the active client as a single
+	transfer session.
+	*/
+	void				sendFilesToClient(const DragFileList& fileList);
+
+	//! Resume sending files to a client
+	/*!
+	Called when the client named \p name asks to resume an unfinished
+	transfer after reconnecting.
+	*/
+	void				fileResumeRequested(const String& name,
+							const FileTransferResume& resume);
+
 	//! Received dragging information from client
 	void				dragInfoReceived(UInt32 fileNum, String content);
 
@@ -166,14 +191,13 @@ public:
 	*/
 	void				getClients(std::vector<String>& list) const;
 	
-	//! Return true if recieved file size is valid
-	bool				isReceivedFileSizeValid();
-
-	//! Return expected file data size
-	size_t&				getExpectedFileSize() { return m_expectedFileSize; }
-
-	//! Return received file data
-	String&				getReceivedFileData() { return m_receivedFileData; }
+	//! Get the file being received from a client
+	/*!
+	Returns the state of the file coming in from the client named
+	\c name.  It is kept after the client disconnects so an unfinished
+	transfer can be resumed when the client comes back.
+	*/
+	FileReceiveState&	getFileReceiveState(const String& name);
 
 	//! Return fake drag file list
 	DragFileList		getFakeDragFileList() { return m_fakeDragFileList; }
@@ -292,6 +316,7 @@ private:
 	// event handlers
 	void				handleShapeChanged(const Event&, void*);
 	void				handleClipboardGrabbed(const Event&, void*);
+	void				handleClipboardGrabTimeout(const Event&, void*);
 	void				handleClipboardChanged(const Event&, void*);
 	void				handleKeyDownEvent(const Event&, void*);
 	void				handleKeyUpEvent(const Event&, void*);
@@ -314,10 +339,33 @@ private:
 	void				handleFakeInputEndEvent(const Event&, void*);
 	void				handleFileChunkSendingEvent(const Event&, void*);
 	void				handleFileRecieveCompletedEvent(const Event&, void*);
+	void				handleFileTransferProgressEvent(const Event&, void*);
+	void				handleFileSendFinishedEvent(const Event&, void*);
+	void				handleClipboardSentEvent(const Event&, void*);
+	void				handleClipboardRefreshEvent(const Event&, void*);
+	void				handleClipboardPrefetchEvent(const Event&, void*);
+	void				handleClipboardMarshalledEvent(const Event&, void*);
+	void				handleClipboardRefreshedEvent(const Event&, void*);
 
 	// event processing
 	void				onClipboardChanged(BaseClientProxy* sender,
 							ClipboardID id, UInt32 seqNum);
+
+	// read and marshall clipboard \p id of \p sender on the bulk loop.
+	// this supersedes any update of it still on the bulk loop.
+	void				marshallClipboard(BaseClientProxy* sender,
+							ClipboardID id, bool refresh);
+
+	// take the marshalled clipboard with \p hash and \p size as the new
+	// contents of clipboard \p id if it has changed.  returns true if
+	// it did.
+	bool				takeClipboardData(ClipboardID id,
+							UInt32 hash, size_t size);
+
+	// tell the other screens about the last grab of clipboard \p id
+	// now if it hasn't been sent yet
+	void				flushClipboardGrab(ClipboardID id);
+	void				flushClipboardGrabs();
 	void				onScreensaver(bool activated);
 	void				onKeyDown(KeyID, KeyModifierMask, KeyButton,
 							const char* screens);
@@ -330,7 +378,7 @@ private:
 	void				onMouseMoveSecondary(SInt32 dx, SInt32 dy);
 	void				onMouseWheel(SInt32 xDelta, SInt32 yDelta);
 	void				onFileChunkSending(const void* data);
-	void				onFileRecieveCompleted();
+	void				onFileRecieveCompleted(FileReceived*);
 
 	// add client to list and attach event handlers for client
 	bool				addClient(BaseClientProxy*);
@@ -341,6 +389,9 @@ private:
 	// close a client
 	void				closeClient(BaseClientProxy*, const char* msg);
 
+	// apply the configured bandwidth limit to a client
+	void				updateBandwidth(BaseClientProxy*);
+
 	// close clients not in \p config
 	void				closeClients(const Config& config);
 
@@ -357,6 +408,18 @@ private:
 	
 	// thread funciton for sending file
 	void				sendFileThread(void*);
+
+	// thread function for resuming sending files
+	void				resumeFileThread(void*);
+
+	// start the file send waiting for the sending thread
+	void				startFileSend();
+
+	// start the file resume waiting for the sending thread
+	void				startFileResume();
+
+	// test if the stream to the screen named \p name sends from files
+	bool				canSendFromFile(const String& name) const;
 	
 	// thread function for writing file to drop directory
 	void				writeToDropDirThread(void*);
@@ -367,6 +430,36 @@ private:
 	// send drag info to new client screen
 	void				sendDragInfo(BaseClientProxy* newScreen);
 
+	// send the clipboards to the active screen.  this never waits for
+	// a send in progress;  that send is interrupted and a new one
+	// starts when it has finished.  a send of the current clipboards
+	// to the active screen (e.g. a prefetch) is left to finish.
+	void				scheduleClipboardSend();
+
+	// start a thread sending the clipboards to \p target
+	void				startClipboardSend(BaseClientProxy* target);
+
+	// get the primary screen's clipboards if it owns them.  returns
+	// false if none needed reading, otherwise a clipboard refreshed
+	// event follows once they're taken.  it sends them to \p target,
+	// or to the active screen if NULL.
+	bool				refreshPrimaryClipboards(BaseClientProxy* target);
+
+	// bulk loop job posting the clipboard refreshed event
+	void				clipboardsRefreshed(void* target);
+
+	// watch the cursor approach the edges of the active screen, given
+	// its shape.  if it will soon cross to a neighbor then post an event
+	// to start sending the clipboards there.  the send is cancelled if
+	// it turns away.
+	void				prefetchClipboard(SInt32 ax, SInt32 ay,
+							SInt32 aw, SInt32 ah);
+	void				cancelClipboardPrefetch();
+	void				resetClipboardPrefetch();
+
+	// interrupt and wait for a clipboard send to \p client
+	void				stopClipboardSend(BaseClientProxy* client);
+
 	// thread funciton for sending clipboard
 	void				sendClipboardThread(void*);
 
@@ -380,9 +473,67 @@ private:
 
 	public:
 		Clipboard		m_clipboard;
-		String			m_clipboardData;
 		String			m_clipboardOwner;
 		UInt32			m_clipboardSeqNum;
+
+		// non-NULL while a grab hasn't been sent to the other screens.
+		// grabs are coalesced until it fires.
+		EventQueueTimer*	m_grabTimer;
+
+		// counts grabs and updates, so a clipboard marshalled on the
+		// bulk loop is dropped if something newer came along meanwhile
+		UInt32			m_updateCount;
+
+		// the hash and size of m_clipboard marshalled, to tell if an
+		// update changed it
+		UInt32			m_clipboardHash;
+		size_t			m_clipboardSize;
+
+		// true if m_clipboard was marshalled from a change the owner
+		// reported since its last grab.  the primary screen's
+		// clipboards needn't be read when leaving it then.
+		bool			m_snapshot;
+	};
+
+	// a changed clipboard being read and marshalled on the bulk loop
+	class ClipboardUpdate : public EventData {
+	public:
+		ClipboardID		m_id;
+		UInt32			m_updateCount;
+
+		// the screen to read the clipboard from, or NULL if it was
+		// read into m_clipboard already
+		BaseClientProxy*	m_sender;
+
+		// true if read for a refresh rather than a reported change
+		bool			m_refresh;
+		Clipboard		m_clipboard;
+		UInt32			m_hash;
+		size_t			m_size;
+	};
+
+	// bulk loop job reading and marshalling a changed clipboard.  it
+	// owns the update until handing it back, so updates still queued
+	// when the bulk loop stops are freed along with their jobs.
+	class ClipboardMarshallJob : public IJob {
+	public:
+		ClipboardMarshallJob(Server* server, ClipboardUpdate* update);
+		virtual ~ClipboardMarshallJob();
+
+		// IJob overrides
+		virtual void	run();
+
+	private:
+		Server*			m_server;
+		ClipboardUpdate*	m_update;
+	};
+
+	// clipboards to send, copied so the sending thread doesn't race
+	// with updates to m_clipboards
+	class ClipboardSend {
+	public:
+		BaseClientProxy*	m_target;
+		Clipboard		m_clipboard[kClipboardEnd];
 	};
 
 	// the primary screen client
@@ -467,12 +618,26 @@ private:
 	IEventQueue*		m_events;
 
 	// file transfer
-	size_t				m_expectedFileSize;
-	String				m_receivedFileData;
+	typedef std::map<String, FileReceiveState> FileReceiveList;
+	FileReceiveList		m_fileReceives;
 	DragFileList		m_dragFileList;
 	DragFileList		m_fakeDragFileList;
 	Thread*				m_sendFileThread;
 	Thread*				m_writeToDropDirThread;
+	String				m_fileTransferTarget;
+
+	// the files to send once the sending thread is done
+	bool				m_sendFilesPending;
+	String				m_sendFilesTarget;
+	DragFileList		m_sendFilesList;
+
+	// the last file session sent to each client, and the session to
+	// resume once the sending thread is done
+	typedef std::map<String, FileTransferSession> FileSessionList;
+	FileSessionList		m_fileSessions;
+	bool				m_fileResumePending;
+	String				m_fileResumeTarget;
+	FileTransferResume	m_fileResume;
 	String				m_dragFileExt;
 	bool				m_ignoreFileTransfer;
 	bool				m_enableDragDrop;
@@ -483,4 +648,27 @@ private:
 	ClientListener*		m_clientListener;
 
 	Thread*				m_sendClipboardThread;
+	BaseClientProxy*	m_sendClipboardTarget;
+	bool				m_sendClipboardPending;
+
+	// true if the clipboards changed since the send thread started
+	bool				m_sendClipboardStale;
+
+	// runs slow work off the event loop so input isn't held up
+	BulkLoop*			m_bulkLoop;
+
+	// screen the cursor is heading for, and its motion, for
+	// prefetching the clipboards
+	BaseClientProxy*	m_prefetchTarget;
+	Stopwatch			m_prefetchTime;
+	EdgePredictor		m_prefetchPredictor;
+
+	// bulk data rate limits.  the global bucket is the parent of each
+	// client's bucket.  client buckets live as long as the server so
+	// sending threads never see one go away.
+	typedef std::map<String, TokenBucket*> BandwidthList;
+	TokenBucket*		m_bandwidth;
+	BandwidthList		m_clientBandwidth;
+	TokenBucket*		m_fileTransferBandwidth;
+	bool				m_fileTransferFromFile;
 };
@@ -32,6 +32,7 @@
 #include "ipc/IpcMessage.h"
 #include "ipc/Ipc.h"
 #include "base/EventQueue.h"
+#include "base/MemoryBudget.h"
 
 #if SYSAPI_WIN32
 #include "arch/win32/ArchMiscWindows.h"
@@ -64,7 +65,12 @@ App::App(IEventQueue* events, CreateTaskBarReceiverFunc createTaskBarReceiver, A
 	m_args(args),
 	m_createTaskBarReceiver(createTaskBarReceiver),
 	m_appUtil(events),
-	m_ipcClient(nullptr)
+	m_ipcClient(nullptr),
+	m_socketMultiplexer(NULL),
+	m_memoryBudget(NULL),
+	m_startupTiming(false),
+	m_startupTime(true),
+	m_startupPhaseTime(true)
 {
 	assert(s_instance == nullptr);
 	s_instance = this;
@@ -73,6 +79,7 @@ App::App(IEventQueue* events, CreateTaskBarReceiverFunc createTaskBarReceiver, A
 App::~App()
 {
 	s_instance = nullptr;
+	delete m_memoryBudget;
 	delete m_args;
 }
 
@@ -170,6 +177,8 @@ App::loggingFilterWarning()
 void 
 App::initApp(int argc, const char** argv)
 {
+	startupBegin();
+
 	// parse command line
 	parseArgs(argc, argv);
 	
@@ -183,6 +192,16 @@ App::initApp(int argc, const char** argv)
 		m_bye(kExitArgs);
 	}
 	loggingFilterWarning();
+
+	// account for memory from here on
+	if (m_memoryBudget == NULL) {
+		m_memoryBudget = new MemoryBudget;
+	}
+	if (argsBase().m_memoryLimit != 0) {
+		MemoryBudget::setLimit(argsBase().m_memoryLimit);
+		LOG((CLOG_INFO "memory limit set to %u MB",
+			(unsigned int)(argsBase().m_memoryLimit / (1024 * 1024))));
+	}
 	
 	if (argsBase().m_enableDragDrop) {
 		LOG((CLOG_INFO "drag and drop enabled"));
@@ -190,9 +209,11 @@ App::initApp(int argc, const char** argv)
 
 	// setup file logging after parsing args
 	setupFileLogging();
+	startupPhase("args");
 
 	// load configuration
 	loadConfig();
+	startupPhase("config");
 
 	if (!argsBase().m_disableTray) {
 
@@ -226,6 +247,56 @@ App::cleanupIpcClient()
 	delete m_ipcClient;
 }
 
+void
+App::loadPlugins()
+{
+	// the only plugin provides secure sockets, so don't pay for
+	// scanning the plugin directory and loading libraries unless
+	// it will be used.
+	if (!argsBase().m_enableCrypto) {
+		LOG((CLOG_DEBUG "crypto disabled, not loading plugins"));
+		return;
+	}
+
+	// load all available plugins.
+	ARCH->plugin().load();
+	// pass log and arch into plugins.
+	ARCH->plugin().init(Log::getInstance(), Arch::getInstance());
+	startupPhase("plugins");
+}
+
+void
+App::startupBegin()
+{
+	m_startupTiming = true;
+	m_startupTime.reset();
+	m_startupTime.start();
+	m_startupPhaseTime.reset();
+	m_startupPhaseTime.start();
+}
+
+void
+App::startupPhase(const char* name)
+{
+	if (!m_startupTiming) {
+		return;
+	}
+
+	LOG((CLOG_DEBUG "startup phase %s took %.1f ms",
+		name, 1000.0 * m_startupPhaseTime.reset()));
+}
+
+void
+App::startupComplete()
+{
+	if (!m_startupTiming) {
+		return;
+	}
+
+	m_startupTiming = false;
+	LOG((CLOG_INFO "startup took %.1f ms", 1000.0 * m_startupTime.getTime()));
+}
+
 void
 App::handleIpcMessage(const Event& e, void*)
 {
@@ -23,6 +23,7 @@
 #include "base/String.h"
 #include "base/Log.h"
 #include "base/EventQueue.h"
+#include "base/Stopwatch.h"
 #include "common/common.h"
 
 #if SYSAPI_WIN32
@@ -38,6 +39,7 @@ class FileLogOutputter;
 namespace synergy { class Screen; }
 class IEventQueue;
 class SocketMultiplexer;
+class MemoryBudget;
 
 typedef IArchTaskBarReceiver* (*CreateTaskBarReceiverFunc)(const BufferedLogOutputter*, IEventQueue* events);
 
@@ -108,6 +110,19 @@ protected:
 	void				cleanupIpcClient();
 	void				runEventsLoop(void*);
 
+	// Load plugins, but only if a feature that needs one is enabled.
+	void				loadPlugins();
+
+	// Start timing startup (or a restart) from now.
+	void				startupBegin();
+
+	// Log how long the named startup phase took.
+	void				startupPhase(const char* name);
+
+	// Log the total startup time.  Only the first call after
+	// startupBegin() is reported.
+	void				startupComplete();
+
 	IArchTaskBarReceiver* m_taskBarReceiver;
 	bool m_suspended;
 	IEventQueue*		m_events;
@@ -120,6 +135,10 @@ private:
 	ARCH_APP_UTIL m_appUtil;
 	IpcClient*			m_ipcClient;
 	SocketMultiplexer*	m_socketMultiplexer;
+	MemoryBudget*		m_memoryBudget;
+	bool				m_startupTiming;
+	Stopwatch			m_startupTime;
+	Stopwatch			m_startupPhaseTime;
 };
 
 class MinimalApp : public App {
@@ -163,7 +182,9 @@ private:
 	"*     --restart            restart the server automatically if it fails.\n" \
 	"  -l  --log <file>         write log messages to file.\n" \
 	"      --no-tray            disable the system tray icon.\n" \
-	"      --enable-drag-drop   enable file drag & drop.\n"
+	"      --enable-drag-drop   enable file drag & drop.\n" \
+	"      --memory-limit <MB>  limit the memory used for buffers, clipboards\n" \
+	"                             and file transfers to about MB megabytes.\n"
 
 #define HELP_COMMON_INFO_2 \
 	"  -h, --help               display this help and exit.\n" \
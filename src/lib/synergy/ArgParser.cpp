@@ -110,9 +110,24 @@ ArgParser::parseClientArgs(ClientArgs& args, int argc, const char* const* argv)
 			// define scroll 
 			args.m_yscroll = atoi(argv[++i]);
 		}
+#if WINAPI_XWINDOWS
+		else if (isArg(i, argc, argv, NULL, "--reactor")) {
+			// poll the server connection with the X connection
+			args.m_reactor = true;
+		}
+#endif
 		else {
 			if (i + 1 == argc) {
+				// the first server is used if it's up, the others are
+				// standbys in the order given
 				args.m_synergyAddress = argv[i];
+				std::vector<String> addresses =
+					synergy::string::splitString(argv[i], ',');
+				if (addresses.size() > 1) {
+					args.m_synergyAddress = addresses[0];
+					args.m_standbyAddresses.assign(
+						addresses.begin() + 1, addresses.end());
+				}
 				return true;
 			}
 
@@ -334,6 +349,17 @@ ArgParser::parseGenericArgs(int argc, const char* const* argv, int& i)
 	else if (isArg(i, argc, argv, NULL, "--plugin-dir", 1)) {
 		argsBase().m_pluginDirectory = argv[++i];
 	}
+	else if (isArg(i, argc, argv, NULL, "--memory-limit", 1)) {
+		int megabytes = atoi(argv[++i]);
+		if (megabytes <= 0) {
+			LOG((CLOG_PRINT "%s: invalid memory limit `%s'" BYE,
+				argsBase().m_pname, argv[i], argsBase().m_pname));
+			argsBase().m_shouldExit = true;
+		}
+		else {
+			argsBase().m_memoryLimit = (size_t)megabytes * 1024 * 1024;
+		}
+	}
 	else {
 		// option not supported here
 		return false;
@@ -18,13 +18,17 @@
 #include "synergy/Chunk.h"
 #include "base/String.h"
 
-Chunk::Chunk(size_t size)
+Chunk::Chunk(size_t size, MemoryBudget::ECategory category) :
+	m_size(size),
+	m_category(category)
 {
 	m_chunk = new char[size];
 	memset(m_chunk, 0, size);
+	MemoryBudget::charge(m_category, m_size);
 }
 
 Chunk::~Chunk()
 {
+	MemoryBudget::release(m_category, m_size);
 	delete[] m_chunk;
 }
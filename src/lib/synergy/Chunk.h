@@ -17,14 +17,26 @@
 
 #pragma once
 
+#include "base/Event.h"
+#include "base/MemoryBudget.h"
 #include "common/basic_types.h"
 
-class Chunk {
+//! Message chunk
+/*!
+Chunks are sent as event data, so use Event::setDataObject().  The
+chunk's memory is charged to \p category of the MemoryBudget until the
+chunk is deleted.
+*/
+class Chunk : public EventData {
 public:
-	Chunk(size_t size);
-	~Chunk();
+	Chunk(size_t size, MemoryBudget::ECategory category);
+	virtual ~Chunk();
 
 public:
 	size_t				m_dataSize;
 	char*				m_chunk;
+
+private:
+	size_t				m_size;
+	MemoryBudget::ECategory m_category;
 };
@@ -110,16 +110,17 @@ ClientApp::help()
 {
 #if WINAPI_XWINDOWS
 #  define WINAPI_ARG \
-	" [--display <display>] [--no-xinitthreads]"
+	" [--display <display>] [--no-xinitthreads] [--reactor]"
 #  define WINAPI_INFO \
 	"      --display <display>  connect to the X server at <display>\n" \
-	"      --no-xinitthreads    do not call XInitThreads()\n"
+	"      --no-xinitthreads    do not call XInitThreads()\n" \
+	"      --reactor            handle network input on the X event thread.\n"
 #else
 #  define WINAPI_ARG
 #  define WINAPI_INFO
 #endif
 
-	char buffer[2000];
+	char buffer[3000];
 	sprintf(
 		buffer,
 		"Usage: %s"
@@ -127,7 +128,7 @@ ClientApp::help()
 		WINAPI_ARG
 		HELP_SYS_ARGS
 		HELP_COMMON_ARGS
-		" <server-address>"
+		" <server-address>[,<server-address>...]"
 		"\n\n"
 		"Connect to a synergy mouse/keyboard sharing server.\n"
 		"\n"
@@ -142,7 +143,8 @@ ClientApp::help()
 		"\n"
 		"The server address is of the form: [<hostname>][:<port>].  The hostname\n"
 		"must be the address or hostname of the server.  The port overrides the\n"
-		"default port, %d.\n",
+		"default port, %d.  Given more than one, the client uses the first that's\n"
+		"up and keeps a connection to the next ready to take over if it goes down.\n",
 		args().m_pname, kDefaultPort
 	);
 
@@ -178,7 +180,8 @@ ClientApp::createScreen()
 #elif WINAPI_XWINDOWS
 	return new synergy::Screen(new XWindowsScreen(
 		args().m_display, false, args().m_disableXInitThreads,
-		args().m_yscroll, m_events), m_events);
+		args().m_yscroll, m_events,
+		args().m_reactor ? getSocketMultiplexer() : NULL), m_events);
 #elif WINAPI_CARBON
 	return new synergy::Screen(new OSXScreen(m_events, false), m_events);
 #endif
@@ -273,6 +276,7 @@ ClientApp::handleClientRestart(const Event&, void* vtimer)
 	m_events->removeHandler(Event::kTimer, timer);
 
 	// reconnect
+	startupBegin();
 	startClient();
 }
 
@@ -292,6 +296,8 @@ void
 ClientApp::handleClientConnected(const Event&, void*)
 {
 	LOG((CLOG_NOTE "connected to server"));
+	startupPhase("connect");
+	startupComplete();
 	resetRestartTimeout();
 	updateStatus();
 }
@@ -398,9 +404,11 @@ ClientApp::startClient()
 	try {
 		if (m_clientScreen == NULL) {
 			clientScreen = openClientScreen();
+			startupPhase("screen");
 			m_client     = openClient(args().m_name,
 				*m_serverAddress, clientScreen);
 			m_clientScreen  = clientScreen;
+			startupPhase("client");
 			LOG((CLOG_NOTE "started client"));
 		}
 
@@ -451,14 +459,12 @@ int
 ClientApp::mainLoop()
 {
 	// create socket multiplexer.  this must happen after daemonization
-	// on unix because threads evaporate across a fork().
-	SocketMultiplexer multiplexer;
+	// on unix because threads evaporate across a fork().  as a reactor
+	// it has no thread;  the screen's event loop polls its sockets.
+	SocketMultiplexer multiplexer(args().m_reactor);
 	setSocketMultiplexer(&multiplexer);
 
-	// load all available plugins.
-	ARCH->plugin().load();
-	// pass log and arch into plugins.
-	ARCH->plugin().init(Log::getInstance(), Arch::getInstance());
+	loadPlugins();
 
 	// start client, etc
 	appUtil().startNode();
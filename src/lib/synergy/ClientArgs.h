@@ -18,6 +18,8 @@
 #pragma once
 
 #include "synergy/ArgsBase.h"
+#include "base/String.h"
+#include "common/stdvector.h"
 
 class NetworkAddress;
 
@@ -27,4 +29,6 @@ public:
 
 public:
 	int					m_yscroll;
+	bool				m_reactor;
+	std::vector<String>	m_standbyAddresses;
 };
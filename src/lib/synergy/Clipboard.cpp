@@ -18,22 +18,58 @@
 
 #include "synergy/Clipboard.h"
 
+#include "base/MemoryBudget.h"
+
 //
 // Clipboard
 //
 
 Clipboard::Clipboard() :
 	m_open(false),
-	m_owner(false)
+	m_owner(false),
+	m_size(0)
 {
 	open(0);
 	empty();
 	close();
 }
 
+Clipboard::Clipboard(const Clipboard& src) :
+	IClipboard(),
+	m_open(false),
+	m_time(src.m_time),
+	m_owner(src.m_owner),
+	m_timeOwned(src.m_timeOwned),
+	m_size(src.m_size)
+{
+	for (SInt32 index = 0; index < kNumFormats; ++index) {
+		m_data[index]  = src.m_data[index];
+		m_added[index] = src.m_added[index];
+	}
+	MemoryBudget::charge(MemoryBudget::kClipboards, m_size);
+}
+
 Clipboard::~Clipboard()
 {
-	// do nothing
+	MemoryBudget::release(MemoryBudget::kClipboards, m_size);
+}
+
+Clipboard&
+Clipboard::operator=(const Clipboard& src)
+{
+	if (&src != this) {
+		MemoryBudget::release(MemoryBudget::kClipboards, m_size);
+		m_time      = src.m_time;
+		m_owner     = src.m_owner;
+		m_timeOwned = src.m_timeOwned;
+		m_size      = src.m_size;
+		for (SInt32 index = 0; index < kNumFormats; ++index) {
+			m_data[index]  = src.m_data[index];
+			m_added[index] = src.m_added[index];
+		}
+		MemoryBudget::charge(MemoryBudget::kClipboards, m_size);
+	}
+	return *this;
 }
 
 bool
@@ -46,6 +82,8 @@ Clipboard::empty()
 		m_data[index]  = "";
 		m_added[index] = false;
 	}
+	MemoryBudget::release(MemoryBudget::kClipboards, m_size);
+	m_size = 0;
 
 	// save time
 	m_timeOwned = m_time;
@@ -62,6 +100,11 @@ Clipboard::add(EFormat format, const String& data)
 	assert(m_open);
 	assert(m_owner);
 
+	MemoryBudget::release(MemoryBudget::kClipboards, m_data[format].size());
+	MemoryBudget::charge(MemoryBudget::kClipboards, data.size());
+	m_size         -= m_data[format].size();
+	m_size         += data.size();
+
 	m_data[format]  = data;
 	m_added[format] = true;
 }
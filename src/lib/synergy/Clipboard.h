@@ -22,13 +22,17 @@
 
 //! Memory buffer clipboard
 /*!
-This class implements a clipboard that stores data in memory.
+This class implements a clipboard that stores data in memory.  The
+data is charged to the clipboards category of the MemoryBudget.
 */
 class Clipboard : public IClipboard {
 public:
 	Clipboard();
+	Clipboard(const Clipboard&);
 	virtual ~Clipboard();
 
+	Clipboard&			operator=(const Clipboard&);
+
 	//! @name manipulators
 	//@{
 
@@ -68,4 +72,5 @@ private:
 	Time				m_timeOwned;
 	bool				m_added[kNumFormats];
 	String				m_data[kNumFormats];
+	size_t				m_size;
 };
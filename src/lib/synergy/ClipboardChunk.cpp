@@ -22,10 +22,25 @@
 #include "io/IStream.h"
 #include "base/Log.h"
 
-size_t ClipboardChunk::s_expectedSize = 0;
+//
+// ClipboardReceiveState
+//
+
+ClipboardReceiveState::ClipboardReceiveState() :
+	m_expectedSize(0),
+	m_rejected(false),
+	m_isDelta(false),
+	m_baseHash(0),
+	m_targetHash(0)
+{
+}
+
+//
+// ClipboardChunk
+//
 
 ClipboardChunk::ClipboardChunk(size_t size) :
-	Chunk(size)
+	Chunk(size, MemoryBudget::kClipboards)
 {
 		m_dataSize = size - CLIPBOARD_CHUNK_META_SIZE;
 }
@@ -85,9 +100,26 @@ ClipboardChunk::end(ClipboardID id, UInt32 sequence)
 	return end;
 }
 
+ClipboardChunk*
+ClipboardChunk::deltaStart(
+					ClipboardID id,
+					UInt32 sequence,
+					size_t size,
+					UInt32 baseHash,
+					UInt32 targetHash)
+{
+	String header = synergy::string::sizeTypeToString(size);
+	header.append(synergy::string::sprintf(",%u,%u", baseHash, targetHash));
+
+	ClipboardChunk* start = ClipboardChunk::start(id, sequence, header);
+	start->m_chunk[5] = kDataDeltaStart;
+
+	return start;
+}
+
 int
 ClipboardChunk::assemble(synergy::IStream* stream,
-					String& dataCached,
+					ClipboardReceiveState& state,
 					ClipboardID& id,
 					UInt32& sequence)
 {
@@ -98,23 +130,49 @@ ClipboardChunk::assemble(synergy::IStream* stream,
 		return kError;
 	}
 	
-	if (mark == kDataStart) {
-		s_expectedSize = synergy::string::stringToSizeType(data);
+	if (mark == kDataStart || mark == kDataDeltaStart) {
+		state.m_isDelta = (mark == kDataDeltaStart);
+		if (!state.m_isDelta) {
+			state.m_expectedSize = synergy::string::stringToSizeType(data);
+		}
+		else if (!parseDeltaStart(data, state.m_expectedSize,
+							state.m_baseHash, state.m_targetHash)) {
+			LOG((CLOG_ERR "invalid clipboard delta header: %s", data.c_str()));
+			state.m_rejected = true;
+			return kError;
+		}
 		LOG((CLOG_DEBUG "start receiving clipboard data"));
-		dataCached.clear();
+		state.m_data.clear();
+
+		// refuse the clipboard up front rather than run out of memory
+		// part way through.  the chunks that follow are dropped.
+		state.m_rejected = !MemoryBudget::isAvailable(state.m_expectedSize);
+		if (state.m_rejected) {
+			LOG((CLOG_ERR "clipboard of %s bytes is too large for the memory limit, dropping it",
+				synergy::string::sizeTypeToString(state.m_expectedSize).c_str()));
+			return kError;
+		}
 		return kStart;
 	}
 	else if (mark == kDataChunk) {
-		dataCached.append(data);
+		if (!state.m_rejected) {
+			state.m_data.append(data);
+		}
 		return kNotFinish;
 	}
 	else if (mark == kDataEnd) {
 		// validate
-		if (id >= kClipboardEnd) {
+		if (state.m_rejected) {
+			state.m_rejected = false;
 			return kError;
 		}
-		else if (s_expectedSize != dataCached.size()) {
-			LOG((CLOG_ERR "corrupted clipboard data, expected size=%d actual size=%d", s_expectedSize, dataCached.size()));
+		else if (id >= kClipboardEnd) {
+			return kError;
+		}
+		else if (state.m_expectedSize != state.m_data.size()) {
+			LOG((CLOG_ERR "corrupted clipboard data, expected size=%s actual size=%s",
+				synergy::string::sizeTypeToString(state.m_expectedSize).c_str(),
+				synergy::string::sizeTypeToString(state.m_data.size()).c_str()));
 			return kError;
 		}
 		return kFinish;
@@ -143,6 +201,10 @@ ClipboardChunk::send(synergy::IStream* stream, void* data)
 		LOG((CLOG_DEBUG2 "sending clipboard chunk start: size=%s", dataChunk.c_str()));
 		break;
 
+	case kDataDeltaStart:
+		LOG((CLOG_DEBUG2 "sending clipboard delta start: %s", dataChunk.c_str()));
+		break;
+
 	case kDataChunk:
 		LOG((CLOG_DEBUG2 "sending clipboard chunk data: size=%i", dataChunk.size()));
 		break;
@@ -154,3 +216,25 @@ ClipboardChunk::send(synergy::IStream* stream, void* data)
 
 	ProtocolUtil::writef(stream, kMsgDClipboard, id, sequence, mark, &dataChunk);
 }
+
+bool
+ClipboardChunk::parseDeltaStart(const String& content, size_t& size,
+				UInt32& baseHash, UInt32& targetHash)
+{
+	String::size_type first = content.find(',');
+	if (first == String::npos || first == 0) {
+		return false;
+	}
+	String::size_type second = content.find(',', first + 1);
+	if (second == String::npos || second == first + 1 ||
+		second + 1 == content.size()) {
+		return false;
+	}
+
+	size       = synergy::string::stringToSizeType(content.substr(0, first));
+	baseHash   = static_cast<UInt32>(synergy::string::stringToSizeType(
+					content.substr(first + 1, second - first - 1)));
+	targetHash = static_cast<UInt32>(synergy::string::stringToSizeType(
+					content.substr(second + 1)));
+	return (baseHash != 0 && targetHash != 0);
+}
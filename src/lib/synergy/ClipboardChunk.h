@@ -28,6 +28,42 @@ namespace synergy {
 class IStream;
 };
 
+//! Clipboard being received
+/*!
+What ClipboardChunk::assemble() knows about the clipboard coming in on
+one stream.  Each stream needs its own so a clipboard rejected or cut
+off on one doesn't affect the others.
+*/
+class ClipboardReceiveState {
+public:
+	ClipboardReceiveState();
+
+	//! Data of the clipboard received so far
+	String&				getData() { return m_data; }
+
+	//! Size the clipboard being received is expected to have
+	size_t				getExpectedSize() const { return m_expectedSize; }
+
+	//! Test if the clipboard is a delta
+	bool				isDelta() const { return m_isDelta; }
+
+	//! Get the hash of the version the delta is against
+	UInt32				getBaseHash() const { return m_baseHash; }
+
+	//! Get the hash of the clipboard the delta gives
+	UInt32				getTargetHash() const { return m_targetHash; }
+
+private:
+	friend class ClipboardChunk;
+
+	String				m_data;
+	size_t				m_expectedSize;
+	bool				m_rejected;
+	bool				m_isDelta;
+	UInt32				m_baseHash;
+	UInt32				m_targetHash;
+};
+
 class ClipboardChunk : public Chunk {
 public:
 	ClipboardChunk(size_t size);
@@ -45,16 +81,39 @@ public:
 	static ClipboardChunk*
 						end(ClipboardID id, UInt32 sequence);
 
+	//! Start a clipboard sent as a delta
+	/*!
+	Like start() but the data chunks that follow are a ClipboardDelta
+	of \p size bytes against the version with \p baseHash, which
+	gives a clipboard with \p targetHash.
+	*/
+	static ClipboardChunk*
+						deltaStart(
+							ClipboardID id,
+							UInt32 sequence,
+							size_t size,
+							UInt32 baseHash,
+							UInt32 targetHash);
+
+	//! Read a clipboard chunk
+	/*!
+	Reads the next chunk from \p stream into \p state, the stream's
+	clipboard being received.  Returns kStart, kNotFinish or kFinish as
+	the clipboard progresses, with its data in \p state once finished,
+	or kError if it was rejected or corrupted.
+	*/
 	static int			assemble(
 							synergy::IStream* stream,
-							String& dataCached,
+							ClipboardReceiveState& state,
 							ClipboardID& id,
 							UInt32& sequence);
 
 	static void			send(synergy::IStream* stream, void* data);
 
-	static size_t		getExpectedSize() { return s_expectedSize; }
-
-private:
-	static size_t		s_expectedSize;
+	//! Parse the content of a kDataDeltaStart chunk
+	static bool			parseDeltaStart(
+							const String& content,
+							size_t& size,
+							UInt32& baseHash,
+							UInt32& targetHash);
 };
@@ -0,0 +1,242 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2013 Synergy Si Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/ClipboardDelta.h"
+
+#include "common/stdvector.h"
+
+#include <algorithm>
+#include <cstring>
+
+// smallest block matched.  bigger data uses bigger blocks to keep the
+// block index to a sensible size.
+static const size_t		kMinBlockSize = 64;
+static const size_t		kMaxBlocks = 65536;
+
+static const char		kOpCopy = 'C';
+static const char		kOpLiteral = 'L';
+
+static const UInt32		kFnvOffset = 2166136261u;
+static const UInt32		kFnvPrime = 16777619u;
+
+namespace {
+
+typedef std::pair<UInt32, UInt32> Block;	// checksum, offset
+typedef std::vector<Block> BlockIndex;
+
+// rolling checksum of \c size bytes at \c data
+class RollingChecksum {
+public:
+	RollingChecksum(const UInt8* data, size_t size) : m_a(0), m_b(0), m_size(size)
+	{
+		for (size_t i = 0; i < size; ++i) {
+			m_a += data[i];
+			m_b += static_cast<UInt32>(size - i) * data[i];
+		}
+	}
+
+	// slide the window forward by one byte
+	void				roll(UInt8 out, UInt8 in)
+	{
+		m_a += in - out;
+		m_b += m_a - static_cast<UInt32>(m_size) * out;
+	}
+
+	UInt32				get() const
+	{
+		return (m_a & 0xffff) | ((m_b & 0xffff) << 16);
+	}
+
+private:
+	UInt32				m_a;
+	UInt32				m_b;
+	size_t				m_size;
+};
+
+void
+appendUInt32(String& out, UInt32 value)
+{
+	out.push_back(static_cast<char>((value >> 24) & 0xff));
+	out.push_back(static_cast<char>((value >> 16) & 0xff));
+	out.push_back(static_cast<char>((value >>  8) & 0xff));
+	out.push_back(static_cast<char>( value        & 0xff));
+}
+
+bool
+readUInt32(const String& in, size_t& pos, UInt32& value)
+{
+	if (in.size() - pos < 4) {
+		return false;
+	}
+	const UInt8* bytes = reinterpret_cast<const UInt8*>(in.data() + pos);
+	value = (static_cast<UInt32>(bytes[0]) << 24) |
+			(static_cast<UInt32>(bytes[1]) << 16) |
+			(static_cast<UInt32>(bytes[2]) <<  8) |
+			 static_cast<UInt32>(bytes[3]);
+	pos += 4;
+	return true;
+}
+
+void
+appendLiteral(String& out, const String& target, size_t start, size_t end)
+{
+	if (end > start) {
+		out.push_back(kOpLiteral);
+		appendUInt32(out, static_cast<UInt32>(end - start));
+		out.append(target, start, end - start);
+	}
+}
+
+void
+appendCopy(String& out, size_t offset, size_t length)
+{
+	out.push_back(kOpCopy);
+	appendUInt32(out, static_cast<UInt32>(offset));
+	appendUInt32(out, static_cast<UInt32>(length));
+}
+
+}
+
+//
+// ClipboardDelta
+//
+
+String
+ClipboardDelta::encode(const String& base, const String& target)
+{
+	String delta;
+
+	size_t blockSize = base.size() / kMaxBlocks;
+	if (blockSize < kMinBlockSize) {
+		blockSize = kMinBlockSize;
+	}
+	if (base.size() < blockSize || target.size() < blockSize) {
+		appendLiteral(delta, target, 0, target.size());
+		return delta;
+	}
+
+	// index the blocks of the base
+	const UInt8* baseData = reinterpret_cast<const UInt8*>(base.data());
+	const UInt8* targetData = reinterpret_cast<const UInt8*>(target.data());
+	BlockIndex index;
+	index.reserve(base.size() / blockSize);
+	for (size_t offset = 0; offset + blockSize <= base.size(); offset += blockSize) {
+		RollingChecksum checksum(baseData + offset, blockSize);
+		index.push_back(Block(checksum.get(), static_cast<UInt32>(offset)));
+	}
+	std::sort(index.begin(), index.end());
+
+	// slide over the target looking for blocks of the base
+	size_t literalStart = 0;
+	size_t pos = 0;
+	RollingChecksum checksum(targetData, blockSize);
+	while (pos + blockSize <= target.size()) {
+		size_t matchOffset = base.size();
+		BlockIndex::const_iterator i = std::lower_bound(index.begin(),
+							index.end(), Block(checksum.get(), 0));
+		for (; i != index.end() && i->first == checksum.get(); ++i) {
+			if (memcmp(baseData + i->second, targetData + pos, blockSize) == 0) {
+				matchOffset = i->second;
+				break;
+			}
+		}
+
+		if (matchOffset == base.size()) {
+			// no match, move on a byte
+			if (pos + blockSize < target.size()) {
+				checksum.roll(targetData[pos], targetData[pos + blockSize]);
+			}
+			++pos;
+			continue;
+		}
+
+		// grow the match backwards over the pending literal and forwards
+		// as far as the data agrees
+		size_t matchStart = pos;
+		while (matchOffset > 0 && matchStart > literalStart &&
+				baseData[matchOffset - 1] == targetData[matchStart - 1]) {
+			--matchOffset;
+			--matchStart;
+		}
+		size_t matchEnd = pos + blockSize;
+		size_t baseEnd  = matchOffset + (matchEnd - matchStart);
+		while (baseEnd < base.size() && matchEnd < target.size() &&
+				baseData[baseEnd] == targetData[matchEnd]) {
+			++baseEnd;
+			++matchEnd;
+		}
+
+		appendLiteral(delta, target, literalStart, matchStart);
+		appendCopy(delta, matchOffset, matchEnd - matchStart);
+		literalStart = matchEnd;
+		pos          = matchEnd;
+
+		if (pos + blockSize <= target.size()) {
+			checksum = RollingChecksum(targetData + pos, blockSize);
+		}
+	}
+	appendLiteral(delta, target, literalStart, target.size());
+
+	return delta;
+}
+
+bool
+ClipboardDelta::decode(const String& base, const String& delta, String& target)
+{
+	target.clear();
+
+	size_t pos = 0;
+	while (pos < delta.size()) {
+		char op = delta[pos++];
+		if (op == kOpCopy) {
+			UInt32 offset, length;
+			if (!readUInt32(delta, pos, offset) ||
+				!readUInt32(delta, pos, length) ||
+				offset > base.size() || length > base.size() - offset) {
+				return false;
+			}
+			target.append(base, offset, length);
+		}
+		else if (op == kOpLiteral) {
+			UInt32 length;
+			if (!readUInt32(delta, pos, length) ||
+				length > delta.size() - pos) {
+				return false;
+			}
+			target.append(delta, pos, length);
+			pos += length;
+		}
+		else {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+UInt32
+ClipboardDelta::hash(const String& data)
+{
+	UInt32 hash = kFnvOffset;
+	for (size_t i = 0; i < data.size(); ++i) {
+		hash ^= static_cast<UInt8>(data[i]);
+		hash *= kFnvPrime;
+	}
+
+	// zero means "no version"
+	return (hash == 0) ? 1 : hash;
+}
@@ -0,0 +1,56 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2013 Synergy Si Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/String.h"
+#include "common/basic_types.h"
+
+//! Binary delta encoding
+/*!
+Encodes data as a delta against an earlier version of it, so that only
+what changed needs to be sent.  The earlier version is cut into blocks
+which are found in the new data with a rolling checksum, as rsync does.
+A delta is a sequence of operations:  'C' followed by a 4 byte offset
+and a 4 byte length copies that range of the earlier version;  'L'
+followed by a 4 byte length and that many bytes inserts them.  Numbers
+are big endian.
+*/
+class ClipboardDelta {
+public:
+	//! Encode a delta
+	/*!
+	Returns the delta that turns \p base into \p target.
+	*/
+	static String		encode(const String& base, const String& target);
+
+	//! Decode a delta
+	/*!
+	Applies \p delta to \p base and stores the result in \p target.
+	Returns false if the delta is malformed or doesn't fit \p base.
+	*/
+	static bool			decode(const String& base, const String& delta,
+							String& target);
+
+	//! Hash data
+	/*!
+	Returns a 32 bit FNV-1a hash of \p data, used to check that both
+	sides hold the same version and that a delta was applied
+	correctly.  Never returns zero.
+	*/
+	static UInt32		hash(const String& data);
+};
@@ -0,0 +1,167 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2013 Synergy Si Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/ClipboardHistory.h"
+
+#include "synergy/ClipboardDelta.h"
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+#include "base/MemoryBudget.h"
+#include "base/Log.h"
+
+// smaller clipboards aren't worth a delta
+static const size_t kMinDeltaSize = 4096;
+
+// a delta must be smaller than the data divided by this
+static const size_t kMinDeltaSaving = 2;
+
+//
+// ClipboardHistory
+//
+
+ClipboardHistory::ClipboardHistory() :
+	m_mutex(new Mutex)
+{
+	// do nothing
+}
+
+ClipboardHistory::~ClipboardHistory()
+{
+	for (ClipboardID id = 0; id < kClipboardEnd; ++id) {
+		forget(m_acknowledged[id]);
+		forget(m_pending[id]);
+		forget(m_received[id]);
+	}
+	delete m_mutex;
+}
+
+bool
+ClipboardHistory::prepareSend(ClipboardID id, const String& data,
+				String& delta, UInt32& baseHash, UInt32& targetHash)
+{
+	targetHash = ClipboardDelta::hash(data);
+
+	// the peer holds the acknowledged version only if nothing was sent
+	// since.  copy it so the delta can be made without the lock.
+	String base;
+	{
+		Lock lock(m_mutex);
+		if (m_pending[id].m_hash == 0 && m_acknowledged[id].m_hash != 0 &&
+			data.size() >= kMinDeltaSize) {
+			base     = m_acknowledged[id].m_data;
+			baseHash = m_acknowledged[id].m_hash;
+		}
+
+		if (!keep(m_pending[id], data, targetHash)) {
+			// can't use anything as a base until there's memory for it
+			forget(m_acknowledged[id]);
+		}
+	}
+
+	if (base.empty()) {
+		return false;
+	}
+
+	delta = ClipboardDelta::encode(base, data);
+	if (delta.size() * kMinDeltaSaving >= data.size()) {
+		LOG((CLOG_DEBUG1 "clipboard %d delta too large, size=%d delta=%d", id, data.size(), delta.size()));
+		return false;
+	}
+
+	LOG((CLOG_DEBUG1 "clipboard %d sent as delta, size=%d delta=%d", id, data.size(), delta.size()));
+	return true;
+}
+
+bool
+ClipboardHistory::acknowledged(ClipboardID id, UInt32 hash)
+{
+	Lock lock(m_mutex);
+
+	if (hash == 0) {
+		LOG((CLOG_DEBUG "clipboard %d delta rejected by peer", id));
+		forget(m_acknowledged[id]);
+		forget(m_pending[id]);
+		return false;
+	}
+
+	// acknowledgements of versions sent before the last are ignored.
+	// the peer may not hold them anymore.
+	if (hash == m_pending[id].m_hash) {
+		forget(m_acknowledged[id]);
+		m_acknowledged[id].m_data.swap(m_pending[id].m_data);
+		m_acknowledged[id].m_hash = m_pending[id].m_hash;
+		m_pending[id].m_hash = 0;
+	}
+	return true;
+}
+
+UInt32
+ClipboardHistory::receivedFull(ClipboardID id, const String& data)
+{
+	UInt32 hash = ClipboardDelta::hash(data);
+
+	Lock lock(m_mutex);
+	keep(m_received[id], data, hash);
+	return hash;
+}
+
+UInt32
+ClipboardHistory::receivedDelta(ClipboardID id, String& data,
+				UInt32 baseHash, UInt32 targetHash)
+{
+	Lock lock(m_mutex);
+
+	Version& base = m_received[id];
+	if (base.m_hash == 0 || base.m_hash != baseHash) {
+		LOG((CLOG_WARN "clipboard %d delta against unknown version", id));
+		return 0;
+	}
+
+	String target;
+	if (!ClipboardDelta::decode(base.m_data, data, target) ||
+		ClipboardDelta::hash(target) != targetHash) {
+		LOG((CLOG_WARN "clipboard %d delta is corrupt", id));
+		return 0;
+	}
+
+	data.swap(target);
+	keep(base, data, targetHash);
+	return targetHash;
+}
+
+bool
+ClipboardHistory::keep(Version& version, const String& data, UInt32 hash)
+{
+	forget(version);
+	if (!MemoryBudget::reserve(MemoryBudget::kClipboards, data.size())) {
+		return false;
+	}
+
+	version.m_data = data;
+	version.m_hash = hash;
+	return true;
+}
+
+void
+ClipboardHistory::forget(Version& version)
+{
+	if (version.m_hash != 0) {
+		MemoryBudget::release(MemoryBudget::kClipboards, version.m_data.size());
+	}
+	String().swap(version.m_data);
+	version.m_hash = 0;
+}
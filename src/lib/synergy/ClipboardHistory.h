@@ -0,0 +1,98 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2013 Synergy Si Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "synergy/clipboard_types.h"
+#include "base/String.h"
+#include "common/basic_types.h"
+
+class Mutex;
+
+//! Clipboard versions shared with a peer
+/*!
+Remembers, per clipboard, the last version sent to a peer that the
+peer acknowledged and the last version received from it, so that
+updates can be sent as a ClipboardDelta against them.  A delta is only
+used when every version sent has been acknowledged;  then the peer is
+known to hold the base.  The versions are charged to the memory budget
+and not kept when it's exhausted.  There's one history per connection.
+Thread safe.
+*/
+class ClipboardHistory {
+public:
+	ClipboardHistory();
+	~ClipboardHistory();
+
+	//! @name manipulators
+	//@{
+
+	//! Prepare a clipboard for sending
+	/*!
+	Returns true and fills in \p delta and \p baseHash if \p data is
+	better sent as a delta.  \p targetHash is always set to the hash
+	of \p data.  \p data is remembered as awaiting acknowledgement.
+	*/
+	bool				prepareSend(ClipboardID id, const String& data,
+							String& delta, UInt32& baseHash,
+							UInt32& targetHash);
+
+	//! Note an acknowledgement from the peer
+	/*!
+	\p hash is the hash of the version the peer now holds.  Zero means
+	the peer couldn't apply a delta, in which case nothing is used as
+	a base until the next acknowledgement and false is returned;  the
+	clipboard should be sent again in full.
+	*/
+	bool				acknowledged(ClipboardID id, UInt32 hash);
+
+	//! Note a clipboard received in full
+	/*!
+	Returns the hash to acknowledge it with.
+	*/
+	UInt32				receivedFull(ClipboardID id, const String& data);
+
+	//! Rebuild a clipboard received as a delta
+	/*!
+	Applies the delta in \p data to the last version received and
+	replaces \p data with the result.  Returns the hash to acknowledge
+	it with, or zero if the base isn't the one with \p baseHash or the
+	result doesn't match \p targetHash.
+	*/
+	UInt32				receivedDelta(ClipboardID id, String& data,
+							UInt32 baseHash, UInt32 targetHash);
+
+	//@}
+
+private:
+	class Version {
+	public:
+		Version() : m_hash(0) { }
+
+		String			m_data;
+		UInt32			m_hash;
+	};
+
+	bool				keep(Version&, const String& data, UInt32 hash);
+	void				forget(Version&);
+
+private:
+	Mutex*				m_mutex;
+	Version				m_acknowledged[kClipboardEnd];
+	Version				m_pending[kClipboardEnd];
+	Version				m_received[kClipboardEnd];
+};
@@ -70,7 +70,7 @@ DragInformation::parseDragInfo(DragFileList& dragFileList, UInt32 fileNum, Strin
 			size_t size = stringToNum(filesize);
 			dragFileList.at(index).setFilesize(size);
 		}
-		startPos = findResult1 + 1;
+		startPos = findResult2 + 1;
 		
 		++index;
 	}
@@ -112,6 +112,29 @@ DragInformation::setupDragInfo(DragFileList& fileList, String& output)
 	return size;
 }
 
+int
+DragInformation::parseDraggingFiles(DragFileList& fileList, const String& files)
+{
+	fileList.clear();
+
+	size_t startPos = 0;
+	while (startPos < files.size()) {
+		size_t endPos = files.find('\n', startPos);
+		if (endPos == string::npos) {
+			endPos = files.size();
+		}
+
+		if (endPos > startPos) {
+			String filename = files.substr(startPos, endPos - startPos);
+			DragInformation di;
+			di.setFilename(filename);
+			fileList.push_back(di);
+		}
+		startPos = endPos + 1;
+	}
+	return static_cast<int>(fileList.size());
+}
+
 bool
 DragInformation::isFileValid(String filename)
 {
@@ -30,6 +30,7 @@ public:
 	~DragInformation() { }
 	
 	String&			getFilename() { return m_filename; }
+	const String&		getFilename() const { return m_filename; }
 	void				setFilename(String& name) { m_filename = name; }
 	size_t				getFilesize() { return m_filesize; }
 	void				setFilesize(size_t size) { m_filesize = size; }
@@ -41,6 +42,12 @@ public:
 	// return file count
 	static int			setupDragInfo(DragFileList& fileList, String& output);
 
+	// helper function to split the files a screen reports as dragged,
+	// one path per line, into a file list
+	// return file count
+	static int			parseDraggingFiles(DragFileList& fileList,
+							const String& files);
+
 	static bool			isFileValid(String filename);
 
 private:
@@ -22,11 +22,12 @@
 #include <fstream>
 
 void
-DropHelper::writeToDir(const String& destination, DragFileList& fileList, String& data)
+DropHelper::writeToDir(const String& destination, const String& filename,
+				const String& data)
 {
-	LOG((CLOG_DEBUG "dropping file, files=%i target=%s", fileList.size(), destination.c_str()));
+	LOG((CLOG_DEBUG "dropping file, file=%s target=%s", filename.c_str(), destination.c_str()));
 
-	if (!destination.empty() && fileList.size() > 0) {
+	if (!destination.empty() && !filename.empty()) {
 		std::fstream file;
 		String dropTarget = destination;
 #ifdef SYSAPI_WIN32
@@ -34,7 +35,7 @@ DropHelper::writeToDir(const String& destination, DragFileList& fileList, String
 #else
 		dropTarget.append("/");
 #endif
-		dropTarget.append(fileList.at(0).getFilename());
+		dropTarget.append(filename);
 		file.open(dropTarget.c_str(), std::ios::out | std::ios::binary);
 		if (!file.is_open()) {
 			LOG((CLOG_ERR "drop file failed: can not open %s", dropTarget.c_str()));
@@ -43,9 +44,7 @@ DropHelper::writeToDir(const String& destination, DragFileList& fileList, String
 		file.write(data.c_str(), data.size());
 		file.close();
 
-		LOG((CLOG_DEBUG "%s is saved to %s", fileList.at(0).getFilename().c_str(), destination.c_str()));
-
-		fileList.clear();
+		LOG((CLOG_DEBUG "%s is saved to %s", filename.c_str(), destination.c_str()));
 	}
 	else {
 		LOG((CLOG_ERR "drop file failed: drop target is empty"));
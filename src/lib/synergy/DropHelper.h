@@ -20,8 +20,18 @@
 #include "synergy/DragInformation.h"
 #include "base/String.h"
 
+//! A received file waiting to be written to the drop target
+class DroppedFile {
+public:
+	DroppedFile(const String& filename) : m_filename(filename) { }
+
+public:
+	String				m_filename;
+	String				m_data;
+};
+
 class DropHelper {
 public:
 	static void			writeToDir(const String& destination,
-							DragFileList& fileList, String& data);
+							const String& filename, const String& data);
 };
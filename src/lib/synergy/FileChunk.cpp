@@ -18,19 +18,138 @@
 #include "synergy/FileChunk.h"
 
 #include "synergy/ProtocolUtil.h"
+#include "synergy/StreamChunker.h"
 #include "synergy/protocol_types.h"
 #include "io/IStream.h"
+#include "io/IFileSender.h"
+#include "base/IJob.h"
 #include "base/Stopwatch.h"
 #include "base/Log.h"
 
+#include <cstring>
+#include <vector>
+#if HAVE_SYS_SENDFILE_H
+#	include <unistd.h>
+#endif
+
 static const UInt16 kIntervalThreshold = 1;
 
+// largest prime below 2^16 and the most bytes that can be summed before
+// the Adler-32 sums have to be reduced
+static const UInt32 kAdlerBase = 65521;
+static const size_t kAdlerMaxRun = 5552;
+
+//
+// FileRangeJob
+//
+
+// tells the file sender a range is done with
+class FileRangeJob : public IJob {
+public:
+	FileRangeJob(size_t size) : m_size(size) { }
+
+	// IJob overrides
+	virtual void		run() { StreamChunker::fileRangeSent(m_size); }
+
+private:
+	size_t				m_size;
+};
+
+// stops the file sender when a stream finds a file ended early
+class FileTruncatedJob : public IJob {
+public:
+	// IJob overrides
+	virtual void		run()
+	{
+		LOG((CLOG_ERR "file was truncated while being sent"));
+		StreamChunker::interruptFile();
+	}
+};
+
+// splits \p content into exactly \p count non-empty comma separated fields
+static
+bool
+splitFields(const String& content, size_t count, std::vector<String>& fields)
+{
+	String::size_type start = 0;
+	while (fields.size() < count) {
+		String::size_type comma = content.find(',', start);
+		String field = content.substr(start, comma == String::npos ?
+							String::npos : comma - start);
+		if (field.empty()) {
+			return false;
+		}
+		fields.push_back(field);
+
+		if (comma == String::npos) {
+			break;
+		}
+		start = comma + 1;
+	}
+	return (fields.size() == count);
+}
+
+//
+// FileReceiveState
+//
+
+FileReceiveState::FileReceiveState() :
+	m_expectedSize(0),
+	m_fileIndex(0),
+	m_transferId(0),
+	m_checksum(FileChunk::kChecksumInit),
+	m_receiving(false),
+	m_inTransfer(false),
+	m_corrupted(false),
+	m_receivedDataSize(0),
+	m_elapsedTime(0.0)
+{
+	// do nothing
+}
+
+bool
+FileReceiveState::getResumePoint(FileTransferResume& resume) const
+{
+	if (!m_receiving || m_transferId == 0) {
+		return false;
+	}
+
+	resume.m_id = m_transferId;
+	resume.m_fileIndex = m_fileIndex;
+	resume.m_checksum = m_checksum;
+	resume.m_offset = m_data.size();
+	return true;
+}
+
+void
+FileReceiveState::abortTransfer()
+{
+	m_data.clear();
+	m_receiving = false;
+	m_transferId = 0;
+}
+
+
+//
+// FileChunk
+//
+
 FileChunk::FileChunk(size_t size) :
-	Chunk(size)
+	Chunk(size, MemoryBudget::kFileTransfers),
+	m_fd(-1)
 {
 		m_dataSize = size - FILE_CHUNK_META_SIZE;
 }
 
+FileChunk::~FileChunk()
+{
+#if HAVE_SYS_SENDFILE_H
+	if (m_fd != -1) {
+		::close(m_fd);
+	}
+#endif
+}
+
 FileChunk*
 FileChunk::start(const String& size)
 {
@@ -44,6 +163,20 @@ FileChunk::start(const String& size)
 	return start;
 }
 
+FileChunk*
+FileChunk::transferStart(UInt32 id, UInt32 index, size_t size, size_t offset)
+{
+	String header = synergy::string::sprintf("%u,%u,", id, index);
+	header.append(synergy::string::sizeTypeToString(size));
+	header.append(",");
+	header.append(synergy::string::sizeTypeToString(offset));
+
+	FileChunk* start = FileChunk::start(header);
+	start->m_chunk[0] = kDataTransferStart;
+
+	return start;
+}
+
 FileChunk*
 FileChunk::data(UInt8* data, size_t dataSize)
 {
@@ -56,6 +189,22 @@ FileChunk::data(UInt8* data, size_t dataSize)
 	return chunk;
 }
 
+FileChunk*
+FileChunk::checkedData(UInt8* data, size_t dataSize, UInt32 checksum)
+{
+	FileChunk* chunk = new FileChunk(dataSize + 4 + FILE_CHUNK_META_SIZE);
+	char* chunkData = chunk->m_chunk;
+	chunkData[0] = kDataCheckedChunk;
+	chunkData[1] = static_cast<char>((checksum >> 24) & 0xff);
+	chunkData[2] = static_cast<char>((checksum >> 16) & 0xff);
+	chunkData[3] = static_cast<char>((checksum >>  8) & 0xff);
+	chunkData[4] = static_cast<char>( checksum        & 0xff);
+	memcpy(&chunkData[5], data, dataSize);
+	chunkData[dataSize + 5] = '\0';
+
+	return chunk;
+}
+
 FileChunk*
 FileChunk::end()
 {
@@ -67,15 +216,40 @@ FileChunk::end()
 	return end;
 }
 
+FileChunk*
+FileChunk::abort()
+{
+	FileChunk* abort = new FileChunk(FILE_CHUNK_META_SIZE);
+	char* chunk = abort->m_chunk;
+	chunk[0] = kDataAbort;
+	chunk[1] = '\0';
+
+	return abort;
+}
+
+FileChunk*
+FileChunk::fileRange(int fd, size_t offset, size_t size)
+{
+	String range = synergy::string::sprintf("%d,", fd);
+	range.append(synergy::string::sizeTypeToString(offset));
+	range.append(",");
+	range.append(synergy::string::sizeTypeToString(size));
+
+	FileChunk* chunk = FileChunk::start(range);
+	chunk->m_chunk[0] = kDataFileRange;
+	chunk->m_fd = fd;
+
+	return chunk;
+}
+
 int
-FileChunk::assemble(synergy::IStream* stream, String& dataReceived, size_t& expectedSize)
+FileChunk::assemble(synergy::IStream* stream, FileReceiveState& state)
 {
 	// parse
 	UInt8 mark = 0;
 	String content;
-	static size_t receivedDataSize;
-	static double elapsedTime;
-	static Stopwatch stopwatch;
+	String& dataReceived = state.m_data;
+	size_t& expectedSize = state.m_expectedSize;
 
 	if (!ProtocolUtil::readf(stream, kMsgDFileTransfer + 4, &mark, &content)) {
 		return kError;
@@ -83,37 +257,157 @@ FileChunk::assemble(synergy::IStream* stream, String& dataReceived, size_t& expe
 
 	switch (mark) {
 	case kDataStart:
+	case kDataFileStart:
 		dataReceived.clear();
-		expectedSize = synergy::string::stringToSizeType(content);
-		receivedDataSize = 0;
-		elapsedTime = 0;
-		stopwatch.reset();
+		state.m_inTransfer = false;
+		if (mark == kDataStart) {
+			state.m_fileIndex = 0;
+			expectedSize = synergy::string::stringToSizeType(content);
+		}
+		else if (!parseFileStart(content, state.m_fileIndex, expectedSize)) {
+			LOG((CLOG_ERR "invalid file header: %s", content.c_str()));
+			return kError;
+		}
+		state.m_transferId = 0;
+		state.m_receiving = false;
+		state.m_corrupted = false;
+		state.m_receivedDataSize = 0;
+		state.m_elapsedTime = 0;
+		state.m_stopwatch.reset();
 
 		if (CLOG->getFilter() >= kDEBUG2) {
-			LOG((CLOG_DEBUG2 "recv file data from client: file size=%s", content.c_str()));
-			stopwatch.start();
+			LOG((CLOG_DEBUG2 "recv file data from client: file index=%u size=%s",
+				state.m_fileIndex,
+				synergy::string::sizeTypeToString(expectedSize).c_str()));
+			state.m_stopwatch.start();
 		}
 		return kStart;
 
+	case kDataTransferStart: {
+		UInt32 id = 0;
+		UInt32 index = 0;
+		size_t size = 0;
+		size_t offset = 0;
+		state.m_inTransfer = true;
+		if (!parseTransferStart(content, id, index, size, offset)) {
+			LOG((CLOG_ERR "invalid file header: %s", content.c_str()));
+			state.m_receiving = false;
+			return kError;
+		}
+
+		// refuse the file up front rather than run out of memory part
+		// way through.  the chunks that follow are dropped.
+		if (offset <= size && !MemoryBudget::isAvailable(size - offset)) {
+			LOG((CLOG_ERR "file of %s bytes is too large for the memory limit, dropping it",
+				synergy::string::sizeTypeToString(size).c_str()));
+			dataReceived.clear();
+			state.m_receiving = false;
+			state.m_transferId = 0;
+			return kError;
+		}
+
+		if (offset == 0) {
+			dataReceived.clear();
+			state.m_transferId = id;
+			state.m_fileIndex = index;
+			state.m_checksum = kChecksumInit;
+			expectedSize = size;
+		}
+		else if (id != state.m_transferId || index != state.m_fileIndex ||
+				size != expectedSize || offset != dataReceived.size()) {
+			LOG((CLOG_ERR "can't resume file transfer %u at offset %s", id,
+				synergy::string::sizeTypeToString(offset).c_str()));
+			state.m_receiving = false;
+			return kError;
+		}
+		else {
+			LOG((CLOG_INFO "resuming file transfer at %s of %s bytes",
+				synergy::string::sizeTypeToString(offset).c_str(),
+				synergy::string::sizeTypeToString(size).c_str()));
+		}
+
+		state.m_receiving = true;
+		state.m_corrupted = false;
+		state.m_receivedDataSize = 0;
+		state.m_elapsedTime = 0;
+		state.m_stopwatch.reset();
+
+		if (CLOG->getFilter() >= kDEBUG2) {
+			LOG((CLOG_DEBUG2 "recv file data from client: transfer=%u file index=%u size=%s",
+				id, index, synergy::string::sizeTypeToString(expectedSize).c_str()));
+			state.m_stopwatch.start();
+		}
+		return kStart;
+	}
+
+	case kDataCheckedChunk: {
+		// nothing to add to after a bad chunk or an aborted transfer.
+		// the end mark reports the error.
+		if (!state.m_receiving || state.m_corrupted) {
+			return kNotFinish;
+		}
+
+		bool valid = false;
+		if (content.size() >= 4) {
+			const UInt8* bytes = reinterpret_cast<const UInt8*>(content.data());
+			UInt32 checksum = (static_cast<UInt32>(bytes[0]) << 24) |
+								(static_cast<UInt32>(bytes[1]) << 16) |
+								(static_cast<UInt32>(bytes[2]) <<  8) |
+								 static_cast<UInt32>(bytes[3]);
+			UInt32 sum = updateChecksum(state.m_checksum, bytes + 4, content.size() - 4);
+			if (sum == checksum) {
+				state.m_checksum = sum;
+				valid = true;
+			}
+		}
+		if (!valid) {
+			// keep what was verified so far so the transfer can be resumed
+			LOG((CLOG_ERR "file chunk checksum mismatch at offset %s",
+				synergy::string::sizeTypeToString(dataReceived.size()).c_str()));
+			state.m_corrupted = true;
+			return kError;
+		}
+
+		dataReceived.append(content, 4, String::npos);
+		state.m_receivedDataSize += content.size() - 4;
+		return kNotFinish;
+	}
+
 	case kDataChunk:
+		// an unchecked chunk in a transfer is dropped like a checked
+		// one after an error and still counts towards the checksum the
+		// transfer is resumed from.
+		if (state.m_inTransfer) {
+			if (!state.m_receiving || state.m_corrupted) {
+				return kNotFinish;
+			}
+			state.m_checksum = updateChecksum(state.m_checksum,
+				reinterpret_cast<const UInt8*>(content.data()), content.size());
+		}
 		dataReceived.append(content);
 		if (CLOG->getFilter() >= kDEBUG2) {
 				LOG((CLOG_DEBUG2 "recv file data from client: chunck size=%i", content.size()));
-				double interval = stopwatch.getTime();
-				receivedDataSize += content.size();
+				double interval = state.m_stopwatch.getTime();
+				state.m_receivedDataSize += content.size();
 				LOG((CLOG_DEBUG2 "recv file data from client: interval=%f s", interval));
 				if (interval >= kIntervalThreshold) {
-					double averageSpeed = receivedDataSize / interval / 1000;
+					double averageSpeed = state.m_receivedDataSize / interval / 1000;
 					LOG((CLOG_DEBUG2 "recv file data from client: average speed=%f kb/s", averageSpeed));
 
-					receivedDataSize = 0;
-					elapsedTime += interval;
-					stopwatch.reset();
+					state.m_receivedDataSize = 0;
+					state.m_elapsedTime += interval;
+					state.m_stopwatch.reset();
 				}
 			}
 		return kNotFinish;
 
 	case kDataEnd:
+		if (state.m_corrupted) {
+			// the verified data is kept until the sender resumes
+			LOG((CLOG_DEBUG "file data incomplete, waiting for resume"));
+			return kNotFinish;
+		}
+		state.m_receiving = false;
 		if (expectedSize != dataReceived.size()) {
 			LOG((CLOG_ERR "corrupted clipboard data, expected size=%d actual size=%d", expectedSize, dataReceived.size()));
 			return kError;
@@ -121,13 +415,20 @@ FileChunk::assemble(synergy::IStream* stream, String& dataReceived, size_t& expe
 
 		if (CLOG->getFilter() >= kDEBUG2) {
 			LOG((CLOG_DEBUG2 "file data transfer finished"));
-			elapsedTime += stopwatch.getTime();
-			double averageSpeed = expectedSize / elapsedTime / 1000;
-			LOG((CLOG_DEBUG2 "file data transfer finished: total time consumed=%f s", elapsedTime));
+			state.m_elapsedTime += state.m_stopwatch.getTime();
+			double averageSpeed = expectedSize / state.m_elapsedTime / 1000;
+			LOG((CLOG_DEBUG2 "file data transfer finished: total time consumed=%f s", state.m_elapsedTime));
 			LOG((CLOG_DEBUG2 "file data transfer finished: total data received=%i kb", expectedSize / 1000));
 			LOG((CLOG_DEBUG2 "file data transfer finished: total average speed=%f kb/s", averageSpeed));
 		}
 		return kFinish;
+
+	case kDataAbort:
+		// zeros took the place of the part of the file that was cut
+		// short, so none of it can be kept or resumed
+		LOG((CLOG_ERR "file was cut short while being sent, dropping it"));
+		state.abortTransfer();
+		return kError;
 	}
 
 	return kError;
@@ -143,14 +444,168 @@ FileChunk::send(synergy::IStream* stream, UInt8 mark, char* data, size_t dataSiz
 		LOG((CLOG_DEBUG2 "sending file chunk start: size=%s", data));
 		break;
 
+	case kDataFileStart:
+		LOG((CLOG_DEBUG2 "sending file chunk start: index,size=%s", data));
+		break;
+
+	case kDataTransferStart:
+		LOG((CLOG_DEBUG2 "sending file chunk start: id,index,size,offset=%s", data));
+		break;
+
 	case kDataChunk:
+	case kDataCheckedChunk:
 		LOG((CLOG_DEBUG2 "sending file chunk: size=%i", chunk.size()));
 		break;
 
 	case kDataEnd:
 		LOG((CLOG_DEBUG2 "sending file finished"));
 		break;
+
+	case kDataAbort:
+		LOG((CLOG_DEBUG2 "sending file aborted"));
+		break;
 	}
 
 	ProtocolUtil::writef(stream, kMsgDFileTransfer, mark, &chunk);
 }
+
+void
+FileChunk::sendRange(synergy::IStream* stream, char* data, size_t dataSize)
+{
+	int fd = -1;
+	size_t offset = 0;
+	size_t size = 0;
+	if (!parseFileRange(String(data, dataSize), fd, offset, size)) {
+		LOG((CLOG_ERR "invalid file range"));
+		return;
+	}
+
+	LOG((CLOG_DEBUG2 "sending file chunk: size=%i", size));
+
+	// the message writef() makes for a kDataChunk, less the file data
+	UInt8 header[9];
+	memcpy(header, kMsgDFileTransfer, 4);
+	header[4] = kDataChunk;
+	header[5] = static_cast<UInt8>((size >> 24) & 0xff);
+	header[6] = static_cast<UInt8>((size >> 16) & 0xff);
+	header[7] = static_cast<UInt8>((size >>  8) & 0xff);
+	header[8] = static_cast<UInt8>( size        & 0xff);
+
+	synergy::IFileSender* sender = synergy::getFileSender(stream);
+	if (sender != NULL) {
+		IJob* done      = new FileRangeJob(size);
+		IJob* truncated = new FileTruncatedJob;
+		if (sender->writeFile(header, sizeof(header), fd, offset,
+							static_cast<UInt32>(size), done, truncated)) {
+			return;
+		}
+		delete truncated;
+		delete done;
+	}
+
+	// the stream can't send from the file, read it ourselves
+	String chunk(size, '\0');
+	if (readRange(fd, offset, size, &chunk[0])) {
+		ProtocolUtil::writef(stream, kMsgDFileTransfer, kDataChunk, &chunk);
+	}
+	else {
+		// the file sender aborts the file
+		LOG((CLOG_ERR "failed to read file"));
+		StreamChunker::interruptFile();
+	}
+	StreamChunker::fileRangeSent(size);
+}
+
+void
+FileChunk::discardRange(char* data, size_t dataSize)
+{
+	int fd = -1;
+	size_t offset = 0;
+	size_t size = 0;
+	if (parseFileRange(String(data, dataSize), fd, offset, size)) {
+		StreamChunker::fileRangeSent(size);
+	}
+}
+
+bool
+FileChunk::parseFileStart(const String& content, UInt32& index, size_t& size)
+{
+	String::size_type comma = content.find(',');
+	if (comma == String::npos || comma == 0 || comma + 1 == content.size()) {
+		return false;
+	}
+
+	index = static_cast<UInt32>(
+				synergy::string::stringToSizeType(content.substr(0, comma)));
+	size  = synergy::string::stringToSizeType(content.substr(comma + 1));
+	return true;
+}
+
+bool
+FileChunk::parseTransferStart(const String& content, UInt32& id,
+				UInt32& index, size_t& size, size_t& offset)
+{
+	std::vector<String> fields;
+	if (!splitFields(content, 4, fields)) {
+		return false;
+	}
+
+	id     = static_cast<UInt32>(synergy::string::stringToSizeType(fields[0]));
+	index  = static_cast<UInt32>(synergy::string::stringToSizeType(fields[1]));
+	size   = synergy::string::stringToSizeType(fields[2]);
+	offset = synergy::string::stringToSizeType(fields[3]);
+	return (offset <= size);
+}
+
+bool
+FileChunk::parseFileRange(const String& content, int& fd,
+				size_t& offset, size_t& size)
+{
+	std::vector<String> fields;
+	if (!splitFields(content, 3, fields)) {
+		return false;
+	}
+
+	fd     = static_cast<int>(synergy::string::stringToSizeType(fields[0]));
+	offset = synergy::string::stringToSizeType(fields[1]);
+	size   = synergy::string::stringToSizeType(fields[2]);
+	return true;
+}
+
+bool
+FileChunk::readRange(int fd, size_t offset, size_t size, char* data)
+{
+#if HAVE_SYS_SENDFILE_H
+	size_t done = 0;
+	while (done < size) {
+		ssize_t n = ::pread(fd, data + done, size - done, offset + done);
+		if (n <= 0) {
+			return false;
+		}
+		done += n;
+	}
+	return true;
+#else
+	return false;
+#endif
+}
+
+UInt32
+FileChunk::updateChecksum(UInt32 checksum, const UInt8* data, size_t size)
+{
+	UInt32 a = checksum & 0xffff;
+	UInt32 b = (checksum >> 16) & 0xffff;
+
+	while (size > 0) {
+		size_t run = (size < kAdlerMaxRun) ? size : kAdlerMaxRun;
+		size -= run;
+		while (run-- > 0) {
+			a += *data++;
+			b += a;
+		}
+		a %= kAdlerBase;
+		b %= kAdlerBase;
+	}
+
+	return (b << 16) | a;
+}
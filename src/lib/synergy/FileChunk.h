@@ -18,6 +18,8 @@
 #pragma once
 
 #include "synergy/Chunk.h"
+#include "base/Event.h"
+#include "base/Stopwatch.h"
 #include "base/String.h"
 #include "common/basic_types.h"
 
@@ -27,20 +29,182 @@ namespace synergy {
 class IStream;
 };
 
+class FileTransferResume;
+
+//! File being received
+/*!
+What FileChunk::assemble() knows about the file coming in from one peer.
+Each peer needs its own, and it must outlive the connection for an
+unfinished transfer to be resumed when the peer comes back.
+*/
+class FileReceiveState {
+public:
+	FileReceiveState();
+
+	//! Get the point an unfinished transfer can be resumed from
+	/*!
+	Returns true if a checksummed transfer was cut off before its end
+	and fills in \p resume with its id, the file index, the checksum
+	of the data received so far and the size of that data.
+	*/
+	bool				getResumePoint(FileTransferResume& resume) const;
+
+	//! Forget the transfer being received and its data
+	void				abortTransfer();
+
+	//! Index of the file being received (0 unless in a session)
+	UInt32				getFileIndex() const { return m_fileIndex; }
+
+	//! Data of the file received so far
+	String&				getData() { return m_data; }
+
+	//! Size the file being received is expected to have
+	size_t				getExpectedSize() const { return m_expectedSize; }
+
+private:
+	friend class FileChunk;
+
+	String				m_data;
+	size_t				m_expectedSize;
+	UInt32				m_fileIndex;
+	UInt32				m_transferId;
+	UInt32				m_checksum;
+	bool				m_receiving;
+	bool				m_inTransfer;
+	bool				m_corrupted;
+
+	// receive rate, only measured when debugging
+	size_t				m_receivedDataSize;
+	double				m_elapsedTime;
+	Stopwatch			m_stopwatch;
+};
+
+//! File received in full
+/*!
+Event data for FileEvents::fileRecieveCompleted.
+*/
+class FileReceived : public EventData {
+public:
+	FileReceived() : m_fileIndex(0) { }
+
+	UInt32				m_fileIndex;
+	String				m_data;
+};
+
 class FileChunk : public Chunk {
 public:
 	FileChunk(size_t size);
+	virtual ~FileChunk();
 
 	static FileChunk*	start(const String& size);
+	static FileChunk*	transferStart(
+							UInt32 id,
+							UInt32 index,
+							size_t size,
+							size_t offset);
 	static FileChunk*	data(UInt8* data, size_t dataSize);
+	static FileChunk*	checkedData(
+							UInt8* data,
+							size_t dataSize,
+							UInt32 checksum);
 	static FileChunk*	end();
+
+	//! Make a kDataAbort chunk
+	/*!
+	Sent in place of end() when the file was cut short while it was
+	being sent, so the receiver drops what it got.
+	*/
+	static FileChunk*	abort();
+
+	//! Make a kDataFileRange chunk
+	/*!
+	The chunk stands for \p size bytes of the file open on \p fd from
+	\p offset and takes ownership of \p fd.  Send it with sendRange().
+	*/
+	static FileChunk*	fileRange(
+							int fd,
+							size_t offset,
+							size_t size);
+
+	//! Read a file transfer message
+	/*!
+	Adds the message read from \p stream to the file in \p state and
+	returns kStart, kNotFinish, kFinish or kError.
+	*/
 	static int			assemble(
 							synergy::IStream* stream,
-							String& dataCached,
-							size_t& expectedSize);
+							FileReceiveState& state);
 	static void			send(
 							synergy::IStream* stream,
 							UInt8 mark,
 							char* data,
 							size_t dataSize);
+
+	//! Send the content of a kDataFileRange chunk
+	/*!
+	Sends the file range as a plain kDataChunk, straight from the file
+	if \p stream can do that.  The sender never reads the range so it
+	has no checksum; the receiver keeps its own, which a resume is
+	checked against.  StreamChunker::fileRangeSent() is called once
+	the stream is done with the range, and StreamChunker::interruptFile()
+	if the file turns out to be shorter.
+	*/
+	static void			sendRange(
+							synergy::IStream* stream,
+							char* data,
+							size_t dataSize);
+
+	//! Drop the content of a kDataFileRange chunk
+	/*!
+	Calls StreamChunker::fileRangeSent() without sending the range.
+	*/
+	static void			discardRange(char* data, size_t dataSize);
+
+	//! Parse the content of a kDataFileStart chunk
+	static bool			parseFileStart(
+							const String& content,
+							UInt32& index,
+							size_t& size);
+
+	//! Parse the content of a kDataTransferStart chunk
+	static bool			parseTransferStart(
+							const String& content,
+							UInt32& id,
+							UInt32& index,
+							size_t& size,
+							size_t& offset);
+
+	//! Parse the content of a kDataFileRange chunk
+	static bool			parseFileRange(
+							const String& content,
+							int& fd,
+							size_t& offset,
+							size_t& size);
+
+	//! Read part of a file
+	/*!
+	Reads \p size bytes at \p offset of the file open on \p fd into
+	\p data.  Returns false if the file is shorter or can't be read.
+	Only supported where files are sent as ranges.
+	*/
+	static bool			readRange(
+							int fd,
+							size_t offset,
+							size_t size,
+							char* data);
+
+	//! Update a rolling Adler-32 checksum
+	/*!
+	Returns \p checksum updated with \p size bytes at \p data.  Start
+	from kChecksumInit.
+	*/
+	static UInt32		updateChecksum(
+							UInt32 checksum,
+							const UInt8* data,
+							size_t size);
+
+	static const UInt32	kChecksumInit = 1;
+
+private:
+	int					m_fd;
 };
@@ -33,6 +33,7 @@ KeyMap::ModifierToNameMap*		KeyMap::s_modifierToNameMap = NULL;
 
 KeyMap::KeyMap() :
 	m_numGroups(0),
+	m_modifierItemsStale(true),
 	m_composeAcrossGroups(false)
 {
 	m_modifierKeyItem.m_id        = kKeyNone;
@@ -56,6 +57,7 @@ KeyMap::swap(KeyMap& x)
 {
 	m_keyIDMap.swap(x.m_keyIDMap);
 	m_modifierKeys.swap(x.m_modifierKeys);
+	m_modifierItems.swap(x.m_modifierItems);
 	m_halfDuplex.swap(x.m_halfDuplex);
 	m_halfDuplexMods.swap(x.m_halfDuplexMods);
 	SInt32 tmp1   = m_numGroups;
@@ -64,6 +66,9 @@ KeyMap::swap(KeyMap& x)
 	bool tmp2               = m_composeAcrossGroups;
 	m_composeAcrossGroups   = x.m_composeAcrossGroups;
 	x.m_composeAcrossGroups = tmp2;
+	bool tmp3               = m_modifierItemsStale;
+	m_modifierItemsStale    = x.m_modifierItemsStale;
+	x.m_modifierItemsStale  = tmp3;
 }
 
 void
@@ -105,6 +110,7 @@ KeyMap::addKeyEntry(const KeyItem& item)
 
 	// add item list
 	entries.push_back(items);
+	m_modifierItemsStale = true;
 	LOG((CLOG_DEBUG5 "add key: %04x %d %03x %04x (%04x %04x %04x)%s", newItem.m_id, newItem.m_group, newItem.m_button, newItem.m_client, newItem.m_required, newItem.m_sensitive, newItem.m_generates, newItem.m_dead ? " dead" : ""));
 }
 
@@ -196,6 +202,7 @@ KeyMap::addKeyCombinationEntry(KeyID id, SInt32 group,
 
 	// add key
 	groupTable[group].push_back(items);
+	m_modifierItemsStale = true;
 	return true;
 }
 
@@ -241,6 +248,9 @@ KeyMap::finish()
 void
 KeyMap::foreachKey(ForeachKeyCallback cb, void* userData)
 {
+	// the callback may change the items
+	m_modifierItemsStale = true;
+
 	for (KeyIDMap::iterator i = m_keyIDMap.begin();
 								i != m_keyIDMap.end(); ++i) {
 		KeyGroupTable& groupTable = i->second;
@@ -331,6 +341,25 @@ KeyMap::mapKey(Keystrokes& keys, KeyID id, SInt32 group,
 	return item;
 }
 
+void
+KeyMap::collectActiveModifiers(SInt32 group, KeyModifierMask mask,
+				ModifierToKeys& activeModifiers) const
+{
+	if (m_modifierItemsStale) {
+		setModifierItems();
+	}
+	if (group < 0 || static_cast<size_t>(group) >= m_modifierItems.size()) {
+		return;
+	}
+
+	const KeyItemList& items = m_modifierItems[group];
+	for (KeyItemList::const_iterator i = items.begin(); i != items.end(); ++i) {
+		if ((i->m_generates & mask) != 0) {
+			activeModifiers.insert(std::make_pair(i->m_generates, *i));
+		}
+	}
+}
+
 SInt32
 KeyMap::getNumGroups() const
 {
@@ -505,6 +534,31 @@ KeyMap::setModifierKeys()
 	}
 }
 
+void
+KeyMap::setModifierItems() const
+{
+	m_modifierItems.clear();
+	for (KeyIDMap::const_iterator i = m_keyIDMap.begin();
+								i != m_keyIDMap.end(); ++i) {
+		const KeyGroupTable& groupTable = i->second;
+		if (m_modifierItems.size() < groupTable.size()) {
+			m_modifierItems.resize(groupTable.size());
+		}
+		for (size_t g = 0; g < groupTable.size(); ++g) {
+			const KeyEntryList& entries = groupTable[g];
+			for (size_t j = 0; j < entries.size(); ++j) {
+				const KeyItemList& items = entries[j];
+				for (size_t k = 0; k < items.size(); ++k) {
+					if (items[k].m_generates != 0) {
+						m_modifierItems[g].push_back(items[k]);
+					}
+				}
+			}
+		}
+	}
+	m_modifierItemsStale = false;
+}
+
 const KeyMap::KeyItem*
 KeyMap::mapCommandKey(Keystrokes& keys, KeyID id, SInt32 group,
 				ModifierToKeys& activeModifiers,
@@ -222,6 +222,17 @@ public:
 							KeyModifierMask desiredMask,
 							bool isAutoRepeat) const;
 
+	//! Collect keys for active modifiers
+	/*!
+	Adds every key in group \p group that generates a modifier in \p mask
+	to \p activeModifiers.  This looks through an index of the modifier
+	keys rather than every key, so it's cheap enough to call whenever the
+	modifier state is polled.
+	*/
+	virtual void		collectActiveModifiers(SInt32 group,
+							KeyModifierMask mask,
+							ModifierToKeys& activeModifiers) const;
+
 	//! Get number of groups
 	/*!
 	Returns the number of keyboard groups (independent layouts) in the map.
@@ -344,6 +355,9 @@ private:
 	// computes the map of modifiers to the keys that generate the modifiers
 	void				setModifierKeys();
 
+	// computes the keys that generate any modifier in each group
+	void				setModifierItems() const;
+
 	// maps a command key.  a command key is a keyboard shortcut and we're
 	// trying to synthesize a button press with an exact sets of modifiers,
 	// not trying to synthesize a character.  so we just need to find the
@@ -475,6 +489,11 @@ private:
 	SInt32				m_numGroups;
 	ModifierToKeyTable	m_modifierKeys;
 
+	// the keys that generate a modifier, by group.  this is rebuilt on
+	// first use after the map changes.
+	mutable std::vector<KeyItemList>	m_modifierItems;
+	mutable bool		m_modifierItemsStale;
+
 	// composition info
 	bool				m_composeAcrossGroups;
 
@@ -512,26 +512,12 @@ KeyState::updateKeyState()
 	m_mask = pollActiveModifiers();
 
 	// set active modifiers
-	AddActiveModifierContext addModifierContext(pollActiveGroup(), m_mask,
-												m_activeModifiers);
-	m_keyMap.foreachKey(&KeyState::addActiveModifierCB, &addModifierContext);
+	m_keyMap.collectActiveModifiers(pollActiveGroup(), m_mask,
+								m_activeModifiers);
 
 	LOG((CLOG_DEBUG1 "modifiers on update: 0x%04x", m_mask));
 }
 
-void
-KeyState::addActiveModifierCB(KeyID, SInt32 group,
-				synergy::KeyMap::KeyItem& keyItem, void* vcontext)
-{
-	AddActiveModifierContext* context =
-		reinterpret_cast<AddActiveModifierContext*>(vcontext);
-	if (group == context->m_activeGroup &&
-		(keyItem.m_generates & context->m_mask) != 0) {
-		context->m_activeModifiers.insert(std::make_pair(
-								keyItem.m_generates, keyItem));
-	}	
-}
-
 void
 KeyState::setHalfDuplexMask(KeyModifierMask mask)
 {
@@ -902,17 +888,3 @@ KeyState::updateModifierKeyState(KeyButton button,
 		}
 	}
 }
-
-//
-// KeyState::AddActiveModifierContext
-//
-
-KeyState::AddActiveModifierContext::AddActiveModifierContext(
-				SInt32 group, KeyModifierMask mask,
-				ModifierToKeys&	activeModifiers) :
-	m_activeGroup(group),
-	m_mask(mask),
-	m_activeModifiers(activeModifiers)
-{
-	// do nothing
-}
@@ -138,24 +138,7 @@ protected:
 private:
 	typedef synergy::KeyMap::Keystrokes Keystrokes;
 	typedef synergy::KeyMap::ModifierToKeys ModifierToKeys;
-public:
-	struct AddActiveModifierContext {
-	public:
-		AddActiveModifierContext(SInt32 group, KeyModifierMask mask,
-							ModifierToKeys&	activeModifiers);
 
-	public:
-		SInt32			m_activeGroup;
-		KeyModifierMask	m_mask;
-		ModifierToKeys&	m_activeModifiers;
-
-	private:
-		// not implemented
-		AddActiveModifierContext(const AddActiveModifierContext&);
-		AddActiveModifierContext& operator=(const AddActiveModifierContext&);
-	};
-private:
-	
 	class ButtonToKeyLess {
 	public:
 		bool operator()(const synergy::KeyMap::ButtonToKeyMap::value_type& a,
@@ -191,10 +174,6 @@ private:
 							const ModifierToKeys& oldModifiers,
 							const ModifierToKeys& newModifiers);
 
-	// active modifiers collection callback
-	static void			addActiveModifierCB(KeyID id, SInt32 group,
-							synergy::KeyMap::KeyItem& keyItem, void* vcontext);
-
 private:
 	// must be declared before m_keyMap. used when this class owns the key map.
 	synergy::KeyMap*			m_keyMapPtr;
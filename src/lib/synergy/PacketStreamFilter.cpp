@@ -23,6 +23,7 @@
 
 #include <cstring>
 #include <memory>
+#include <vector>
 
 //
 // PacketStreamFilter
@@ -82,7 +83,7 @@ PacketStreamFilter::read(void* buffer, UInt32 n)
 	readPacketSize();
 
 	if (m_inputShutdown && m_size == 0) {
-		m_events->addEvent(Event(m_events->forIStream().inputShutdown(),
+		m_events->addEvent(Event(kIStreamInputShutdown,
 						getEventTarget(), NULL));
 	}
 
@@ -104,6 +105,31 @@ PacketStreamFilter::write(const void* buffer, UInt32 count)
 	getStream()->write(buffer, count);
 }
 
+bool
+PacketStreamFilter::writeFile(const void* header, UInt32 headerSize,
+				int fd, size_t offset, UInt32 size,
+				IJob* done, IJob* truncated)
+{
+	synergy::IFileSender* sender = synergy::getFileSender(getStream());
+	if (sender == NULL) {
+		return false;
+	}
+
+	// the length of the payload goes in front of the header
+	UInt32 count = headerSize + size;
+	std::vector<UInt8> packet(4 + headerSize);
+	packet[0] = (UInt8)((count >> 24) & 0xff);
+	packet[1] = (UInt8)((count >> 16) & 0xff);
+	packet[2] = (UInt8)((count >>  8) & 0xff);
+	packet[3] = (UInt8)( count        & 0xff);
+	if (headerSize > 0) {
+		memcpy(&packet[4], header, headerSize);
+	}
+
+	return sender->writeFile(&packet[0], (UInt32)packet.size(),
+							fd, offset, size, done, truncated);
+}
+
 void
 PacketStreamFilter::shutdownInput()
 {
@@ -178,13 +204,13 @@ PacketStreamFilter::readMore()
 void
 PacketStreamFilter::filterEvent(const Event& event)
 {
-	if (event.getType() == m_events->forIStream().inputReady()) {
+	if (event.getType() == kIStreamInputReady) {
 		Lock lock(&m_mutex);
 		if (!readMore()) {
 			return;
 		}
 	}
-	else if (event.getType() == m_events->forIStream().inputShutdown()) {
+	else if (event.getType() == kIStreamInputShutdown) {
 		// discard this if we have buffered data
 		Lock lock(&m_mutex);
 		m_inputShutdown = true;
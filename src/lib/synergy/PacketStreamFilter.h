@@ -41,6 +41,11 @@ public:
 	virtual bool		isReady() const;
 	virtual UInt32		getSize() const;
 
+	// IFileSender overrides
+	virtual bool		writeFile(const void* header, UInt32 headerSize,
+							int fd, size_t offset, UInt32 size,
+							IJob* done, IJob* truncated);
+
 protected:
 	// StreamFilter overrides
 	virtual void		filterEvent(const Event&);
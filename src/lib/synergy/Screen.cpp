@@ -497,7 +497,8 @@ Screen::enablePrimary()
 	m_screen->openScreensaver(true);
 
 	// claim screen changed size
-	m_events->addEvent(Event(m_events->forIScreen().shapeChanged(), getEventTarget()));
+	m_events->addEvent(Event(m_events->forIScreen().shapeChanged(),
+							getEventTarget(), NULL, Event::kCollapse));
 }
 
 void
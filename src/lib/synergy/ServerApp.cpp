@@ -59,6 +59,22 @@
 #include <iostream>
 #include <stdio.h>
 #include <fstream>
+#include <sstream>
+
+// read a whole configuration file into text
+static
+bool
+readConfigFile(const String& pathname, String& text)
+{
+	std::ifstream configStream(pathname.c_str(), std::ios::binary);
+	if (!configStream.is_open()) {
+		return false;
+	}
+	std::ostringstream buffer;
+	buffer << configStream.rdbuf();
+	text = buffer.str();
+	return true;
+}
 
 //
 // ServerApp
@@ -170,7 +186,23 @@ void
 ServerApp::reloadConfig(const Event&, void*)
 {
 	LOG((CLOG_DEBUG "reload configuration"));
-	if (loadConfig(args().m_configFile)) {
+
+	// large generated configurations take a while to parse and apply,
+	// so don't bother if the file hasn't changed since we loaded it
+	const String& pathname = args().m_configFile;
+	String text;
+	if (!readConfigFile(pathname, text)) {
+		LOG((CLOG_DEBUG "cannot open configuration \"%s\"",
+			pathname.c_str()));
+		return;
+	}
+	if (text == m_configText) {
+		LOG((CLOG_NOTE "configuration is unchanged"));
+		return;
+	}
+
+	// parse the text we just compared rather than reading the file again
+	if (parseConfig(pathname, text)) {
 		if (m_server != NULL) {
 			m_server->setConfig(*args().m_config);
 		}
@@ -223,20 +255,29 @@ ServerApp::loadConfig()
 
 bool
 ServerApp::loadConfig(const String& pathname)
+{
+	// load configuration
+	LOG((CLOG_DEBUG "opening configuration \"%s\"", pathname.c_str()));
+	String text;
+	if (!readConfigFile(pathname, text)) {
+		// report failure to open configuration as a debug message
+		// since we try several paths and we expect some to be
+		// missing.
+		LOG((CLOG_DEBUG "cannot open configuration \"%s\"",
+			pathname.c_str()));
+		return false;
+	}
+	return parseConfig(pathname, text);
+}
+
+bool
+ServerApp::parseConfig(const String& pathname, String& text)
 {
 	try {
-		// load configuration
-		LOG((CLOG_DEBUG "opening configuration \"%s\"", pathname.c_str()));
-		std::ifstream configStream(pathname.c_str());
-		if (!configStream.is_open()) {
-			// report failure to open configuration as a debug message
-			// since we try several paths and we expect some to be
-			// missing.
-			LOG((CLOG_DEBUG "cannot open configuration \"%s\"",
-				pathname.c_str()));
-			return false;
-		}
+		// parse from memory rather than reading the file line by line
+		std::istringstream configStream(text);
 		configStream >> *args().m_config;
+		m_configText.swap(text);
 		LOG((CLOG_DEBUG "configuration read successfully"));
 		return true;
 	}
@@ -452,7 +493,9 @@ bool ServerApp::initServer()
 	try {
 		String name    = args().m_config->getCanonicalName(args().m_name);
 		serverScreen    = openServerScreen();
+		startupPhase("screen");
 		primaryClient   = openPrimaryClient(name, serverScreen);
+		startupPhase("primary client");
 		m_serverScreen  = serverScreen;
 		m_primaryClient = primaryClient;
 		m_serverState   = kInitialized;
@@ -541,13 +584,16 @@ ServerApp::startServer()
 	ClientListener* listener = NULL;
 	try {
 		listener   = openClientListener(args().m_config->getSynergyAddress());
+		startupPhase("listener");
 		m_server   = openServer(*args().m_config, m_primaryClient);
+		startupPhase("server");
 		listener->setServer(m_server);
 		m_server->setListener(listener);
 		m_listener = listener;
 		updateStatus();
 		LOG((CLOG_NOTE "started server, waiting for clients"));
 		m_serverState = kStarted;
+		startupComplete();
 		return true;
 	}
 	catch (XSocketAddressInUse& e) {
@@ -586,7 +632,8 @@ ServerApp::createScreen()
 		true, args().m_noHooks, args().m_stopOnDeskSwitch, m_events), m_events);
 #elif WINAPI_XWINDOWS
 	return new synergy::Screen(new XWindowsScreen(
-		args().m_display, true, args().m_disableXInitThreads, 0, m_events), m_events);
+		args().m_display, true, args().m_disableXInitThreads, 0, m_events,
+		NULL), m_events);
 #elif WINAPI_CARBON
 	return new synergy::Screen(new OSXScreen(m_events, true), m_events);
 #endif
@@ -707,10 +754,7 @@ ServerApp::mainLoop()
 		return kExitFailed;
 	}
 
-	// load all available plugins.
-	ARCH->plugin().load();
-	// pass log and arch into plugins.
-	ARCH->plugin().init(Log::getInstance(), Arch::getInstance());
+	loadPlugins();
 
 	// start server, etc
 	appUtil().startNode();
@@ -791,6 +835,7 @@ void ServerApp::resetServer(const Event&, void*)
 	LOG((CLOG_DEBUG1 "resetting server"));
 	stopServer();
 	cleanupServer();
+	startupBegin();
 	startServer();
 }
 
@@ -70,6 +70,7 @@ public:
 	void reloadConfig(const Event&, void*);
 	void loadConfig();
 	bool loadConfig(const String& pathname);
+	bool parseConfig(const String& pathname, String& text);
 	void forceReconnect(const Event&, void*);
 	void resetServer(const Event&, void*);
 	void handleClientConnected(const Event&, void* vlistener);
@@ -113,6 +114,9 @@ public:
 	EventQueueTimer*	m_timer;
 	NetworkAddress*		m_synergyAddress;
 
+	// the text of the configuration file we last loaded
+	String				m_configText;
+
 private:
 	void handleScreenSwitched(const Event&, void*  data);
 };
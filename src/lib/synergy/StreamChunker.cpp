@@ -19,17 +19,25 @@
 
 #include "synergy/FileChunk.h"
 #include "synergy/ClipboardChunk.h"
+#include "synergy/TokenBucket.h"
 #include "synergy/protocol_types.h"
 #include "base/EventTypes.h"
 #include "base/Event.h"
 #include "base/IEventQueue.h"
 #include "base/EventTypes.h"
 #include "base/Log.h"
+#include "base/MemoryBudget.h"
 #include "base/Stopwatch.h"
 #include "base/String.h"
+#include "arch/Arch.h"
 #include "common/stdexcept.h"
 
 #include <fstream>
+#include <ctime>
+#if HAVE_SYS_SENDFILE_H
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
 
 #define SEND_THRESHOLD 0.005f
 
@@ -38,12 +46,37 @@ using namespace std;
 #define SOCKET_CHUNK_SIZE 512 * 1024; // 512kb
 #define SECURE_SOCKET_CHUNK_SIZE 2 * 1024; // 2kb
 
+// how far (in bytes) reading files may run ahead of writing them to the
+// stream, how often progress is reported and how long to wait for the
+// stream to take more data before giving up on a transfer.
+static const size_t kFileSendWindow = 4 * 1024 * 1024;
+static const double kFileProgressInterval = 1.0;
+static const double kFileSendStallTimeout = 30.0;
+
+// longest sleep while waiting for bandwidth, so interrupts are noticed
+static const double kBandwidthPollInterval = 0.05;
+
+// how long to hold back chunks while the memory budget is exhausted
+static const double kMemoryStallTimeout = 10.0;
+
 size_t StreamChunker::s_chunkSize = SOCKET_CHUNK_SIZE;
 bool StreamChunker::s_isChunkingClipboard = false;
 bool StreamChunker::s_interruptClipboard = false;
 bool StreamChunker::s_isChunkingFile = false;
 bool StreamChunker::s_interruptFile = false;
+ArchMutex StreamChunker::s_fileWindowMutex = NULL;
+size_t StreamChunker::s_fileBytesQueued = 0;
+size_t StreamChunker::s_fileBytesSent = 0;
+UInt32 StreamChunker::s_transferCount = 0;
 
+void
+StreamChunker::init()
+{
+	// kept for the life of the process
+	if (s_fileWindowMutex == NULL) {
+		s_fileWindowMutex = ARCH->newMutex();
+	}
+}
 
 void
 StreamChunker::sendFile(
@@ -51,117 +84,386 @@ StreamChunker::sendFile(
 				IEventQueue* events,
 				void* eventTarget)
 {
-	s_isChunkingFile = true;
-	
-	std::fstream file(reinterpret_cast<char*>(filename), std::ios::in | std::ios::binary);
+	String name(filename);
+	DragInformation di;
+	di.setFilename(name);
+	DragFileList fileList;
+	fileList.push_back(di);
+
+	sendFiles(newSession(fileList), events, eventTarget, NULL, false);
+}
+
+FileTransferSession
+StreamChunker::newSession(const DragFileList& fileList)
+{
+	// tag the session with an id that is unlikely to match one a peer
+	// remembers from an earlier run.  that needs the wall clock, since
+	// the monotonic clock may start over.
+	FileTransferSession session;
+	session.m_id = static_cast<UInt32>(::time(NULL)) + (++s_transferCount);
+	if (session.m_id == 0) {
+		session.m_id = 1;
+	}
+	session.m_files = fileList;
+	return session;
+}
+
+void
+StreamChunker::sendFiles(
+				const FileTransferSession& session,
+				IEventQueue* events,
+				void* eventTarget,
+				TokenBucket* bandwidth,
+				bool sendFromFile)
+{
+	sendFilesFrom(session, 0, 0, FileChunk::kChecksumInit,
+		events, eventTarget, bandwidth, sendFromFile);
+}
+
+void
+StreamChunker::resumeFiles(
+				const FileTransferSession& session,
+				IEventQueue* events,
+				void* eventTarget,
+				TokenBucket* bandwidth,
+				bool sendFromFile)
+{
+	const FileTransferResume& resume = session.m_resume;
+	if (session.m_id == 0 || resume.m_id != session.m_id ||
+		resume.m_fileIndex >= session.m_files.size()) {
+		LOG((CLOG_DEBUG "ignoring request to resume unknown file transfer %u", resume.m_id));
+		return;
+	}
+
+	// the receiver's data is only good if the file hasn't changed since
+	size_t offset = resume.m_offset;
+	UInt32 checksum = resume.m_checksum;
+	if (offset > 0 && !checkFilePrefix(
+			session.m_files[resume.m_fileIndex].getFilename(),
+			offset, checksum)) {
+		LOG((CLOG_WARN "file %u of transfer %u has changed, sending it again",
+			resume.m_fileIndex + 1, resume.m_id));
+		offset = 0;
+		checksum = FileChunk::kChecksumInit;
+	}
 
+	LOG((CLOG_INFO "resuming file transfer %u, file %u at %s bytes",
+		resume.m_id, resume.m_fileIndex + 1,
+		synergy::string::sizeTypeToString(offset).c_str()));
+
+	sendFilesFrom(session, resume.m_fileIndex, offset, checksum,
+		events, eventTarget, bandwidth, sendFromFile);
+}
+
+bool
+StreamChunker::checkFilePrefix(
+				const String& filename,
+				size_t size,
+				UInt32 checksum)
+{
+	std::fstream file(filename.c_str(), std::ios::in | std::ios::binary);
 	if (!file.is_open()) {
-		throw runtime_error("failed to open file");
+		return false;
 	}
 
-	// check file size
-	file.seekg (0, std::ios::end);
-	size_t size = (size_t)file.tellg();
+	UInt32 sum = FileChunk::kChecksumInit;
+	std::vector<char> buffer(64 * 1024);
+	while (size > 0) {
+		size_t length = (size < buffer.size()) ? size : buffer.size();
+		file.read(&buffer[0], length);
+		if ((size_t)file.gcount() != length) {
+			return false;
+		}
+		sum = FileChunk::updateChecksum(sum,
+				reinterpret_cast<const UInt8*>(&buffer[0]), length);
+		size -= length;
+	}
+	return (sum == checksum);
+}
 
-	// send first message (file size)
-	String fileSize = synergy::string::sizeTypeToString(size);
-	FileChunk* sizeMessage = FileChunk::start(fileSize);
+void
+StreamChunker::sendFilesFrom(
+				const FileTransferSession& session,
+				UInt32 firstIndex,
+				size_t offset,
+				UInt32 checksum,
+				IEventQueue* events,
+				void* eventTarget,
+				TokenBucket* bandwidth,
+				bool sendFromFile)
+{
+	s_isChunkingFile = true;
 
-	events->addEvent(Event(events->forFile().fileChunkSending(), eventTarget, sizeMessage));
+	// open every file up front so we know the session size and can fail
+	// before sending anything
+	const DragFileList& fileList = session.m_files;
+	UInt32 fileCount = static_cast<UInt32>(fileList.size());
+	std::vector<size_t> fileSizes;
+	size_t totalSize = 0;
+	size_t sessionSent = 0;
+	for (UInt32 i = 0; i < fileCount; ++i) {
+		std::fstream file(fileList[i].getFilename().c_str(), std::ios::in | std::ios::binary);
+		if (!file.is_open()) {
+			s_isChunkingFile = false;
+			throw runtime_error("failed to open file");
+		}
+		file.seekg (0, std::ios::end);
+		fileSizes.push_back((size_t)file.tellg());
+		totalSize += fileSizes.back();
+		if (i < firstIndex) {
+			sessionSent += fileSizes.back();
+		}
+	}
 
-	// send chunk messages with a fixed chunk size
-	size_t sentLength = 0;
-	size_t chunkSize = s_chunkSize;
-	Stopwatch sendStopwatch;
-	sendStopwatch.start();
-	file.seekg (0, std::ios::beg);
+	if (firstIndex < fileCount && offset > fileSizes[firstIndex]) {
+		s_isChunkingFile = false;
+		throw runtime_error("resume offset beyond end of file");
+	}
+	sessionSent += offset;
 
-	while (true) {
-		if (s_interruptFile) {
-			s_interruptFile = false;
-			LOG((CLOG_DEBUG "file transmission interrupted"));
-			break;
+	LOG((CLOG_DEBUG "sending %u file(s), total size=%s", fileCount,
+		synergy::string::sizeTypeToString(totalSize).c_str()));
+
+	// forget about chunks of an earlier, abandoned session
+	{
+		ArchMutexLock lock(s_fileWindowMutex);
+		s_fileBytesQueued = s_fileBytesSent;
+	}
+
+	Stopwatch sessionStopwatch;
+	Stopwatch progressStopwatch;
+	bool interrupted = false;
+	size_t maxChunkSize = s_chunkSize;
+	char* chunkData = new char[maxChunkSize];
+
+	for (UInt32 index = firstIndex; index < fileCount; ++index) {
+#if HAVE_SYS_SENDFILE_H
+		int fd = ::open(fileList[index].getFilename().c_str(), O_RDONLY);
+		if (fd == -1) {
+#else
+		std::fstream file(fileList[index].getFilename().c_str(), std::ios::in | std::ios::binary);
+		if (!file.is_open()) {
+#endif
+			delete[] chunkData;
+			s_isChunkingFile = false;
+			throw runtime_error("failed to open file");
 		}
-		
-		if (sendStopwatch.getTime() > SEND_THRESHOLD) {
-			events->addEvent(Event(events->forFile().keepAlive(), eventTarget));
 
-			// make sure we don't read too much from the mock data.
+		// only the first file can be resumed part way through
+		size_t sentLength = 0;
+		if (index == firstIndex && offset > 0) {
+#if !HAVE_SYS_SENDFILE_H
+			file.seekg(offset, std::ios::beg);
+#endif
+			sentLength = offset;
+		}
+		else {
+			checksum = FileChunk::kChecksumInit;
+		}
+
+		// send the file header (transfer id, index, size and offset)
+		size_t size = fileSizes[index];
+		FileChunk* header = FileChunk::transferStart(session.m_id, index, size, sentLength);
+		{
+			ArchMutexLock lock(s_fileWindowMutex);
+			s_fileBytesQueued += header->m_dataSize;
+		}
+		addChunkEvent(events, events->forFile().fileChunkSending(), eventTarget, header);
+
+		// send chunk messages with a fixed chunk size, reading ahead of
+		// the stream by no more than the send window and no faster than
+		// the bandwidth limit
+		while (sentLength < size) {
+			size_t chunkSize = maxChunkSize;
 			if (sentLength + chunkSize > size) {
 				chunkSize = size - sentLength;
 			}
 
-			char* chunkData = new char[chunkSize];
+			if (!waitForFileWindow(kFileSendWindow) ||
+				!waitForMemory(s_interruptFile) ||
+				!waitForBandwidth(bandwidth, chunkSize, s_interruptFile)) {
+				s_interruptFile = false;
+				interrupted = true;
+				break;
+			}
+
+			events->addEvent(Event(events->forFile().keepAlive(), eventTarget,
+				NULL, Event::kCollapse));
+
+			// a stream that sends straight from the file gets the range,
+			// unchecked since it's never read here.  a range is counted
+			// as sent by fileRangeSent() and its chunk by fileChunkSent().
+			FileChunk* fileChunk = NULL;
+			size_t queued = 0;
+			bool read = false;
+#if HAVE_SYS_SENDFILE_H
+			if (sendFromFile) {
+				int rangeFd = ::dup(fd);
+				if (rangeFd != -1) {
+					fileChunk = FileChunk::fileRange(rangeFd, sentLength, chunkSize);
+					queued = chunkSize + fileChunk->m_dataSize;
+					read = true;
+				}
+			}
+			else {
+				read = FileChunk::readRange(fd, sentLength, chunkSize, chunkData);
+			}
+#else
 			file.read(chunkData, chunkSize);
-			UInt8* data = reinterpret_cast<UInt8*>(chunkData);
-			FileChunk* fileChunk = FileChunk::data(data, chunkSize);
-			delete[] chunkData;
+			read = ((size_t)file.gcount() == chunkSize);
+#endif
+			if (!read) {
+#if HAVE_SYS_SENDFILE_H
+				::close(fd);
+#endif
+				delete[] chunkData;
+				s_isChunkingFile = false;
+				throw runtime_error("failed to read file");
+			}
 
-			events->addEvent(Event(events->forFile().fileChunkSending(), eventTarget, fileChunk));
+			// otherwise send a copy with the running checksum
+			if (fileChunk == NULL) {
+				UInt8* data = reinterpret_cast<UInt8*>(chunkData);
+				checksum = FileChunk::updateChecksum(checksum, data, chunkSize);
+				fileChunk = FileChunk::checkedData(data, chunkSize, checksum);
+				queued = fileChunk->m_dataSize;
+			}
+			{
+				ArchMutexLock lock(s_fileWindowMutex);
+				s_fileBytesQueued += queued;
+			}
+			addChunkEvent(events, events->forFile().fileChunkSending(), eventTarget, fileChunk);
 
-			sentLength += chunkSize;
-			file.seekg (sentLength, std::ios::beg);
+			sentLength  += chunkSize;
+			sessionSent += chunkSize;
 
-			if (sentLength == size) {
-				break;
+			if (progressStopwatch.getTime() >= kFileProgressInterval) {
+				sendFileProgress(index, fileCount, sessionSent, totalSize,
+					sessionStopwatch.getTime(), events, eventTarget);
+				progressStopwatch.reset();
 			}
+		}
 
-			sendStopwatch.reset();
+		bool aborted = false;
+#if HAVE_SYS_SENDFILE_H
+		::close(fd);
+
+		// a stream pads a range that was cut short with zeros, which the
+		// receiver can't tell from data.  wait for the stream to get
+		// through the file's ranges and have the receiver drop the file
+		// if any was.
+		if (sendFromFile && !interrupted && !waitForFileWindow(1)) {
+			interrupted = true;
+			aborted = true;
 		}
-	}
+#endif
 
-	// send last message
-	FileChunk* end = FileChunk::end();
+		// send end of file.  if interrupted, the receiver sees the size
+		// mismatch and discards the partial file.  if the connection was
+		// lost the end never arrives and the receiver can resume.
+		FileChunk* end = aborted ? FileChunk::abort() : FileChunk::end();
+		addChunkEvent(events, events->forFile().fileChunkSending(), eventTarget, end);
 
-	events->addEvent(Event(events->forFile().fileChunkSending(), eventTarget, end));
+		if (interrupted) {
+			break;
+		}
+
+		sendFileProgress(index, fileCount, sessionSent, totalSize,
+			sessionStopwatch.getTime(), events, eventTarget);
+		progressStopwatch.reset();
+	}
 
-	file.close();
+	delete[] chunkData;
 	
 	s_isChunkingFile = false;
 }
 
-void
+bool
 StreamChunker::sendClipboard(
 				String& data,
 				size_t size,
 				ClipboardID id,
 				UInt32 sequence,
 				IEventQueue* events,
-				void* eventTarget)
+				void* eventTarget,
+				TokenBucket* bandwidth)
 {
+	String dataSize = synergy::string::sizeTypeToString(size);
+	return sendClipboardChunks(ClipboardChunk::start(id, sequence, dataSize),
+				data, size, id, sequence, events, eventTarget, bandwidth);
+}
+
+bool
+StreamChunker::sendClipboardDelta(
+				String& delta,
+				UInt32 baseHash,
+				UInt32 targetHash,
+				ClipboardID id,
+				UInt32 sequence,
+				IEventQueue* events,
+				void* eventTarget,
+				TokenBucket* bandwidth)
+{
+	ClipboardChunk* start = ClipboardChunk::deltaStart(id, sequence,
+				delta.size(), baseHash, targetHash);
+	return sendClipboardChunks(start, delta, delta.size(), id, sequence,
+				events, eventTarget, bandwidth);
+}
+
+bool
+StreamChunker::sendClipboardChunks(
+				ClipboardChunk* start,
+				String& data,
+				size_t size,
+				ClipboardID id,
+				UInt32 sequence,
+				IEventQueue* events,
+				void* eventTarget,
+				TokenBucket* bandwidth)
+{
+	if (s_interruptClipboard) {
+		LOG((CLOG_DEBUG "clipboard transmission skipped"));
+		delete start;
+		return false;
+	}
+
 	s_isChunkingClipboard = true;
 	
 	// send first message (data size)
-	String dataSize = synergy::string::sizeTypeToString(size);
-	ClipboardChunk* sizeMessage = ClipboardChunk::start(id, sequence, dataSize);
-	
-	events->addEvent(Event(events->forClipboard().clipboardSending(), eventTarget, sizeMessage));
+	addChunkEvent(events, events->forClipboard().clipboardSending(), eventTarget, start);
 
 	// send clipboard chunk with a fixed size
 	size_t sentLength = 0;
 	size_t chunkSize = s_chunkSize;
+	bool interrupted = false;
 	Stopwatch sendStopwatch;
 	sendStopwatch.start();
 	
 	while (true) {
 		if (s_interruptClipboard) {
-			s_interruptClipboard = false;
 			LOG((CLOG_DEBUG "clipboard transmission interrupted"));
+			interrupted = true;
 			break;
 		}
 
 		if (sendStopwatch.getTime() > SEND_THRESHOLD) {
-			events->addEvent(Event(events->forFile().keepAlive(), eventTarget));
+			events->addEvent(Event(events->forFile().keepAlive(), eventTarget,
+				NULL, Event::kCollapse));
 
 			// make sure we don't read too much from the mock data.
 			if (sentLength + chunkSize > size) {
 				chunkSize = size - sentLength;
 			}
 
+			if (!waitForMemory(s_interruptClipboard) ||
+				!waitForBandwidth(bandwidth, chunkSize, s_interruptClipboard)) {
+				continue;
+			}
+
 			String chunk(data.substr(sentLength, chunkSize).c_str(), chunkSize);
 			ClipboardChunk* dataChunk = ClipboardChunk::data(id, sequence, chunk);
 			
-			events->addEvent(Event(events->forClipboard().clipboardSending(), eventTarget, dataChunk));
+			addChunkEvent(events, events->forClipboard().clipboardSending(), eventTarget, dataChunk);
 
 			sentLength += chunkSize;
 			if (sentLength == size) {
@@ -175,9 +477,10 @@ StreamChunker::sendClipboard(
 	// send last message
 	ClipboardChunk* end = ClipboardChunk::end(id, sequence);
 
-	events->addEvent(Event(events->forClipboard().clipboardSending(), eventTarget, end));
+	addChunkEvent(events, events->forClipboard().clipboardSending(), eventTarget, end);
 	
 	s_isChunkingClipboard = false;
+	return !interrupted;
 }
 
 void
@@ -200,11 +503,154 @@ StreamChunker::interruptFile()
 	}
 }
 
+void
+StreamChunker::resetFileInterrupt()
+{
+	s_interruptFile = false;
+}
+
+void
+StreamChunker::fileChunkSent(size_t size)
+{
+	ArchMutexLock lock(s_fileWindowMutex);
+	s_fileBytesSent += size;
+}
+
+void
+StreamChunker::fileRangeSent(size_t size)
+{
+	ArchMutexLock lock(s_fileWindowMutex);
+	s_fileBytesSent += size;
+}
+
+size_t
+StreamChunker::getFileBytesUnsent()
+{
+	ArchMutexLock lock(s_fileWindowMutex);
+	if (s_fileBytesQueued < s_fileBytesSent) {
+		return 0;
+	}
+	return s_fileBytesQueued - s_fileBytesSent;
+}
+
+bool
+StreamChunker::waitForFileWindow(size_t window)
+{
+	Stopwatch stallStopwatch;
+	while (getFileBytesUnsent() >= window) {
+		if (s_interruptFile) {
+			s_interruptFile = false;
+			LOG((CLOG_DEBUG "file transmission interrupted"));
+			return false;
+		}
+		if (stallStopwatch.getTime() > kFileSendStallTimeout) {
+			LOG((CLOG_WARN "file transmission stalled, giving up"));
+			return false;
+		}
+		ARCH->sleep(SEND_THRESHOLD);
+	}
+
+	if (s_interruptFile) {
+		s_interruptFile = false;
+		LOG((CLOG_DEBUG "file transmission interrupted"));
+		return false;
+	}
+	return true;
+}
+
+bool
+StreamChunker::waitForMemory(const bool& interrupt)
+{
+	if (!MemoryBudget::isExhausted()) {
+		return true;
+	}
+
+	// let the queued chunks drain to the sockets before making more
+	LOG((CLOG_DEBUG1 "memory budget exhausted, waiting to send"));
+	Stopwatch stallStopwatch;
+	while (MemoryBudget::isExhausted()) {
+		if (interrupt) {
+			return false;
+		}
+		if (stallStopwatch.getTime() > kMemoryStallTimeout) {
+			// give up waiting rather than never sending.  whatever is
+			// holding the memory isn't being drained by us.
+			LOG((CLOG_WARN "memory budget still exhausted, sending anyway"));
+			return true;
+		}
+		ARCH->sleep(kBandwidthPollInterval);
+	}
+	return !interrupt;
+}
+
+bool
+StreamChunker::waitForBandwidth(
+				TokenBucket* bandwidth,
+				size_t size,
+				const bool& interrupt)
+{
+	if (bandwidth == NULL) {
+		return true;
+	}
+
+	double wait = bandwidth->take(size);
+	Stopwatch stopwatch;
+	for (double left = wait; left > 0.0; left = wait - stopwatch.getTime()) {
+		if (interrupt) {
+			return false;
+		}
+		ARCH->sleep(left < kBandwidthPollInterval ? left : kBandwidthPollInterval);
+	}
+	return !interrupt;
+}
+
+void
+StreamChunker::sendFileProgress(
+				UInt32 index,
+				UInt32 count,
+				size_t sent,
+				size_t total,
+				double elapsed,
+				IEventQueue* events,
+				void* eventTarget)
+{
+	FileTransferProgress* progress = new FileTransferProgress;
+	progress->m_fileIndex  = index;
+	progress->m_fileCount  = count;
+	progress->m_bytesSent  = sent;
+	progress->m_bytesTotal = total;
+	if (elapsed > 0.0) {
+		progress->m_bytesPerSecond = sent / elapsed;
+	}
+
+	Event event(events->forFile().fileTransferProgress(), eventTarget);
+	event.setDataObject(progress);
+	events->addEvent(event);
+}
+
 void
 StreamChunker::interruptClipboard()
 {
 	if (s_isChunkingClipboard) {
-		s_interruptClipboard = true;
 		LOG((CLOG_INFO "previous clipboard data has become invalid"));
 	}
+	s_interruptClipboard = true;
+}
+
+void
+StreamChunker::resetClipboardInterrupt()
+{
+	s_interruptClipboard = false;
+}
+
+void
+StreamChunker::addChunkEvent(
+				IEventQueue* events,
+				Event::Type type,
+				void* eventTarget,
+				Chunk* chunk)
+{
+	Event event(type, eventTarget);
+	event.setDataObject(chunk);
+	events->addEvent(event);
 }
@@ -18,31 +18,240 @@
 #pragma once
 
 #include "synergy/clipboard_types.h"
+#include "synergy/DragInformation.h"
+#include "base/Event.h"
 #include "base/String.h"
+#include "arch/IArchMultithread.h"
 
+class Chunk;
+class ClipboardChunk;
 class IEventQueue;
+class TokenBucket;
+
+//! File transfer progress
+/*!
+Event data for FileEvents::fileTransferProgress.  Byte counts cover the
+whole session; the rate is the average since the session started.
+*/
+class FileTransferProgress : public EventData {
+public:
+	FileTransferProgress() :
+		m_fileIndex(0),
+		m_fileCount(0),
+		m_bytesSent(0),
+		m_bytesTotal(0),
+		m_bytesPerSecond(0.0) { }
+
+	UInt32				m_fileIndex;
+	UInt32				m_fileCount;
+	size_t				m_bytesSent;
+	size_t				m_bytesTotal;
+	double				m_bytesPerSecond;
+};
+
+//! Point to resume a file transfer from
+/*!
+Sent by the receiver of an unfinished transfer, see kMsgDFileResume.
+*/
+class FileTransferResume {
+public:
+	FileTransferResume() :
+		m_id(0),
+		m_fileIndex(0),
+		m_checksum(0),
+		m_offset(0) { }
+
+	UInt32				m_id;
+	UInt32				m_fileIndex;
+	UInt32				m_checksum;
+	size_t				m_offset;
+};
+
+//! File session
+/*!
+Files sent by StreamChunker::sendFiles() under one transfer id.  The
+sender keeps the last session it sent to each peer so the peer can ask
+for it to be resumed.
+*/
+class FileTransferSession {
+public:
+	FileTransferSession() : m_id(0) { }
+
+	UInt32				m_id;
+	DragFileList		m_files;
+
+	// where the receiver asked to resume the session from, if it did
+	FileTransferResume	m_resume;
+};
 
 class StreamChunker {
 public:
+	//! Prepare for sending files
+	/*!
+	Must be called on the main thread before any file is sent.  Calling
+	it again does nothing.
+	*/
+	static void			init();
+
 	static void			sendFile(
 							char* filename,
 							IEventQueue* events,
 							void* eventTarget);
-	static void			sendClipboard(
+
+	//! Make a file session
+	/*!
+	Returns a session of the files in \p fileList with a new transfer
+	id.
+	*/
+	static FileTransferSession
+						newSession(const DragFileList& fileList);
+
+	//! Send several files as one session
+	/*!
+	Streams the files of \p session back to back, each preceded by a
+	header with its index.  The file being read runs ahead of the
+	stream by at most a fixed window of bytes; the receiver of the
+	fileChunkSending events must call fileChunkSent() once it has
+	written each chunk.  Chunks are paced by \p bandwidth unless it is
+	NULL.  If \p sendFromFile is true the chunks are kDataFileRange
+	chunks, for a stream that can send from the file (see
+	synergy::getFileSender()), otherwise they're copies of the data.
+	*/
+	static void			sendFiles(
+							const FileTransferSession& session,
+							IEventQueue* events,
+							void* eventTarget,
+							TokenBucket* bandwidth,
+							bool sendFromFile);
+
+	//! Resume a file session
+	/*!
+	Continues \p session from its resume point, seeking past the data
+	the receiver already has.  If that data doesn't match the start of
+	the file, the file is sent again from the beginning.  Does nothing
+	if the resume point refers to another session.
+	*/
+	static void			resumeFiles(
+							const FileTransferSession& session,
+							IEventQueue* events,
+							void* eventTarget,
+							TokenBucket* bandwidth,
+							bool sendFromFile);
+
+	//! Send a clipboard
+	/*!
+	Returns false if the send was interrupted by interruptClipboard(),
+	in which case the receiver gets an incomplete clipboard and it
+	should be sent again.
+	*/
+	static bool			sendClipboard(
 							String& data,
 							size_t size,
 							ClipboardID id,
 							UInt32 sequence,
 							IEventQueue* events,
-							void* eventTarget);
+							void* eventTarget,
+							TokenBucket* bandwidth);
+
+	//! Send a clipboard as a delta
+	/*!
+	Like sendClipboard() but sends \p delta, a ClipboardDelta against
+	the version with \p baseHash that gives a clipboard with
+	\p targetHash.
+	*/
+	static bool			sendClipboardDelta(
+							String& delta,
+							UInt32 baseHash,
+							UInt32 targetHash,
+							ClipboardID id,
+							UInt32 sequence,
+							IEventQueue* events,
+							void* eventTarget,
+							TokenBucket* bandwidth);
 	static void			updateChunkSize(bool useSecureSocket);
 	static void			interruptFile();
+
+	//! Forget an interrupt that arrived after the last file send ended
+	static void			resetFileInterrupt();
+
+	//! Interrupt clipboard sending
+	/*!
+	Stops the clipboard being sent, if any, and makes any later
+	sendClipboard() return immediately until resetClipboardInterrupt()
+	is called.
+	*/
 	static void			interruptClipboard();
+
+	//! Allow clipboard sending after interruptClipboard()
+	static void			resetClipboardInterrupt();
+
+	//! Notify that a file chunk has been written to the stream
+	static void			fileChunkSent(size_t size);
+
+	//! Notify that a stream is done with a file range
+	/*!
+	Called once the \p size bytes of a kDataFileRange chunk have been
+	sent or discarded.  Unlike fileChunkSent() this may be called on
+	any thread.
+	*/
+	static void			fileRangeSent(size_t size);
 	
+private:
+	static void			sendFilesFrom(
+							const FileTransferSession& session,
+							UInt32 firstIndex,
+							size_t offset,
+							UInt32 checksum,
+							IEventQueue* events,
+							void* eventTarget,
+							TokenBucket* bandwidth,
+							bool sendFromFile);
+	static bool			sendClipboardChunks(
+							ClipboardChunk* start,
+							String& data,
+							size_t size,
+							ClipboardID id,
+							UInt32 sequence,
+							IEventQueue* events,
+							void* eventTarget,
+							TokenBucket* bandwidth);
+	static bool			checkFilePrefix(
+							const String& filename,
+							size_t size,
+							UInt32 checksum);
+	static bool			waitForFileWindow(size_t window);
+	static size_t		getFileBytesUnsent();
+	static bool			waitForMemory(const bool& interrupt);
+	static bool			waitForBandwidth(
+							TokenBucket* bandwidth,
+							size_t size,
+							const bool& interrupt);
+	static void			sendFileProgress(
+							UInt32 index,
+							UInt32 count,
+							size_t sent,
+							size_t total,
+							double elapsed,
+							IEventQueue* events,
+							void* eventTarget);
+	static void			addChunkEvent(
+							IEventQueue* events,
+							Event::Type type,
+							void* eventTarget,
+							Chunk* chunk);
+
 private:
 	static size_t		s_chunkSize;
 	static bool			s_isChunkingClipboard;
 	static bool			s_interruptClipboard;
 	static bool			s_isChunkingFile;
 	static bool			s_interruptFile;
+
+	// bytes queued by the sending threads and bytes the streams are
+	// done with, which they may report on any thread
+	static ArchMutex	s_fileWindowMutex;
+	static size_t		s_fileBytesQueued;
+	static size_t		s_fileBytesSent;
+
+	static UInt32		s_transferCount;
 };
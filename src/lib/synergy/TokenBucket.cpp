@@ -0,0 +1,102 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/TokenBucket.h"
+
+#include "mt/Lock.h"
+#include "mt/Mutex.h"
+
+// how many seconds worth of tokens the bucket holds
+static const double kBurstTime = 1.0;
+
+//
+// TokenBucket
+//
+
+TokenBucket::TokenBucket(TokenBucket* parent) :
+	m_parent(parent),
+	m_mutex(new Mutex),
+	m_rate(0.0),
+	m_tokens(0.0)
+{
+	// do nothing
+}
+
+TokenBucket::~TokenBucket()
+{
+	delete m_mutex;
+}
+
+void
+TokenBucket::setRate(double bytesPerSecond)
+{
+	Lock lock(m_mutex);
+	if (bytesPerSecond < 0.0) {
+		bytesPerSecond = 0.0;
+	}
+	if (bytesPerSecond != m_rate) {
+		// start the new rate with a full bucket
+		m_rate   = bytesPerSecond;
+		m_tokens = m_rate * kBurstTime;
+		m_stopwatch.reset();
+	}
+}
+
+double
+TokenBucket::take(size_t size)
+{
+	double wait;
+	{
+		Lock lock(m_mutex);
+		wait = takeLocked(size);
+	}
+
+	if (m_parent != NULL) {
+		double parentWait = m_parent->take(size);
+		if (parentWait > wait) {
+			wait = parentWait;
+		}
+	}
+	return wait;
+}
+
+double
+TokenBucket::getRate() const
+{
+	Lock lock(m_mutex);
+	return m_rate;
+}
+
+double
+TokenBucket::takeLocked(size_t size)
+{
+	if (m_rate <= 0.0) {
+		return 0.0;
+	}
+
+	// refill for the time since we last looked
+	m_tokens += m_stopwatch.reset() * m_rate;
+	if (m_tokens > m_rate * kBurstTime) {
+		m_tokens = m_rate * kBurstTime;
+	}
+
+	m_tokens -= static_cast<double>(size);
+	if (m_tokens >= 0.0) {
+		return 0.0;
+	}
+	return -m_tokens / m_rate;
+}
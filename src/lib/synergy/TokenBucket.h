@@ -0,0 +1,73 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "base/Stopwatch.h"
+#include "common/basic_types.h"
+
+class Mutex;
+
+//! Token bucket rate limiter
+/*!
+Limits the average rate of bulk data to a number of bytes per second
+while allowing bursts of up to one second's worth.  Data may be taken
+before there are enough tokens for it; the bucket then goes into debt
+and the caller is told how long to wait before sending.  A bucket can
+have a parent (e.g. a global limit above a per-client one) that is
+charged as well.  A rate of zero means unlimited.  Thread safe.
+*/
+class TokenBucket {
+public:
+	TokenBucket(TokenBucket* parent = NULL);
+	~TokenBucket();
+
+	//! @name manipulators
+	//@{
+
+	//! Set the rate
+	/*!
+	Sets the rate in bytes per second.  Zero removes the limit.
+	*/
+	void				setRate(double bytesPerSecond);
+
+	//! Take tokens
+	/*!
+	Charges \p size bytes to this bucket and its parent and returns
+	how long (in seconds) the caller should wait before sending them.
+	*/
+	double				take(size_t size);
+
+	//@}
+	//! @name accessors
+	//@{
+
+	//! Get the rate
+	double				getRate() const;
+
+	//@}
+
+private:
+	double				takeLocked(size_t size);
+
+private:
+	TokenBucket*		m_parent;
+	Mutex*				m_mutex;
+	double				m_rate;
+	double				m_tokens;
+	Stopwatch			m_stopwatch;
+};
@@ -67,6 +67,10 @@ static const OptionID	kOptionXTestXineramaUnaware   = OPTION_CODE("XTXU");
 static const OptionID	kOptionScreenPreserveFocus    = OPTION_CODE("SFOC");
 static const OptionID	kOptionRelativeMouseMoves     = OPTION_CODE("MDLT");
 static const OptionID	kOptionWin32KeepForeground    = OPTION_CODE("_KFW");
+static const OptionID	kOptionClientKeyRepeat        = OPTION_CODE("CKRP");
+static const OptionID	kOptionKeyRepeatDelay         = OPTION_CODE("KRDL");
+static const OptionID	kOptionKeyRepeatRate          = OPTION_CODE("KRRT");
+static const OptionID	kOptionBandwidthLimit         = OPTION_CODE("BWLM");
 //@}
 
 //! @name Screen switch corner enumeration
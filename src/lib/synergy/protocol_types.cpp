@@ -42,10 +42,12 @@ const char*				kMsgDMouseRelMove	= "DMRM%2i%2i";
 const char*				kMsgDMouseWheel		= "DMWM%2i%2i";
 const char*				kMsgDMouseWheel1_0	= "DMWM%2i";
 const char*				kMsgDClipboard		= "DCLP%1i%4i%1i%s";
+const char*				kMsgDClipboardAck	= "DCAK%1i%4i";
 const char*				kMsgDInfo			= "DINF%2i%2i%2i%2i%2i%2i%2i";
 const char*				kMsgDSetOptions		= "DSOP%4I";
 const char*				kMsgDFileTransfer	= "DFTR%1i%s";
 const char*				kMsgDDragInfo		= "DDRG%2i%s";
+const char*				kMsgDFileResume		= "DFRS%4i%4i%4i%s";
 const char*				kMsgQInfo			= "QINF";
 const char*				kMsgEIncompatible	= "EICV%2i%2i";
 const char*				kMsgEBusy 			= "EBSY";
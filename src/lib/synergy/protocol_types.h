@@ -29,9 +29,13 @@
 // 1.4:  adds crypto support
 // 1.5:  adds file transfer and removes home brew crypto
 // 1.6:  adds clipboard streaming
+// 1.7:  adds client side key auto-repeat
+// 1.8:  adds multi-file transfer sessions
+// 1.9:  adds resumable, checksummed file transfers
+// 1.10: adds delta encoded clipboards
 // NOTE: with new version, synergy minor version should increment
 static const SInt16		kProtocolMajorVersion = 1;
-static const SInt16		kProtocolMinorVersion = 6;
+static const SInt16		kProtocolMinorVersion = 10;
 
 // default contact port number
 static const UInt16		kDefaultPort = 24800;
@@ -47,6 +51,20 @@ static const double		kKeepAliveRate = 3.0;
 // number of skipped kMsgCKeepAlive messages that indicates a problem
 static const double		kKeepAlivesUntilDeath = 3.0;
 
+// default delay (in seconds) before a held key starts to auto-repeat
+// and default number of repeats per second, used by clients that
+// auto-repeat keys locally.  these can be overridden using options.
+static const double		kKeyRepeatDelay = 0.5;
+static const double		kKeyRepeatRate = 25.0;
+
+// time between kMsgCNoop messages (in seconds) sent by the server while
+// any key is held on a client that auto-repeats keys locally.
+static const double		kKeyRepeatHoldRate = 0.25;
+
+// time without any message from the server (in seconds) after which a
+// client that auto-repeats keys locally stops repeating the held key.
+static const double		kKeyRepeatTimeout = 1.0;
+
 // obsolete heartbeat stuff
 static const double		kHeartRate = -1.0;
 static const double		kHeartBeatsUntilDeath = 3.0;
@@ -74,7 +92,15 @@ enum EDirectionMask {
 enum EDataTransfer {
 	kDataStart = 1,
 	kDataChunk = 2,
-	kDataEnd = 3
+	kDataEnd = 3,
+	kDataFileStart = 4,
+	kDataTransferStart = 5,
+	kDataCheckedChunk = 6,
+	kDataDeltaStart = 7,
+	kDataAbort = 8,
+
+	// never sent.  a range of a file the stream sends as a kDataChunk.
+	kDataFileRange = 128
 };
 
 // Data received constants
@@ -169,7 +195,9 @@ extern const char*		kMsgCInfoAck;
 // a reasonable time then the server disconnects the client.  if the
 // client doesn't receive these (or any message) periodically then it
 // should disconnect from the server.  the appropriate interval is
-// defined by an option.
+// defined by an option.  a client holding a standby connection sends
+// these every kKeepAliveRate seconds in place of the reply to kMsgHello
+// until it switches to that server.
 extern const char*		kMsgCKeepAlive;
 
 //
@@ -194,6 +222,9 @@ extern const char*		kMsgDKeyDown1_0;
 
 // key auto-repeat:  primary -> secondary
 // $1 = KeyID, $2 = KeyModifierMask, $3 = number of repeats, $4 = KeyButton
+// not sent to clients that auto-repeat keys locally (see
+// kOptionClientKeyRepeat).  instead the server sends a kMsgCNoop every
+// kKeyRepeatHoldRate seconds while any key is held.
 extern const char*		kMsgDKeyRepeat;
 
 // key auto-repeat 1.0:  same as above but without KeyButton
@@ -237,8 +268,19 @@ extern const char*		kMsgDMouseWheel1_0;
 // is 0 when sent by the primary.  secondary screens should use the
 // sequence number from the most recent kMsgCEnter.  $1 = clipboard
 // identifier.
+// mark 7 (since 1.10) starts a clipboard sent as a ClipboardDelta
+// against the last version the receiver acknowledged.  the data is the
+// delta size, the hash of that version and the hash of the new
+// clipboard, separated by commas.  the delta follows in chunks.
 extern const char*		kMsgDClipboard;
 
+// clipboard acknowledgement:  primary <-> secondary (since 1.10)
+// sent by the receiver of a kMsgDClipboard once it has all of it.
+// $1 = clipboard identifier, $2 = hash of the clipboard data it now
+// holds, or 0 if it couldn't apply a delta.  after a 0 the sender
+// should send the clipboard again in full.
+extern const char*		kMsgDClipboardAck;
+
 // client data:  secondary -> primary
 // $1 = coordinate of leftmost pixel on secondary screen,
 // $2 = coordinate of topmost pixel on secondary screen,
@@ -262,11 +304,28 @@ extern const char*		kMsgDSetOptions;
 
 // file data:  primary <-> secondary
 // transfer file data. A mark is used in the first byte.
-// 0 means the content followed is the file size.
-// 1 means the content followed is the chunk data.
-// 2 means the file transfer is finished.
+// 1 means the content followed is the file size.
+// 2 means the content followed is the chunk data.
+// 3 means the file transfer is finished.
+// 4 (since 1.8) starts the next file of a multi-file session.  the
+// content followed is the file's index in the drag information, a
+// comma and the file size.  files are sent in order, back to back,
+// each followed by its chunks and a 3.
+// 5 (since 1.9) starts or resumes a file.  the content followed is
+// the transfer id, the file's index, the file size and the offset to
+// continue from, separated by commas.  the offset is 0 for a new file.
+// 6 (since 1.9) is chunk data preceded by 4 bytes holding the Adler-32
+// checksum of the file from its start up to the end of this chunk.
 extern const char*		kMsgDFileTransfer;
 
+// file resume:  primary <-> secondary
+// sent by the receiver of an unfinished file transfer after connecting
+// to ask the sender to continue it.  $1 = transfer id, $2 = file index,
+// $3 = checksum of the data received so far, $4 = number of bytes
+// received so far as a decimal string.  the sender ignores transfers it
+// doesn't know.
+extern const char*		kMsgDFileResume;
+
 // drag infomation:  primary <-> secondary
 // transfer drag infomation. The first 2 bytes are used for storing
 // the number of dragging objects. Then the following string consists
@@ -0,0 +1,243 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#define TEST_ENV
+
+#include "test/mock/synergy/MockScreen.h"
+#include "test/global/TestEventQueue.h"
+#include "client/Client.h"
+#include "synergy/PacketStreamFilter.h"
+#include "synergy/ProtocolUtil.h"
+#include "synergy/protocol_types.h"
+#include "synergy/ClientArgs.h"
+#include "net/TCPListenSocket.h"
+#include "net/TCPSocketFactory.h"
+#include "net/SocketMultiplexer.h"
+#include "net/NetworkAddress.h"
+#include "net/IDataSocket.h"
+#include "base/TMethodEventJob.h"
+
+#include "test/global/gtest.h"
+
+#include <cstring>
+#include <vector>
+
+using ::testing::NiceMock;
+
+#define TEST_HOST "127.0.0.1"
+#define TEST_PRIMARY_PORT 24806
+#define TEST_STANDBY_PORT 24807
+
+//
+// FakeServer
+//
+
+// accepts a single client and says hello to it.  a primary also
+// completes the handshake when the hello is answered.
+class FakeServer {
+public:
+	FakeServer(IEventQueue* events, SocketMultiplexer* multiplexer,
+				int port, bool sayHello, bool primary) :
+		m_events(events),
+		m_listen(events, multiplexer),
+		m_stream(NULL),
+		m_sayHello(sayHello),
+		m_primary(primary),
+		m_accepted(false),
+		m_keepAlive(false),
+		m_helloBack(false),
+		m_peer(NULL)
+	{
+		NetworkAddress address(TEST_HOST, port);
+		address.resolve();
+		m_listen.bind(address);
+		m_events->adoptHandler(m_events->forIListenSocket().connecting(),
+							&m_listen,
+							new TMethodEventJob<FakeServer>(this,
+								&FakeServer::handleConnecting));
+	}
+
+	~FakeServer()
+	{
+		m_events->removeHandler(m_events->forIListenSocket().connecting(),
+							&m_listen);
+		disconnect();
+	}
+
+	// drop the client
+	void				disconnect()
+	{
+		if (m_stream != NULL) {
+			m_events->removeHandler(m_events->forIStream().inputReady(),
+							m_stream->getEventTarget());
+			delete m_stream;
+			m_stream = NULL;
+		}
+	}
+
+private:
+	void				handleConnecting(const Event&, void*)
+	{
+		IDataSocket* socket = m_listen.accept();
+		if (socket == NULL || m_stream != NULL) {
+			delete socket;
+			return;
+		}
+
+		m_accepted = true;
+		m_stream   = new PacketStreamFilter(m_events, socket, true);
+		m_events->adoptHandler(m_events->forIStream().inputReady(),
+							m_stream->getEventTarget(),
+							new TMethodEventJob<FakeServer>(this,
+								&FakeServer::handleData));
+		if (m_sayHello) {
+			ProtocolUtil::writef(m_stream, kMsgHello,
+							kProtocolMajorVersion, kProtocolMinorVersion);
+		}
+		if (m_peer != NULL && !m_sayHello) {
+			// the standby can't be ready yet
+			m_peer->disconnect();
+		}
+	}
+
+	void				handleData(const Event&, void*)
+	{
+		// read a message at a time
+		UInt32 n;
+		while ((n = m_stream->getSize()) > 0) {
+			std::vector<char> message(n);
+			m_stream->read(&message[0], n);
+			if (n >= 7 && memcmp(&message[0], "Synergy", 7) == 0) {
+				m_helloBack = true;
+				if (m_primary) {
+					std::vector<UInt32> options;
+					ProtocolUtil::writef(m_stream, kMsgDSetOptions, &options);
+				}
+				else {
+					m_events->addEvent(Event(Event::kQuit));
+				}
+			}
+			else if (n == 4 && memcmp(&message[0], kMsgCKeepAlive, 4) == 0 &&
+					!m_keepAlive && m_peer != NULL) {
+				// the standby is ready
+				m_keepAlive = true;
+				m_peer->disconnect();
+			}
+		}
+	}
+
+public:
+	IEventQueue*		m_events;
+	TCPListenSocket		m_listen;
+	synergy::IStream*	m_stream;
+	bool				m_sayHello;
+	bool				m_primary;
+	bool				m_accepted;
+	bool				m_keepAlive;
+	bool				m_helloBack;
+
+	// the server dropped once this one sees the client
+	FakeServer*			m_peer;
+};
+
+//
+// ClientFailoverTests
+//
+
+class ClientFailoverTests : public ::testing::Test
+{
+public:
+	ClientFailoverTests() :
+		m_primaryAddress(TEST_HOST, TEST_PRIMARY_PORT),
+		m_disconnected(false)
+	{
+		m_primaryAddress.resolve();
+		m_args.m_enableCrypto = false;
+		m_args.m_standbyAddresses.push_back("127.0.0.1:24807");
+	}
+
+	void				handleDisconnected(const Event&, void*)
+	{
+		m_disconnected = true;
+		m_events.raiseQuitEvent();
+	}
+
+public:
+	TestEventQueue		m_events;
+	NetworkAddress		m_primaryAddress;
+	ClientArgs			m_args;
+	bool				m_disconnected;
+};
+
+TEST_F(ClientFailoverTests, standbyReady_disconnected_helloAnsweredFromStandby)
+{
+	SocketMultiplexer multiplexer;
+	FakeServer primary(&m_events, &multiplexer, TEST_PRIMARY_PORT, true, true);
+	FakeServer standby(&m_events, &multiplexer, TEST_STANDBY_PORT, true, false);
+	standby.m_peer = &primary;
+
+	NiceMock<MockScreen> screen;
+	Client client(&m_events, "stub", m_primaryAddress,
+				new TCPSocketFactory(&m_events, &multiplexer), &screen, m_args);
+
+	client.connect();
+
+	// the standby's first keep alive drops the primary, then the
+	// standby quits once the client answers its hello
+	m_events.initQuitTimeout(10);
+	m_events.loop();
+	m_events.cleanupQuitTimeout();
+
+	EXPECT_TRUE(primary.m_helloBack);
+	EXPECT_TRUE(standby.m_keepAlive);
+	EXPECT_TRUE(standby.m_helloBack);
+	EXPECT_EQ(TEST_STANDBY_PORT, client.getServerAddress().getPort());
+}
+
+TEST_F(ClientFailoverTests, standbyNotReady_disconnected_nextServer)
+{
+	SocketMultiplexer multiplexer;
+	FakeServer primary(&m_events, &multiplexer, TEST_PRIMARY_PORT, true, true);
+	FakeServer standby(&m_events, &multiplexer, TEST_STANDBY_PORT, false, false);
+	standby.m_peer = &primary;
+
+	NiceMock<MockScreen> screen;
+	Client client(&m_events, "stub", m_primaryAddress,
+				new TCPSocketFactory(&m_events, &multiplexer), &screen, m_args);
+
+	m_events.adoptHandler(m_events.forClient().disconnected(),
+							client.getEventTarget(),
+							new TMethodEventJob<ClientFailoverTests>(this,
+								&ClientFailoverTests::handleDisconnected));
+
+	client.connect();
+
+	// the standby never says hello, so losing the primary disconnects
+	// and moves on to the standby's address for the next attempt
+	m_events.initQuitTimeout(10);
+	m_events.loop();
+	m_events.removeHandler(m_events.forClient().disconnected(),
+							client.getEventTarget());
+	m_events.cleanupQuitTimeout();
+
+	EXPECT_TRUE(primary.m_helloBack);
+	EXPECT_TRUE(standby.m_accepted);
+	EXPECT_FALSE(standby.m_helloBack);
+	EXPECT_TRUE(m_disconnected);
+	EXPECT_EQ(TEST_STANDBY_PORT, client.getServerAddress().getPort());
+}
@@ -346,8 +346,8 @@ NetworkTests::sendToClient_mockData_handleClientConnected(const Event&, void* vl
 void 
 NetworkTests::sendToClient_mockData_fileRecieveCompleted(const Event& event, void*)
 {
-	Client* client = reinterpret_cast<Client*>(event.getTarget());
-	EXPECT_TRUE(client->isReceivedFileSizeValid());
+	FileReceived* file = static_cast<FileReceived*>(event.getDataObject());
+	EXPECT_EQ(kMockDataSize, file->m_data.size());
 
 	m_events.raiseQuitEvent();
 }
@@ -373,8 +373,8 @@ NetworkTests::sendToClient_mockFile_handleClientConnected(const Event&, void* vl
 void 
 NetworkTests::sendToClient_mockFile_fileRecieveCompleted(const Event& event, void*)
 {
-	Client* client = reinterpret_cast<Client*>(event.getTarget());
-	EXPECT_TRUE(client->isReceivedFileSizeValid());
+	FileReceived* file = static_cast<FileReceived*>(event.getDataObject());
+	EXPECT_EQ(kMockFileSize, file->m_data.size());
 
 	m_events.raiseQuitEvent();
 }
@@ -389,8 +389,8 @@ NetworkTests::sendToServer_mockData_handleClientConnected(const Event&, void* vc
 void 
 NetworkTests::sendToServer_mockData_fileRecieveCompleted(const Event& event, void*)
 {
-	Server* server = reinterpret_cast<Server*>(event.getTarget());
-	EXPECT_TRUE(server->isReceivedFileSizeValid());
+	FileReceived* file = static_cast<FileReceived*>(event.getDataObject());
+	EXPECT_EQ(kMockDataSize, file->m_data.size());
 
 	m_events.raiseQuitEvent();
 }
@@ -405,8 +405,8 @@ NetworkTests::sendToServer_mockFile_handleClientConnected(const Event&, void* vc
 void 
 NetworkTests::sendToServer_mockFile_fileRecieveCompleted(const Event& event, void*)
 {
-	Server* server = reinterpret_cast<Server*>(event.getTarget());
-	EXPECT_TRUE(server->isReceivedFileSizeValid());
+	FileReceived* file = static_cast<FileReceived*>(event.getDataObject());
+	EXPECT_EQ(kMockFileSize, file->m_data.size());
 
 	m_events.raiseQuitEvent();
 }
@@ -418,7 +418,9 @@ NetworkTests::sendMockData(void* eventTarget)
 	String size = synergy::string::sizeTypeToString(kMockDataSize);
 	FileChunk* sizeMessage = FileChunk::start(size);
 	
-	m_events.addEvent(Event(m_events.forFile().fileChunkSending(), eventTarget, sizeMessage));
+	Event sizeMessageEvent(m_events.forFile().fileChunkSending(), eventTarget);
+	sizeMessageEvent.setDataObject(sizeMessage);
+	m_events.addEvent(sizeMessageEvent);
 
 	// send chunk messages with incrementing chunk size
 	size_t lastSize = 0;
@@ -433,7 +435,9 @@ NetworkTests::sendMockData(void* eventTarget)
 
 		// first byte is the chunk mark, last is \0
 		FileChunk* chunk = FileChunk::data(m_mockData, dataSize);
-		m_events.addEvent(Event(m_events.forFile().fileChunkSending(), eventTarget, chunk));
+		Event chunkEvent(m_events.forFile().fileChunkSending(), eventTarget);
+		chunkEvent.setDataObject(chunk);
+		m_events.addEvent(chunkEvent);
 
 		sentLength += dataSize;
 		lastSize = dataSize;
@@ -446,7 +450,9 @@ NetworkTests::sendMockData(void* eventTarget)
 	
 	// send last message
 	FileChunk* transferFinished = FileChunk::end();
-	m_events.addEvent(Event(m_events.forFile().fileChunkSending(), eventTarget, transferFinished));
+	Event transferFinishedEvent(m_events.forFile().fileChunkSending(), eventTarget);
+	transferFinishedEvent.setDataObject(transferFinished);
+	m_events.addEvent(transferFinishedEvent);
 }
 
 UInt8*
@@ -0,0 +1,346 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// sends data between two secure sockets over loopback.  the server's
+// certificate and the client's trusted fingerprint are written to a
+// temporary profile directory.  the throughput benchmark compares user
+// space and kernel tls.  it's disabled by default;  run it with
+// --gtest_also_run_disabled_tests.
+
+#include <openssl/ssl.h>
+
+// the key is generated with the openssl 3.0 api
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+
+#include "plugin/ns/SecureSocket.h"
+#include "net/SocketMultiplexer.h"
+#include "arch/Arch.h"
+#include "base/Log.h"
+#include "test/global/TestEventQueue.h"
+
+#include "test/global/gtest.h"
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define TEST_PORT 24805
+#define TEST_HOST "127.0.0.1"
+
+static const size_t kSmallTransferSize = 64 * 1024; // 64KB
+static const size_t kBenchmarkTransferSize = 16 * 1024 * 1024; // 16MB
+static const UInt32 kWriteSize = 64 * 1024; // 64KB
+
+// how much is queued in the sending socket's output buffer at once
+static const UInt32 kWriteWindow = 1024 * 1024; // 1MB
+
+// longest wait for the handshake or the data
+static const double kTimeout = 30.0;
+
+class SecureSocketTests : public ::testing::Test
+{
+public:
+	SecureSocketTests() :
+		m_server(NULL),
+		m_client(NULL),
+		m_haveCertificate(false)
+	{
+		// the profile holds the server's certificate and the
+		// fingerprints the client trusts
+		char dir[] = "/tmp/synergy-tls-XXXXXX";
+		if (mkdtemp(dir) == NULL) {
+			return;
+		}
+		m_profileDir = dir;
+		m_oldProfileDir = ARCH->getProfileDirectory();
+		ARCH->setProfileDirectory(m_profileDir);
+		mkdir((m_profileDir + "/SSL").c_str(), 0700);
+		mkdir((m_profileDir + "/SSL/Fingerprints").c_str(), 0700);
+		m_certificateFilename = m_profileDir + "/SSL/Synergy.pem";
+		m_fingerprintFilename = m_profileDir + "/SSL/Fingerprints/TrustedServers.txt";
+		m_haveCertificate = writeCertificate();
+	}
+
+	~SecureSocketTests()
+	{
+		disconnect();
+		if (!m_profileDir.empty()) {
+			ARCH->setProfileDirectory(m_oldProfileDir);
+			remove(m_fingerprintFilename.c_str());
+			remove(m_certificateFilename.c_str());
+			rmdir((m_profileDir + "/SSL/Fingerprints").c_str());
+			rmdir((m_profileDir + "/SSL").c_str());
+			rmdir(m_profileDir.c_str());
+		}
+	}
+
+	//! Connect a pair of secure sockets and start the handshake
+	/*!
+	Kernel tls offload is tried if \p kernelTls is true.
+	*/
+	bool				connect(bool kernelTls);
+
+	//! Close the sockets connect() made
+	void				disconnect();
+
+	//! Wait for both ends to finish the handshake
+	bool				waitForHandshake();
+
+	//! Send \p size bytes from the client and return what the server read
+	std::string			transfer(size_t size);
+
+	//! Time a transfer and log its throughput and cpu time
+	void				benchmark(bool kernelTls);
+
+	//! Get the process's user and system time
+	static double		getCpuTime();
+
+private:
+	bool				writeCertificate();
+
+public:
+	TestEventQueue		m_events;
+	SocketMultiplexer	m_multiplexer;
+	SecureSocket*		m_server;
+	SecureSocket*		m_client;
+	bool				m_haveCertificate;
+	String				m_profileDir;
+	String				m_oldProfileDir;
+	String				m_certificateFilename;
+	String				m_fingerprintFilename;
+};
+
+TEST_F(SecureSocketTests, write_smallData_received)
+{
+	ASSERT_TRUE(connect(true));
+	ASSERT_TRUE(waitForHandshake());
+
+	std::string received = transfer(kSmallTransferSize);
+
+	EXPECT_EQ(kSmallTransferSize, received.size());
+	EXPECT_TRUE(received == std::string(kSmallTransferSize, 'x'));
+}
+
+TEST_F(SecureSocketTests, DISABLED_write_benchmark)
+{
+	// openssl encrypting in user space, then the kernel if it can
+	benchmark(false);
+	if (HasFatalFailure()) {
+		return;
+	}
+	disconnect();
+	benchmark(true);
+}
+
+bool
+SecureSocketTests::connect(bool kernelTls)
+{
+	if (!m_haveCertificate) {
+		return false;
+	}
+
+	// a connected pair of sockets over loopback
+	ArchNetAddress address = ARCH->nameToAddr(TEST_HOST);
+	ARCH->setAddrPort(address, TEST_PORT);
+	ArchSocket listener = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kSTREAM);
+	ARCH->setReuseAddrOnSocket(listener, true);
+	ARCH->bindSocket(listener, address);
+	ARCH->listenOnSocket(listener);
+	ArchSocket peer = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kSTREAM);
+	ARCH->connectSocket(peer, address);
+	ARCH->closeAddr(address);
+
+	ArchSocket accepted = NULL;
+	for (int i = 0; accepted == NULL && i < 100; ++i) {
+		accepted = ARCH->acceptSocket(listener, NULL);
+		if (accepted == NULL) {
+			ARCH->sleep(0.01);
+		}
+	}
+	ARCH->closeSocket(listener);
+	if (accepted == NULL) {
+		ARCH->closeSocket(peer);
+		return false;
+	}
+
+	// the same set up the secure listen socket and the client do
+	m_server = new SecureSocket(&m_events, &m_multiplexer, accepted);
+	m_server->initSsl(true);
+	m_server->setKernelTls(kernelTls);
+	m_server->loadCertificates(m_certificateFilename);
+	m_server->secureAccept();
+
+	m_client = new SecureSocket(&m_events, &m_multiplexer, peer);
+	m_client->initSsl(false);
+	m_client->setKernelTls(kernelTls);
+	m_client->secureConnect();
+	return true;
+}
+
+void
+SecureSocketTests::disconnect()
+{
+	delete m_client;
+	delete m_server;
+	m_client = NULL;
+	m_server = NULL;
+}
+
+void
+SecureSocketTests::benchmark(bool kernelTls)
+{
+	ASSERT_TRUE(connect(kernelTls));
+	ASSERT_TRUE(waitForHandshake());
+	if (kernelTls && !m_client->canSendFile()) {
+		LOG((CLOG_INFO "secure socket (kernel tls): not available, skipped"));
+		return;
+	}
+
+	// time from the first write until the server has read the last
+	// byte.  the cpu time includes the encryption the kernel does on
+	// our behalf when tls is offloaded.
+	double start    = ARCH->time();
+	double startCpu = getCpuTime();
+	std::string received = transfer(kBenchmarkTransferSize);
+	double elapsed  = ARCH->time() - start;
+	double cpu      = getCpuTime() - startCpu;
+
+	EXPECT_EQ(kBenchmarkTransferSize, received.size());
+	LOG((CLOG_INFO "secure socket (%s tls): %d MB in %.2fs, %.0f MB/s, %.2fs cpu",
+		kernelTls ? "kernel" : "user space",
+		static_cast<int>(kBenchmarkTransferSize / (1024 * 1024)), elapsed,
+		kBenchmarkTransferSize / (1024.0 * 1024.0) / elapsed, cpu));
+}
+
+bool
+SecureSocketTests::waitForHandshake()
+{
+	double start = ARCH->time();
+	while (!(m_server->isSecureReady() && m_client->isSecureReady())) {
+		if (m_server->isFatal() || m_client->isFatal() ||
+			ARCH->time() - start > kTimeout) {
+			return false;
+		}
+		ARCH->sleep(0.01);
+	}
+	return true;
+}
+
+std::string
+SecureSocketTests::transfer(size_t size)
+{
+	std::string data(kWriteSize, 'x');
+	std::string received;
+	std::vector<char> buffer(kWriteSize);
+	size_t sent = 0;
+	double start = ARCH->time();
+	while (received.size() < size && ARCH->time() - start < kTimeout) {
+		// keep the output buffer topped up without queueing it all
+		bool idle = true;
+		if (sent < size && m_client->getUnsentSize() < kWriteWindow) {
+			UInt32 n = static_cast<UInt32>(std::min<size_t>(kWriteSize, size - sent));
+			m_client->write(data.data(), n);
+			sent += n;
+			idle  = false;
+		}
+
+		UInt32 n = m_server->read(&buffer[0], kWriteSize);
+		if (n > 0) {
+			received.append(&buffer[0], n);
+			idle = false;
+		}
+
+		if (idle) {
+			ARCH->sleep(0.001);
+		}
+	}
+	return received;
+}
+
+bool
+SecureSocketTests::writeCertificate()
+{
+	EVP_PKEY* key = EVP_RSA_gen(2048);
+	if (key == NULL) {
+		return false;
+	}
+
+	X509* certificate = X509_new();
+	X509_set_version(certificate, 2);
+	ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1);
+	X509_gmtime_adj(X509_getm_notBefore(certificate), 0);
+	X509_gmtime_adj(X509_getm_notAfter(certificate), 60 * 60);
+	X509_set_pubkey(certificate, key);
+
+	X509_NAME* name = X509_get_subject_name(certificate);
+	X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+		reinterpret_cast<const unsigned char*>("synergy"), -1, -1, 0);
+	X509_set_issuer_name(certificate, name);
+	X509_sign(certificate, key, EVP_sha256());
+
+	// the certificate and key go in the same file
+	bool written = false;
+	FILE* file = fopen(m_certificateFilename.c_str(), "w");
+	if (file != NULL) {
+		written = PEM_write_X509(file, certificate) == 1 &&
+			PEM_write_PrivateKey(file, key, NULL, NULL, 0, NULL, NULL) == 1;
+		fclose(file);
+	}
+
+	// trust it by its sha1 fingerprint, formatted as the client does
+	unsigned char digest[EVP_MAX_MD_SIZE];
+	unsigned int digestSize = 0;
+	X509_digest(certificate, EVP_sha1(), digest, &digestSize);
+	String fingerprint;
+	for (unsigned int i = 0; i < digestSize; ++i) {
+		char hex[4];
+		sprintf(hex, i == 0 ? "%02X" : ":%02X", digest[i]);
+		fingerprint.append(hex);
+	}
+	file = fopen(m_fingerprintFilename.c_str(), "w");
+	if (file != NULL) {
+		written = written && fprintf(file, "%s\n", fingerprint.c_str()) > 0;
+		fclose(file);
+	}
+	else {
+		written = false;
+	}
+
+	X509_free(certificate);
+	EVP_PKEY_free(key);
+	return written;
+}
+
+double
+SecureSocketTests::getCpuTime()
+{
+	// user and system time of every thread
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1000000.0 +
+			usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1000000.0;
+}
+
+#endif
@@ -0,0 +1,184 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "net/TCPSocket.h"
+#include "net/SocketMultiplexer.h"
+#include "arch/Arch.h"
+#include "base/IJob.h"
+#include "test/global/TestEventQueue.h"
+
+#include "test/global/gtest.h"
+
+// file ranges are only sent from the file where there's sendfile()
+#if HAVE_SYS_SENDFILE_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#define TEST_PORT 24804
+#define TEST_HOST "127.0.0.1"
+
+// more than the kernel takes at once, so what follows stays queued
+// behind it in the socket's output buffer
+static const size_t kBacklogSize = 8 * 1024 * 1024;
+
+// longest wait for the data to arrive
+static const double kReceiveTimeout = 10.0;
+
+// sets a flag when run
+class FlagJob : public IJob {
+public:
+	FlagJob(bool& flag) : m_flag(flag) { }
+
+	// IJob overrides
+	virtual void		run() { m_flag = true; }
+
+private:
+	bool&				m_flag;
+};
+
+class TCPSocketTests : public ::testing::Test
+{
+public:
+	TCPSocketTests() :
+		m_listener(NULL),
+		m_peer(NULL),
+		m_file(NULL),
+		m_socket(NULL),
+		m_done(false),
+		m_truncated(false)
+	{
+		// the file ranges are sent from
+		m_file = tmpfile();
+		fputs("0123456789", m_file);
+		fflush(m_file);
+
+		// a connected pair of sockets over loopback
+		ArchNetAddress address = ARCH->nameToAddr(TEST_HOST);
+		ARCH->setAddrPort(address, TEST_PORT);
+		m_listener = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kSTREAM);
+		ARCH->setReuseAddrOnSocket(m_listener, true);
+		ARCH->bindSocket(m_listener, address);
+		ARCH->listenOnSocket(m_listener);
+		m_peer = ARCH->newSocket(IArchNetwork::kINET, IArchNetwork::kSTREAM);
+		ARCH->connectSocket(m_peer, address);
+		ARCH->closeAddr(address);
+
+		ArchSocket accepted = NULL;
+		for (int i = 0; accepted == NULL && i < 100; ++i) {
+			accepted = ARCH->acceptSocket(m_listener, NULL);
+			if (accepted == NULL) {
+				ARCH->sleep(0.01);
+			}
+		}
+		if (accepted != NULL) {
+			m_socket = new TCPSocket(&m_events, &m_multiplexer, accepted);
+		}
+	}
+
+	~TCPSocketTests()
+	{
+		delete m_socket;
+		ARCH->closeSocket(m_peer);
+		ARCH->closeSocket(m_listener);
+		fclose(m_file);
+	}
+
+	// queue a range of the file with a header in front of it
+	void				writeFile(const std::string& header,
+							size_t offset, UInt32 size)
+	{
+		bool queued = m_socket->writeFile(header.data(),
+							static_cast<UInt32>(header.size()),
+							fileno(m_file), offset, size,
+							new FlagJob(m_done), new FlagJob(m_truncated));
+		ASSERT_TRUE(queued);
+	}
+
+	void				write(const std::string& data)
+	{
+		m_socket->write(data.data(), static_cast<UInt32>(data.size()));
+	}
+
+	// read what the socket sent until there's \p size bytes of it
+	std::string			receive(size_t size)
+	{
+		std::string data;
+		std::vector<char> buffer(64 * 1024);
+		double start = ARCH->time();
+		while (data.size() < size && ARCH->time() - start < kReceiveTimeout) {
+			size_t n = ARCH->readSocket(m_peer, &buffer[0], buffer.size());
+			if (n == 0) {
+				ARCH->sleep(0.001);
+			}
+			data.append(&buffer[0], n);
+		}
+
+		// the jobs are run by the time the socket is flushed
+		m_socket->flush();
+		return data;
+	}
+
+public:
+	TestEventQueue		m_events;
+	SocketMultiplexer	m_multiplexer;
+	ArchSocket			m_listener;
+	ArchSocket			m_peer;
+	FILE*				m_file;
+	TCPSocket*			m_socket;
+	bool				m_done;
+	bool				m_truncated;
+};
+
+TEST_F(TCPSocketTests, writeFile_betweenWrites_sentInOrder)
+{
+	ASSERT_TRUE(m_socket != NULL);
+	std::string backlog(kBacklogSize, 'x');
+
+	write(backlog);
+	writeFile("[a]", 0, 4);
+	write("b");
+	write("c");
+	writeFile("[d]", 4, 3);
+	write("e");
+
+	std::string expected = backlog + "[a]0123bc[d]456e";
+	std::string received = receive(expected.size());
+	EXPECT_EQ(expected.size(), received.size());
+	EXPECT_TRUE(received == expected);
+	EXPECT_TRUE(m_done);
+	EXPECT_FALSE(m_truncated);
+}
+
+TEST_F(TCPSocketTests, writeFile_fileEndsEarly_zerosSent)
+{
+	ASSERT_TRUE(m_socket != NULL);
+
+	// the range runs 4 bytes past the end of the file
+	writeFile("[a]", 6, 8);
+	write("b");
+
+	std::string expected = std::string("[a]6789") + std::string(4, '\0') + "b";
+	std::string received = receive(expected.size());
+	EXPECT_EQ(expected.size(), received.size());
+	EXPECT_TRUE(received == expected);
+	EXPECT_TRUE(m_done);
+	EXPECT_TRUE(m_truncated);
+}
+
+#endif
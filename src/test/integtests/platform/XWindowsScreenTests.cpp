@@ -30,7 +30,7 @@ TEST(CXWindowsScreenTests, fakeMouseMove_nonPrimary_getCursorPosValuesCorrect)
 	EXPECT_CALL(eventQueue, adoptBuffer(_)).Times(2);
 	EXPECT_CALL(eventQueue, removeHandler(_, _)).Times(2);
 	XWindowsScreen screen(
-		":0.0", false, false, 0, &eventQueue);
+		":0.0", false, false, 0, &eventQueue, NULL);
 
 	screen.fakeMouseMove(10, 20);
 
@@ -0,0 +1,489 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2013 Synergy Si Ltd.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#define TEST_ENV
+
+#include "test/mock/server/MockConfig.h"
+#include "test/mock/server/MockPrimaryClient.h"
+#include "test/mock/server/MockClientProxy.h"
+#include "test/mock/server/MockInputFilter.h"
+#include "test/mock/synergy/MockScreen.h"
+#include "test/global/TestEventQueue.h"
+#include "server/Server.h"
+#include "synergy/StreamChunker.h"
+#include "synergy/Clipboard.h"
+#include "mt/Thread.h"
+#include "base/TMethodEventJob.h"
+#include "base/Stopwatch.h"
+#include "base/Log.h"
+
+#include "test/global/gtest.h"
+
+using ::testing::_;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::Invoke;
+using ::testing::Exactly;
+using ::testing::AtLeast;
+
+// large enough that sending it takes much longer than a crossing
+const size_t kLargeClipboardSize = 1024 * 1024 * 16; // 16MB
+const int kCrossings = 40;
+const double kCrossingInterval = 0.02;
+
+// grabs within this time of each other are sent as one
+const int kGrabs = 10;
+const double kGrabSettleTime = 0.5;
+
+// a client's clipboard changes to these, the first one twice
+const char* const kClipboardChanges[] = { "first", "first", "second" };
+const int kClipboardChangeCount = 3;
+
+// long enough for the bulk loop to marshall a change before the next
+const double kClipboardChangeInterval = 0.1;
+
+// 2000 pixels a second towards the right edge, stopping short of it
+const SInt32 kMoveStartX = 1000;
+const SInt32 kMoveEndX = 1800;
+const SInt32 kMoveStep = 20;
+const SInt32 kSlowMoveStep = 1;
+const double kMoveInterval = 0.01;
+
+void getServerScreenShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h);
+void getCursorOrigin(SInt32& x, SInt32& y);
+void getWideScreenShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h);
+bool getLargeClipboard(ClipboardID, IClipboard* clipboard);
+
+class ServerTests : public ::testing::Test
+{
+public:
+	ServerTests() :
+		m_server(NULL),
+		m_primaryClient(NULL),
+		m_clientProxy(NULL),
+		m_crossings(0),
+		m_totalTime(0.0),
+		m_maxTime(0.0),
+		m_leaveTime(0.0),
+		m_clipboardSends(0),
+		m_clipboardTime(0.0),
+		m_moveX(kMoveStartX),
+		m_moveStep(kMoveStep),
+		m_eventLoopThread(Thread::getCurrentThread()),
+		m_clipboardReads(0),
+		m_clipboardReadsOnEventLoop(0),
+		m_clipboardChanges(0) { }
+
+	void				sendClipboard(ClipboardID id, const IClipboard* clipboard);
+	bool				getChangedClipboard(ClipboardID id, IClipboard* clipboard);
+	void				addClipboardEvent(Event::Type type, void* target,
+							UInt32 sequenceNumber);
+	void				handleCrossingTimer(const Event&, void*);
+	void				handleMoveTimer(const Event&, void*);
+	void				handleClipboardChangeTimer(const Event&, void*);
+	void				handleQuitTimer(const Event&, void*);
+
+public:
+	TestEventQueue		m_events;
+	Server*				m_server;
+	BaseClientProxy*	m_primaryClient;
+	BaseClientProxy*	m_clientProxy;
+	int					m_crossings;
+	double				m_totalTime;
+	double				m_maxTime;
+
+	// when the primary screen was last left, and the clipboard sends
+	// that finished after it.  written by the sending thread and only
+	// read once it's done.
+	Stopwatch			m_stopwatch;
+	double				m_leaveTime;
+	int					m_clipboardSends;
+	double				m_clipboardTime;
+	SInt32				m_moveX;
+	SInt32				m_moveStep;
+
+	// where the client's clipboard was read from.  only written by the
+	// bulk loop and read once the test is done.
+	Thread				m_eventLoopThread;
+	int					m_clipboardReads;
+	int					m_clipboardReadsOnEventLoop;
+	int					m_clipboardChanges;
+};
+
+TEST_F(ServerTests, switchScreen_largeClipboardPending_crossingDoesNotWait)
+{
+	NiceMock<MockScreen> serverScreen;
+	NiceMock<MockPrimaryClient> primaryClient;
+	NiceMock<MockConfig> serverConfig;
+	NiceMock<MockInputFilter> serverInputFilter;
+	NiceMock<MockClientProxy> clientProxy("stub");
+
+	ON_CALL(serverConfig, isScreen(_)).WillByDefault(Return(true));
+	ON_CALL(serverConfig, getInputFilter()).WillByDefault(Return(&serverInputFilter));
+	ON_CALL(primaryClient, getShape(_, _, _, _)).WillByDefault(Invoke(getServerScreenShape));
+	ON_CALL(primaryClient, leave()).WillByDefault(Return(true));
+	ON_CALL(primaryClient, getClipboard(_, _)).WillByDefault(Invoke(getLargeClipboard));
+	ON_CALL(clientProxy, getEventTarget()).WillByDefault(Return(&clientProxy));
+	ON_CALL(clientProxy, getShape(_, _, _, _)).WillByDefault(Invoke(getServerScreenShape));
+	ON_CALL(clientProxy, getCursorPos(_, _)).WillByDefault(Invoke(getCursorOrigin));
+	ON_CALL(clientProxy, leave()).WillByDefault(Return(true));
+	ON_CALL(clientProxy, setClipboard(_, _)).WillByDefault(Invoke(this, &ServerTests::sendClipboard));
+
+	Server server(serverConfig, &primaryClient, &serverScreen, &m_events, false);
+	server.m_mock = true;
+	server.adoptClient(&clientProxy);
+
+	m_server        = &server;
+	m_primaryClient = &primaryClient;
+	m_clientProxy   = &clientProxy;
+
+	// the server only learns where the cursor is from motion, and
+	// jumping back to the primary screen returns it there
+	server.moveOnPrimary(0, 0);
+
+	// cross back and forth while the clipboard is being sent
+	EventQueueTimer* timer = m_events.newTimer(kCrossingInterval, NULL);
+	m_events.adoptHandler(Event::kTimer, timer,
+		new TMethodEventJob<ServerTests>(
+			this, &ServerTests::handleCrossingTimer));
+
+	m_events.initQuitTimeout(30);
+	m_events.loop();
+	m_events.removeHandler(Event::kTimer, timer);
+	m_events.deleteTimer(timer);
+	m_events.cleanupQuitTimeout();
+
+	// timings are only reported.  wall clock limits fail on loaded
+	// build machines.
+	double averageTime = m_totalTime / m_crossings;
+	LOG((CLOG_INFO "crossing latency with %d MB clipboard pending: "
+		"average %.3f ms, max %.3f ms",
+		static_cast<int>(kLargeClipboardSize / (1024 * 1024)),
+		1000.0 * averageTime, 1000.0 * m_maxTime));
+	if (m_clipboardSends > 0) {
+		LOG((CLOG_INFO "deferred clipboard send: %d finished, "
+			"average %.3f ms after leaving the primary screen",
+			m_clipboardSends, 1000.0 * m_clipboardTime / m_clipboardSends));
+	}
+
+	EXPECT_EQ(kCrossings, m_crossings);
+}
+
+TEST_F(ServerTests, clipboardGrabbed_manyGrabs_sentOnce)
+{
+	NiceMock<MockScreen> serverScreen;
+	NiceMock<MockPrimaryClient> primaryClient;
+	NiceMock<MockConfig> serverConfig;
+	NiceMock<MockInputFilter> serverInputFilter;
+	NiceMock<MockClientProxy> clientProxy("stub");
+
+	ON_CALL(serverConfig, isScreen(_)).WillByDefault(Return(true));
+	ON_CALL(serverConfig, getInputFilter()).WillByDefault(Return(&serverInputFilter));
+	ON_CALL(primaryClient, getEventTarget()).WillByDefault(Return(&primaryClient));
+	ON_CALL(clientProxy, getEventTarget()).WillByDefault(Return(&clientProxy));
+
+	EXPECT_CALL(clientProxy, grabClipboard(kClipboardClipboard)).Times(Exactly(1));
+
+	Server server(serverConfig, &primaryClient, &serverScreen, &m_events, false);
+	server.m_mock = true;
+	server.adoptClient(&clientProxy);
+
+	// selecting text grabs the clipboard over and over
+	for (int i = 0; i < kGrabs; ++i) {
+		IScreen::ClipboardInfo* info =
+			(IScreen::ClipboardInfo*)malloc(sizeof(IScreen::ClipboardInfo));
+		info->m_id = kClipboardClipboard;
+		info->m_sequenceNumber = i;
+		m_events.addEvent(Event(m_events.forClipboard().clipboardGrabbed(),
+							&primaryClient, info));
+	}
+
+	EventQueueTimer* timer = m_events.newOneShotTimer(kGrabSettleTime, NULL);
+	m_events.adoptHandler(Event::kTimer, timer,
+		new TMethodEventJob<ServerTests>(
+			this, &ServerTests::handleQuitTimer));
+
+	m_events.initQuitTimeout(5);
+	m_events.loop();
+	m_events.removeHandler(Event::kTimer, timer);
+	m_events.deleteTimer(timer);
+	m_events.cleanupQuitTimeout();
+}
+
+TEST_F(ServerTests, clipboardChanged_fromClient_marshalledOnBulkLoop)
+{
+	NiceMock<MockScreen> serverScreen;
+	NiceMock<MockPrimaryClient> primaryClient;
+	NiceMock<MockConfig> serverConfig;
+	NiceMock<MockInputFilter> serverInputFilter;
+	NiceMock<MockClientProxy> clientProxy("stub");
+
+	ON_CALL(serverConfig, isScreen(_)).WillByDefault(Return(true));
+	ON_CALL(serverConfig, getInputFilter()).WillByDefault(Return(&serverInputFilter));
+	ON_CALL(primaryClient, getEventTarget()).WillByDefault(Return(&primaryClient));
+	ON_CALL(clientProxy, getEventTarget()).WillByDefault(Return(&clientProxy));
+	ON_CALL(clientProxy, getClipboard(_, _)).WillByDefault(Invoke(this, &ServerTests::getChangedClipboard));
+
+	// the other screens hear of each clipboard that changed but not
+	// of the repeat
+	EXPECT_CALL(primaryClient, grabClipboard(kClipboardClipboard)).Times(Exactly(1));
+	EXPECT_CALL(primaryClient, setClipboardDirty(kClipboardClipboard, true)).Times(Exactly(2));
+
+	Server server(serverConfig, &primaryClient, &serverScreen, &m_events, false);
+	server.m_mock = true;
+	server.adoptClient(&clientProxy);
+	m_clientProxy = &clientProxy;
+
+	// the client grabs its clipboard, then changes it a few times
+	addClipboardEvent(m_events.forClipboard().clipboardGrabbed(), &clientProxy, 1);
+
+	EventQueueTimer* timer = m_events.newTimer(kClipboardChangeInterval, NULL);
+	m_events.adoptHandler(Event::kTimer, timer,
+		new TMethodEventJob<ServerTests>(
+			this, &ServerTests::handleClipboardChangeTimer));
+
+	m_events.initQuitTimeout(5);
+	m_events.loop();
+	m_events.removeHandler(Event::kTimer, timer);
+	m_events.deleteTimer(timer);
+	m_events.cleanupQuitTimeout();
+
+	EXPECT_EQ(kClipboardChangeCount, m_clipboardReads);
+	EXPECT_EQ(0, m_clipboardReadsOnEventLoop);
+}
+
+TEST_F(ServerTests, mouseMovePrimary_headingForNeighbor_prefetchesClipboard)
+{
+	NiceMock<MockScreen> serverScreen;
+	NiceMock<MockPrimaryClient> primaryClient("server");
+	NiceMock<MockConfig> serverConfig;
+	NiceMock<MockInputFilter> serverInputFilter;
+	NiceMock<MockClientProxy> clientProxy("stub");
+
+	serverConfig.addScreen("server");
+	serverConfig.addScreen("stub");
+	serverConfig.connect("server", kRight, 0.0f, 1.0f, "stub", 0.0f, 1.0f);
+
+	ON_CALL(serverConfig, isScreen(_)).WillByDefault(Return(true));
+	ON_CALL(serverConfig, getInputFilter()).WillByDefault(Return(&serverInputFilter));
+	ON_CALL(primaryClient, getEventTarget()).WillByDefault(Return(&primaryClient));
+	ON_CALL(primaryClient, getShape(_, _, _, _)).WillByDefault(Invoke(getWideScreenShape));
+	ON_CALL(primaryClient, getJumpZoneSize()).WillByDefault(Return(1));
+	ON_CALL(clientProxy, getEventTarget()).WillByDefault(Return(&clientProxy));
+	ON_CALL(clientProxy, getShape(_, _, _, _)).WillByDefault(Invoke(getWideScreenShape));
+
+	// the clipboards are sent before the cursor gets to the edge
+	EXPECT_CALL(clientProxy, setClipboard(_, _)).Times(AtLeast(1));
+	EXPECT_CALL(clientProxy, enter(_, _, _, _, _)).Times(Exactly(0));
+
+	Server server(serverConfig, &primaryClient, &serverScreen, &m_events, false);
+	server.m_mock = true;
+	server.adoptClient(&clientProxy);
+	m_server = &server;
+
+	EventQueueTimer* timer = m_events.newTimer(kMoveInterval, NULL);
+	m_events.adoptHandler(Event::kTimer, timer,
+		new TMethodEventJob<ServerTests>(
+			this, &ServerTests::handleMoveTimer));
+
+	m_events.initQuitTimeout(5);
+	m_events.loop();
+	m_events.removeHandler(Event::kTimer, timer);
+	m_events.deleteTimer(timer);
+	m_events.cleanupQuitTimeout();
+}
+
+TEST_F(ServerTests, mouseMovePrimary_slowTowardsNeighbor_noPrefetch)
+{
+	NiceMock<MockScreen> serverScreen;
+	NiceMock<MockPrimaryClient> primaryClient("server");
+	NiceMock<MockConfig> serverConfig;
+	NiceMock<MockInputFilter> serverInputFilter;
+	NiceMock<MockClientProxy> clientProxy("stub");
+
+	serverConfig.addScreen("server");
+	serverConfig.addScreen("stub");
+	serverConfig.connect("server", kRight, 0.0f, 1.0f, "stub", 0.0f, 1.0f);
+
+	ON_CALL(serverConfig, isScreen(_)).WillByDefault(Return(true));
+	ON_CALL(serverConfig, getInputFilter()).WillByDefault(Return(&serverInputFilter));
+	ON_CALL(primaryClient, getEventTarget()).WillByDefault(Return(&primaryClient));
+	ON_CALL(primaryClient, getShape(_, _, _, _)).WillByDefault(Invoke(getWideScreenShape));
+	ON_CALL(primaryClient, getJumpZoneSize()).WillByDefault(Return(1));
+	ON_CALL(clientProxy, getEventTarget()).WillByDefault(Return(&clientProxy));
+	ON_CALL(clientProxy, getShape(_, _, _, _)).WillByDefault(Invoke(getWideScreenShape));
+
+	EXPECT_CALL(clientProxy, setClipboard(_, _)).Times(Exactly(0));
+
+	Server server(serverConfig, &primaryClient, &serverScreen, &m_events, false);
+	server.m_mock = true;
+	server.adoptClient(&clientProxy);
+	m_server = &server;
+
+	// 100 pixels a second is far below the prefetch speed
+	m_moveX    = kMoveEndX - 10 * kSlowMoveStep;
+	m_moveStep = kSlowMoveStep;
+
+	EventQueueTimer* timer = m_events.newTimer(kMoveInterval, NULL);
+	m_events.adoptHandler(Event::kTimer, timer,
+		new TMethodEventJob<ServerTests>(
+			this, &ServerTests::handleMoveTimer));
+
+	m_events.initQuitTimeout(5);
+	m_events.loop();
+	m_events.removeHandler(Event::kTimer, timer);
+	m_events.deleteTimer(timer);
+	m_events.cleanupQuitTimeout();
+}
+
+void
+ServerTests::sendClipboard(ClipboardID id, const IClipboard* clipboard)
+{
+	String data = IClipboard::marshall(clipboard);
+	if (StreamChunker::sendClipboard(data, data.size(), id, 0,
+			&m_events, m_clientProxy, NULL)) {
+		++m_clipboardSends;
+		m_clipboardTime += m_stopwatch.getTime() - m_leaveTime;
+	}
+}
+
+bool
+ServerTests::getChangedClipboard(ClipboardID, IClipboard* clipboard)
+{
+	if (Thread::getCurrentThread() == m_eventLoopThread) {
+		++m_clipboardReadsOnEventLoop;
+	}
+
+	int change = m_clipboardReads++ % kClipboardChangeCount;
+	clipboard->open(0);
+	clipboard->empty();
+	clipboard->add(IClipboard::kText, kClipboardChanges[change]);
+	clipboard->close();
+	return true;
+}
+
+void
+ServerTests::addClipboardEvent(Event::Type type, void* target,
+				UInt32 sequenceNumber)
+{
+	IScreen::ClipboardInfo* info =
+		(IScreen::ClipboardInfo*)malloc(sizeof(IScreen::ClipboardInfo));
+	info->m_id = kClipboardClipboard;
+	info->m_sequenceNumber = sequenceNumber;
+	m_events.addEvent(Event(type, target, info));
+}
+
+void
+ServerTests::handleCrossingTimer(const Event&, void*)
+{
+	if (m_crossings == kCrossings) {
+		// don't let the sending thread outlive the test
+		if (!m_server->isSendingClipboard()) {
+			m_events.raiseQuitEvent();
+		}
+		return;
+	}
+
+	// even crossings leave the primary screen, odd ones come back
+	BaseClientProxy* screen =
+		(m_crossings % 2 == 0) ? m_clientProxy : m_primaryClient;
+
+	if (screen == m_clientProxy) {
+		m_leaveTime = m_stopwatch.getTime();
+	}
+
+	Stopwatch stopwatch;
+	m_server->jumpTo(screen);
+	double time = stopwatch.getTime();
+
+	m_totalTime += time;
+	if (time > m_maxTime) {
+		m_maxTime = time;
+	}
+	++m_crossings;
+}
+
+void
+ServerTests::handleMoveTimer(const Event&, void*)
+{
+	if (m_moveX > kMoveEndX) {
+		// don't let the sending thread outlive the test
+		if (!m_server->isSendingClipboard()) {
+			m_events.raiseQuitEvent();
+		}
+		return;
+	}
+
+	m_server->moveOnPrimary(m_moveX, 500);
+	m_moveX += m_moveStep;
+}
+
+void
+ServerTests::handleClipboardChangeTimer(const Event&, void*)
+{
+	if (m_clipboardChanges == kClipboardChangeCount) {
+		m_events.raiseQuitEvent();
+		return;
+	}
+
+	addClipboardEvent(m_events.forClipboard().clipboardChanged(),
+		m_clientProxy, 1);
+	++m_clipboardChanges;
+}
+
+void
+ServerTests::handleQuitTimer(const Event&, void*)
+{
+	m_events.raiseQuitEvent();
+}
+
+void
+getServerScreenShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h)
+{
+	x = 0;
+	y = 0;
+	w = 1;
+	h = 1;
+}
+
+void
+getWideScreenShape(SInt32& x, SInt32& y, SInt32& w, SInt32& h)
+{
+	x = 0;
+	y = 0;
+	w = 1920;
+	h = 1080;
+}
+
+void
+getCursorOrigin(SInt32& x, SInt32& y)
+{
+	x = 0;
+	y = 0;
+}
+
+bool
+getLargeClipboard(ClipboardID, IClipboard* clipboard)
+{
+	static const String data(kLargeClipboardSize, 'x');
+
+	clipboard->open(0);
+	clipboard->empty();
+	clipboard->add(IClipboard::kText, data);
+	clipboard->close();
+	return true;
+}
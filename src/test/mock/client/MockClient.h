@@ -0,0 +1,37 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#define TEST_ENV
+
+#include "client/Client.h"
+
+#include "test/global/gmock.h"
+
+class MockClient : public Client
+{
+public:
+	MockClient(ClientArgs* args) : Client(*args) { }
+	MOCK_METHOD0(handshakeComplete, void());
+	MOCK_METHOD5(enter, void(SInt32, SInt32, UInt32, KeyModifierMask, bool));
+	MOCK_METHOD0(leave, bool());
+	MOCK_METHOD3(keyDown, void(KeyID, KeyModifierMask, KeyButton));
+	MOCK_METHOD4(keyRepeat, void(KeyID, KeyModifierMask, SInt32, KeyButton));
+	MOCK_METHOD3(keyUp, void(KeyID, KeyModifierMask, KeyButton));
+	MOCK_METHOD1(setOptions, void(const OptionsList&));
+};
@@ -41,4 +41,5 @@ public:
 	MOCK_CONST_METHOD0(getEventTarget, void*());
 	MOCK_CONST_METHOD0(isReady, bool());
 	MOCK_CONST_METHOD0(getSize, UInt32());
+	MOCK_CONST_METHOD0(getUnsentSize, UInt32());
 };
@@ -27,7 +27,9 @@
 class MockPrimaryClient : public PrimaryClient
 {
 public:
+	MockPrimaryClient(const String& name = "") : PrimaryClient(name) { }
 	MOCK_CONST_METHOD0(getEventTarget, void*());
+	MOCK_CONST_METHOD0(getJumpZoneSize, SInt32());
 	MOCK_CONST_METHOD2(getCursorPos, void(SInt32&, SInt32&));
 	MOCK_CONST_METHOD2(setJumpCursorPos, void(SInt32, SInt32));
 	MOCK_METHOD1(reconfigure, void(UInt32));
@@ -38,4 +40,11 @@ public:
 	MOCK_METHOD2(registerHotKey, UInt32(KeyID, KeyModifierMask));
 	MOCK_CONST_METHOD0(getToggleMask, KeyModifierMask());
 	MOCK_METHOD1(unregisterHotKey, void(UInt32));
+	MOCK_CONST_METHOD4(getShape, void(SInt32&, SInt32&, SInt32&, SInt32&));
+	MOCK_CONST_METHOD2(getClipboard, bool(ClipboardID, IClipboard*));
+	MOCK_METHOD2(setClipboard, void(ClipboardID, const IClipboard*));
+	MOCK_METHOD1(grabClipboard, void(ClipboardID));
+	MOCK_METHOD2(setClipboardDirty, void(ClipboardID, bool));
+	MOCK_METHOD5(enter, void(SInt32, SInt32, UInt32, KeyModifierMask, bool));
+	MOCK_METHOD0(leave, bool());
 };
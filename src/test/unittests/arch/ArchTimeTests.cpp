@@ -0,0 +1,68 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "arch/Arch.h"
+
+#include "test/global/gtest.h"
+
+// long enough to measure, short enough to keep the tests quick
+static const double kSleepTime = 0.05;
+
+// allowance for the scheduler waking us late
+static const double kSleepTolerance = 0.5;
+
+static const double kNanoseconds = 1.0e9;
+
+TEST(ArchTimeTests, ticks_repeated_neverGoesBackwards)
+{
+	UInt64 last = ARCH->ticks();
+	for (int i = 0; i < 100000; ++i) {
+		UInt64 now = ARCH->ticks();
+		ASSERT_LE(last, now);
+		last = now;
+	}
+}
+
+TEST(ArchTimeTests, ticks_sleep_countsNanoseconds)
+{
+	UInt64 start = ARCH->ticks();
+	ARCH->sleep(kSleepTime);
+	double elapsed = static_cast<double>(ARCH->ticks() - start) / kNanoseconds;
+
+	EXPECT_LE(kSleepTime, elapsed);
+	EXPECT_GT(kSleepTime + kSleepTolerance, elapsed);
+}
+
+TEST(ArchTimeTests, coarseTicks_sleep_tracksTicks)
+{
+	// the coarse clock may lag by its resolution, a few milliseconds
+	UInt64 start = ARCH->coarseTicks();
+	ARCH->sleep(kSleepTime);
+	double elapsed = static_cast<double>(ARCH->coarseTicks() - start) / kNanoseconds;
+
+	EXPECT_LE(kSleepTime - 0.02, elapsed);
+	EXPECT_GT(kSleepTime + kSleepTolerance, elapsed);
+}
+
+TEST(ArchTimeTests, time_sameClockAsTicks)
+{
+	double ticks = static_cast<double>(ARCH->ticks()) / kNanoseconds;
+	double time  = ARCH->time();
+
+	EXPECT_LE(ticks, time);
+	EXPECT_GT(ticks + kSleepTolerance, time);
+}
@@ -0,0 +1,133 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Synergy Si Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test/global/TestEventQueue.h"
+#include "base/TMethodEventJob.h"
+
+#include "test/global/gtest.h"
+
+#include <vector>
+
+class EventQueueTests : public ::testing::Test
+{
+public:
+	EventQueueTests() : m_count(0), m_lastData(NULL) { }
+
+	void				handleEvent(const Event& event, void*)
+	{
+		++m_count;
+		m_lastData = event.getData();
+	}
+
+	// records which timer fired and quits after the second
+	void				handleTimer(const Event& event, void*)
+	{
+		m_targets.push_back(event.getTarget());
+		if (m_targets.size() == 2) {
+			m_events.raiseQuitEvent();
+		}
+	}
+
+public:
+	TestEventQueue		m_events;
+	int					m_count;
+	void*				m_lastData;
+	std::vector<void*>	m_targets;
+};
+
+TEST_F(EventQueueTests, addEvent_collapsible_latestDeliveredOnce)
+{
+	Event::Type type = m_events.forIStream().inputReady();
+	m_events.adoptHandler(type, this,
+		new TMethodEventJob<EventQueueTests>(
+			this, &EventQueueTests::handleEvent));
+
+	void* data = NULL;
+	for (int i = 0; i < 3; ++i) {
+		data = malloc(1);
+		m_events.addEvent(Event(type, this, data, Event::kCollapse));
+	}
+	m_events.raiseQuitEvent();
+
+	m_events.initQuitTimeout(5);
+	m_events.loop();
+	m_events.cleanupQuitTimeout();
+	m_events.removeHandler(type, this);
+
+	EXPECT_EQ(1, m_count);
+	EXPECT_TRUE(data == m_lastData);
+}
+
+TEST_F(EventQueueTests, addEvent_notCollapsible_allDelivered)
+{
+	Event::Type type = m_events.forIStream().inputReady();
+	m_events.adoptHandler(type, this,
+		new TMethodEventJob<EventQueueTests>(
+			this, &EventQueueTests::handleEvent));
+
+	for (int i = 0; i < 3; ++i) {
+		m_events.addEvent(Event(type, this));
+	}
+	m_events.raiseQuitEvent();
+
+	m_events.initQuitTimeout(5);
+	m_events.loop();
+	m_events.cleanupQuitTimeout();
+	m_events.removeHandler(type, this);
+
+	EXPECT_EQ(3, m_count);
+}
+
+TEST_F(EventQueueTests, getRegisteredType_qualifiedName_type)
+{
+	EXPECT_EQ(m_events.forIDataSocket().connected(),
+		m_events.getRegisteredType("IDataSocketEvents::connected"));
+	EXPECT_EQ(m_events.forClient().connected(),
+		m_events.getRegisteredType("ClientEvents::connected"));
+}
+
+TEST_F(EventQueueTests, getRegisteredType_bareName_unknown)
+{
+	// several classes have a "connected" event
+	EXPECT_EQ(Event::kUnknown, m_events.getRegisteredType("connected"));
+	EXPECT_EQ(Event::kUnknown, m_events.getRegisteredType("Events::connected"));
+}
+
+TEST_F(EventQueueTests, newOneShotTimer_twoTimers_earliestDeadlineFirst)
+{
+	int late, early;
+	m_events.adoptHandler(Event::kTimer, &late,
+		new TMethodEventJob<EventQueueTests>(
+			this, &EventQueueTests::handleTimer));
+	m_events.adoptHandler(Event::kTimer, &early,
+		new TMethodEventJob<EventQueueTests>(
+			this, &EventQueueTests::handleTimer));
+	EventQueueTimer* lateTimer  = m_events.newOneShotTimer(0.2, &late);
+	EventQueueTimer* earlyTimer = m_events.newOneShotTimer(0.05, &early);
+
+	m_events.initQuitTimeout(5);
+	m_events.loop();
+	m_events.cleanupQuitTimeout();
+	m_events.deleteTimer(earlyTimer);
+	m_events.deleteTimer(lateTimer);
+	m_events.removeHandler(Event::kTimer, &early);
+	m_events.removeHandler(Event::kTimer, &late);
+
+	ASSERT_EQ(2u, m_targets.size());
+	EXPECT_TRUE(m_targets[0] == &early);
+	EXPECT_TRUE(m_targets[1] == &late);
+}
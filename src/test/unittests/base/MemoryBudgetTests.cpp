@@ -0,0 +1,71 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2014 Synergy Si Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/MemoryBudget.h"
+#include "io/StreamBuffer.h"
+
+#include "test/global/gtest.h"
+
+TEST(MemoryBudgetTests, reserve_overLimit_refused)
+{
+	MemoryBudget budget;
+	MemoryBudget::setLimit(1000);
+
+	EXPECT_TRUE(MemoryBudget::reserve(MemoryBudget::kClipboards, 600));
+	EXPECT_FALSE(MemoryBudget::reserve(MemoryBudget::kFileTransfers, 600));
+	EXPECT_EQ(600U, MemoryBudget::getUsed());
+	EXPECT_FALSE(MemoryBudget::isExhausted());
+
+	MemoryBudget::release(MemoryBudget::kClipboards, 600);
+	EXPECT_TRUE(MemoryBudget::reserve(MemoryBudget::kFileTransfers, 600));
+}
+
+TEST(MemoryBudgetTests, charge_overLimit_exhausted)
+{
+	MemoryBudget budget;
+	MemoryBudget::setLimit(1000);
+
+	MemoryBudget::charge(MemoryBudget::kStreamBuffers, 1500);
+
+	EXPECT_TRUE(MemoryBudget::isExhausted());
+	EXPECT_FALSE(MemoryBudget::isAvailable(1));
+	EXPECT_EQ(1500U, MemoryBudget::getUsed(MemoryBudget::kStreamBuffers));
+}
+
+TEST(MemoryBudgetTests, streamBuffer_writeAndPop_accounted)
+{
+	MemoryBudget budget;
+	char data[100] = { 0 };
+	{
+		StreamBuffer buffer;
+		buffer.write(data, sizeof(data));
+		buffer.write(data, sizeof(data));
+		EXPECT_EQ(200U, MemoryBudget::getUsed(MemoryBudget::kStreamBuffers));
+
+		buffer.pop(50);
+		EXPECT_EQ(150U, MemoryBudget::getUsed(MemoryBudget::kStreamBuffers));
+	}
+
+	EXPECT_EQ(0U, MemoryBudget::getUsed());
+}
+
+TEST(MemoryBudgetTests, noBudget_unlimited)
+{
+	EXPECT_TRUE(MemoryBudget::reserve(MemoryBudget::kClipboards, 1 << 30));
+	EXPECT_FALSE(MemoryBudget::isExhausted());
+	EXPECT_EQ(0U, MemoryBudget::getUsed());
+}
@@ -0,0 +1,90 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/Stopwatch.h"
+#include "arch/Arch.h"
+
+#include "test/global/gtest.h"
+
+// long enough to measure, short enough to keep the tests quick
+static const double kSleepTime = 0.05;
+
+// allowance for the scheduler waking us late
+static const double kSleepTolerance = 0.5;
+
+TEST(StopwatchTests, getTime_running_measuresSleep)
+{
+	Stopwatch stopwatch;
+
+	ARCH->sleep(kSleepTime);
+	double t = stopwatch.getTime();
+
+	EXPECT_LE(kSleepTime, t);
+	EXPECT_GT(kSleepTime + kSleepTolerance, t);
+}
+
+TEST(StopwatchTests, getTime_triggered_startsAtZero)
+{
+	Stopwatch stopwatch(true);
+
+	ARCH->sleep(kSleepTime);
+	EXPECT_TRUE(stopwatch.isStopped());
+	EXPECT_EQ(0.0, stopwatch.getTime());
+	EXPECT_FALSE(stopwatch.isStopped());
+
+	ARCH->sleep(kSleepTime);
+	EXPECT_LE(kSleepTime, stopwatch.getTime());
+}
+
+TEST(StopwatchTests, stop_sleepWhileStopped_notCounted)
+{
+	Stopwatch stopwatch;
+	ARCH->sleep(kSleepTime);
+	stopwatch.stop();
+	double stopped = stopwatch.getTime();
+
+	ARCH->sleep(kSleepTime);
+
+	EXPECT_EQ(stopped, stopwatch.getTime());
+
+	stopwatch.start();
+	ARCH->sleep(kSleepTime);
+	double t = stopwatch.getTime();
+
+	EXPECT_LE(stopped + kSleepTime, t);
+	EXPECT_GT(stopped + kSleepTime + kSleepTolerance, t);
+}
+
+TEST(StopwatchTests, reset_running_returnsElapsedAndRestarts)
+{
+	Stopwatch stopwatch;
+	ARCH->sleep(kSleepTime);
+
+	EXPECT_LE(kSleepTime, stopwatch.reset());
+	EXPECT_GT(kSleepTime, stopwatch.getTime());
+}
+
+TEST(StopwatchTests, reset_stopped_staysStoppedAtZero)
+{
+	Stopwatch stopwatch;
+	ARCH->sleep(kSleepTime);
+	stopwatch.stop();
+
+	EXPECT_LE(kSleepTime, stopwatch.reset());
+	EXPECT_TRUE(stopwatch.isStopped());
+	EXPECT_EQ(0.0, stopwatch.getTime());
+}
@@ -0,0 +1,238 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test/mock/client/MockClient.h"
+#include "test/mock/io/MockStream.h"
+#include "test/mock/synergy/MockEventQueue.h"
+
+#include "client/ServerProxy.h"
+#include "synergy/protocol_types.h"
+#include "synergy/option_types.h"
+#include "base/IEventJob.h"
+
+#include "test/global/gtest.h"
+
+#include <cstring>
+#include <map>
+#include <string>
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+static const KeyID kKeyA = 0x61;
+static const KeyButton kButtonA = 38;
+static const KeyButton kButtonB = 56;
+
+class ServerProxyTests : public ::testing::Test
+{
+public:
+	typedef std::map<void*, IEventJob*> TimerJobs;
+
+	ServerProxyTests() :
+		m_client(&m_args),
+		m_stream(new NiceMock<MockStream>),
+		m_timers(0),
+		m_lastTimer(NULL),
+		m_lastDuration(0.0),
+		m_proxy(NULL)
+	{
+		ON_CALL(m_events, forIStream()).WillByDefault(ReturnRef(m_streamEvents));
+		ON_CALL(m_events, forClipboard()).WillByDefault(ReturnRef(m_clipboardEvents));
+		ON_CALL(m_events, newOneShotTimer(_, _)).WillByDefault(
+			Invoke(this, &ServerProxyTests::newOneShotTimer));
+		ON_CALL(m_events, adoptHandler(_, _, _)).WillByDefault(
+			Invoke(this, &ServerProxyTests::adoptHandler));
+		ON_CALL(m_events, removeHandler(_, _)).WillByDefault(
+			Invoke(this, &ServerProxyTests::removeHandler));
+		ON_CALL(*m_stream, getEventTarget()).WillByDefault(Return(this));
+		ON_CALL(*m_stream, read(_, _)).WillByDefault(
+			Invoke(this, &ServerProxyTests::read));
+
+		m_proxy = new ServerProxy(&m_client, m_stream, &m_events);
+	}
+
+	~ServerProxyTests()
+	{
+		delete m_proxy;
+		delete m_stream;
+		for (TimerJobs::iterator i = m_timerJobs.begin(); i != m_timerJobs.end(); ++i) {
+			delete i->second;
+		}
+		for (size_t i = 0; i < m_jobs.size(); ++i) {
+			delete m_jobs[i];
+		}
+	}
+
+	EventQueueTimer*	newOneShotTimer(double duration, void*)
+	{
+		// any unique pointer will do
+		m_lastTimer    = reinterpret_cast<EventQueueTimer*>(&m_timerTargets[m_timers++]);
+		m_lastDuration = duration;
+		return m_lastTimer;
+	}
+
+	void				adoptHandler(Event::Type type, void* target, IEventJob* job)
+	{
+		if (type == Event::kTimer) {
+			delete m_timerJobs[target];
+			m_timerJobs[target] = job;
+		}
+		else {
+			m_jobs.push_back(job);
+		}
+	}
+
+	void				removeHandler(Event::Type type, void* target)
+	{
+		if (type == Event::kTimer) {
+			TimerJobs::iterator i = m_timerJobs.find(target);
+			if (i != m_timerJobs.end()) {
+				delete i->second;
+				m_timerJobs.erase(i);
+			}
+		}
+	}
+
+	UInt32				read(void* buffer, UInt32 n)
+	{
+		n = std::min<UInt32>(n, static_cast<UInt32>(m_input.size()));
+		memcpy(buffer, m_input.data(), n);
+		m_input.erase(0, n);
+		return n;
+	}
+
+	// deliver messages from the server
+	void				receive(const std::string& messages)
+	{
+		m_input += messages;
+		m_proxy->handleDataForTest();
+	}
+
+	// run the most recently created timer as if it expired
+	void				fireLastTimer()
+	{
+		TimerJobs::iterator i = m_timerJobs.find(m_lastTimer);
+		ASSERT_TRUE(i != m_timerJobs.end());
+		i->second->run(Event(Event::kTimer, m_lastTimer));
+	}
+
+	bool				hasTimerHandler(EventQueueTimer* timer) const
+	{
+		return m_timerJobs.count(timer) != 0;
+	}
+
+	// the bytes each message is sent as
+	static std::string	uint16(UInt16 v)
+	{
+		std::string bytes;
+		bytes += static_cast<char>((v >> 8) & 0xff);
+		bytes += static_cast<char>(v & 0xff);
+		return bytes;
+	}
+
+	static std::string	uint32(UInt32 v)
+	{
+		return uint16(static_cast<UInt16>(v >> 16)) +
+				uint16(static_cast<UInt16>(v & 0xffff));
+	}
+
+	static std::string	setOptions(bool local, UInt32 delay, UInt32 rate)
+	{
+		std::string message(kMsgDSetOptions, 4);
+		message += uint32(6);
+		message += uint32(kOptionClientKeyRepeat) + uint32(local ? 1 : 0);
+		message += uint32(kOptionKeyRepeatDelay)  + uint32(delay);
+		message += uint32(kOptionKeyRepeatRate)   + uint32(rate);
+		return message;
+	}
+
+	static std::string	key(const char* code, KeyID id, KeyButton button)
+	{
+		return std::string(code, 4) + uint16(static_cast<UInt16>(id)) +
+				uint16(0) + uint16(button);
+	}
+
+public:
+	ClientArgs			m_args;
+	NiceMock<MockClient>	m_client;
+	NiceMock<MockEventQueue>	m_events;
+	IStreamEvents		m_streamEvents;
+	ClipboardEvents		m_clipboardEvents;
+	NiceMock<MockStream>*	m_stream;
+	int					m_timerTargets[64];
+	int					m_timers;
+	EventQueueTimer*	m_lastTimer;
+	double				m_lastDuration;
+	TimerJobs			m_timerJobs;
+	std::vector<IEventJob*>	m_jobs;
+	std::string			m_input;
+	ServerProxy*		m_proxy;
+};
+
+TEST_F(ServerProxyTests, keyDown_localRepeat_repeatsAfterDelayAtRate)
+{
+	receive(setOptions(true, 250, 20));
+	receive(key(kMsgDKeyDown, kKeyA, kButtonA));
+
+	EXPECT_DOUBLE_EQ(0.25, m_lastDuration);
+
+	EXPECT_CALL(m_client, keyRepeat(kKeyA, 0, 1, kButtonA)).Times(2);
+	fireLastTimer();
+	EXPECT_DOUBLE_EQ(0.05, m_lastDuration);
+	fireLastTimer();
+	EXPECT_DOUBLE_EQ(0.05, m_lastDuration);
+}
+
+TEST_F(ServerProxyTests, keyUp_repeatingKey_stopsRepeat)
+{
+	receive(setOptions(true, 250, 20));
+	receive(key(kMsgDKeyDown, kKeyA, kButtonA));
+	EventQueueTimer* repeatTimer = m_lastTimer;
+
+	EXPECT_CALL(m_events, deleteTimer(_)).Times(AnyNumber());
+	EXPECT_CALL(m_events, deleteTimer(repeatTimer));
+	EXPECT_CALL(m_client, keyRepeat(_, _, _, _)).Times(0);
+	EXPECT_CALL(m_client, keyUp(kKeyA, 0, kButtonA));
+	receive(key(kMsgDKeyUp, kKeyA, kButtonA));
+
+	EXPECT_FALSE(hasTimerHandler(repeatTimer));
+}
+
+TEST_F(ServerProxyTests, keyUp_otherKey_keepsRepeating)
+{
+	receive(setOptions(true, 250, 20));
+	receive(key(kMsgDKeyDown, kKeyA, kButtonA));
+	EventQueueTimer* repeatTimer = m_lastTimer;
+
+	receive(key(kMsgDKeyUp, kKeyA, kButtonB));
+
+	EXPECT_TRUE(hasTimerHandler(repeatTimer));
+}
+
+TEST_F(ServerProxyTests, keyDown_remoteRepeat_noRepeatTimer)
+{
+	receive(setOptions(false, 250, 20));
+	int timers = m_timers;
+
+	receive(key(kMsgDKeyDown, kKeyA, kButtonA));
+
+	EXPECT_EQ(timers, m_timers);
+}
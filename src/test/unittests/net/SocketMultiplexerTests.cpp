@@ -0,0 +1,122 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "arch/Arch.h"
+
+// the test makes its sockets with socketpair()
+#if SYSAPI_UNIX
+
+#include "net/SocketMultiplexer.h"
+#include "net/TSocketMultiplexerMethodJob.h"
+
+#include "test/global/gtest.h"
+
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+
+class SocketMultiplexerTests : public ::testing::Test
+{
+public:
+	SocketMultiplexerTests() :
+		m_socket(NULL),
+		m_reads(0)
+	{
+		m_fds[0] = -1;
+		m_fds[1] = -1;
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, m_fds) == 0) {
+			m_socket             = new ArchSocketImpl;
+			m_socket->m_fd       = m_fds[0];
+			m_socket->m_refCount = 1;
+		}
+	}
+
+	~SocketMultiplexerTests()
+	{
+		if (m_socket != NULL) {
+			ARCH->closeSocket(m_socket);
+		}
+		if (m_fds[1] != -1) {
+			close(m_fds[1]);
+		}
+	}
+
+	// the multiplexer only uses the socket as a key
+	ISocket*			getKey()
+	{
+		return reinterpret_cast<ISocket*>(this);
+	}
+
+	ISocketMultiplexerJob*
+						serviceSocket(ISocketMultiplexerJob* job,
+							bool read, bool, bool)
+	{
+		char c;
+		if (read && ::read(m_fds[0], &c, 1) == 1) {
+			++m_reads;
+		}
+		return job;
+	}
+
+public:
+	int					m_fds[2];
+	ArchSocket			m_socket;
+	int					m_reads;
+};
+
+TEST_F(SocketMultiplexerTests, endPoll_reactorSocketReadable_jobRunsInline)
+{
+	ASSERT_TRUE(m_socket != NULL);
+
+	SocketMultiplexer reactor(true);
+	EXPECT_TRUE(reactor.isReactor());
+	reactor.addSocket(getKey(),
+		new TSocketMultiplexerMethodJob<SocketMultiplexerTests>(
+			this, &SocketMultiplexerTests::serviceSocket,
+			m_socket, true, false));
+	ASSERT_EQ(1, write(m_fds[1], "x", 1));
+
+	// poll the way an event queue buffer does
+	SocketMultiplexer::PollEntries entries;
+	reactor.beginPoll(entries);
+	ASSERT_EQ(1u, entries.size());
+	EXPECT_EQ(IArchNetwork::kPOLLIN, entries[0].m_events);
+
+	struct pollfd pfd;
+	pfd.fd      = ARCH->getPollFdOnSocket(entries[0].m_socket);
+	pfd.events  = POLLIN;
+	pfd.revents = 0;
+	ASSERT_EQ(m_fds[0], pfd.fd);
+	ASSERT_EQ(1, poll(&pfd, 1, 1000));
+	entries[0].m_revents = ((pfd.revents & POLLIN) != 0) ?
+							IArchNetwork::kPOLLIN : 0;
+
+	// no thread of its own, so the job has run once this returns
+	EXPECT_EQ(0, m_reads);
+	EXPECT_TRUE(reactor.endPoll(entries));
+	EXPECT_EQ(1, m_reads);
+
+	reactor.removeSocket(getKey());
+}
+
+TEST_F(SocketMultiplexerTests, getPollFdOnSocket_null_isInvalid)
+{
+	EXPECT_EQ(-1, ARCH->getPollFdOnSocket(NULL));
+}
+
+#endif
@@ -0,0 +1,124 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/BulkLoop.h"
+
+#include "mt/Thread.h"
+#include "arch/Arch.h"
+#include "base/IJob.h"
+
+#include "test/global/gtest.h"
+
+#include <vector>
+
+// long enough that the test gets ahead of the loop
+static const double kSlowJobTime = 0.1;
+
+// records that it ran, where, and that it was deleted
+class RecordingJob : public IJob {
+public:
+	RecordingJob(int id, std::vector<int>* runs, int* deletes,
+				double delay = 0.0) :
+		m_id(id),
+		m_runs(runs),
+		m_deletes(deletes),
+		m_delay(delay),
+		m_onCaller(NULL),
+		m_caller(Thread::getCurrentThread()) { }
+	virtual ~RecordingJob() { ++*m_deletes; }
+
+	void				setOnCaller(bool* onCaller) { m_onCaller = onCaller; }
+
+	// IJob overrides
+	virtual void		run()
+	{
+		if (m_delay > 0.0) {
+			ARCH->sleep(m_delay);
+		}
+		if (m_onCaller != NULL) {
+			*m_onCaller = (Thread::getCurrentThread() == m_caller);
+		}
+		m_runs->push_back(m_id);
+	}
+
+private:
+	int					m_id;
+	std::vector<int>*	m_runs;
+	int*				m_deletes;
+	double				m_delay;
+	bool*				m_onCaller;
+	Thread				m_caller;
+};
+
+TEST(BulkLoopTests, post_threeJobs_runInOrderOnLoopThread)
+{
+	std::vector<int> runs;
+	int deletes = 0;
+	bool onCaller = true;
+	BulkLoop loop;
+
+	RecordingJob* first = new RecordingJob(1, &runs, &deletes, kSlowJobTime);
+	first->setOnCaller(&onCaller);
+	loop.post(first);
+	loop.post(new RecordingJob(2, &runs, &deletes));
+	loop.post(new RecordingJob(3, &runs, &deletes));
+	loop.flush();
+
+	ASSERT_EQ(3u, runs.size());
+	EXPECT_EQ(1, runs[0]);
+	EXPECT_EQ(2, runs[1]);
+	EXPECT_EQ(3, runs[2]);
+	EXPECT_EQ(3, deletes);
+	EXPECT_FALSE(onCaller);
+}
+
+TEST(BulkLoopTests, flush_slowJobRunning_waitsForIt)
+{
+	std::vector<int> runs;
+	int deletes = 0;
+	BulkLoop loop;
+
+	loop.post(new RecordingJob(1, &runs, &deletes, kSlowJobTime));
+	loop.flush();
+
+	EXPECT_EQ(1u, runs.size());
+	EXPECT_EQ(1, deletes);
+}
+
+TEST(BulkLoopTests, flush_noJobs_returns)
+{
+	BulkLoop loop;
+	loop.flush();
+}
+
+TEST(BulkLoopTests, destructor_jobsQueued_deletedWithoutRunning)
+{
+	std::vector<int> runs;
+	int deletes = 0;
+	{
+		BulkLoop loop;
+
+		// the loop is busy with (or about to drop) the first job when
+		// it's stopped, so the second never runs
+		loop.post(new RecordingJob(1, &runs, &deletes, kSlowJobTime));
+		loop.post(new RecordingJob(2, &runs, &deletes));
+	}
+
+	EXPECT_EQ(2, deletes);
+	EXPECT_TRUE(runs.size() <= 1);
+	EXPECT_TRUE(runs.empty() || runs[0] == 1);
+}
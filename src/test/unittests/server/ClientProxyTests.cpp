@@ -0,0 +1,305 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxy1_0.h"
+#include "server/ClientProxy1_7.h"
+#include "synergy/protocol_types.h"
+#include "synergy/option_types.h"
+#include "base/IEventJob.h"
+#include "test/mock/io/MockStream.h"
+#include "test/mock/server/MockServer.h"
+#include "test/mock/synergy/MockEventQueue.h"
+
+#include "test/global/gtest.h"
+
+#include <string>
+#include <vector>
+
+using ::testing::_;
+using ::testing::AnyNumber;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+// more than the proxy lets pile up before it holds motion back
+static const UInt32 kBackedUp = 1024 * 1024;
+
+class ClientProxyTests : public ::testing::Test
+{
+public:
+	ClientProxyTests() :
+		m_stream(new NiceMock<MockStream>),
+		m_unsent(0),
+		m_timer(reinterpret_cast<EventQueueTimer*>(&m_timerTarget)),
+		m_timerJob(NULL),
+		m_flushedJob(NULL),
+		m_proxy(NULL)
+	{
+		ON_CALL(m_events, forIStream()).WillByDefault(ReturnRef(m_streamEvents));
+		ON_CALL(m_events, newTimer(_, _)).WillByDefault(Return(m_timer));
+		ON_CALL(m_events, adoptHandler(_, _, _)).WillByDefault(
+			Invoke(this, &ClientProxyTests::adoptHandler));
+		ON_CALL(*m_stream, getEventTarget()).WillByDefault(Return(this));
+		ON_CALL(*m_stream, write(_, _)).WillByDefault(
+			Invoke(this, &ClientProxyTests::write));
+		ON_CALL(*m_stream, getUnsentSize()).WillByDefault(
+			Invoke(this, &ClientProxyTests::getUnsentSize));
+
+		// the proxy adopts the stream
+		m_proxy = new ClientProxy1_0("client", m_stream, &m_events);
+		m_output.clear();
+	}
+
+	~ClientProxyTests()
+	{
+		delete m_proxy;
+		for (size_t i = 0; i < m_jobs.size(); ++i) {
+			delete m_jobs[i];
+		}
+	}
+
+	void				adoptHandler(Event::Type type, void* target, IEventJob* job)
+	{
+		m_jobs.push_back(job);
+		if (type == Event::kTimer && target == m_timer) {
+			m_timerJob = job;
+		}
+		else if (type == m_streamEvents.outputFlushed()) {
+			m_flushedJob = job;
+		}
+	}
+
+	void				write(const void* data, UInt32 size)
+	{
+		m_output.append(static_cast<const char*>(data), size);
+	}
+
+	UInt32				getUnsentSize()
+	{
+		return m_unsent;
+	}
+
+	// run the motion timer as if it fired
+	void				fireTimer()
+	{
+		ASSERT_TRUE(m_timerJob != NULL);
+		m_timerJob->run(Event(Event::kTimer, m_timer));
+	}
+
+	void				fireOutputFlushed()
+	{
+		ASSERT_TRUE(m_flushedJob != NULL);
+		m_flushedJob->run(Event(m_streamEvents.outputFlushed(), this));
+	}
+
+	// the bytes a mouse move to \p x,y is written as
+	static std::string	mouseMove(SInt16 x, SInt16 y)
+	{
+		std::string message(kMsgDMouseMove, 4);
+		message += static_cast<char>((x >> 8) & 0xff);
+		message += static_cast<char>(x & 0xff);
+		message += static_cast<char>((y >> 8) & 0xff);
+		message += static_cast<char>(y & 0xff);
+		return message;
+	}
+
+public:
+	NiceMock<MockEventQueue>	m_events;
+	IStreamEvents		m_streamEvents;
+	NiceMock<MockStream>*	m_stream;
+	UInt32				m_unsent;
+	int					m_timerTarget;
+	EventQueueTimer*	m_timer;
+	IEventJob*			m_timerJob;
+	IEventJob*			m_flushedJob;
+	std::vector<IEventJob*>	m_jobs;
+	std::string			m_output;
+	ClientProxy1_0*		m_proxy;
+};
+
+TEST_F(ClientProxyTests, mouseMove_notBackedUp_writesEachMoveWithoutSampling)
+{
+	EXPECT_CALL(*m_stream, getUnsentSize()).Times(0);
+
+	m_proxy->mouseMove(1, 2);
+	m_proxy->mouseMove(3, 4);
+
+	EXPECT_EQ(mouseMove(1, 2) + mouseMove(3, 4), m_output);
+}
+
+TEST_F(ClientProxyTests, mouseMove_backedUp_coalescesToLatest)
+{
+	m_proxy->mouseMove(1, 1);
+	m_unsent = kBackedUp;
+	fireTimer();
+	m_output.clear();
+
+	m_proxy->mouseMove(2, 2);
+	m_proxy->mouseMove(3, 3);
+	EXPECT_TRUE(m_output.empty());
+
+	m_unsent = 0;
+	fireTimer();
+	EXPECT_EQ(mouseMove(3, 3), m_output);
+}
+
+TEST_F(ClientProxyTests, keyDown_motionHeld_flushesMotionFirst)
+{
+	m_proxy->mouseMove(1, 1);
+	m_unsent = kBackedUp;
+	fireTimer();
+	m_output.clear();
+
+	m_proxy->mouseMove(5, 6);
+	m_proxy->keyDown(0x61, 0, 0);
+
+	ASSERT_EQ(mouseMove(5, 6), m_output.substr(0, 8));
+	EXPECT_EQ(std::string(kMsgDKeyDown1_0, 4), m_output.substr(8, 4));
+}
+
+TEST_F(ClientProxyTests, handleOutputFlushed_drained_sendsHeldMotion)
+{
+	m_proxy->mouseMove(1, 1);
+	m_unsent = kBackedUp;
+	fireTimer();
+	m_proxy->mouseMove(7, 8);
+	m_output.clear();
+
+	m_unsent = 0;
+	fireOutputFlushed();
+
+	EXPECT_EQ(mouseMove(7, 8), m_output);
+}
+
+class ClientProxy1_7Tests : public ::testing::Test
+{
+public:
+	ClientProxy1_7Tests() :
+		m_stream(new NiceMock<MockStream>),
+		m_holdTimer(reinterpret_cast<EventQueueTimer*>(&m_holdTimerTarget)),
+		m_holdJob(NULL),
+		m_proxy(NULL)
+	{
+		ON_CALL(m_events, forIStream()).WillByDefault(ReturnRef(m_streamEvents));
+		ON_CALL(m_events, forFile()).WillByDefault(ReturnRef(m_fileEvents));
+		ON_CALL(m_events, forClipboard()).WillByDefault(ReturnRef(m_clipboardEvents));
+		ON_CALL(m_events, newTimer(kKeyRepeatHoldRate, _)).WillByDefault(
+			Return(m_holdTimer));
+		ON_CALL(m_events, adoptHandler(_, _, _)).WillByDefault(
+			Invoke(this, &ClientProxy1_7Tests::adoptHandler));
+		ON_CALL(m_events, removeHandler(_, _)).WillByDefault(
+			Invoke(this, &ClientProxy1_7Tests::removeHandler));
+		ON_CALL(*m_stream, getEventTarget()).WillByDefault(Return(this));
+		ON_CALL(*m_stream, write(_, _)).WillByDefault(
+			Invoke(this, &ClientProxy1_7Tests::write));
+
+		// the proxy adopts the stream
+		m_proxy = new ClientProxy1_7("client", m_stream, &m_server, &m_events);
+
+		// the client repeats keys itself
+		OptionsList options;
+		options.push_back(kOptionClientKeyRepeat);
+		options.push_back(1);
+		m_proxy->setOptions(options);
+		m_output.clear();
+	}
+
+	~ClientProxy1_7Tests()
+	{
+		delete m_proxy;
+		for (size_t i = 0; i < m_jobs.size(); ++i) {
+			delete m_jobs[i];
+		}
+	}
+
+	void				adoptHandler(Event::Type type, void* target, IEventJob* job)
+	{
+		m_jobs.push_back(job);
+		if (type == Event::kTimer && target == m_holdTimer) {
+			m_holdJob = job;
+		}
+	}
+
+	void				removeHandler(Event::Type type, void* target)
+	{
+		if (type == Event::kTimer && target == m_holdTimer) {
+			m_holdJob = NULL;
+		}
+	}
+
+	void				write(const void* data, UInt32 size)
+	{
+		m_output.append(static_cast<const char*>(data), size);
+	}
+
+	// run the key hold timer as if it fired
+	void				fireHoldTimer()
+	{
+		ASSERT_TRUE(m_holdJob != NULL);
+		m_holdJob->run(Event(Event::kTimer, m_holdTimer));
+	}
+
+public:
+	NiceMock<MockEventQueue>	m_events;
+	MockServer			m_server;
+	IStreamEvents		m_streamEvents;
+	FileEvents			m_fileEvents;
+	ClipboardEvents		m_clipboardEvents;
+	NiceMock<MockStream>*	m_stream;
+	int					m_holdTimerTarget;
+	EventQueueTimer*	m_holdTimer;
+	IEventJob*			m_holdJob;
+	std::vector<IEventJob*>	m_jobs;
+	std::string			m_output;
+	ClientProxy1_7*		m_proxy;
+};
+
+TEST_F(ClientProxy1_7Tests, keyDown_localRepeat_holdTimerSendsNoop)
+{
+	m_proxy->keyDown(0x61, 0, 38);
+	m_output.clear();
+
+	fireHoldTimer();
+	fireHoldTimer();
+
+	EXPECT_EQ(std::string(kMsgCNoop, 4) + std::string(kMsgCNoop, 4), m_output);
+}
+
+TEST_F(ClientProxy1_7Tests, keyRepeat_localRepeat_notSent)
+{
+	m_proxy->keyDown(0x61, 0, 38);
+	m_output.clear();
+
+	m_proxy->keyRepeat(0x61, 0, 1, 38);
+
+	EXPECT_TRUE(m_output.empty());
+}
+
+TEST_F(ClientProxy1_7Tests, keyUp_lastHeldKey_holdTimerRemoved)
+{
+	m_proxy->keyDown(0x61, 0, 38);
+	m_proxy->keyDown(0x62, 0, 56);
+
+	m_proxy->keyUp(0x61, 0, 38);
+	EXPECT_TRUE(m_holdJob != NULL);
+
+	EXPECT_CALL(m_events, deleteTimer(_)).Times(AnyNumber());
+	EXPECT_CALL(m_events, deleteTimer(m_holdTimer));
+	m_proxy->keyUp(0x62, 0, 56);
+	EXPECT_TRUE(m_holdJob == NULL);
+}
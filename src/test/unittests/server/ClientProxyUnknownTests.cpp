@@ -0,0 +1,187 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/ClientProxyUnknown.h"
+#include "synergy/protocol_types.h"
+#include "base/IEventJob.h"
+#include "test/mock/io/MockStream.h"
+#include "test/mock/server/MockServer.h"
+#include "test/mock/synergy/MockEventQueue.h"
+
+#include "test/global/gtest.h"
+
+#include <cstring>
+#include <vector>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+using ::testing::ReturnRef;
+
+static const double kTimeout = 30.0;
+
+class ClientProxyUnknownTests : public ::testing::Test
+{
+public:
+	ClientProxyUnknownTests() :
+		m_stream(new NiceMock<MockStream>),
+		m_pending(0),
+		m_timer(reinterpret_cast<EventQueueTimer*>(&m_timerTarget)),
+		m_timers(0),
+		m_failures(0),
+		m_timerJob(NULL),
+		m_dataJob(NULL),
+		m_client(NULL)
+	{
+		ON_CALL(m_events, forIStream()).WillByDefault(ReturnRef(m_streamEvents));
+		ON_CALL(m_events, forClientProxyUnknown()).WillByDefault(
+			ReturnRef(m_unknownEvents));
+		ON_CALL(m_events, newOneShotTimer(_, _)).WillByDefault(
+			Invoke(this, &ClientProxyUnknownTests::newOneShotTimer));
+		ON_CALL(m_events, adoptHandler(_, _, _)).WillByDefault(
+			Invoke(this, &ClientProxyUnknownTests::adoptHandler));
+		ON_CALL(m_events, addEvent(_)).WillByDefault(
+			Invoke(this, &ClientProxyUnknownTests::addEvent));
+		ON_CALL(*m_stream, getEventTarget()).WillByDefault(Return(this));
+		ON_CALL(*m_stream, getSize()).WillByDefault(
+			Invoke(this, &ClientProxyUnknownTests::getSize));
+		ON_CALL(*m_stream, read(_, _)).WillByDefault(
+			Invoke(this, &ClientProxyUnknownTests::read));
+
+		// the client adopts the stream
+		m_client = new ClientProxyUnknown(m_stream, kTimeout, &m_server, &m_events);
+	}
+
+	~ClientProxyUnknownTests()
+	{
+		delete m_client;
+		for (size_t i = 0; i < m_jobs.size(); ++i) {
+			delete m_jobs[i];
+		}
+	}
+
+	EventQueueTimer*	newOneShotTimer(double, void*)
+	{
+		++m_timers;
+		return m_timer;
+	}
+
+	void				adoptHandler(Event::Type type, void*, IEventJob* job)
+	{
+		m_jobs.push_back(job);
+		if (type == Event::kTimer) {
+			m_timerJob = job;
+		}
+		else if (type == m_streamEvents.inputReady()) {
+			m_dataJob = job;
+		}
+	}
+
+	void				addEvent(const Event& event)
+	{
+		if (event.getType() == m_unknownEvents.failure()) {
+			++m_failures;
+		}
+	}
+
+	UInt32				getSize()
+	{
+		return m_pending;
+	}
+
+	UInt32				read(void* buffer, UInt32 n)
+	{
+		memcpy(buffer, kMsgCKeepAlive, n);
+		m_pending = 0;
+		return n;
+	}
+
+	// deliver a keep alive from a standby client
+	void				keepAlive()
+	{
+		ASSERT_TRUE(m_dataJob != NULL);
+		m_pending = 4;
+		m_dataJob->run(Event(m_streamEvents.inputReady(), this));
+	}
+
+	// run the handshake timer as if it expired
+	void				fireTimer()
+	{
+		ASSERT_TRUE(m_timerJob != NULL);
+		m_timerJob->run(Event(Event::kTimer, m_timer));
+	}
+
+public:
+	NiceMock<MockEventQueue>	m_events;
+	MockServer			m_server;
+	IStreamEvents		m_streamEvents;
+	ClientProxyUnknownEvents	m_unknownEvents;
+	NiceMock<MockStream>*	m_stream;
+	UInt32				m_pending;
+	int					m_timerTarget;
+	EventQueueTimer*	m_timer;
+	int					m_timers;
+	int					m_failures;
+	IEventJob*			m_timerJob;
+	IEventJob*			m_dataJob;
+	std::vector<IEventJob*>	m_jobs;
+	ClientProxyUnknown*	m_client;
+};
+
+TEST_F(ClientProxyUnknownTests, handleTimeout_noKeepAlive_fails)
+{
+	fireTimer();
+
+	EXPECT_EQ(1, m_failures);
+}
+
+TEST_F(ClientProxyUnknownTests, keepAlive_beforeTimeout_doesNotRestartTimer)
+{
+	keepAlive();
+	keepAlive();
+	keepAlive();
+
+	EXPECT_EQ(1, m_timers);
+	EXPECT_EQ(0, m_failures);
+}
+
+TEST_F(ClientProxyUnknownTests, handleTimeout_afterKeepAlive_restartsTimerOnce)
+{
+	keepAlive();
+	fireTimer();
+
+	EXPECT_EQ(2, m_timers);
+	EXPECT_EQ(0, m_failures);
+
+	// no keep alive during the second timeout
+	fireTimer();
+
+	EXPECT_EQ(2, m_timers);
+	EXPECT_EQ(1, m_failures);
+}
+
+TEST_F(ClientProxyUnknownTests, handleTimeout_standbyHeldTooLong_fails)
+{
+	while (m_failures == 0 && m_timers < 1000) {
+		keepAlive();
+		fireTimer();
+	}
+
+	EXPECT_EQ(1, m_failures);
+	EXPECT_EQ(121, m_timers);
+}
@@ -0,0 +1,100 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2016 Synergy Si Ltd.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/Config.h"
+#include "test/mock/synergy/MockEventQueue.h"
+
+#include <sstream>
+
+#include "test/global/gtest.h"
+
+using ::testing::NiceMock;
+
+static const char* s_config =
+	"# generated\n"
+	"section: screens\n"
+	"\tserver:   \r\n"
+	"  client1:\n"
+	"\tclient2:\n"
+	"end\n"
+	"section: aliases\n"
+	"\tclient1:\n"
+	"\t\tlaptop # the old name\n"
+	"end\n"
+	"section: links\n"
+	"\tserver:\n"
+	"\t\tright(0,50) = client1\n"
+	"\t\tright(50,100) = client2(0,50)\n"
+	"\tclient1:\n"
+	"\t\tleft = server\n"
+	"end\n";
+
+TEST(ConfigTests, read_linksAndAliases_readAsWritten)
+{
+	NiceMock<MockEventQueue> eventQueue;
+	Config config(&eventQueue);
+	std::istringstream stream(s_config);
+
+	stream >> config;
+
+	EXPECT_TRUE(config.isScreen("laptop"));
+	EXPECT_EQ("client1", config.getCanonicalName("laptop"));
+	EXPECT_EQ("client1", config.getNeighbor("server", kRight, 0.25f, NULL));
+
+	float position;
+	EXPECT_EQ("client2", config.getNeighbor("server", kRight, 0.75f, &position));
+	EXPECT_FLOAT_EQ(0.25f, position);
+	EXPECT_EQ("server", config.getNeighbor("laptop", kLeft, 0.5f, NULL));
+}
+
+TEST(ConfigTests, read_linksFromAlias_throws)
+{
+	NiceMock<MockEventQueue> eventQueue;
+	Config config(&eventQueue);
+	std::istringstream stream(
+		"section: screens\n"
+		"\tserver:\n"
+		"end\n"
+		"section: aliases\n"
+		"\tserver:\n"
+		"\t\tdesk\n"
+		"end\n"
+		"section: links\n"
+		"\tdesk:\n"
+		"\t\tleft = server\n"
+		"end\n");
+
+	EXPECT_THROW(stream >> config, XConfigRead);
+}
+
+TEST(ConfigTests, read_overlappingLinks_throws)
+{
+	NiceMock<MockEventQueue> eventQueue;
+	Config config(&eventQueue);
+	std::istringstream stream(
+		"section: screens\n"
+		"\tserver:\n"
+		"\tclient:\n"
+		"end\n"
+		"section: links\n"
+		"\tserver:\n"
+		"\t\tright(0,60) = client\n"
+		"\t\tright(40,100) = client\n"
+		"end\n");
+
+	EXPECT_THROW(stream >> config, XConfigRead);
+}
@@ -0,0 +1,130 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "server/EdgePredictor.h"
+
+#include "test/global/gtest.h"
+
+// predict edges reached within 0.25s at 300 pixels a second or more.
+// the speed after a pause of more than 0.1s is taken from that move
+// alone, so the tests set it with one 0.2s move.
+static EdgePredictor
+newPredictor()
+{
+	return EdgePredictor(0.25, 300.0, 0.1);
+}
+
+TEST(EdgePredictorTests, addMotion_twoMoves_averagesSpeed)
+{
+	EdgePredictor predictor = newPredictor();
+
+	predictor.addMotion(200, -200, 0.2);
+	predictor.addMotion(30, 0, 0.01);
+
+	EXPECT_DOUBLE_EQ(2000.0, predictor.getXSpeed());
+	EXPECT_DOUBLE_EQ(-500.0, predictor.getYSpeed());
+}
+
+TEST(EdgePredictorTests, addMotion_afterPause_restartsSpeed)
+{
+	EdgePredictor predictor = newPredictor();
+
+	predictor.addMotion(100, 0, 0.01);
+	predictor.addMotion(20, 0, 0.2);
+
+	EXPECT_DOUBLE_EQ(100.0, predictor.getXSpeed());
+}
+
+TEST(EdgePredictorTests, addMotion_noTime_ignored)
+{
+	EdgePredictor predictor = newPredictor();
+
+	predictor.addMotion(100, 100, 0.0);
+
+	EXPECT_EQ(0.0, predictor.getXSpeed());
+	EXPECT_EQ(0.0, predictor.getYSpeed());
+}
+
+TEST(EdgePredictorTests, predictEdge_fastTowardsRight_right)
+{
+	EdgePredictor predictor = newPredictor();
+
+	// 1000 pixels a second, 200 pixels from the right edge
+	predictor.addMotion(200, 0, 0.2);
+
+	EXPECT_EQ(kRight, predictor.predictEdge(1719, 500, 0, 0, 1920, 1080));
+}
+
+TEST(EdgePredictorTests, predictEdge_fastTowardsLeft_left)
+{
+	EdgePredictor predictor = newPredictor();
+
+	predictor.addMotion(-200, 0, 0.2);
+
+	EXPECT_EQ(kLeft, predictor.predictEdge(200, 500, 0, 0, 1920, 1080));
+}
+
+TEST(EdgePredictorTests, predictEdge_farFromEdge_none)
+{
+	EdgePredictor predictor = newPredictor();
+
+	// would take 0.5s to reach the right edge
+	predictor.addMotion(200, 0, 0.2);
+
+	EXPECT_EQ(kNoDirection, predictor.predictEdge(1419, 500, 0, 0, 1920, 1080));
+}
+
+TEST(EdgePredictorTests, predictEdge_slow_none)
+{
+	EdgePredictor predictor = newPredictor();
+
+	// 200 pixels a second, right by the edge
+	predictor.addMotion(40, 0, 0.2);
+
+	EXPECT_EQ(kNoDirection, predictor.predictEdge(1915, 500, 0, 0, 1920, 1080));
+}
+
+TEST(EdgePredictorTests, predictEdge_diagonal_nearestEdge)
+{
+	EdgePredictor predictor = newPredictor();
+
+	// the bottom edge is 0.1s away, the right edge 0.2s
+	predictor.addMotion(200, 200, 0.2);
+
+	EXPECT_EQ(kBottom, predictor.predictEdge(1719, 979, 0, 0, 1920, 1080));
+	EXPECT_EQ(kRight, predictor.predictEdge(1819, 879, 0, 0, 1920, 1080));
+}
+
+TEST(EdgePredictorTests, predictEdge_offsetScreen_usesShape)
+{
+	EdgePredictor predictor = newPredictor();
+
+	predictor.addMotion(0, -200, 0.2);
+
+	EXPECT_EQ(kTop, predictor.predictEdge(500, 1100, 0, 1000, 1920, 1080));
+	EXPECT_EQ(kNoDirection, predictor.predictEdge(500, 1500, 0, 1000, 1920, 1080));
+}
+
+TEST(EdgePredictorTests, reset_afterMotion_none)
+{
+	EdgePredictor predictor = newPredictor();
+	predictor.addMotion(200, 0, 0.2);
+
+	predictor.reset();
+
+	EXPECT_EQ(kNoDirection, predictor.predictEdge(1915, 500, 0, 0, 1920, 1080));
+}
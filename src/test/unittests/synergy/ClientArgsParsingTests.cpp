@@ -51,6 +51,22 @@ TEST(ClientArgsParsingTests, parseClientArgs_yScrollArg_setYScroll)
 	EXPECT_EQ(1, clientArgs.m_yscroll);
 }
 
+#if WINAPI_XWINDOWS
+TEST(ClientArgsParsingTests, parseClientArgs_reactorArg_setReactor)
+{
+	NiceMock<MockArgParser> argParser;
+	ON_CALL(argParser, parseGenericArgs(_, _, _)).WillByDefault(Invoke(client_stubParseGenericArgs));
+	ON_CALL(argParser, checkUnexpectedArgs()).WillByDefault(Invoke(client_stubCheckUnexpectedArgs));
+	ClientArgs clientArgs;
+	const int argc = 3;
+	const char* kReactorCmd[argc] = { "stub", "--reactor", "mock_address" };
+
+	argParser.parseClientArgs(clientArgs, argc, kReactorCmd);
+
+	EXPECT_EQ(true, clientArgs.m_reactor);
+}
+#endif
+
 TEST(ClientArgsParsingTests, parseClientArgs_addressArg_setSynergyAddress)
 {
 	NiceMock<MockArgParser> argParser;
@@ -66,6 +82,24 @@ TEST(ClientArgsParsingTests, parseClientArgs_addressArg_setSynergyAddress)
 	EXPECT_EQ(true, result);
 }
 
+TEST(ClientArgsParsingTests, parseClientArgs_addressList_setStandbyAddresses)
+{
+	NiceMock<MockArgParser> argParser;
+	ON_CALL(argParser, parseGenericArgs(_, _, _)).WillByDefault(Invoke(client_stubParseGenericArgs));
+	ON_CALL(argParser, checkUnexpectedArgs()).WillByDefault(Invoke(client_stubCheckUnexpectedArgs));
+	ClientArgs clientArgs;
+	const int argc = 2;
+	const char* kAddressCmd[argc] = { "stub", "primary,backup:24801,spare" };
+
+	bool result = argParser.parseClientArgs(clientArgs, argc, kAddressCmd);
+
+	EXPECT_EQ("primary", clientArgs.m_synergyAddress);
+	ASSERT_EQ(2U, clientArgs.m_standbyAddresses.size());
+	EXPECT_EQ("backup:24801", clientArgs.m_standbyAddresses[0]);
+	EXPECT_EQ("spare", clientArgs.m_standbyAddresses[1]);
+	EXPECT_EQ(true, result);
+}
+
 TEST(ClientArgsParsingTests, parseClientArgs_noAddressArg_returnFalse)
 {
 	NiceMock<MockArgParser> argParser;
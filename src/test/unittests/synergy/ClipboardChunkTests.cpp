@@ -17,9 +17,45 @@
 
 #include "synergy/ClipboardChunk.h"
 #include "synergy/protocol_types.h"
+#include "base/MemoryBudget.h"
+#include "test/mock/io/MockStream.h"
 
 #include "test/global/gtest.h"
 
+#include <cstring>
+
+using ::testing::_;
+using ::testing::Invoke;
+
+// the clipboard messages read by the stream, less their codes
+static String s_messages;
+static size_t s_messagesRead = 0;
+
+static void
+queueMessage(ClipboardID id, UInt8 mark, const String& content)
+{
+	UInt32 size = static_cast<UInt32>(content.size());
+	s_messages.push_back(static_cast<char>(id));
+	s_messages.append(4, '\0');
+	s_messages.push_back(static_cast<char>(mark));
+	s_messages.push_back(static_cast<char>((size >> 24) & 0xff));
+	s_messages.push_back(static_cast<char>((size >> 16) & 0xff));
+	s_messages.push_back(static_cast<char>((size >>  8) & 0xff));
+	s_messages.push_back(static_cast<char>( size        & 0xff));
+	s_messages.append(content);
+}
+
+static UInt32
+readMessages(void* buffer, UInt32 size)
+{
+	if (s_messagesRead + size > s_messages.size()) {
+		size = static_cast<UInt32>(s_messages.size() - s_messagesRead);
+	}
+	memcpy(buffer, s_messages.data() + s_messagesRead, size);
+	s_messagesRead += size;
+	return size;
+}
+
 TEST(ClipboardChunkTests, start_formatStartChunk)
 {
 	ClipboardID id = 0;
@@ -74,3 +110,35 @@ TEST(ClipboardChunkTests, end_formatDataChunk)
 
 	delete chunk;
 }
+
+TEST(ClipboardChunkTests, assemble_oneStreamRejected_otherStreamFinishes)
+{
+	MemoryBudget budget;
+	MemoryBudget::setLimit(1000);
+	s_messages.clear();
+	s_messagesRead = 0;
+	MockStream stream;
+	ON_CALL(stream, read(_, _)).WillByDefault(Invoke(readMessages));
+	ClipboardReceiveState rejected;
+	ClipboardReceiveState accepted;
+	ClipboardID id;
+	UInt32 sequence;
+
+	// the first stream starts a clipboard too large for the budget,
+	// the second a small one, and their chunks interleave
+	queueMessage(0, kDataStart, "5000");
+	queueMessage(0, kDataStart, "4");
+	queueMessage(0, kDataChunk, "mock");
+	queueMessage(0, kDataChunk, "data");
+	queueMessage(0, kDataEnd, "");
+	queueMessage(0, kDataEnd, "");
+
+	EXPECT_EQ(kError, ClipboardChunk::assemble(&stream, rejected, id, sequence));
+	EXPECT_EQ(kStart, ClipboardChunk::assemble(&stream, accepted, id, sequence));
+	EXPECT_EQ(kNotFinish, ClipboardChunk::assemble(&stream, rejected, id, sequence));
+	EXPECT_EQ(kNotFinish, ClipboardChunk::assemble(&stream, accepted, id, sequence));
+	EXPECT_EQ(kError, ClipboardChunk::assemble(&stream, rejected, id, sequence));
+	EXPECT_EQ(kFinish, ClipboardChunk::assemble(&stream, accepted, id, sequence));
+	EXPECT_EQ("data", accepted.getData());
+	EXPECT_TRUE(rejected.getData().empty());
+}
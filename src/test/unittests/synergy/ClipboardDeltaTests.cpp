@@ -0,0 +1,115 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/ClipboardDelta.h"
+#include "synergy/ClipboardHistory.h"
+
+#include "test/global/gtest.h"
+
+static String
+makeText(size_t size)
+{
+	String text;
+	text.reserve(size);
+	UInt32 seed = 1;
+	while (text.size() < size) {
+		seed = seed * 1103515245 + 12345;
+		text += static_cast<char>('a' + (seed >> 16) % 26);
+	}
+	return text;
+}
+
+TEST(ClipboardDeltaTests, encode_smallEdit_smallDeltaThatDecodes)
+{
+	String base = makeText(100000);
+	String target = base;
+	target.insert(50000, "inserted text");
+	target.erase(1000, 10);
+
+	String delta = ClipboardDelta::encode(base, target);
+	String result;
+
+	EXPECT_LT(delta.size(), 1000U);
+	EXPECT_TRUE(ClipboardDelta::decode(base, delta, result));
+	EXPECT_TRUE(result == target);
+}
+
+TEST(ClipboardDeltaTests, encode_unrelatedData_decodes)
+{
+	String base = makeText(5000);
+	String target(3000, 'z');
+
+	String delta = ClipboardDelta::encode(base, target);
+	String result;
+
+	EXPECT_TRUE(ClipboardDelta::decode(base, delta, result));
+	EXPECT_TRUE(result == target);
+}
+
+TEST(ClipboardDeltaTests, decode_truncatedDelta_fails)
+{
+	String base = makeText(10000);
+	String target = base + "tail";
+	String delta = ClipboardDelta::encode(base, target);
+	String result;
+
+	EXPECT_FALSE(ClipboardDelta::decode(base, delta.substr(0, delta.size() - 1), result));
+}
+
+TEST(ClipboardDeltaTests, decode_copyPastEndOfBase_fails)
+{
+	String base = makeText(10000);
+	String delta = ClipboardDelta::encode(base, base);
+	String result;
+
+	EXPECT_FALSE(ClipboardDelta::decode(base.substr(0, 100), delta, result));
+}
+
+TEST(ClipboardDeltaTests, history_acknowledgedBase_sendsDeltaThatPeerApplies)
+{
+	ClipboardHistory sender;
+	ClipboardHistory receiver;
+	String first = makeText(100000);
+	String second = first + "more";
+	String delta;
+	UInt32 baseHash, targetHash;
+
+	EXPECT_FALSE(sender.prepareSend(kClipboardClipboard, first, delta, baseHash, targetHash));
+	UInt32 ack = receiver.receivedFull(kClipboardClipboard, first);
+	EXPECT_EQ(targetHash, ack);
+	EXPECT_TRUE(sender.acknowledged(kClipboardClipboard, ack));
+
+	EXPECT_TRUE(sender.prepareSend(kClipboardClipboard, second, delta, baseHash, targetHash));
+	ack = receiver.receivedDelta(kClipboardClipboard, delta, baseHash, targetHash);
+	EXPECT_EQ(targetHash, ack);
+	EXPECT_TRUE(delta == second);
+}
+
+TEST(ClipboardDeltaTests, history_rejectedDelta_sendsFullNextTime)
+{
+	ClipboardHistory sender;
+	String first = makeText(100000);
+	String delta;
+	UInt32 baseHash, targetHash;
+
+	sender.prepareSend(kClipboardClipboard, first, delta, baseHash, targetHash);
+	sender.acknowledged(kClipboardClipboard, targetHash);
+	sender.prepareSend(kClipboardClipboard, first + "x", delta, baseHash, targetHash);
+
+	EXPECT_FALSE(sender.acknowledged(kClipboardClipboard, 0));
+	EXPECT_FALSE(sender.prepareSend(kClipboardClipboard, first + "y", delta, baseHash, targetHash));
+}
@@ -0,0 +1,356 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ * 
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ * 
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/FileChunk.h"
+#include "synergy/StreamChunker.h"
+#include "synergy/protocol_types.h"
+#include "test/mock/io/MockFileStream.h"
+#include "test/mock/io/MockStream.h"
+#include "base/IJob.h"
+
+#include "test/global/gtest.h"
+
+#include <cstdio>
+#include <cstring>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::Return;
+
+static UInt8 s_fileHeader[13];
+static IJob* s_fileDone = NULL;
+
+// the file transfer messages read by the stream, less their codes
+static String s_messages;
+static size_t s_messagesRead = 0;
+
+// the bytes written to the stream
+static String s_written;
+
+static void
+queueMessage(UInt8 mark, const String& content)
+{
+	UInt32 size = static_cast<UInt32>(content.size());
+	s_messages.push_back(static_cast<char>(mark));
+	s_messages.push_back(static_cast<char>((size >> 24) & 0xff));
+	s_messages.push_back(static_cast<char>((size >> 16) & 0xff));
+	s_messages.push_back(static_cast<char>((size >>  8) & 0xff));
+	s_messages.push_back(static_cast<char>( size        & 0xff));
+	s_messages.append(content);
+}
+
+static void
+queueChunk(FileChunk* chunk)
+{
+	queueMessage(chunk->m_chunk[0], String(&chunk->m_chunk[1], chunk->m_dataSize));
+	delete chunk;
+}
+
+static void
+queueFile(UInt32 id, UInt32 index, const String& data)
+{
+	UInt8* bytes = reinterpret_cast<UInt8*>(const_cast<char*>(data.data()));
+	UInt32 checksum = FileChunk::updateChecksum(
+						FileChunk::kChecksumInit, bytes, data.size());
+
+	queueChunk(FileChunk::transferStart(id, index, data.size(), 0));
+	queueChunk(FileChunk::checkedData(bytes, data.size(), checksum));
+	queueChunk(FileChunk::end());
+}
+
+static UInt32
+readMessages(void* buffer, UInt32 size)
+{
+	if (s_messagesRead + size > s_messages.size()) {
+		size = static_cast<UInt32>(s_messages.size() - s_messagesRead);
+	}
+	memcpy(buffer, s_messages.data() + s_messagesRead, size);
+	s_messagesRead += size;
+	return size;
+}
+
+static void
+saveWritten(const void* buffer, UInt32 size)
+{
+	s_written.append(static_cast<const char*>(buffer), size);
+}
+
+static bool
+saveFileHeader(const void* header, UInt32 headerSize,
+				int, size_t, UInt32, IJob* done, IJob* truncated)
+{
+	memcpy(s_fileHeader, header, headerSize);
+	s_fileDone = done;
+	delete truncated;
+	return true;
+}
+
+TEST(FileChunkTests, updateChecksum_knownValue)
+{
+	const UInt8 data[] = "Wikipedia";
+	UInt32 checksum = FileChunk::updateChecksum(FileChunk::kChecksumInit, data, 9);
+
+	EXPECT_EQ(0x11E60398u, checksum);
+}
+
+TEST(FileChunkTests, updateChecksum_rollingMatchesWhole)
+{
+	UInt8 data[20000];
+	for (size_t i = 0; i < sizeof(data); ++i) {
+		data[i] = static_cast<UInt8>(i * 7 + 3);
+	}
+
+	UInt32 whole = FileChunk::updateChecksum(FileChunk::kChecksumInit, data, sizeof(data));
+	UInt32 rolling = FileChunk::updateChecksum(FileChunk::kChecksumInit, data, 1234);
+	rolling = FileChunk::updateChecksum(rolling, data + 1234, sizeof(data) - 1234);
+
+	EXPECT_EQ(whole, rolling);
+}
+
+TEST(FileChunkTests, transferStart_parseTransferStart)
+{
+	FileChunk* chunk = FileChunk::transferStart(42, 3, 1000, 512);
+	EXPECT_EQ(kDataTransferStart, chunk->m_chunk[0]);
+
+	UInt32 id = 0;
+	UInt32 index = 0;
+	size_t size = 0;
+	size_t offset = 0;
+	String content(&chunk->m_chunk[1], chunk->m_dataSize);
+	EXPECT_TRUE(FileChunk::parseTransferStart(content, id, index, size, offset));
+	EXPECT_EQ(42u, id);
+	EXPECT_EQ(3u, index);
+	EXPECT_EQ(1000u, size);
+	EXPECT_EQ(512u, offset);
+
+	delete chunk;
+}
+
+TEST(FileChunkTests, parseTransferStart_rejectsBadHeader)
+{
+	UInt32 id = 0;
+	UInt32 index = 0;
+	size_t size = 0;
+	size_t offset = 0;
+
+	EXPECT_FALSE(FileChunk::parseTransferStart("1,2,3", id, index, size, offset));
+	EXPECT_FALSE(FileChunk::parseTransferStart("1,,3,0", id, index, size, offset));
+	EXPECT_FALSE(FileChunk::parseTransferStart("1,2,3,4", id, index, size, offset));
+}
+
+TEST(FileChunkTests, checkedData_formatChecksumFirst)
+{
+	UInt8 data[] = "mock";
+	FileChunk* chunk = FileChunk::checkedData(data, 4, 0x01020304);
+
+	EXPECT_EQ(kDataCheckedChunk, chunk->m_chunk[0]);
+	EXPECT_EQ(1, chunk->m_chunk[1]);
+	EXPECT_EQ(2, chunk->m_chunk[2]);
+	EXPECT_EQ(3, chunk->m_chunk[3]);
+	EXPECT_EQ(4, chunk->m_chunk[4]);
+	EXPECT_EQ('m', chunk->m_chunk[5]);
+	EXPECT_EQ('k', chunk->m_chunk[8]);
+	EXPECT_EQ(8u, chunk->m_dataSize);
+
+	delete chunk;
+}
+
+TEST(FileChunkTests, assemble_multiFileSession_completesEachFile)
+{
+	s_messages.clear();
+	s_messagesRead = 0;
+	queueFile(9, 0, "first");
+	queueFile(9, 1, "second");
+
+	MockStream stream;
+	ON_CALL(stream, read(_, _)).WillByDefault(Invoke(readMessages));
+	EXPECT_CALL(stream, read(_, _)).Times(::testing::AnyNumber());
+
+	FileReceiveState state;
+	EXPECT_EQ(kStart, FileChunk::assemble(&stream, state));
+	EXPECT_EQ(kNotFinish, FileChunk::assemble(&stream, state));
+	EXPECT_EQ(kFinish, FileChunk::assemble(&stream, state));
+	EXPECT_EQ(0u, state.getFileIndex());
+	EXPECT_EQ("first", state.getData());
+
+	EXPECT_EQ(kStart, FileChunk::assemble(&stream, state));
+	EXPECT_EQ(1u, state.getFileIndex());
+	EXPECT_TRUE(state.getData().empty());
+	EXPECT_EQ(kNotFinish, FileChunk::assemble(&stream, state));
+	EXPECT_EQ(kFinish, FileChunk::assemble(&stream, state));
+	EXPECT_EQ("second", state.getData());
+	EXPECT_EQ(s_messages.size(), s_messagesRead);
+}
+
+TEST(FileChunkTests, assemble_twoPeers_keepOwnResumePoints)
+{
+	s_messages.clear();
+	s_messagesRead = 0;
+	queueChunk(FileChunk::transferStart(1, 2, 100, 0));
+	queueChunk(FileChunk::transferStart(7, 0, 100, 0));
+
+	MockStream stream;
+	ON_CALL(stream, read(_, _)).WillByDefault(Invoke(readMessages));
+	EXPECT_CALL(stream, read(_, _)).Times(::testing::AnyNumber());
+
+	// each peer's transfer is cut off after its header
+	FileReceiveState first;
+	FileReceiveState second;
+	EXPECT_EQ(kStart, FileChunk::assemble(&stream, first));
+	EXPECT_EQ(kStart, FileChunk::assemble(&stream, second));
+
+	FileTransferResume resume;
+	EXPECT_TRUE(first.getResumePoint(resume));
+	EXPECT_EQ(1u, resume.m_id);
+	EXPECT_EQ(2u, resume.m_fileIndex);
+	EXPECT_TRUE(second.getResumePoint(resume));
+	EXPECT_EQ(7u, resume.m_id);
+	EXPECT_EQ(0u, resume.m_fileIndex);
+
+	second.abortTransfer();
+	EXPECT_FALSE(second.getResumePoint(resume));
+	EXPECT_TRUE(first.getResumePoint(resume));
+}
+
+TEST(FileChunkTests, parseFileRange_validAndBadRanges)
+{
+	int fd = -1;
+	size_t offset = 0;
+	size_t size = 0;
+
+	EXPECT_TRUE(FileChunk::parseFileRange("7,4096,1000", fd, offset, size));
+	EXPECT_EQ(7, fd);
+	EXPECT_EQ(4096u, offset);
+	EXPECT_EQ(1000u, size);
+
+	EXPECT_FALSE(FileChunk::parseFileRange("7,4096", fd, offset, size));
+	EXPECT_FALSE(FileChunk::parseFileRange("7,,1000", fd, offset, size));
+	EXPECT_FALSE(FileChunk::parseFileRange("7,4096,", fd, offset, size));
+}
+
+TEST(FileChunkTests, fileRange_parseFileRange)
+{
+	FileChunk* chunk = FileChunk::fileRange(-1, 512, 1000);
+	EXPECT_EQ(kDataFileRange, static_cast<UInt8>(chunk->m_chunk[0]));
+
+	int fd = 0;
+	size_t offset = 0;
+	size_t size = 0;
+	String content(&chunk->m_chunk[1], chunk->m_dataSize);
+	EXPECT_TRUE(FileChunk::parseFileRange(content, fd, offset, size));
+	EXPECT_EQ(-1, fd);
+	EXPECT_EQ(512u, offset);
+	EXPECT_EQ(1000u, size);
+
+	delete chunk;
+}
+
+TEST(FileChunkTests, sendRange_streamSendsFile_plainChunkHeader)
+{
+	NiceMock<MockFileStream> stream;
+	ON_CALL(stream, canSendFile()).WillByDefault(Return(true));
+	EXPECT_CALL(stream, writeFile(_, 9, 7, 4096, 1000, _, _))
+		.WillOnce(Invoke(saveFileHeader));
+
+	char range[] = "7,4096,1000";
+	FileChunk::sendRange(&stream, range, strlen(range));
+
+	// the same bytes writef() sends ahead of a kDataChunk's data
+	EXPECT_EQ(0, memcmp(s_fileHeader, "DFTR", 4));
+	EXPECT_EQ(kDataChunk, s_fileHeader[4]);
+	EXPECT_EQ(0, s_fileHeader[5]);
+	EXPECT_EQ(0, s_fileHeader[6]);
+	EXPECT_EQ(1000 >> 8, s_fileHeader[7]);
+	EXPECT_EQ(1000 & 0xff, s_fileHeader[8]);
+
+	// the stream would run it once the range is sent
+	ASSERT_TRUE(s_fileDone != NULL);
+	delete s_fileDone;
+	s_fileDone = NULL;
+}
+
+TEST(FileChunkTests, sendRange_streamCantSendFile_chunkReadFromFile)
+{
+	FILE* file = tmpfile();
+	ASSERT_TRUE(file != NULL);
+	fputs("0123456789", file);
+	fflush(file);
+
+	s_written.clear();
+	NiceMock<MockFileStream> stream;
+	ON_CALL(stream, canSendFile()).WillByDefault(Return(false));
+	ON_CALL(stream, write(_, _)).WillByDefault(Invoke(saveWritten));
+	EXPECT_CALL(stream, writeFile(_, _, _, _, _, _, _)).Times(0);
+
+	String range = synergy::string::sprintf("%d,2,5", fileno(file));
+	StreamChunker::init();
+	FileChunk::sendRange(&stream, &range[0], range.size());
+	fclose(file);
+
+	// writef() sends the range read from the file as a kDataChunk
+	ASSERT_EQ(14u, s_written.size());
+	EXPECT_EQ(0, memcmp(s_written.data(), "DFTR", 4));
+	EXPECT_EQ(kDataChunk, static_cast<UInt8>(s_written[4]));
+	EXPECT_EQ("23456", s_written.substr(9));
+}
+
+TEST(FileChunkTests, assemble_rangeEndsEarly_fileDropped)
+{
+	String first("0123456789");
+	String second("second");
+	UInt8* bytes = reinterpret_cast<UInt8*>(const_cast<char*>(first.data()));
+	UInt32 firstSum = FileChunk::updateChecksum(
+						FileChunk::kChecksumInit, bytes, first.size());
+
+	s_messages.clear();
+	s_messagesRead = 0;
+	queueChunk(FileChunk::transferStart(3, 0, 16, 0));
+	queueChunk(FileChunk::checkedData(bytes, first.size(), firstSum));
+
+	// the second part is sent as a range but the file was truncated
+	// before the stream got to it, so the stream pads it with zeros and
+	// the sender aborts the file
+	NiceMock<MockFileStream> sender;
+	ON_CALL(sender, canSendFile()).WillByDefault(Return(true));
+	EXPECT_CALL(sender, writeFile(_, 9, 7, 10, 6, _, _))
+		.WillOnce(Invoke(saveFileHeader));
+	char range[] = "7,10,6";
+	FileChunk::sendRange(&sender, range, strlen(range));
+	s_messages.append(reinterpret_cast<char*>(&s_fileHeader[4]), 5);
+	s_messages.append(second.size(), '\0');
+	queueChunk(FileChunk::abort());
+	delete s_fileDone;
+	s_fileDone = NULL;
+
+	MockStream stream;
+	ON_CALL(stream, read(_, _)).WillByDefault(Invoke(readMessages));
+	EXPECT_CALL(stream, read(_, _)).Times(::testing::AnyNumber());
+
+	// the padding can't be told from data, so the whole file is dropped
+	// and there's nothing to resume from
+	FileReceiveState state;
+	EXPECT_EQ(kStart, FileChunk::assemble(&stream, state));
+	EXPECT_EQ(kNotFinish, FileChunk::assemble(&stream, state));
+	EXPECT_EQ(kNotFinish, FileChunk::assemble(&stream, state));
+	EXPECT_EQ(kError, FileChunk::assemble(&stream, state));
+	EXPECT_EQ(s_messages.size(), s_messagesRead);
+
+	FileTransferResume resume;
+	EXPECT_FALSE(state.getResumePoint(resume));
+	EXPECT_TRUE(state.getData().empty());
+}
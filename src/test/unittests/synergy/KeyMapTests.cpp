@@ -0,0 +1,77 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/KeyMap.h"
+
+#include "test/global/gtest.h"
+
+using synergy::KeyMap;
+
+static KeyMap::KeyItem
+makeKeyItem(KeyID id, SInt32 group, KeyButton button)
+{
+	KeyMap::KeyItem item;
+	item.m_id        = id;
+	item.m_group     = group;
+	item.m_button    = button;
+	item.m_required  = 0;
+	item.m_sensitive = 0;
+	item.m_generates = 0;
+	item.m_dead      = false;
+	item.m_lock      = false;
+	item.m_client    = 0;
+	KeyMap::initModifierKey(item);
+	return item;
+}
+
+TEST(KeyMapTests, collectActiveModifiers_shiftActive_onlyShiftKeysInGroup)
+{
+	KeyMap keyMap;
+	keyMap.addKeyEntry(makeKeyItem(kKeyShift_L, 0, 50));
+	keyMap.addKeyEntry(makeKeyItem(kKeyShift_R, 0, 62));
+	keyMap.addKeyEntry(makeKeyItem(kKeyControl_L, 0, 37));
+	keyMap.addKeyEntry(makeKeyItem(kKeyShift_L, 1, 51));
+	keyMap.addKeyEntry(makeKeyItem('a', 0, 38));
+	keyMap.finish();
+
+	KeyMap::ModifierToKeys activeModifiers;
+	keyMap.collectActiveModifiers(0, KeyModifierShift, activeModifiers);
+
+	ASSERT_EQ(2, activeModifiers.size());
+	EXPECT_EQ(2, activeModifiers.count(KeyModifierShift));
+	for (KeyMap::ModifierToKeys::const_iterator i = activeModifiers.begin();
+								i != activeModifiers.end(); ++i) {
+		EXPECT_EQ(0, i->second.m_group);
+	}
+}
+
+TEST(KeyMapTests, collectActiveModifiers_keyAddedAfterFinish_keyCollected)
+{
+	KeyMap keyMap;
+	keyMap.addKeyEntry(makeKeyItem(kKeyShift_L, 0, 50));
+	keyMap.finish();
+
+	KeyMap::ModifierToKeys activeModifiers;
+	keyMap.collectActiveModifiers(0, KeyModifierControl, activeModifiers);
+	EXPECT_EQ(0, activeModifiers.size());
+
+	keyMap.addKeyEntry(makeKeyItem(kKeyControl_L, 0, 37));
+	keyMap.collectActiveModifiers(0, KeyModifierControl, activeModifiers);
+
+	ASSERT_EQ(1, activeModifiers.size());
+	EXPECT_EQ(37, activeModifiers.begin()->second.m_button);
+}
@@ -83,7 +83,6 @@ TEST(KeyStateTests, sendKeyEvent_halfDuplex_addEventCalledTwice)
 	NiceMock<MockEventQueue> eventQueue;
 	KeyStateImpl keyState(eventQueue, keyMap);
 	IKeyStateEvents keyStateEvents;
-	keyStateEvents.setEvents(&eventQueue);
 	
 	ON_CALL(keyMap, isHalfDuplex(_, _)).WillByDefault(Return(true));
 	ON_CALL(eventQueue, forIKeyState()).WillByDefault(ReturnRef(keyStateEvents));
@@ -99,7 +98,6 @@ TEST(KeyStateTests, sendKeyEvent_keyRepeat_addEventCalledOnce)
 	NiceMock<MockEventQueue> eventQueue;
 	KeyStateImpl keyState(eventQueue, keyMap);
 	IKeyStateEvents keyStateEvents;
-	keyStateEvents.setEvents(&eventQueue);
 	
 	ON_CALL(eventQueue, forIKeyState()).WillByDefault(ReturnRef(keyStateEvents));
 
@@ -114,7 +112,6 @@ TEST(KeyStateTests, sendKeyEvent_keyDown_addEventCalledOnce)
 	NiceMock<MockEventQueue> eventQueue;
 	KeyStateImpl keyState(eventQueue, keyMap);
 	IKeyStateEvents keyStateEvents;
-	keyStateEvents.setEvents(&eventQueue);
 	
 	ON_CALL(eventQueue, forIKeyState()).WillByDefault(ReturnRef(keyStateEvents));
 
@@ -129,7 +126,6 @@ TEST(KeyStateTests, sendKeyEvent_keyUp_addEventCalledOnce)
 	NiceMock<MockEventQueue> eventQueue;
 	KeyStateImpl keyState(eventQueue, keyMap);
 	IKeyStateEvents keyStateEvents;
-	keyStateEvents.setEvents(&eventQueue);
 	
 	ON_CALL(eventQueue, forIKeyState()).WillByDefault(ReturnRef(keyStateEvents));
 
@@ -206,10 +202,10 @@ TEST(KeyStateTests, updateKeyState_activeModifiers_keyMapGotModifers)
 	MockEventQueue eventQueue;
 	KeyStateImpl keyState(eventQueue, keyMap);
 	ON_CALL(keyState, pollActiveModifiers()).WillByDefault(Return(1));
-	ON_CALL(keyMap, foreachKey(_, _)).WillByDefault(Invoke(assertMaskIsOne));
 
-	// key map gets new modifiers via foreachKey()
-	EXPECT_CALL(keyMap, foreachKey(_, _));
+	// key map gets new modifiers without walking every key
+	EXPECT_CALL(keyMap, collectActiveModifiers(_, 1, _));
+	EXPECT_CALL(keyMap, foreachKey(_, _)).Times(0);
 
 	keyState.updateKeyState();
 }
@@ -453,12 +449,6 @@ stubPollPressedKeys(IKeyState::KeyButtonSet& pressedKeys)
 	pressedKeys.insert(1);
 }
 
-void
-assertMaskIsOne(ForeachKeyCallback cb, void* userData)
-{
-	ASSERT_EQ(1, ((KeyState::AddActiveModifierContext*)userData)->m_mask);
-}
-
 const synergy::KeyMap::KeyItem*
 stubMapKey(
 	synergy::KeyMap::Keystrokes& keys, KeyID id, SInt32 group,
@@ -52,15 +52,9 @@ typedef ::testing::NiceMock<MockKeyState> KeyStateImpl;
 
 typedef UInt32 KeyID;
 
-typedef void (*ForeachKeyCallback)(
-		KeyID, SInt32 group, synergy::KeyMap::KeyItem&, void* userData);
-
 void
 stubPollPressedKeys(IKeyState::KeyButtonSet& pressedKeys);
 
-void
-assertMaskIsOne(ForeachKeyCallback cb, void* userData);
-
 const synergy::KeyMap::KeyItem*
 stubMapKey(
 	synergy::KeyMap::Keystrokes& keys, KeyID id, SInt32 group,
@@ -0,0 +1,256 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/StreamChunker.h"
+#include "synergy/FileChunk.h"
+#include "synergy/protocol_types.h"
+#include "test/mock/synergy/MockEventQueue.h"
+
+#include "test/global/gtest.h"
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+using ::testing::_;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::ReturnRef;
+
+static std::vector<Event> s_events;
+
+// saves the event and, like the proxies, reports its file chunk sent
+static void
+saveEvent(const Event& event)
+{
+	s_events.push_back(event);
+
+	FileChunk* chunk = dynamic_cast<FileChunk*>(event.getDataObject());
+	if (chunk == NULL) {
+		return;
+	}
+	if (static_cast<UInt8>(chunk->m_chunk[0]) == kDataFileRange) {
+		int fd = -1;
+		size_t offset = 0;
+		size_t size = 0;
+		String content(&chunk->m_chunk[1], chunk->m_dataSize);
+		if (FileChunk::parseFileRange(content, fd, offset, size)) {
+			StreamChunker::fileRangeSent(size);
+		}
+	}
+	StreamChunker::fileChunkSent(chunk->m_dataSize);
+}
+
+static void
+createFile(const char* filename, size_t size)
+{
+	std::fstream file(filename, std::ios::out | std::ios::binary);
+	for (size_t i = 0; i < size; ++i) {
+		file.put(static_cast<char>(i & 0xff));
+	}
+}
+
+// the running checksum of the first \p size bytes createFile() writes
+static UInt32
+fileChecksum(size_t size)
+{
+	UInt32 checksum = FileChunk::kChecksumInit;
+	for (size_t i = 0; i < size; ++i) {
+		UInt8 byte = static_cast<UInt8>(i & 0xff);
+		checksum = FileChunk::updateChecksum(checksum, &byte, 1);
+	}
+	return checksum;
+}
+
+// resumes a session of one file and returns the offset it restarted at
+static size_t
+resumeFile(const char* filename, size_t offset, UInt32 checksum)
+{
+	DragFileList fileList;
+	String name(filename);
+	DragInformation di;
+	di.setFilename(name);
+	fileList.push_back(di);
+
+	FileTransferSession session = StreamChunker::newSession(fileList);
+	session.m_resume.m_id = session.m_id;
+	session.m_resume.m_fileIndex = 0;
+	session.m_resume.m_checksum = checksum;
+	session.m_resume.m_offset = offset;
+
+	FileEvents fileEvents;
+	NiceMock<MockEventQueue> eventQueue;
+	ON_CALL(eventQueue, forFile()).WillByDefault(ReturnRef(fileEvents));
+	ON_CALL(eventQueue, addEvent(_)).WillByDefault(Invoke(saveEvent));
+
+	s_events.clear();
+	StreamChunker::init();
+	StreamChunker::resumeFiles(session, &eventQueue, NULL, NULL, false);
+
+	size_t start = (size_t)-1;
+	for (size_t i = 0; i < s_events.size(); ++i) {
+		if (s_events[i].getType() == fileEvents.fileChunkSending()) {
+			FileChunk* chunk = static_cast<FileChunk*>(s_events[i].getDataObject());
+			if (chunk->m_chunk[0] == kDataTransferStart) {
+				UInt32 id = 0;
+				UInt32 index = 0;
+				size_t size = 0;
+				String content(&chunk->m_chunk[1], chunk->m_dataSize);
+				FileChunk::parseTransferStart(content, id, index, size, start);
+			}
+		}
+		delete s_events[i].getDataObject();
+	}
+	return start;
+}
+
+// sends two files and checks each is a header with its index, its
+// data and an end mark.  copies of the data carry the file's running
+// checksum; ranges don't.
+static void
+sendTwoFiles(bool sendFromFile)
+{
+	createFile("StreamChunkerTests0.tmp", 1000);
+	createFile("StreamChunkerTests1.tmp", 3000);
+
+	DragFileList fileList;
+	String name0("StreamChunkerTests0.tmp");
+	String name1("StreamChunkerTests1.tmp");
+	DragInformation di;
+	di.setFilename(name0);
+	fileList.push_back(di);
+	di.setFilename(name1);
+	fileList.push_back(di);
+
+	FileEvents fileEvents;
+	NiceMock<MockEventQueue> eventQueue;
+	ON_CALL(eventQueue, forFile()).WillByDefault(ReturnRef(fileEvents));
+	ON_CALL(eventQueue, addEvent(_)).WillByDefault(Invoke(saveEvent));
+
+	s_events.clear();
+	StreamChunker::init();
+	StreamChunker::sendFiles(StreamChunker::newSession(fileList),
+		&eventQueue, NULL, NULL, sendFromFile);
+
+	std::vector<UInt32> indexes;
+	std::vector<size_t> sizes;
+	size_t ends = 0;
+	size_t ranges = 0;
+	for (size_t i = 0; i < s_events.size(); ++i) {
+		if (s_events[i].getType() != fileEvents.fileChunkSending()) {
+			delete s_events[i].getDataObject();
+			continue;
+		}
+
+		FileChunk* chunk = static_cast<FileChunk*>(s_events[i].getDataObject());
+		String content(&chunk->m_chunk[1], chunk->m_dataSize);
+		UInt32 id = 0;
+		UInt32 index = 0;
+		size_t size = 0;
+		size_t offset = 0;
+		int fd = -1;
+		UInt32 checksum = 0;
+		switch (static_cast<UInt8>(chunk->m_chunk[0])) {
+		case kDataTransferStart:
+			EXPECT_TRUE(FileChunk::parseTransferStart(content, id, index, size, offset));
+			EXPECT_EQ(ends, indexes.size());
+			indexes.push_back(index);
+			sizes.push_back(0);
+			EXPECT_EQ(0u, offset);
+			break;
+
+		case kDataCheckedChunk: {
+			ASSERT_FALSE(sizes.empty());
+			sizes.back() += content.size() - 4;
+			const UInt8* bytes = reinterpret_cast<const UInt8*>(content.data());
+			checksum = (static_cast<UInt32>(bytes[0]) << 24) |
+						(static_cast<UInt32>(bytes[1]) << 16) |
+						(static_cast<UInt32>(bytes[2]) <<  8) |
+						 static_cast<UInt32>(bytes[3]);
+			EXPECT_EQ(fileChecksum(sizes.back()), checksum);
+			break;
+		}
+
+		case kDataFileRange:
+			ASSERT_FALSE(sizes.empty());
+			EXPECT_TRUE(FileChunk::parseFileRange(content, fd, offset, size));
+			EXPECT_EQ(sizes.back(), offset);
+			sizes.back() += size;
+			++ranges;
+			break;
+
+		case kDataEnd:
+			++ends;
+			EXPECT_EQ(ends, indexes.size());
+			break;
+
+		default:
+			ADD_FAILURE() << "unexpected mark " << (int)chunk->m_chunk[0];
+		}
+		delete chunk;
+	}
+
+	ASSERT_EQ(2u, indexes.size());
+	EXPECT_EQ(0u, indexes[0]);
+	EXPECT_EQ(1u, indexes[1]);
+	EXPECT_EQ(1000u, sizes[0]);
+	EXPECT_EQ(3000u, sizes[1]);
+	EXPECT_EQ(2u, ends);
+#if HAVE_SYS_SENDFILE_H
+	EXPECT_EQ(sendFromFile, ranges > 0);
+#else
+	EXPECT_EQ(0u, ranges);
+#endif
+
+	remove("StreamChunkerTests0.tmp");
+	remove("StreamChunkerTests1.tmp");
+}
+
+TEST(StreamChunkerTests, sendFiles_copies_checkedAndFramedByIndex)
+{
+	sendTwoFiles(false);
+}
+
+TEST(StreamChunkerTests, sendFiles_fromFile_rangesFramedByIndex)
+{
+	sendTwoFiles(true);
+}
+
+TEST(StreamChunkerTests, resumeFiles_prefixMatches_resumesAtOffset)
+{
+	createFile("StreamChunkerTests2.tmp", 2000);
+
+	UInt8 prefix[1000];
+	for (size_t i = 0; i < sizeof(prefix); ++i) {
+		prefix[i] = static_cast<UInt8>(i & 0xff);
+	}
+	UInt32 checksum = FileChunk::updateChecksum(
+						FileChunk::kChecksumInit, prefix, sizeof(prefix));
+
+	EXPECT_EQ(1000u, resumeFile("StreamChunkerTests2.tmp", 1000, checksum));
+
+	remove("StreamChunkerTests2.tmp");
+}
+
+TEST(StreamChunkerTests, resumeFiles_prefixChanged_restartsFile)
+{
+	createFile("StreamChunkerTests3.tmp", 2000);
+
+	EXPECT_EQ(0u, resumeFile("StreamChunkerTests3.tmp", 1000, 12345));
+
+	remove("StreamChunkerTests3.tmp");
+}
@@ -0,0 +1,70 @@
+/*
+ * synergy -- mouse and keyboard sharing utility
+ * Copyright (C) 2015 Synergy Si Inc.
+ *
+ * This package is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * found in the file LICENSE that should have accompanied this file.
+ *
+ * This package is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "synergy/TokenBucket.h"
+
+#include "test/global/gtest.h"
+
+// allowance for the bucket refilling while a test runs
+static const double kWaitTolerance = 0.05;
+
+TEST(TokenBucketTests, take_noRate_neverWaits)
+{
+	TokenBucket bucket;
+
+	EXPECT_EQ(0.0, bucket.take(1024 * 1024 * 1024));
+	EXPECT_EQ(0.0, bucket.getRate());
+}
+
+TEST(TokenBucketTests, take_withinBurst_noWait)
+{
+	TokenBucket bucket;
+	bucket.setRate(1000.0);
+
+	EXPECT_EQ(0.0, bucket.take(600));
+	EXPECT_EQ(0.0, bucket.take(400));
+}
+
+TEST(TokenBucketTests, take_overBurst_waitsForDebt)
+{
+	TokenBucket bucket;
+	bucket.setRate(1000.0);
+
+	EXPECT_EQ(0.0, bucket.take(1000));
+	EXPECT_NEAR(0.5, bucket.take(500), kWaitTolerance);
+	EXPECT_NEAR(1.5, bucket.take(1000), kWaitTolerance);
+}
+
+TEST(TokenBucketTests, take_parentSlower_waitsForParent)
+{
+	TokenBucket parent;
+	parent.setRate(1000.0);
+	TokenBucket child(&parent);
+	child.setRate(10000.0);
+
+	EXPECT_NEAR(1.0, child.take(2000), kWaitTolerance);
+}
+
+TEST(TokenBucketTests, setRate_negative_unlimited)
+{
+	TokenBucket bucket;
+	bucket.setRate(1000.0);
+	bucket.setRate(-5.0);
+
+	EXPECT_EQ(0.0, bucket.getRate());
+	EXPECT_EQ(0.0, bucket.take(1000000));
+}